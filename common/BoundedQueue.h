@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace mv::common {
+
+    // A queue that hands items from producer threads to consumer threads. Producers wait while the queue holds
+    // capacity items, which bounds the memory a producer that is faster than its consumers can use. Closing the
+    // queue wakes up all threads waiting on it
+    template<typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t const capacity)
+            : m_capacity(std::max<size_t>(capacity, 1)) {
+        }
+
+        BoundedQueue(BoundedQueue const&) = delete;
+        BoundedQueue& operator=(BoundedQueue const&) = delete;
+
+        // Waits until there is room for the item. Returns false without adding the item if the queue is closed
+        bool push(T item) {
+            std::unique_lock lock{m_mutex};
+            m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+            if (m_closed) return false;
+            m_items.push_back(std::move(item));
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        // Waits until there is an item. Items pushed before the queue was closed are still returned, after which
+        // nothing is
+        std::optional<T> pop() {
+            std::unique_lock lock{m_mutex};
+            m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+            if (m_items.empty()) return std::nullopt;
+            std::optional<T> item {std::move(m_items.front())};
+            m_items.pop_front();
+            m_notFull.notify_one();
+            return item;
+        }
+
+        // Returns the next item without waiting for one
+        std::optional<T> tryPop() {
+            std::lock_guard lock{m_mutex};
+            if (m_items.empty()) return std::nullopt;
+            std::optional<T> item {std::move(m_items.front())};
+            m_items.pop_front();
+            m_notFull.notify_one();
+            return item;
+        }
+
+        // Makes pushes fail and pops fail once the queue is empty
+        void close() {
+            std::lock_guard lock{m_mutex};
+            m_closed = true;
+            m_notFull.notify_all();
+            m_notEmpty.notify_all();
+        }
+
+        [[nodiscard]] bool isClosed() const {
+            std::lock_guard lock{m_mutex};
+            return m_closed;
+        }
+
+        [[nodiscard]] bool isEmpty() const {
+            std::lock_guard lock{m_mutex};
+            return m_items.empty();
+        }
+
+    private:
+        size_t const m_capacity;
+        std::deque<T> m_items;
+        bool m_closed = false;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_notFull;
+        std::condition_variable m_notEmpty;
+    };
+
+}
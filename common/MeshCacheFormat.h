@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Layout of .mvmesh files, MeshViewer's native mesh format. Mesh data is stored the way meshes hold it in memory,
+// so a file can be memory mapped and used without parsing
+//
+// A file starts with a Header that is followed by numSections Sections. Each section refers to a block of the file
+// that starts at a multiple of sectionAlignment. Numbers are stored in the byte order of the machine that wrote the
+// file, and readers reject files whose byteOrderMark doesn't match theirs
+
+namespace mv::common::meshcache {
+
+    constexpr std::array<char, 8> magic {'M', 'V', 'M', 'E', 'S', 'H', '\r', '\n'};
+    constexpr uint32_t version = 1;
+    constexpr uint32_t byteOrderMark = 0x01020304;
+    // 16 KiB is a multiple of the page size of all supported platforms
+    constexpr uint64_t sectionAlignment = 16384;
+
+    enum class SectionType : uint32_t {
+        // x,y,z float triples, numVertices of them
+        Positions,
+        // Vertex index triples, numFaces of them
+        Indices,
+        // x,y,z float triples, numVertices of them
+        VertexNormals,
+        // x,y,z float triples, numFaces of them
+        FaceNormals,
+        // Minimum x,y,z followed by maximum x,y,z
+        Bounds,
+        // Reserved for a serialized spatial index. Readers skip sections they don't know
+        SpatialIndex,
+    };
+
+    struct Header {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint32_t numVertices;
+        uint32_t numFaces;
+        uint32_t numSections;
+        uint32_t reserved;
+    };
+
+    struct Section {
+        SectionType type;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    static_assert(sizeof(Header) == 32 && sizeof(Section) == 24, "Layout of mvmesh files changed");
+
+}
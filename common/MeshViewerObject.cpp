@@ -4,7 +4,7 @@
 
 namespace mv {
 
-size_t MeshViewerObject::instanceCount = 0;
+std::atomic<size_t> MeshViewerObject::instanceCount = 0;
     
 MeshViewerObject::MeshViewerObject()
     : id(++instanceCount) {
@@ -4,6 +4,7 @@
 #define STB_IMAGE_IMPLEMENTATION
 #endif
 
+#include <atomic>
 #include <cstddef> // for size_t
 #include <iostream>
 
@@ -50,7 +51,8 @@ class MeshViewerObject {
 
     private:
         size_t id;
-        static size_t instanceCount;
+        // Atomic since objects can be created concurrently
+        static std::atomic<size_t> instanceCount;
         bool moved{};
     protected:
         bool debug{};
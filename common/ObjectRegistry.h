@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MeshViewerObject.h"
+#include <mutex>
 #include <unordered_set>
 #include <string>
 #include <vector>
@@ -15,12 +16,14 @@ namespace mv {
 
     private:
         void registerObject(MeshViewerObject const& object) {
+           std::lock_guard lock{registryMutex};
            registeredObjects.insert(std::ref(object));
         }
 
         void unRegisterObject(MeshViewerObject const& object) {
             // Remove from registry if the object wasn't moved from
             if (!object.wasMoved()) {
+                std::lock_guard lock{registryMutex};
                 auto iterator = getIterator(object);
                 if (iterator == registeredObjects.end()) {
                     throw std::runtime_error(
@@ -37,10 +40,12 @@ namespace mv {
 
     public:
         bool hasRegisteredObjects() {
+            std::lock_guard lock{registryMutex};
             return !registeredObjects.empty();
         }
 
         bool isRegistered(MeshViewerObject const& object) {
+            std::lock_guard lock{registryMutex};
             return getIterator(object) != registeredObjects.end();
         }
 
@@ -58,6 +63,8 @@ namespace mv {
                 MeshViewerObject::MeshViewerObjectHash,
                 MeshViewerObject::MeshViewerObjectEquals>;
         inline static RegisteredObjects registeredObjects {};
+        // Objects are created and destroyed on worker threads as well as the main thread
+        inline static std::mutex registryMutex;
 
         using DeletionObservers = std::vector<std::reference_wrapper<ObjectDeletionObserver>>;
         inline static DeletionObservers deletionObservers;
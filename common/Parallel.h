@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+// Minimal data parallel helpers for the compute heavy parts of the application (mesh processing, file parsing)
+
+namespace mv::common {
+
+    // Number of threads the parallel algorithms below spread work across
+    inline unsigned getConcurrency() {
+#ifdef EMSCRIPTEN
+        // Web builds have a small, fixed pool of workers. Blocking the main thread on a worker that the pool
+        // cannot supply deadlocks the browser, so work is done on the calling thread
+        return 1;
+#else
+        static unsigned const concurrency = std::max(1u, std::thread::hardware_concurrency());
+        return concurrency;
+#endif
+    }
+
+    // Threads that parallelFor runs ranges on besides the calling thread. They are started on first use and
+    // live as long as the application
+    inline ThreadPool& getThreadPool() {
+        static ThreadPool threadPool {getConcurrency() - 1};
+        return threadPool;
+    }
+
+    // Number of ranges parallelFor splits count items into. Calls from threads of the pool get one range, so
+    // work that is nested in a parallelFor doesn't start more work than there are threads
+    inline size_t getNumberOfRanges(size_t const count, size_t const minimumRangeSize) {
+        if (ThreadPool::isPoolThread()) return 1;
+        return std::clamp<size_t>(count / std::max<size_t>(minimumRangeSize, 1), 1, getConcurrency());
+    }
+
+    // Splits [0, count) into contiguous ranges and calls rangeFunction(begin, end) for each range on the threads
+    // of the pool and the calling thread. Ranges are never smaller than minimumRangeSize, so small inputs are
+    // processed on the calling thread alone. If rangeFunction accepts a third argument, it is passed the index of
+    // the range, which is in [0, getNumberOfRanges(count, minimumRangeSize)). The first exception raised by
+    // rangeFunction is re-thrown on the calling thread after all ranges are done
+    template<typename RangeFunction>
+    void parallelFor(size_t const count, RangeFunction&& rangeFunction, size_t const minimumRangeSize = 16384) {
+        if (!count) return;
+
+        auto invoke = [&rangeFunction](size_t const begin, size_t const end, size_t const rangeIndex) {
+            if constexpr (std::is_invocable_v<RangeFunction, size_t, size_t, size_t>) {
+                rangeFunction(begin, end, rangeIndex);
+            } else {
+                rangeFunction(begin, end);
+            }
+        };
+
+        auto const numRanges = getNumberOfRanges(count, minimumRangeSize);
+        if (numRanges == 1) {
+            invoke(0, count, 0);
+            return;
+        }
+
+        // Ranges are taken in order by the calling thread and by as many tasks of the pool. The calling thread
+        // runs ranges that tasks haven't taken yet, so it finishes even when the pool is busy with other work.
+        // Tasks that start after all ranges were taken return without touching the caller's state
+        struct State {
+            std::atomic<size_t> nextRange {0};
+            size_t numRangesDone = 0;
+            std::exception_ptr exception;
+            std::mutex mutex;
+            std::condition_variable rangesDone;
+        };
+        auto const state = std::make_shared<State>();
+        auto const rangeSize = count / numRanges;
+        auto const remainder = count % numRanges;
+        auto runRanges = [state, &invoke, count, numRanges, rangeSize, remainder] {
+            for (auto rangeIndex = state->nextRange++; rangeIndex < numRanges; rangeIndex = state->nextRange++) {
+                auto const begin = rangeIndex * rangeSize + std::min(rangeIndex, remainder);
+                auto const end = std::min(count, begin + rangeSize + (rangeIndex < remainder ? 1 : 0));
+                std::exception_ptr exception;
+                try {
+                    invoke(begin, end, rangeIndex);
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+                std::lock_guard lock{state->mutex};
+                if (!state->exception) state->exception = exception;
+                if (++state->numRangesDone == numRanges) state->rangesDone.notify_one();
+            }
+        };
+
+        auto& threadPool = getThreadPool();
+        for (size_t i = 1; i < std::min<size_t>(numRanges, threadPool.getNumberOfThreads() + 1); ++i) {
+            threadPool.submit(runRanges);
+        }
+        runRanges();
+        std::unique_lock lock{state->mutex};
+        state->rangesDone.wait(lock, [&] { return state->numRangesDone == numRanges; });
+        auto const exception = state->exception;
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+}
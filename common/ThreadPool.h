@@ -0,0 +1,81 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mv::common {
+
+    // A fixed number of threads that run tasks in the order they are submitted. Threads are started when the pool
+    // is created and wait for tasks until the pool is destroyed, so submitting a task doesn't start a thread
+    class ThreadPool {
+    public:
+        explicit ThreadPool(unsigned const numThreads) {
+            m_threads.reserve(numThreads);
+            for (unsigned i = 0; i < numThreads; ++i) {
+                m_threads.emplace_back([this] { run(); });
+            }
+        }
+
+        // Waits for the tasks that were submitted
+        ~ThreadPool() {
+            {
+                std::lock_guard lock{m_mutex};
+                m_stopped = true;
+            }
+            m_taskAdded.notify_all();
+            for (auto& thread : m_threads) {
+                thread.join();
+            }
+        }
+
+        ThreadPool(ThreadPool const&) = delete;
+        ThreadPool& operator=(ThreadPool const&) = delete;
+
+        // Tasks must not throw
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard lock{m_mutex};
+                m_tasks.push_back(std::move(task));
+            }
+            m_taskAdded.notify_one();
+        }
+
+        [[nodiscard]] size_t getNumberOfThreads() const { return m_threads.size(); }
+
+        // True on the threads of any pool. Work that a task splits up is done on the task's thread, since the
+        // other threads of the pool may be busy with the other parts of the work the task belongs to
+        [[nodiscard]] static bool isPoolThread() { return getIsPoolThread(); }
+
+    private:
+        static bool& getIsPoolThread() {
+            thread_local bool isPoolThread = false;
+            return isPoolThread;
+        }
+
+        void run() {
+            getIsPoolThread() = true;
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock lock{m_mutex};
+                    m_taskAdded.wait(lock, [this] { return m_stopped || !m_tasks.empty(); });
+                    if (m_tasks.empty()) return;
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void()>> m_tasks;
+        bool m_stopped = false;
+        std::mutex m_mutex;
+        std::condition_variable m_taskAdded;
+    };
+
+}
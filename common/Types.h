@@ -67,12 +67,19 @@ namespace mv::common {
                 : m_size(numElements), m_offset(0), m_data(new T[m_size * tupleSize], std::default_delete<T[]>()) {
         }
 
+        // Shares data that is owned elsewhere, e.g. by a memory mapped file
+        Array(size_t numElements, std::shared_ptr<T[]> data)
+                : m_size(numElements), m_offset(0), m_data(std::move(data)) {
+        }
+
         [[nodiscard]] size_t getSize() const { return m_size; }
 
         [[nodiscard]] size_t getDataSize() const { return m_size * tupleSize * sizeof(T); }
 
         T const *getData() const { return m_data.get(); }
 
+        T *getData() { return m_data.get(); }
+
         // TODO: Assert that all the parameters are of the same type
         template<typename... Types>
         void append(Types... args) {
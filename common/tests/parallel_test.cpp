@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+#include "Parallel.h"
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace mv::common;
+
+TEST(Parallel, RangesCoverAllItems) {
+    constexpr size_t count = 100003;
+    vector<atomic<unsigned>> visits(count);
+    auto const expectedRanges = getNumberOfRanges(count, 1000);
+    atomic<size_t> numRanges = 0;
+    parallelFor(count, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+        ASSERT_LT(rangeIndex, expectedRanges);
+        ++numRanges;
+        for (auto i = begin; i < end; ++i) ++visits[i];
+    }, 1000);
+    ASSERT_EQ(numRanges, expectedRanges);
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(visits[i], 1) << "Item " << i << " was not visited once";
+    }
+}
+
+TEST(Parallel, ThreadsAreReused) {
+    // Ranges only run on the calling thread and the threads of the pool, however often parallelFor is called
+    mutex threadsMutex;
+    set<thread::id> threads;
+    for (int call = 0; call < 20; ++call) {
+        parallelFor(getConcurrency() * 4, [&](size_t, size_t) {
+            lock_guard lock{threadsMutex};
+            threads.insert(this_thread::get_id());
+        }, 1);
+    }
+    ASSERT_LE(threads.size(), getConcurrency());
+}
+
+TEST(Parallel, NestedCallsRunOnTheirThread) {
+    // Ranges that run on the pool do their nested work themselves instead of queueing it behind other ranges
+    atomic<bool> nestedOnOtherThread = false;
+    atomic<size_t> numItems = 0;
+    parallelFor(getConcurrency() * 2, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            auto const outerThread = this_thread::get_id();
+            auto const outerOnPool = ThreadPool::isPoolThread();
+            parallelFor(1000, [&](size_t const innerBegin, size_t const innerEnd) {
+                if (outerOnPool && this_thread::get_id() != outerThread) nestedOnOtherThread = true;
+                numItems += innerEnd - innerBegin;
+            }, 1);
+        }
+    }, 1);
+    ASSERT_FALSE(nestedOnOtherThread);
+    ASSERT_EQ(numItems, getConcurrency() * 2 * 1000);
+}
+
+TEST(Parallel, ExceptionIsRethrown) {
+    auto const count = getConcurrency() * 8;
+    atomic<size_t> numItems = 0;
+    ASSERT_THROW(parallelFor(count, [&](size_t const begin, size_t const end) {
+        numItems += end - begin;
+        if (begin == 0) throw runtime_error("First range failed");
+    }, 1), runtime_error);
+    // The other ranges are still done before the exception reaches the caller
+    ASSERT_EQ(numItems, count);
+    // The pool keeps working after a range failed
+    atomic<size_t> numItemsAfterFailure = 0;
+    parallelFor(count, [&](size_t const begin, size_t const end) { numItemsAfterFailure += end - begin; }, 1);
+    ASSERT_EQ(numItemsAfterFailure, count);
+}
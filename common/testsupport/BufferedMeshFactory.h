@@ -0,0 +1,18 @@
+#pragma once
+
+#include "MeshFactory.h"
+#include "MockBufferedMesh.h"
+#include "gmock/gmock.h"
+#include <memory>
+
+namespace mv {
+
+    // Creates meshes with flat buffers, so that tests can check what readers decode into them
+    class BufferedMeshFactory : public IMeshFactory {
+        public:
+            Mesh::MeshPointer createMesh() const override {
+                return std::make_unique<testing::NiceMock<MockBufferedMesh>>();
+            }
+    };
+
+}
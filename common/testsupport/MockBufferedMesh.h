@@ -0,0 +1,30 @@
+#pragma once
+
+#include "MockMesh.h"
+#include <vector>
+
+namespace mv {
+
+    // A mock mesh that exposes flat position and index buffers the way TriangleMesh does, so readers
+    // decode into it directly
+    class MockBufferedMesh : public MockMesh {
+        public:
+            MockBufferedMesh() {
+                ON_CALL(*this, initialize).WillByDefault([this](unsigned numVertices, unsigned numFaces) {
+                    positions.assign(numVertices * 3, 0.f);
+                    indices.assign(numFaces * 3, 0);
+                });
+            }
+            std::span<float> getPositionBuffer() override { return positions; }
+            std::span<unsigned> getIndexBuffer() override { return indices; }
+            std::span<float> getVertexNormalBuffer() override {
+                normals.assign(positions.size(), 0.f);
+                return normals;
+            }
+
+            std::vector<float> positions;
+            std::vector<unsigned> indices;
+            std::vector<float> normals;
+    };
+
+}
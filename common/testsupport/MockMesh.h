@@ -8,6 +8,10 @@
 namespace mv {
     class MockMesh : public Mesh {
         public:
+            MockMesh() {
+                // Meshes that are read in the background compute their normals ahead of the first frame
+                ON_CALL(*this, getNormals).WillByDefault([](common::NormalLocation) { return NormalData(0); });
+            }
             MOCK_METHOD(void, initialize, (unsigned numVertices, unsigned numFaces), (override));
             MOCK_METHOD(void, addVertex, (float x, float y, float z), (override));
             MOCK_METHOD(void, addFace, (const std::initializer_list<unsigned>& vertexIds), (override));
@@ -18,6 +22,7 @@ namespace mv {
             MOCK_METHOD(const Faces&, getConnectivity, (), (const, override));
             MOCK_METHOD(const mv::Vertex&, getVertex, (unsigned vertexIndex), (const, override));
             MOCK_METHOD(const mv::Face&, getFace, (unsigned faceIndex), (const, override));
+            MOCK_METHOD(std::span<unsigned const>, getVertexFaces, (unsigned vertexIndex), (const, override));
             MOCK_METHOD(VertexData, getVertexData,(), (const, override));
             MOCK_METHOD(void, getConnectivityData,(size_t & numBytes, unsigned * &connData), (const, override));
             MOCK_METHOD(std::unique_ptr<Mesh>, transform,(common::TransformMatrix const &transformMatrix), (const, override));
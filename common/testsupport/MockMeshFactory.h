@@ -11,6 +11,11 @@ namespace mv {
             mv::Mesh::MeshPointer createMesh() const override {
                 return std::make_unique<MockMesh>();
             }
+            // Like the mesh factory of the application, shows meshes while they are read when set
+            bool createsProgressiveMeshes{};
+            mv::Drawable::DrawablePointer createProgressiveMesh(std::shared_ptr<MeshChunkChannel>) const override {
+                return createsProgressiveMeshes ? std::make_shared<MockMesh>() : nullptr;
+            }
     };
 
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "ReaderFactory.h"
 #include "MockMeshFactory.h"
 #include "MockReader.h"
+#include <mutex>
 
 namespace mv {
 
@@ -15,7 +16,9 @@ namespace mv {
         }
 
         MockReaderFactory() {
+            // Models are read on several threads at once
             ON_CALL(*this, getReader).WillByDefault([this](std::string const& name) {
+                std::lock_guard lock{readersMutex};
                 auto itr = readers.find(name);
                 readers::ReaderPointer result;
                 if (itr != readers.end()) {
@@ -27,6 +30,7 @@ namespace mv {
         }
         MockMeshFactory mockMeshFactory;
         std::unordered_map<std::string, std::unique_ptr<MockReader>> readers;
+        std::mutex readersMutex;
     };
 
 }
\ No newline at end of file
@@ -3,6 +3,12 @@
 #include "Viewer.h"
 #include "3dmath/Matrix.h"
 #include "gmock/gmock.h"
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 struct MockViewer : mv::viewer::Viewer {
     MOCK_METHOD(void, add, (mv::Drawable::DrawablePointer&&), (override));
@@ -24,7 +30,30 @@ struct MockViewer : mv::viewer::Viewer {
     void add(mv::Drawable::DrawablePointer const&) override {
         addSingleDrawableCalled = true;
     }
-
-
-
+    // Posted tasks are run by the test, which stands in for the render loop
+    std::mutex postedTasksMutex;
+    std::vector<std::function<void()>> postedTasks;
+    void post(std::function<void()> task) override {
+        std::lock_guard lock{postedTasksMutex};
+        postedTasks.push_back(std::move(task));
+    }
+    // Waits up to a few seconds for at least minimumTasks tasks to be posted and runs them. Returns false if none
+    // were posted
+    bool runPostedTasks(size_t const minimumTasks = 1) {
+        std::vector<std::function<void()>> tasks;
+        auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (tasks.size() < minimumTasks && std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard lock{postedTasksMutex};
+                tasks.insert(tasks.end(), std::make_move_iterator(postedTasks.begin()),
+                             std::make_move_iterator(postedTasks.end()));
+                postedTasks.clear();
+            }
+            if (tasks.size() < minimumTasks) std::this_thread::yield();
+        }
+        for (auto& task : tasks) {
+            task();
+        }
+        return !tasks.empty();
+    }
 };
\ No newline at end of file
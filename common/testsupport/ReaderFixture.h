@@ -0,0 +1,143 @@
+#pragma once
+
+#include "BufferedMeshFactory.h"
+#include "MockBufferedMesh.h"
+#include "ReaderFactory.h"
+#include "gtest/gtest.h"
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mv {
+
+    // Positions and indices of a mesh that a reader created
+    struct Geometry {
+        std::vector<float> positions;
+        std::vector<unsigned> indices;
+        bool operator==(Geometry const&) const = default;
+    };
+
+    // Appends the shortest text that is read back as the value
+    inline void appendNumber(std::string& text, auto const value) {
+        char digits[32];
+        auto const end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        text.append(digits, end);
+    }
+
+    // Tests of readers that read the sample models and files they write to a directory of their own. The directory
+    // is named after the test suite and is removed after each test
+    class ReaderFixture : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                auto* pData = std::getenv("modelsDir");
+                if (!pData) throw std::runtime_error("modelsDir environment variable not set");
+                m_modelsDir = pData;
+                m_directory = std::filesystem::temp_directory_path() /
+                              ::testing::UnitTest::GetInstance()->current_test_suite()->name();
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+            }
+
+            void TearDown() override {
+                std::filesystem::remove_all(m_directory);
+            }
+
+            // Reads the file into a mesh that exposes its buffers. prepareReader is called with the reader before
+            // it reads. Streams are read from the file instead of its mapping. What readers print is dropped
+            static Geometry read(std::filesystem::path const& file, bool const clean = false,
+                                 std::function<void(readers::Reader&)> const& prepareReader = {},
+                                 bool const asStream = false) {
+                readers::ReaderFactory readerFactory {std::make_unique<BufferedMeshFactory>()};
+                readerFactory.setCleanupOnImport(clean);
+                auto reader = readerFactory.getReader(file.string());
+                if (prepareReader) prepareReader(*reader);
+                testing::internal::CaptureStdout();
+                Mesh::MeshPointer mesh;
+                try {
+                    if (asStream) {
+                        std::ifstream ifs {file, std::ios::binary};
+                        mesh = reader->readStream(ifs);
+                    } else {
+                        mesh = reader->getOutput();
+                    }
+                } catch (...) {
+                    testing::internal::GetCapturedStdout();
+                    throw;
+                }
+                testing::internal::GetCapturedStdout();
+                auto const& bufferedMesh = dynamic_cast<MockBufferedMesh const&>(*mesh);
+                return {bufferedMesh.positions, bufferedMesh.indices};
+            }
+
+            // A binary STL with a grid of triangles, 512 to a row
+            [[nodiscard]] std::filesystem::path writeBinarySTL(unsigned const numTriangles) const {
+                auto const file = m_directory / "large.stl";
+                std::ofstream ofs {file, std::ios::binary};
+                char header[80] {};
+                ofs.write(header, sizeof(header));
+                ofs.write(reinterpret_cast<char const*>(&numTriangles), sizeof(numTriangles));
+                for (unsigned i = 0; i < numTriangles; ++i) {
+                    char record[50] {};
+                    auto const x = static_cast<float>(i % 512);
+                    auto const y = static_cast<float>(i / 512);
+                    float const vertices[9] {x, y, 0, x + 1, y, 0, x, y + 1, 0};
+                    std::memcpy(record + 12, vertices, sizeof(vertices));
+                    ofs.write(record, sizeof(record));
+                }
+                return file;
+            }
+
+            // The geometry of the Armadillo sample as ASCII PLY and STL, which are long enough to be parsed in pieces
+            [[nodiscard]] std::vector<std::filesystem::path> writeAsciiFiles() const {
+                auto const geometry = read(m_modelsDir / "Armadillo.ply");
+
+                std::string ply = "ply\nformat ascii 1.0\nelement vertex " +
+                                  std::to_string(geometry.positions.size() / 3) +
+                                  "\nproperty float x\nproperty float y\nproperty float z\nelement face " +
+                                  std::to_string(geometry.indices.size() / 3) +
+                                  "\nproperty list uchar int vertex_indices\nend_header\n";
+                for (size_t i = 0; i < geometry.positions.size(); ++i) {
+                    appendNumber(ply, geometry.positions[i]);
+                    ply += i % 3 == 2 ? '\n' : ' ';
+                }
+                for (size_t i = 0; i < geometry.indices.size(); i += 3) {
+                    ply += '3';
+                    for (size_t j = i; j < i + 3; ++j) {
+                        ply += ' ';
+                        appendNumber(ply, geometry.indices[j]);
+                    }
+                    ply += '\n';
+                }
+
+                std::string stl = "solid armadillo\n";
+                for (size_t i = 0; i < geometry.indices.size(); i += 3) {
+                    stl += "facet normal 0 0 0\nouter loop\n";
+                    for (size_t j = i; j < i + 3; ++j) {
+                        stl += "vertex";
+                        for (size_t k = 0; k < 3; ++k) {
+                            stl += ' ';
+                            appendNumber(stl, geometry.positions[3 * geometry.indices[j] + k]);
+                        }
+                        stl += '\n';
+                    }
+                    stl += "endloop\nendfacet\n";
+                }
+                stl += "endsolid armadillo\n";
+
+                std::ofstream{m_directory / "armadillo_ascii.ply", std::ios::binary} << ply;
+                std::ofstream{m_directory / "armadillo_ascii.stl", std::ios::binary} << stl;
+                return {m_directory / "armadillo_ascii.ply", m_directory / "armadillo_ascii.stl"};
+            }
+
+            std::filesystem::path m_modelsDir;
+            std::filesystem::path m_directory;
+    };
+
+}
@@ -15,6 +15,10 @@ namespace mv::events {
         DragRotated                             = 1006,
         DragCompleted                           = 1007,
         DragStarted                             = 1008,
+        // Data: model file, bytes read, total bytes (0 if unknown) and elements read
+        ModelLoadProgressed                     = 1009,
+        // Data: model file and the reason it could not be loaded
+        ModelLoadFailed                         = 1010,
     };
 
     enum class MouseButton : unsigned {
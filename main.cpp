@@ -36,7 +36,8 @@ bool loadModels(int argc, char** argv, ModelManager& modelManager) {
     if (!ValidateArguments(argc, argv)) {
         return false;
     }
-    modelManager.loadModelFiles({argv + 1, argv + argc});
+    // Models are read while the viewer draws. Errors are printed as the models are read
+    modelManager.loadModelFilesAsync({argv + 1, argv + argc});
 #else
     modelManager.loadModelFilesFromDirectory("/testfiles");
 #endif
@@ -53,7 +54,18 @@ int main(int argc, char** argv) {
     SetupTexturePath(argv[0]);
 
     // Load models
-    ModelManager modelManager;
+    auto& configuration = ConfigurationReader::getInstance();
+    auto readerFactory = std::make_unique<ReaderFactory>();
+    readerFactory->setCleanupOnImport(configuration.getBoolean("CleanupOnImport"));
+#ifndef EMSCRIPTEN
+    // Meshes that were read and cleaned up before are reopened from the cache
+    readerFactory->setDerivedDataCache(std::make_shared<DerivedDataCache const>(
+            std::filesystem::path{configuration.getValue("temporaryFilesDirectory")} / "derivedData",
+            configuration.getValueAs<uint64_t>("DerivedDataCacheSizeMB") << 20));
+#endif
+    ModelManager modelManager {ModelManager::Mode::DisplaySingleModel, std::move(readerFactory)};
+    modelManager.setMemoryBudget(configuration.getValueAs<uint64_t>("ModelLoadMemoryBudgetMB") << 20);
+    modelManager.setPrefetchCount(configuration.getValueAs<size_t>("PrefetchedModels"));
     if (!loadModels(argc, argv, modelManager)) {
         return EXIT_FAILURE;
     }
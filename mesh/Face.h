@@ -21,6 +21,10 @@ class Face {
             m_vertexIds = vertexIds;
         }
 
+        explicit Face(std::vector<unsigned> vertexIds)
+        : m_vertexIds(std::move(vertexIds)) {
+        }
+
         [[nodiscard]]
         common::Vector3D getNormal(const Mesh&) const;
 
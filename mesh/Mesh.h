@@ -5,6 +5,7 @@
 #include <vector>
 #include <optional>
 #include <filesystem>
+#include <span>
 #include "Types.h"
 #include "Vertex.h"
 #include "Face.h"
@@ -34,6 +35,34 @@ class Mesh : public virtual Drawable3D {
         // NOTE: vertexIds are 0-based
         virtual void addFace(const std::initializer_list<unsigned>& vertexIds) = 0;
 
+        // Writable views of the position (x,y,z triples) and connectivity (vertex index triples) buffers of meshes
+        // that store them contiguously. They let readers decode files straight into the mesh instead of calling
+        // addVertex and addFace per element. Each view covers the capacity set by initialize() and getting it
+        // counts all vertices or faces as added. Meshes without such buffers return empty views
+        virtual std::span<float> getPositionBuffer() { return {}; }
+        virtual std::span<unsigned> getIndexBuffer() { return {}; }
+
+        // Writable view of the vertex normals (x,y,z triples) of meshes that can use normals supplied by a file
+        // instead of computing them. Get it after the position and index buffers are written, since writing those
+        // discards normals. Meshes that always compute their normals return an empty view
+        virtual std::span<float> getVertexNormalBuffer() { return {}; }
+
+        // Buffers that are owned elsewhere, e.g. sections of a memory mapped file, in the layout of the views
+        // above. Normals and bounds are optional
+        struct SharedBuffers {
+            unsigned numVertices;
+            unsigned numFaces;
+            std::shared_ptr<float[]> positions;
+            std::shared_ptr<unsigned[]> indices;
+            std::shared_ptr<float[]> vertexNormals;
+            std::shared_ptr<float[]> faceNormals;
+            std::optional<common::Bounds> bounds;
+        };
+
+        // Makes the mesh use the buffers as its storage instead of copying them. Meshes that can't share storage
+        // return false and are left unchanged
+        virtual bool setSharedBuffers(SharedBuffers const&) { return false; }
+
         // Merges coincident vertices and adjusts the connectivity data
         // accordingly. Return number of duplicates that were removed
         virtual unsigned removeDuplicateVertices() = 0;
@@ -56,6 +85,9 @@ class Mesh : public virtual Drawable3D {
         // Returns a face at the specified index
         virtual const Face& getFace(unsigned faceIndex) const = 0;
 
+        // Gets the indices of the faces that share the specified vertex
+        virtual std::span<unsigned const> getVertexFaces(unsigned vertexIndex) const = 0;
+
         // Gets vertices
         virtual VertexData getVertexData() const = 0;
 
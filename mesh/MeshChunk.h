@@ -0,0 +1,24 @@
+#pragma once
+
+#include "BoundedQueue.h"
+#include <cstddef>
+#include <vector>
+
+namespace mv {
+
+    // A piece of a mesh that is being read. The vertices of a chunk follow the vertices of the chunks before it and
+    // its triangles refer to vertices of this or earlier chunks by their index in the whole mesh
+    struct MeshChunk {
+        std::vector<float> positions;
+        std::vector<unsigned> indices;
+    };
+
+    // Most triangles in a chunk. Chunks have up to three times as many vertices, so that a chunk of triangles
+    // that don't share vertices holds all of their vertices
+    constexpr size_t trianglesPerMeshChunk = 1 << 16;
+    constexpr size_t verticesPerMeshChunk = 3 * trianglesPerMeshChunk;
+
+    // Hands chunks from the thread that reads a mesh to the thread that draws them
+    using MeshChunkChannel = common::BoundedQueue<MeshChunk>;
+
+}
@@ -1,8 +1,13 @@
 #include "MeshFactory.h"
-#include "MeshImpl.h"
+#include "TriangleMesh.h"
+#include "ProgressiveMesh.h"
 
 namespace mv {
     Mesh::MeshPointer MeshFactory::createMesh() const {
-        return std::make_unique<MeshImpl>();
+        return std::make_unique<TriangleMesh>();
+    }
+
+    Drawable::DrawablePointer MeshFactory::createProgressiveMesh(std::shared_ptr<MeshChunkChannel> chunkChannel) const {
+        return std::make_shared<ProgressiveMesh>(std::move(chunkChannel));
     }
 }
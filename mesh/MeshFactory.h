@@ -1,15 +1,23 @@
 #pragma once
 #include "MeshViewerObject.h"
 #include "Mesh.h"
+#include "MeshChunk.h"
+#include <memory>
 
 namespace mv {
     // This interface facilitates dependency injection allowing tests from having to link against the mesh library
     struct IMeshFactory : MeshViewerObject {
        virtual Mesh::MeshPointer createMesh() const = 0;
+       // Drawable that shows a mesh while it is read through the channel. Factories whose meshes can't be shown
+       // before they are read return nullptr
+       virtual Drawable::DrawablePointer createProgressiveMesh(std::shared_ptr<MeshChunkChannel>) const {
+           return nullptr;
+       }
        virtual ~IMeshFactory() = default;
     };
 
     struct MeshFactory : IMeshFactory {
         Mesh::MeshPointer createMesh() const override;
+        Drawable::DrawablePointer createProgressiveMesh(std::shared_ptr<MeshChunkChannel>) const override;
     };
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include "MeshImpl.h"
-#include "ConfigurationReader.h"
+#include "MeshNormals.h"
+#include "PointKernels.h"
+#include "Parallel.h"
+#include "VertexWelder.h"
 #include <limits>
 #include <iostream>
 #include <algorithm>
-#include <unordered_set>
 
 using namespace std;
 
@@ -43,9 +45,7 @@ void MeshImpl::addVertex(const float x, const float y, const float z) {
 
 void MeshImpl::addFace(const initializer_list<unsigned>& vertexIds) {
     m_faces.emplace_back(vertexIds);
-    for (auto vertexId : vertexIds) {
-        m_vertices.at(vertexId).addFace(m_faces.size()-1);
-    }
+    m_vertexFaces.reset();
 }
 
 const Vertex& MeshImpl::getVertex(const unsigned vertexIndex) const {
@@ -60,6 +60,16 @@ const Face& MeshImpl::getFace(unsigned faceIndex) const {
     return m_faces.at(faceIndex);
 }
 
+void MeshImpl::buildVertexFaces() {
+    m_vertexFaces.emplace(static_cast<unsigned>(m_vertices.size()), m_faces);
+}
+
+std::span<unsigned const> MeshImpl::getVertexFaces(unsigned const vertexIndex) const {
+    // Built on first use after all faces are added
+    if (!m_vertexFaces) const_cast<MeshImpl*>(this)->buildVertexFaces();
+    return m_vertexFaces->getFaces(vertexIndex);
+}
+
 Bounds MeshImpl::getBounds() const {
     if (!m_bounds) {
         const_cast<MeshImpl*>(this)->buildBounds();
@@ -68,76 +78,41 @@ Bounds MeshImpl::getBounds() const {
 }
 
 void MeshImpl::buildBounds() {
-    m_bounds.emplace();
-    for (auto& v : m_vertices) {
-        if (v.x < m_bounds->x.min) m_bounds->x.min = v.x;
-        if (v.y < m_bounds->y.min) m_bounds->y.min = v.y;
-        if (v.z < m_bounds->z.min) m_bounds->z.min = v.z;
-
-        if (v.x > m_bounds->x.max) m_bounds->x.max = v.x;
-        if (v.y > m_bounds->y.max) m_bounds->y.max = v.y;
-        if (v.z > m_bounds->z.max) m_bounds->z.max = v.z;
-    }
+    // Vertex objects are not tightly packed. Reduce over the flat vertex data instead
+    auto const vertexData = getVertexData();
+    m_bounds = PointKernels::computeBounds(vertexData.getData(), m_vertices.size());
 }
 
 unsigned MeshImpl::removeDuplicateVertices() {
-    // Build octree for faster search
-    if (!m_octree) {
-        m_octree.emplace(*this);
-    }
-
-    // Compare each vertex against its neighbours and see
-    // if there is a duplicate in the neighborhood
-    unordered_set<VertexIndex> duplicateVertices;
-    unordered_map<VertexIndex, VertexIndex> remapEntries;
-    size_t numDuplicates = 0;
-    for (VertexIndex i = 0; i < m_vertices.size(); ++i) {
-        VertexIndices neighbors;
-        m_octree->getNeighboringVertices(i, neighbors);
-        for (size_t ni = 0; ni < neighbors.size(); ++ni) {
-            if (duplicateVertices.find(neighbors.at(ni)) == duplicateVertices.end() &&
-                neighbors.at(ni) != i &&
-                getVertex(neighbors.at(ni)) == getVertex(i)) {
-                cout << "Vertex at " << i << ' ' << getVertex(i)
-                               << " has a duplicate vertex at index " << neighbors.at(ni) << endl;
-                duplicateVertices.insert(i);
-                duplicateVertices.insert(neighbors.at(ni));
-                remapEntries.emplace(neighbors.at(ni), i);
-                ++numDuplicates;
-            }
-        }
-    }
-
-    // Find new indices for vertices to account for duplication
-    for (auto& remapEntry : remapEntries) {
-        // If vertex N were to removed as a duplicate, all vertices in the range
-        // [N+1, Number of vertices-1] should be shifted to the left
-        for (VertexIndex i = remapEntry.first; i < m_numVertices; ++i) {
-            if (remapEntries.find(i) == remapEntries.end())
-                remapEntries.emplace(i, remapEntries.find(i-1) == remapEntries.end() ? i-1 : remapEntries[i-1]-1);
-        }
-        if (remapEntries.find(remapEntry.second) != remapEntries.end()) {
-            remapEntry.second = remapEntries[remapEntry.second];
-        }
-        cout << "Vertex " << remapEntry.first << ":" << remapEntry.second << endl;
-    }
+    auto const vertexData = getVertexData();
+    VertexWelder const welder(vertexData.getData(), static_cast<unsigned>(m_vertices.size()));
+    auto const numDuplicates = static_cast<unsigned>(m_vertices.size()) - welder.getNumberOfWeldedVertices();
+    if (!numDuplicates) return 0;
+
+    // Point faces at the retained vertices and drop faces that collapsed
+    welder.weldFaces(m_faces);
+    m_numFaces = static_cast<unsigned>(m_faces.size());
+
+    // Rebuild vertices from the welded positions
+    VertexData weldedVertexData(welder.getNumberOfWeldedVertices());
+    welder.getWeldedPositions(weldedVertexData.getData());
+    auto const* weldedPositions = weldedVertexData.getData();
+    m_vertices.resize(welder.getNumberOfWeldedVertices());
+    for (size_t i = 0; i < m_vertices.size(); ++i) {
+        m_vertices[i] = Vertex(weldedPositions[3 * i], weldedPositions[3 * i + 1], weldedPositions[3 * i + 2]);
+    }
+    m_numVertices = static_cast<unsigned>(m_vertices.size());
+    m_vertexData = weldedVertexData;
+
+    // Derived data is stale
+    m_connectivity.reset();
+    m_vertexNormals.reset();
+    m_faceNormals.reset();
+    m_vertexFaces.reset();
 
-    // Execute remapping
-    for (auto& remapEntry : remapEntries) {
-        // TODO: Complete implementation of remap
-    }
     if (debug)
         cout << "Removed " << numDuplicates << " duplicate vertices" << endl;
-    return duplicateVertices.size();
-}
-
-Point3D MeshImpl::getCentroid() const {
-    if (!m_bounds) {
-        const_cast<MeshImpl*>(this)->buildBounds();
-    }
-    return { (this->m_bounds->x.max + this->m_bounds->x.min) * 0.5f,
-             (this->m_bounds->y.max + this->m_bounds->y.min) * 0.5f,
-             (this->m_bounds->z.max + this->m_bounds->z.min) * 0.5f };
+    return numDuplicates;
 }
 
 void MeshImpl::buildVertexData() {
@@ -175,14 +150,32 @@ void MeshImpl::getConnectivityData(size_t& numBytes, unsigned*& pConnData) const
 }
 
 std::unique_ptr<Mesh> MeshImpl::transform(common::TransformMatrix const& transformMatrix) const {
-    std::unique_ptr<Mesh> transformedMesh(new MeshImpl(*this));
-    auto& vertices = transformedMesh->getVertices();
-    for (auto& vertex : vertices) {
-        auto& v = const_cast<Vertex&>(vertex);
-        auto transformedVertex = transformMatrix * math3d::Vector4<float>{vertex.x, vertex.y, vertex.z, 1.0f};
-        v.x = transformedVertex.x;
-        v.y = transformedVertex.y;
-        v.z = transformedVertex.z;
+    auto transformedMesh = std::make_unique<MeshImpl>(*this);
+
+    // Transform the flat vertex data in one batch and write the results back to the vertex objects
+    auto const vertexData = getVertexData();
+    VertexData transformedVertexData(m_vertices.size());
+    PointKernels::transformPoints(transformMatrix, vertexData.getData(), m_vertices.size(),
+                                  transformedVertexData.getData());
+    auto const* transformedPositions = transformedVertexData.getData();
+    auto& transformedVertices = transformedMesh->m_vertices;
+    parallelFor(transformedVertices.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            transformedVertices[i].x = transformedPositions[3 * i];
+            transformedVertices[i].y = transformedPositions[3 * i + 1];
+            transformedVertices[i].z = transformedPositions[3 * i + 2];
+        }
+    });
+    transformedMesh->m_vertexData = transformedVertexData;
+
+    // Cached normals are carried over so that the transformed mesh doesn't have to recompute them
+    if (m_faceNormals && m_vertexNormals) {
+        transformedMesh->m_faceNormals = NormalData(m_numFaces);
+        PointKernels::transformNormals(transformMatrix, m_faceNormals->getData(), m_numFaces,
+                                       transformedMesh->m_faceNormals->getData());
+        transformedMesh->m_vertexNormals = NormalData(m_numVertices);
+        PointKernels::transformNormals(transformMatrix, m_vertexNormals->getData(), m_numVertices,
+                                       transformedMesh->m_vertexNormals->getData());
     }
     return transformedMesh;
 }
@@ -214,158 +207,21 @@ void MeshImpl::writeToSTL(std::string const& fileName) const {
     ofs.close();
 }
 
-void MeshImpl::generateVertexNormals() {
-    if (m_vertexNormals) return;
-    m_vertexNormals = NormalData(m_numVertices);
-    for (size_t i = 0; i < m_numVertices; ++i) {
-        auto normal = m_vertices.at(i).getNormal(*this);
-        m_vertexNormals->append(normal[0], normal[1], normal[2]);
-    }
-}
-
-void MeshImpl::generateFaceNormals() {
-    if (m_faceNormals) return;
+void MeshImpl::generateNormals() {
+    // Face normals are computed once and both normal caches are filled together
+    auto const vertexData = getVertexData();
     m_faceNormals = NormalData(m_numFaces);
-    for (size_t i = 0; i < m_numFaces; ++i) {
-        auto normal = m_faces.at(i).getNormal(*this);
-        m_faceNormals->append(normal[0], normal[1], normal[2]);
-    }
-}
-
-MeshImpl::NormalData MeshImpl::getNormals(const NormalLocation location) const {
-    if (location == NormalLocation::Vertex) {
-        if (!m_vertexNormals)
-            const_cast<MeshImpl*>(this)->generateVertexNormals();
-        return m_vertexNormals.value();
-    } else {
-        if (!m_faceNormals)
-            const_cast<MeshImpl*>(this)->generateFaceNormals();
-        return m_faceNormals.value();
-    }
-}
-
-void MeshImpl::generateRenderData() {
-
-    if (readyToRender) return;
-
-    // Compile and link shaders
-    createShaderProgram();
-
-    // Switch to mesh shader program
-    glUseProgram(shaderProgram);
-
-    // Create mesh vertex array object
-    glGenVertexArrays(1, &vertexArrayObject);
-    glBindVertexArray(vertexArrayObject);
-
-    // Create mesh vertex buffer object
-    GLuint meshVbo;
-    glGenBuffers(1, &meshVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, meshVbo);
-
-    // Push vertex data to graphics card
-    const auto vertexData = getVertexData();
-    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexData.getDataSize()), vertexData.getData(),
-                 GL_STATIC_DRAW);
-
-    // Define layout of vertex data
-    GLint posAttrib = glGetAttribLocation(shaderProgram, "vertexModel");
-    glEnableVertexAttribArray(posAttrib);
-    glVertexAttribPointer(posAttrib,            //attrib identifier
-                          3,                    //number of values for this attribute
-                          GL_FLOAT,             //data type
-                          GL_FALSE,             //data normalization status
-                          3 * sizeof(float),      //stride--each vertex has 3 float entries
-                          nullptr               //offset into the array
-    );
-
-    // Create VBO for normals
-    GLuint meshNormalsVbo;
-    glGenBuffers(1, &meshNormalsVbo);
-
-    // Make the normals vertex buffer object the current buffer
-    glBindBuffer(GL_ARRAY_BUFFER, meshNormalsVbo);
-
-    // Upload normals to the vertex buffer object
-    auto const normalData = getNormals(common::NormalLocation::Vertex);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(normalData.getDataSize()), normalData.getData(), GL_STATIC_DRAW);
-
-    // Define layout of normal data
-    GLint normalAttrib = glGetAttribLocation(shaderProgram, "vertexNormalModel");
-    glEnableVertexAttribArray(normalAttrib);
-    glVertexAttribPointer(normalAttrib,         //attrib identifier
-                          3,                    //number of values for this attribute
-                          GL_FLOAT,             //data type
-                          GL_FALSE,             //data normalization status
-                          3 * sizeof(float),      //stride--each normal has 3 float entries
-                          nullptr                     //offset into the array
-    );
-
-    // Define element data
-    // Create element buffer object
-    glGenBuffers(1, &elementBufferObject);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferObject);
-
-    // Upload connectivity data to element buffer object
-    size_t numBytes;
-    GLuint *faceData;
-    getConnectivityData(numBytes, faceData);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(numBytes), faceData, GL_STATIC_DRAW);
-
-    generateColors();
-    readyToRender = true;
-
-    // TODO: Dump member data buffers
-}
+    MeshNormals::computeFaceNormals(vertexData.getData(), m_faces, m_faceNormals->getData());
 
-void MeshImpl::generateColors() {
-    if (readyToRender) return;
-
-    auto& cfgReader = config::ConfigurationReader::getInstance();
-
-    // Set mesh colors
-    GLint diffuseColorId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.diffuseColor");
-    glCallWithErrorCheck(glUniform3fv, diffuseColorId, 1, cfgReader.getColor("MeshDiffuseColor", true).getData());
-    GLint ambientColorId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.ambientColor");
-    glCallWithErrorCheck(glUniform3fv, ambientColorId, 1, cfgReader.getColor("MeshAmbientColor", true).getData());
-    GLint specularColorId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.specularColor");
-    glCallWithErrorCheck(glUniform3fv, specularColorId, 1, cfgReader.getColor("MeshSpecularColor", true).getData());
-    GLint shininessId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.shininess");
-    glCallWithErrorCheck(glUniform1f, shininessId, std::atof(cfgReader.getValue("MeshShininess").c_str()));
-
-    // TODO: This moves to the viewport.
-    // Set light position in view coordinates
-    // The default light is a simple headlight that's positioned at the
-    // camera's location. Camera in GL is considered to be global origin
-    GLint lightPosId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "light.position");
-    glCallWithErrorCheck(glUniform3fv, lightPosId, 1, cfgReader.getVector("LightPosition").getData());
-
-    // Set light intensity
-    GLint lightIntensityId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "light.color");
-    glCallWithErrorCheck(glUniform3fv, lightIntensityId, 1, cfgReader.getColor("LightColor", true).getData());
+    if (!m_vertexFaces) buildVertexFaces();
+    m_vertexNormals = NormalData(m_numVertices);
+    MeshNormals::accumulateFaceNormals(m_vertexFaces.value(), m_faceNormals->getData(), m_vertexNormals->getData());
 }
 
-void MeshImpl::render() {
-
-    if (!readyToRender) {
-        generateRenderData();
-    }
-
-    glUseProgram(shaderProgram);
-
-    // Send matrices to the shader
-    setTransforms();
-
-    glBindVertexArray(vertexArrayObject);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferObject);
-#ifndef EMSCRIPTEN
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-#endif
-    glDrawElements(GL_TRIANGLES,
-                   static_cast<int>(m_numFaces*3),              // Number of entries in the connectivity array
-                   GL_UNSIGNED_INT,                              // Type of element buffer data
-                   nullptr                                     // Offset into element buffer data
-                  );
+MeshImpl::NormalData MeshImpl::getNormals(const NormalLocation location) const {
+    if (!m_vertexNormals || !m_faceNormals)
+        const_cast<MeshImpl*>(this)->generateNormals();
+    return location == NormalLocation::Vertex ? m_vertexNormals.value() : m_faceNormals.value();
 }
 
 unsigned MeshImpl::getNumberOfVertices() const  { return m_numVertices; };
@@ -378,13 +234,4 @@ Mesh::Vertices const& MeshImpl::getVertices() const { return m_vertices; }
 // Gets all faces in this mesh
 Mesh::Faces const& MeshImpl::getConnectivity() const { return m_faces; }
 
-void MeshImpl::writeToFile(std::string const& fileName, common::TransformMatrix const& transform) const {
-    std::filesystem::path filePath = fileName;
-    if (filePath.extension() == ".STL" || filePath.extension() == ".stl") {
-        this->transform(transform)->writeToSTL(fileName);
-    } else {
-        throw std::runtime_error("Currently, only STL output for meshes is supported.");
-    }
-}
-
 }
@@ -1,12 +1,11 @@
 #pragma once
 
-#include "Mesh.h"
-#include "Drawable3D.h"
-#include "Octree.h"
+#include "RenderableMesh.h"
+#include "VertexFaceAdjacency.h"
 
 namespace mv {
 
-    class MeshImpl : public Mesh {
+    class MeshImpl : public RenderableMesh {
 
     public:
         MeshImpl();
@@ -20,11 +19,6 @@ namespace mv {
         //       Define move constructor
         //
 
-        void render() override;
-
-        [[nodiscard]]
-        bool supportsGlyphs() const override { return true; }
-
         void initialize(unsigned numVertices, unsigned numFaces) override;
 
         void addVertex(float x, float y, float z) override;
@@ -58,13 +52,13 @@ namespace mv {
         [[nodiscard]]
         const Face &getFace(unsigned faceIndex) const override;
 
-        // Gets the bounds of the mesh
+        // Gets the indices of the faces that share the specified vertex
         [[nodiscard]]
-        common::Bounds getBounds() const override;
+        std::span<unsigned const> getVertexFaces(unsigned vertexIndex) const override;
 
-        // Gets the centroid of the mesh
+        // Gets the bounds of the mesh
         [[nodiscard]]
-        common::Point3D getCentroid() const override;
+        common::Bounds getBounds() const override;
 
         // Gets vertices
         [[nodiscard]]
@@ -84,37 +78,30 @@ namespace mv {
         [[nodiscard]]
         NormalData getNormals(common::NormalLocation) const override;
 
-        void writeToFile(std::string const &fileName, common::TransformMatrix const &transform) const override;
-
-    protected:
-        void generateRenderData() override;
-
-        void generateColors() override;
-
     private:
         unsigned m_numVertices;
         unsigned m_numFaces;
         Vertices m_vertices;
         Faces m_faces;
         std::optional<common::Bounds> m_bounds;
-        std::optional<Octree> m_octree;
         std::unique_ptr<unsigned> m_connectivity;
         size_t m_connectivityDataSize;
         std::optional<NormalData> m_vertexNormals;
         std::optional<NormalData> m_faceNormals;
         std::optional<VertexData> m_vertexData;
+        std::optional<VertexFaceAdjacency> m_vertexFaces;
 
     private:
         void buildConnectivityData();
 
         void buildBounds();
 
-        void generateVertexNormals();
-
-        void generateFaceNormals();
+        void generateNormals();
 
         void buildVertexData();
 
+        void buildVertexFaces();
+
     };
 
 }
\ No newline at end of file
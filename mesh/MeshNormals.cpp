@@ -0,0 +1,107 @@
+#include "MeshNormals.h"
+#include "Face.h"
+#include "Parallel.h"
+#include "VertexFaceAdjacency.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace std;
+
+namespace mv {
+
+using namespace common;
+
+namespace {
+    // Work per thread below which thread startup costs more than it saves
+    constexpr size_t minimumItemsPerThread = 16384;
+
+    // Writes the unit normal of the triangle ABC to normal. Matches Face::getNormal, which
+    // computes the normal as AB x BC
+    inline void computeTriangleNormal(float const* A, float const* B, float const* C, float* normal) {
+        float const ab[3] {B[0] - A[0], B[1] - A[1], B[2] - A[2]};
+        float const bc[3] {C[0] - B[0], C[1] - B[1], C[2] - B[2]};
+        float n[3] {ab[1] * bc[2] - ab[2] * bc[1],
+                    ab[2] * bc[0] - ab[0] * bc[2],
+                    ab[0] * bc[1] - ab[1] * bc[0]};
+        auto const length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        auto const scale = length > 0.f ? 1.f / length : 0.f;
+        normal[0] = n[0] * scale;
+        normal[1] = n[1] * scale;
+        normal[2] = n[2] * scale;
+    }
+}
+
+void MeshNormals::computeFaceNormals(float const* positions, span<unsigned const> const triangles,
+                                     float* faceNormals) {
+    parallelFor(triangles.size() / 3, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            auto const* triangle = triangles.data() + 3 * i;
+            computeTriangleNormal(positions + 3 * triangle[0], positions + 3 * triangle[1],
+                                  positions + 3 * triangle[2], faceNormals + 3 * i);
+        }
+    }, minimumItemsPerThread);
+}
+
+void MeshNormals::computeFaceNormals(float const* positions, vector<Face> const& faces, float* faceNormals) {
+    parallelFor(faces.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            auto const& face = faces[i];
+            if (face.size() < 3) {
+                fill_n(faceNormals + 3 * i, 3, 0.f);
+                continue;
+            }
+            computeTriangleNormal(positions + 3 * face.data()[0], positions + 3 * face.data()[1],
+                                  positions + 3 * face.data()[2], faceNormals + 3 * i);
+        }
+    }, minimumItemsPerThread);
+}
+
+bool MeshNormals::hasUnsharedVertices(unsigned const numVertices, span<unsigned const> const triangles) {
+    if (triangles.size() != numVertices) return false;
+    atomic<bool> unshared {true};
+    parallelFor(triangles.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end && unshared.load(memory_order_relaxed); ++i) {
+            if (triangles[i] != i) {
+                unshared.store(false, memory_order_relaxed);
+            }
+        }
+    }, minimumItemsPerThread);
+    return unshared;
+}
+
+void MeshNormals::copyFaceNormalsToVertices(unsigned const numFaces, float const* faceNormals, float* vertexNormals) {
+    parallelFor(numFaces, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            auto const* faceNormal = faceNormals + 3 * i;
+            auto* triangleNormals = vertexNormals + 9 * i;
+            for (int j = 0; j < 9; ++j) {
+                triangleNormals[j] = faceNormal[j % 3];
+            }
+        }
+    }, minimumItemsPerThread);
+}
+
+void MeshNormals::accumulateFaceNormals(VertexFaceAdjacency const& vertexFaces, float const* faceNormals,
+                                        float* vertexNormals) {
+    // Each vertex gathers the normals of its faces, so threads never write to the same vertex
+    parallelFor(vertexFaces.getNumberOfVertices(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            float sum[3] {};
+            for (auto faceIndex : vertexFaces.getFaces(static_cast<unsigned>(i))) {
+                auto const* faceNormal = faceNormals + 3 * faceIndex;
+                sum[0] += faceNormal[0];
+                sum[1] += faceNormal[1];
+                sum[2] += faceNormal[2];
+            }
+            auto const length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+            auto const scale = length > 0.f ? 1.f / length : 0.f;
+            auto* vertexNormal = vertexNormals + 3 * i;
+            vertexNormal[0] = sum[0] * scale;
+            vertexNormal[1] = sum[1] * scale;
+            vertexNormal[2] = sum[2] * scale;
+        }
+    }, minimumItemsPerThread);
+}
+
+}
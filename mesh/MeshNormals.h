@@ -0,0 +1,40 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+namespace mv {
+
+class Face;
+class VertexFaceAdjacency;
+
+// Normal kernels that work on flat x,y,z position and normal buffers. A mesh computes its face normals
+// once and derives its vertex normals from them instead of recomputing the normals of incident faces
+// for every vertex. Large inputs are processed across threads
+class MeshNormals {
+    public:
+        // Computes the unit normal of each triangle. triangles holds vertex index triples. Uses the same
+        // convention as Face::getNormal. Degenerate triangles get a zero normal
+        static void computeFaceNormals(float const* positions, std::span<unsigned const> triangles,
+                                       float* faceNormals);
+
+        // Computes the unit normal of the plane through the first three vertices of each face. Faces with
+        // fewer than three vertices get a zero normal
+        static void computeFaceNormals(float const* positions, std::vector<Face> const& faces, float* faceNormals);
+
+        // Checks if the triangles use every vertex exactly once and in order, which is how meshes read from
+        // STL files are laid out until their duplicate vertices are removed
+        [[nodiscard]]
+        static bool hasUnsharedVertices(unsigned numVertices, std::span<unsigned const> triangles);
+
+        // Sets the normal of each vertex of a mesh with unshared vertices to the normal of the triangle
+        // the vertex belongs to
+        static void copyFaceNormalsToVertices(unsigned numFaces, float const* faceNormals, float* vertexNormals);
+
+        // Sets the normal of each vertex to the normalized sum of the normals of its faces. Vertices that
+        // are not part of any face get a zero normal
+        static void accumulateFaceNormals(VertexFaceAdjacency const& vertexFaces, float const* faceNormals,
+                                          float* vertexNormals);
+};
+
+}
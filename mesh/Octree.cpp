@@ -1,180 +1,747 @@
 #include "Octree.h"
 #include "Mesh.h"
-#include "Util.h"
+#include "Parallel.h"
 #include <algorithm>
-#include <numeric>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <queue>
 using namespace std;
 
 namespace mv {
 
 using namespace common;
 
-// Initialize static variable
-Octree* Octree::Octant::sm_octree = nullptr;
+namespace {
+    // Work per thread below which thread startup costs more than it saves
+    constexpr size_t minimumItemsPerThread = 65536;
+    constexpr size_t minimumQueriesPerThread = 256;
+
+    // Meshes with more vertices than this get 63 bit Morton codes (21 levels) instead of 30 bit codes (10 levels)
+    constexpr size_t maximumVerticesForShortCodes = 1 << 20;
+
+    // Levels of the Morton grid below the root it was placed over. It matches the resolution of 63 bit Morton codes,
+    // and leaves are not split below it
+    constexpr int gridBits = 21;
+
+    // Levels the root can grow by before grid cells no longer fit in 63 bits
+    constexpr int maximumGridLevels = 62;
+
+    // Marks the absence of an octant, e.g. the parent of the root
+    constexpr unsigned noOctant = std::numeric_limits<unsigned>::max();
+
+    // Slot of a vertex that is not in the octree
+    constexpr unsigned noSlot = std::numeric_limits<unsigned>::max();
+
+    // Octants are split and grown geometrically, which needs a root that has an extent along every axis.
+    // Axes along which the mesh is flat get the extent of the mesh's largest axis
+    Bounds getRootBounds(Bounds bounds) {
+        auto length = std::max({bounds.x.length(), bounds.y.length(), bounds.z.length()});
+        if (length <= 0.f) length = 1.f;
+        for (auto* extents : {&bounds.x, &bounds.y, &bounds.z}) {
+            if (extents->length() <= 0.f) extents->max = extents->min + length;
+        }
+        return bounds;
+    }
+
+    // Spreads the lower 21 bits of value so that there are two zero bits between every bit
+    inline uint64_t spreadBits(uint64_t value) {
+        value &= 0x1fffff;
+        value = (value | value << 32) & 0x1f00000000ffff;
+        value = (value | value << 16) & 0x1f0000ff0000ff;
+        value = (value | value << 8) & 0x100f00f00f00f00f;
+        value = (value | value << 4) & 0x10c30c30c30c30c3;
+        value = (value | value << 2) & 0x1249249249249249;
+        return value;
+    }
+
+    inline float getSquaredDistance(float const* a, float const* b) {
+        auto const dx = a[0] - b[0];
+        auto const dy = a[1] - b[1];
+        auto const dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // Squared distance from a point to the closest point of a box. Zero when the point is inside the box
+    inline float getSquaredDistance(Bounds const& bounds, float const* point) {
+        auto getAxisDistance = [](auto const& extents, float const value) {
+            return value < extents.min ? extents.min - value : (value > extents.max ? value - extents.max : 0.f);
+        };
+        auto const dx = getAxisDistance(bounds.x, point[0]);
+        auto const dy = getAxisDistance(bounds.y, point[1]);
+        auto const dz = getAxisDistance(bounds.z, point[2]);
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // Stable least significant digit radix sort of keys that carries values along. Each pass histograms
+    // contiguous ranges of the input on separate threads and then scatters each range to the offsets its
+    // histogram reserved, which keeps the sort stable. Passes over digits that are the same for all keys are
+    // skipped, which is common for the high digits of Morton codes
+    template<typename Key>
+    void radixSort(vector<Key>& keys, vector<unsigned>& values) {
+        constexpr unsigned digitBits = 8;
+        constexpr size_t numDigits = 1 << digitBits;
+        auto const count = keys.size();
+        vector<Key> sortedKeys(count);
+        vector<unsigned> sortedValues(count);
+        vector<array<size_t, numDigits>> histograms(getNumberOfRanges(count, minimumItemsPerThread));
+
+        for (unsigned shift = 0; shift < sizeof(Key) * 8; shift += digitBits) {
+            parallelFor(count, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+                auto& histogram = histograms[rangeIndex];
+                histogram.fill(0);
+                for (auto i = begin; i < end; ++i) {
+                    ++histogram[(keys[i] >> shift) & (numDigits - 1)];
+                }
+            }, minimumItemsPerThread);
+
+            // Turn the histograms into scatter offsets. Digits are ordered first and ranges second
+            size_t offset = 0;
+            bool isDigitShared = false;
+            for (size_t digit = 0; digit < numDigits && !isDigitShared; ++digit) {
+                size_t numKeysWithDigit = 0;
+                for (auto& histogram : histograms) {
+                    auto const numKeys = histogram[digit];
+                    histogram[digit] = offset;
+                    offset += numKeys;
+                    numKeysWithDigit += numKeys;
+                }
+                isDigitShared = numKeysWithDigit == count;
+            }
+            if (isDigitShared) continue;
+
+            parallelFor(count, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+                auto& offsets = histograms[rangeIndex];
+                for (auto i = begin; i < end; ++i) {
+                    auto const position = offsets[(keys[i] >> shift) & (numDigits - 1)]++;
+                    sortedKeys[position] = keys[i];
+                    sortedValues[position] = values[i];
+                }
+            }, minimumItemsPerThread);
+            keys.swap(sortedKeys);
+            values.swap(sortedValues);
+        }
+    }
+}
 
 Octree::Octree(Mesh& mesh, const unsigned maxVerticesInOctant) :
     m_mesh(mesh),
     m_maxVerticesInOctant(maxVerticesInOctant),
-    m_depth(1) {
-    
-    // All octants share a pointer to this parent octree
-    // to keep per octant overhead to a minimum
-    Octree::Octant::sm_octree = this;
-
-    // NOTE: Create the root octant after setting the static member
-    // variable in Octant. The constructor of Octant relies on
-    // this static variable being set so it can get hold of
-    // the mesh reference from the static pointer variable
-    m_root = Octree::Octant(nullptr, {}, 0);
-
-    // Build the octree by recursively subdividing octants
-    m_root.subdivide();
-}
-
-void Octree::getNeighboringVertices(const VertexIndex vertexIndex, common::VertexIndices& neighbors) {
-    
-    // Find the leaf octant containing the vertex and copy all
-    // vertices in that leaf octant into the result
-    Octree::Octant::LeafOctants leafOctants;
-    getLeafOctants(m_root, leafOctants); 
-    neighbors.clear();
-    neighbors.reserve(leafOctants.size() * m_maxVerticesInOctant);
-    for (auto leafOctant : leafOctants) {
-        if (leafOctant.get().hasVertex(vertexIndex)) {
-            copy(leafOctant.get().m_vertices.begin(), leafOctant.get().m_vertices.end(), std::back_inserter(neighbors));
+    m_positions(mesh.getVertexData()),
+    m_rootLevel(0) {
+
+    auto const numVertices = m_mesh.getNumberOfVertices();
+    auto const rootBounds = numVertices ? getRootBounds(m_mesh.getBounds()) : Bounds{};
+    m_octants.emplace_back(Octant(rootBounds, 0, noOctant, 0, numVertices));
+    countOctants(0, 1);
+    resetGrid();
+    if (isDebugOn()) cerr << "Creating root octant with bounds " << m_octants.front().m_bounds;
+
+    if (numVertices > maximumVerticesForShortCodes) {
+        build<uint64_t>(21);
+    } else {
+        build<uint32_t>(10);
+    }
+}
+
+template<typename MortonCode>
+void Octree::build(unsigned const bitsPerAxis) {
+    auto const numVertices = getRoot().m_end;
+
+    // Codes with fewer bits per axis than the grid drop the finest levels of the cell, so their digits
+    // are the bits of the cell that getChildIndex selects children by
+    auto getMortonCode = [&](float const* point) {
+        auto const cell = getGridCell(point);
+        uint64_t code = 0;
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            code |= spreadBits(cell[axis] >> (gridBits - bitsPerAxis)) << axis;
+        }
+        return static_cast<MortonCode>(code);
+    };
+
+    // Sort vertices by Morton code
+    vector<MortonCode> codes(numVertices);
+    m_vertices.resize(numVertices);
+    parallelFor(numVertices, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            codes[i] = getMortonCode(getPosition(static_cast<unsigned>(i)));
+            m_vertices[i] = static_cast<unsigned>(i);
+        }
+    }, minimumItemsPerThread);
+    radixSort(codes, m_vertices);
+
+    // Split octants breadth first. Children of an octant partition its range of sorted codes by the
+    // three code bits of the child level
+    for (unsigned i = 0; i < m_octants.size(); ++i) {
+        auto const begin = m_octants[i].m_begin;
+        auto const end = m_octants[i].m_end;
+        m_octants[i].m_numVertices = end - begin;
+        if (end - begin <= m_maxVerticesInOctant) {
+            if (isDebugOn()) cerr << "Number of vertices in octant is " << end - begin << ". Termination criteria met." << endl;
+            continue;
+        }
+        auto const childLevel = static_cast<unsigned>(m_octants[i].m_level + 1);
+        if (childLevel > bitsPerAxis) {
+            if (isDebugOn()) cerr << "Octant at level " << m_octants[i].m_level << " is at the resolution of the tree. Cannot subdivide." << endl;
+            continue;
+        }
+
+        if (isDebugOn()) cerr << "Subdividing Octant at level " << m_octants[i].m_level << endl;
+        auto const firstChild = createChildren(i);
+        auto const childShift = 3 * (bitsPerAxis - childLevel);
+        auto childBegin = codes.begin() + begin;
+        for (unsigned childIndex = 0; childIndex < 8; ++childIndex) {
+            auto const childEnd = std::partition_point(childBegin, codes.begin() + end,
+                [&](MortonCode const code) { return ((code >> childShift) & 7) <= childIndex; });
+            m_octants[firstChild + childIndex].m_begin = static_cast<unsigned>(childBegin - codes.begin());
+            m_octants[firstChild + childIndex].m_end = static_cast<unsigned>(childEnd - codes.begin());
+            childBegin = childEnd;
+        }
+    }
+
+    // Vertices of a leaf are kept in ascending order regardless of their Morton order
+    m_vertexSlots.resize(numVertices);
+    parallelFor(m_octants.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            auto const& octant = m_octants[i];
+            if (octant.isLeaf() && octant.m_numVertices) {
+                std::sort(m_vertices.begin() + octant.m_begin, m_vertices.begin() + octant.m_end);
+                for (auto slot = octant.m_begin; slot < octant.m_end; ++slot) {
+                    m_vertexSlots[m_vertices[slot]] = slot;
+                }
+            }
+        }
+    }, 1024);
+}
+
+void Octree::resetGrid() {
+    auto& root = m_octants.front();
+    auto getScale = [](auto const& extents) {
+        return extents.length() > 0.f ? static_cast<float>(1u << gridBits) / extents.length() : 0.f;
+    };
+    root.m_level = m_rootLevel = 0;
+    m_gridOrigin = {root.m_bounds.x.min, root.m_bounds.y.min, root.m_bounds.z.min};
+    m_gridScale = {getScale(root.m_bounds.x), getScale(root.m_bounds.y), getScale(root.m_bounds.z)};
+    m_rootCell = {};
+}
+
+Octree::GridCell Octree::getGridCell(float const* point) const {
+    // Points on the upper bounds of the root belong to its last cell
+    auto const lastCell = static_cast<double>((int64_t{1} << (gridBits - m_rootLevel)) - 1);
+    GridCell cell;
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        auto const value = std::floor(static_cast<double>((point[axis] - m_gridOrigin[axis]) * m_gridScale[axis]));
+        cell[axis] = static_cast<uint64_t>(std::clamp(value - static_cast<double>(m_rootCell[axis]), 0., lastCell));
+    }
+    return cell;
+}
+
+unsigned Octree::getChildIndex(GridCell const& cell, int const childLevel) {
+    auto const shift = gridBits - childLevel;
+    return static_cast<unsigned>(((cell[0] >> shift) & 1) | ((cell[1] >> shift) & 1) << 1 |
+                                 ((cell[2] >> shift) & 1) << 2);
+}
+
+unsigned Octree::findLeaf(float const* point) const {
+    auto const cell = getGridCell(point);
+    unsigned octantIndex = 0;
+    while (!m_octants[octantIndex].isLeaf()) {
+        auto const& octant = m_octants[octantIndex];
+        octantIndex = octant.m_firstChild + getChildIndex(cell, octant.m_level + 1);
+    }
+    return octantIndex;
+}
+
+unsigned Octree::findLeaf(unsigned const slot) const {
+    unsigned octantIndex = 0;
+    while (!m_octants[octantIndex].isLeaf()) {
+        octantIndex = m_octants[octantIndex].m_firstChild;
+        while (slot >= m_octants[octantIndex].m_end) ++octantIndex;
+    }
+    return octantIndex;
+}
+
+bool Octree::hasVertex(unsigned const vertexIndex) const {
+    return vertexIndex < m_vertexSlots.size() && m_vertexSlots[vertexIndex] != noSlot;
+}
+
+void Octree::getNeighboringVertices(const VertexIndex vertexIndex, common::VertexIndices& neighbors) const {
+    if (!hasVertex(vertexIndex))
+        throw std::runtime_error("Vertex index invalid");
+
+    // Copy all vertices in the leaf octant that contains the vertex into the result
+    auto const leafVertices = getVertices(m_octants[findLeaf(m_vertexSlots[vertexIndex])]);
+    neighbors.assign(leafVertices.begin(), leafVertices.end());
+}
+
+std::span<unsigned const> Octree::getOctantVertices(Point3D const& point) const {
+    if (!getRoot().m_numVertices || !getRoot().contains(point.getData())) {
+        return {};
+    }
+    return getVertices(m_octants[findLeaf(point.getData())]);
+}
+
+void Octree::getVerticesInRadius(Point3D const& point, float const radius, VertexIndices& result) const {
+    if (radius < 0.f)
+        throw std::runtime_error("Search radius cannot be negative");
+
+    result.clear();
+    auto const* queryPoint = point.getData();
+    auto const squaredRadius = radius * radius;
+
+    // Depth first traversal that skips octants whose bounds are outside the search sphere
+    vector<unsigned> octantsToVisit {0};
+    while (!octantsToVisit.empty()) {
+        auto const& octant = m_octants[octantsToVisit.back()];
+        octantsToVisit.pop_back();
+        if (!octant.m_numVertices || getSquaredDistance(octant.m_bounds, queryPoint) > squaredRadius) {
+            continue;
+        }
+        if (octant.isLeaf()) {
+            for (auto vertex : getVertices(octant)) {
+                if (getSquaredDistance(getPosition(vertex), queryPoint) <= squaredRadius) {
+                    result.push_back(vertex);
+                }
+            }
+        } else {
+            for (unsigned i = 0; i < 8; ++i) {
+                octantsToVisit.push_back(octant.m_firstChild + i);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+}
+
+void Octree::getNearestVertices(Point3D const& point, unsigned const k, VertexIndices& result) const {
+    result.clear();
+    if (!k) return;
+
+    auto const* queryPoint = point.getData();
+
+    // Best first traversal. Octants are visited in the order of their distance from the point, and the
+    // k nearest vertices seen so far are kept in a bounded max-heap. The search ends when the nearest
+    // unvisited octant is farther than the k-th nearest vertex
+    using Candidate = std::pair<float, unsigned>;
+    std::priority_queue<Candidate> nearestVertices;
+    std::priority_queue<Candidate, vector<Candidate>, std::greater<>> octantsToVisit;
+    octantsToVisit.emplace(getSquaredDistance(getRoot().m_bounds, queryPoint), 0);
+    while (!octantsToVisit.empty()) {
+        auto const [octantDistance, octantIndex] = octantsToVisit.top();
+        octantsToVisit.pop();
+        if (nearestVertices.size() == k && octantDistance > nearestVertices.top().first) {
             break;
         }
+        auto const& octant = m_octants[octantIndex];
+        if (octant.isLeaf()) {
+            for (auto vertex : getVertices(octant)) {
+                Candidate const candidate {getSquaredDistance(getPosition(vertex), queryPoint), vertex};
+                if (nearestVertices.size() < k) {
+                    nearestVertices.push(candidate);
+                } else if (candidate < nearestVertices.top()) {
+                    nearestVertices.pop();
+                    nearestVertices.push(candidate);
+                }
+            }
+        } else {
+            for (auto i = octant.m_firstChild; i < octant.m_firstChild + 8; ++i) {
+                if (m_octants[i].m_numVertices) {
+                    octantsToVisit.emplace(getSquaredDistance(m_octants[i].m_bounds, queryPoint), i);
+                }
+            }
+        }
+    }
+
+    result.resize(nearestVertices.size());
+    for (auto itr = result.rbegin(); itr != result.rend(); ++itr) {
+        *itr = nearestVertices.top().second;
+        nearestVertices.pop();
     }
 }
 
-// xmin --> x.min
-// ymin --> y.min
-// xmax --> x.max
+void Octree::getVerticesInRadius(std::span<Point3D const> points, float const radius,
+                                 vector<VertexIndices>& results) const {
+    results.resize(points.size());
+    parallelFor(points.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            getVerticesInRadius(points[i], radius, results[i]);
+        }
+    }, minimumQueriesPerThread);
+}
 
-bool Octree::Octant::hasVertex(const unsigned vertexIndex) const {
-    const Vertex& vertex = getMesh().getVertex(vertexIndex); 
-    return 
-        Util::isGreaterOrEqual(vertex.x, m_bounds.x.min) &&
-        Util::isLessOrEqual(vertex.x, m_bounds.x.max) &&
-        Util::isGreaterOrEqual(vertex.y, m_bounds.y.min) &&
-        Util::isLessOrEqual(vertex.y, m_bounds.y.max) &&
-        Util::isGreaterOrEqual(vertex.z, m_bounds.z.min) &&
-        Util::isLessOrEqual(vertex.z, m_bounds.z.max);
+void Octree::getNearestVertices(std::span<Point3D const> points, unsigned const k,
+                                vector<VertexIndices>& results) const {
+    results.resize(points.size());
+    parallelFor(points.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            getNearestVertices(points[i], k, results[i]);
+        }
+    }, minimumQueriesPerThread);
 }
 
-Octree::Octant::LeafOctants Octree::getLeafOctants() {
-    Octree::Octant::LeafOctants leaves;
-    getLeafOctants(m_root, leaves);
-    return leaves;
+void Octree::insertVertex(unsigned const vertexIndex) {
+    if (hasVertex(vertexIndex))
+        throw std::runtime_error("Vertex " + std::to_string(vertexIndex) + " is already in the octree");
+
+    m_positions = m_mesh.getVertexData();
+    auto const numVertices = m_mesh.getNumberOfVertices();
+    if (vertexIndex >= numVertices)
+        throw std::runtime_error("Vertex " + std::to_string(vertexIndex) + " is not in the mesh");
+    if (m_vertexSlots.size() < numVertices) {
+        m_vertexSlots.resize(numVertices, noSlot);
+    }
+
+    auto const* point = getPosition(vertexIndex);
+    if (!getRoot().contains(point)) {
+        growRoot(point);
+    }
+
+    // The vertex takes the first free slot of its leaf, and the vertices after it in ascending order move up by one
+    auto const leafIndex = findLeaf(point);
+    if (!m_octants[leafIndex].getNumberOfFreeSlots()) {
+        makeFreeSlot(leafIndex);
+    }
+    auto const leafBegin = m_vertices.begin() + m_octants[leafIndex].m_begin;
+    auto const leafEnd = leafBegin + m_octants[leafIndex].m_numVertices;
+    auto const position = std::upper_bound(leafBegin, leafEnd, vertexIndex);
+    std::copy_backward(position, leafEnd, leafEnd + 1);
+    *position = vertexIndex;
+    for (auto itr = position; itr <= leafEnd; ++itr) {
+        m_vertexSlots[*itr] = static_cast<unsigned>(itr - m_vertices.begin());
+    }
+    for (auto octantIndex = leafIndex; octantIndex != noOctant; octantIndex = m_octants[octantIndex].m_parent) {
+        ++m_octants[octantIndex].m_numVertices;
+    }
+
+    splitLeaf(leafIndex);
 }
 
-void Octree::getLeafOctants(Octree::Octant& octant, Octree::Octant::LeafOctants& leafOctants) {
-    // An octant is a leaf if it doesn't have any children. We further restrict the definition
-    // by including only those leaves that have at least one vertex in them
-    bool hasChildren = std::any_of(octant.m_childOctants.begin(), octant.m_childOctants.end(),
-                                   [](auto& childOctant) { return childOctant != nullptr; });
-    if (!hasChildren && !octant.m_vertices.empty()) {
-        leafOctants.push_back(std::ref(octant));
+void Octree::removeVertex(unsigned const vertexIndex) {
+    if (!hasVertex(vertexIndex))
+        throw std::runtime_error("Vertex " + std::to_string(vertexIndex) + " is not in the octree");
+
+    m_positions = m_mesh.getVertexData();
+    auto const vertexSlot = m_vertexSlots[vertexIndex];
+    auto const leafIndex = findLeaf(vertexSlot);
+    auto const leafEnd = m_octants[leafIndex].m_begin + m_octants[leafIndex].m_numVertices;
+    std::copy(m_vertices.begin() + vertexSlot + 1, m_vertices.begin() + leafEnd, m_vertices.begin() + vertexSlot);
+    for (auto slot = vertexSlot; slot + 1 < leafEnd; ++slot) {
+        m_vertexSlots[m_vertices[slot]] = slot;
+    }
+    m_vertexSlots[vertexIndex] = noSlot;
+    for (auto octantIndex = leafIndex; octantIndex != noOctant; octantIndex = m_octants[octantIndex].m_parent) {
+        --m_octants[octantIndex].m_numVertices;
+    }
+
+    mergeAncestors(leafIndex);
+}
+
+void Octree::moveVertex(unsigned const vertexIndex) {
+    if (!hasVertex(vertexIndex))
+        throw std::runtime_error("Vertex " + std::to_string(vertexIndex) + " is not in the octree");
+
+    m_positions = m_mesh.getVertexData();
+    if (vertexIndex >= m_mesh.getNumberOfVertices())
+        throw std::runtime_error("Vertex " + std::to_string(vertexIndex) + " is not in the mesh");
+
+    // Vertices that stay inside their leaf keep their slot
+    auto const* point = getPosition(vertexIndex);
+    if (getRoot().contains(point) && findLeaf(point) == findLeaf(m_vertexSlots[vertexIndex])) {
         return;
-    } else {
-        for(auto& childOctant : octant.m_childOctants) {
-            if (childOctant) {
-                getLeafOctants(*childOctant.get(), leafOctants);
-            } 
+    }
+    removeVertex(vertexIndex);
+    insertVertex(vertexIndex);
+}
+
+void Octree::placeVertices(std::span<unsigned const> const vertices, unsigned slot) {
+    for (auto vertex : vertices) {
+        m_vertices[slot] = vertex;
+        m_vertexSlots[vertex] = slot++;
+    }
+}
+
+void Octree::makeFreeSlot(unsigned const leafIndex) {
+    // Spreading the free slots of an ancestor that has only a few of them would soon have to be repeated, so the
+    // nearest ancestor with at least a quarter of its range free is used. Without one, the range of the root grows
+    // to twice its size
+    auto hasEnoughFreeSlots = [](Octant const& octant) {
+        auto const freeSlots = octant.getNumberOfFreeSlots();
+        return freeSlots && 4 * freeSlots >= octant.m_end - octant.m_begin;
+    };
+    auto octantIndex = m_octants[leafIndex].m_parent;
+    while (octantIndex != noOctant && !hasEnoughFreeSlots(m_octants[octantIndex])) {
+        octantIndex = m_octants[octantIndex].m_parent;
+    }
+    if (octantIndex == noOctant) {
+        m_vertices.resize(std::max<size_t>({2 * m_vertices.size(), m_maxVerticesInOctant, 1}));
+        m_octants.front().m_end = static_cast<unsigned>(m_vertices.size());
+        octantIndex = 0;
+    }
+    spreadFreeSlots(octantIndex, leafIndex);
+}
+
+void Octree::spreadFreeSlots(unsigned const octantIndex, unsigned const leafIndex) {
+    // Octants below the octant in depth first order, which is the order of their ranges
+    vector<unsigned> octants;
+    vector<unsigned> octantsToVisit {octantIndex};
+    unsigned numLeaves = 0;
+    while (!octantsToVisit.empty()) {
+        auto const& octant = m_octants[octantsToVisit.back()];
+        octants.push_back(octantsToVisit.back());
+        octantsToVisit.pop_back();
+        if (octant.isLeaf()) {
+            ++numLeaves;
+        } else {
+            for (auto i = octant.m_firstChild + 8; i-- > octant.m_firstChild;) {
+                octantsToVisit.push_back(i);
+            }
+        }
+    }
+
+    vector<unsigned> vertices;
+    vertices.reserve(m_octants[octantIndex].m_numVertices);
+    for (auto index : octants) {
+        auto const leafVertices = getVertices(m_octants[index]);
+        vertices.insert(vertices.end(), leafVertices.begin(), leafVertices.end());
+    }
+
+    auto const freeSlots = m_octants[octantIndex].getNumberOfFreeSlots();
+    auto slot = m_octants[octantIndex].m_begin;
+    std::span<unsigned const> remainingVertices {vertices};
+    for (auto index : octants) {
+        auto& octant = m_octants[index];
+        if (!octant.isLeaf()) continue;
+        placeVertices(remainingVertices.first(octant.m_numVertices), slot);
+        remainingVertices = remainingVertices.subspan(octant.m_numVertices);
+        octant.m_begin = slot;
+        slot += octant.m_numVertices + freeSlots / numLeaves + (index == leafIndex ? freeSlots % numLeaves : 0);
+        octant.m_end = slot;
+    }
+
+    // Octants with children cover the ranges of their children
+    for (auto itr = octants.rbegin(); itr != octants.rend(); ++itr) {
+        auto& octant = m_octants[*itr];
+        if (!octant.isLeaf()) {
+            octant.m_begin = m_octants[octant.m_firstChild].m_begin;
+            octant.m_end = m_octants[octant.m_firstChild + 7].m_end;
         }
     }
 }
 
-Octree::Octant::Octant(Octant* parent, const Bounds& bounds, unsigned level) :
-    m_level(level) {
-    
-    if (parent) {
-        if (sm_octree->isDebugOn()) cerr << "Creating child octant at level " << m_level << " with bounds " << bounds;
-        
-        // Set bounds
-        m_bounds = bounds;
-        // Initialize this octant with vertices that are inside this octant
-        populate(parent->m_vertices); 
+unsigned Octree::createChildren(unsigned const octantIndex) {
+    // Reuse octants released by a merge before growing the octant array
+    unsigned firstChild;
+    if (!m_freeOctants.empty()) {
+        firstChild = m_freeOctants.back();
+        m_freeOctants.pop_back();
     } else {
-        // Since this is the root octant its bounds should be that of the mesh
-        m_bounds = getMesh().getBounds();
-        // All vertices in the mesh belong in the root octant
-        m_vertices.resize(getMesh().getVertices().size());
-        iota(m_vertices.begin(), m_vertices.end(), 0); 
-        
-        if (sm_octree->isDebugOn()) cerr << "Creating root octant with bounds " << m_bounds;
-    }
-}
-
-void Octree::Octant::populate(const VertexIndices& parentVertices) {
-    
-    // Allocate enough memory for maximum possible vertex list
-    m_vertices.reserve(parentVertices.size());
-
-    // Copy vertices in the parent that reside inside this child octant
-    // NOTE: uses back_inserter to be able to push_back into m_vertices
-    copy_if(parentVertices.begin(), parentVertices.end(), 
-            std::back_inserter(m_vertices), [&parentVertices, this](auto vertIndex) {
-                
-                // Skip vertices that were previously added to other octants
-                if (sm_octree->m_levelToVerticesMap[m_level].find(vertIndex) != 
-                    sm_octree->m_levelToVerticesMap[m_level].end()) {
-                        if (sm_octree->isDebugOn()) 
-                            cerr << "Skipping vertex " << vertIndex << " that was added to level " << m_level << " already" << endl;
-                        return false;
-                }
-                
-                // Check vertex against octant bounds
-                bool vertexInOctant = hasVertex(vertIndex); 
-                
-                // Flag vertices that are within any octant in the current tree level 
-                if (vertexInOctant) {
-
-                    sm_octree->m_levelToVerticesMap[m_level].insert(vertIndex);
-                    
-                    if (sm_octree->isDebugOn())
-                        cerr << "Adding vertex (index = " << vertIndex << " coordinates = "
-                             << sm_octree->m_mesh.getVertex(vertIndex) << ") to octant" << endl;
-                }
-                
-                return vertexInOctant;
-        });
-    // Release extra memory
-    m_vertices.shrink_to_fit();
+        firstChild = static_cast<unsigned>(m_octants.size());
+        m_octants.resize(m_octants.size() + 8, Octant(Bounds{}, 0, noOctant));
+    }
+
+    auto& octant = m_octants[octantIndex];
+    for (auto octantId : Octant::OctantIdIterator()) {
+        m_octants[firstChild + static_cast<unsigned>(octantId)] =
+            Octant(octant.getChildOctantBounds(octantId), octant.m_level + 1, octantIndex);
+        if (isDebugOn()) cerr << "Creating child octant at level " << octant.m_level + 1 << " with bounds " << m_octants[firstChild + static_cast<unsigned>(octantId)].m_bounds;
+    }
+    octant.m_firstChild = firstChild;
+    countOctants(octant.m_level + 1, 8);
+    return firstChild;
+}
+
+void Octree::releaseChildren(unsigned const octantIndex) {
+    auto& octant = m_octants[octantIndex];
+    for (auto i = octant.m_firstChild; i < octant.m_firstChild + 8; ++i) {
+        m_octants[i] = Octant(Bounds{}, 0, noOctant);
+    }
+    m_freeOctants.push_back(octant.m_firstChild);
+    octant.m_firstChild = 0;
+    countOctants(octant.m_level + 1, -8);
 }
 
-void Octree::Octant::subdivide() {
+void Octree::splitLeaf(unsigned const octantIndex) {
+    if (m_octants[octantIndex].m_numVertices <= m_maxVerticesInOctant ||
+        m_octants[octantIndex].m_level >= gridBits) {
+        return;
+    }
 
-    if (sm_octree->isDebugOn()) {
-        cerr << "Subdividing Octant at level " << m_level << endl;
+    auto const firstChild = createChildren(octantIndex);
+    auto const& octant = m_octants[octantIndex];
+    vector<unsigned> const vertices(m_vertices.begin() + octant.m_begin,
+                                    m_vertices.begin() + octant.m_begin + octant.m_numVertices);
+    vector<unsigned char> childIndices(vertices.size());
+    std::array<unsigned, 8> nextSlots {};
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        childIndices[i] = static_cast<unsigned char>(
+            getChildIndex(getGridCell(getPosition(vertices[i])), octant.m_level + 1));
+        ++m_octants[firstChild + childIndices[i]].m_numVertices;
     }
 
-    // Terminte subdivision if the termination criteria is met 
-    if (m_vertices.size() <= sm_octree->m_maxVerticesInOctant) { 
-        if (sm_octree->isDebugOn()) cerr << "Number of vertices in octant is " << m_vertices.size() << ". Termination criteria met." << endl;
+    // Children divide the range of the leaf and share its free slots
+    auto const freeSlots = octant.getNumberOfFreeSlots();
+    auto slot = octant.m_begin;
+    for (unsigned i = 0; i < 8; ++i) {
+        auto& child = m_octants[firstChild + i];
+        child.m_begin = nextSlots[i] = slot;
+        slot += child.m_numVertices + freeSlots / 8 + (i == 7 ? freeSlots % 8 : 0);
+        child.m_end = slot;
+    }
+    // Vertices are distributed in ascending order, so the vertices of the children are sorted as well
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        placeVertices({&vertices[i], 1}, nextSlots[childIndices[i]]++);
+    }
+
+    // All vertices might be in the same child
+    for (auto childIndex = firstChild; childIndex < firstChild + 8; ++childIndex) {
+        splitLeaf(childIndex);
+    }
+}
+
+void Octree::mergeAncestors(unsigned const octantIndex) {
+    // Octants with few vertices become leaves again. Merging only below half the split threshold keeps
+    // vertices that move back and forth across the threshold from repeatedly splitting and merging octants.
+    // Every octant with children has more vertices than that, so the children of a merged octant are leaves
+    for (auto parentIndex = m_octants[octantIndex].m_parent;
+         parentIndex != noOctant && m_octants[parentIndex].m_numVertices <= m_maxVerticesInOctant / 2;
+         parentIndex = m_octants[parentIndex].m_parent) {
+        // The ranges of the children divide the range of the parent, so their vertices fit at its beginning
+        auto const& parent = m_octants[parentIndex];
+        vector<unsigned> vertices;
+        vertices.reserve(parent.m_numVertices);
+        for (auto childIndex = parent.m_firstChild; childIndex < parent.m_firstChild + 8; ++childIndex) {
+            auto const childVertices = getVertices(m_octants[childIndex]);
+            vertices.insert(vertices.end(), childVertices.begin(), childVertices.end());
+        }
+        std::sort(vertices.begin(), vertices.end());
+        placeVertices(vertices, parent.m_begin);
+        releaseChildren(parentIndex);
+    }
+}
+
+void Octree::growRoot(float const* point) {
+    // An empty octree moves to the point
+    auto& root = m_octants.front();
+    if (!root.m_numVertices && root.isLeaf()) {
+        auto const length = root.m_bounds.x.max > root.m_bounds.x.min ?
+            std::max({root.m_bounds.x.length(), root.m_bounds.y.length(), root.m_bounds.z.length()}) : 1.f;
+        root.m_bounds = {{point[0] - length / 2, point[1] - length / 2, point[2] - length / 2},
+                         {point[0] + length / 2, point[1] + length / 2, point[2] + length / 2}};
+        resetGrid();
         return;
     }
-    
-    // Increment tree depth
-    ++sm_octree->m_depth;
 
-    // Split this octant into 8 child octants
-    for (auto octantId : OctantIdIterator()) {
-        m_childOctants[static_cast<int>(octantId)].reset(new Octree::Octant(this, getChildOctantBounds(octantId), m_level+1));
+    // The root becomes a child of an octant that is twice as large and extends towards the point. This repeats
+    // until the point is inside the root
+    while (!m_octants.front().contains(point)) {
+        if (!m_octants.front().isLeaf() && gridBits - m_rootLevel >= maximumGridLevels)
+            throw std::runtime_error("Position is too far from the octree to grow its root to");
+        auto oldRoot = std::move(m_octants.front());
+        auto bounds = oldRoot.m_bounds;
+        auto rootCell = m_rootCell;
+        unsigned oldRootIndex = 0;
+        auto extend = [&](auto& extents, float const value, unsigned const axis) {
+            auto const length = extents.length();
+            if (value < extents.min) {
+                extents.min -= length;
+                rootCell[axis] -= int64_t{1} << (gridBits - m_rootLevel);
+                oldRootIndex |= 1 << axis;
+            } else {
+                extents.max += length;
+            }
+        };
+        extend(bounds.x, point[0], 0);
+        extend(bounds.y, point[1], 1);
+        extend(bounds.z, point[2], 2);
+
+        // A leaf root just covers more space. Growing it by adding a level would create an octant with
+        // children that has too few vertices to have been split
+        if (oldRoot.isLeaf()) {
+            oldRoot.m_bounds = bounds;
+            m_octants.front() = std::move(oldRoot);
+            resetGrid();
+            continue;
+        }
+
+        m_rootCell = rootCell;
+        --m_rootLevel;
+        m_numOctantsAtDepth.insert(m_numOctantsAtDepth.begin(), 0);
+        m_octants.front() = Octant(bounds, m_rootLevel, noOctant, oldRoot.m_begin, oldRoot.m_end);
+        m_octants.front().m_numVertices = oldRoot.m_numVertices;
+        countOctants(m_rootLevel, 1);
+        auto const firstChild = createChildren(0);
+        oldRootIndex += firstChild;
+        countOctants(m_rootLevel + 1, -1);
+
+        // The other children are empty and have empty ranges before or after the range of the old root
+        for (auto i = firstChild; i < firstChild + 8; ++i) {
+            m_octants[i].m_begin = m_octants[i].m_end = i < oldRootIndex ? oldRoot.m_begin : oldRoot.m_end;
+        }
+
+        // Octants that refer to the old root by index now refer to its new place
+        oldRoot.m_parent = 0;
+        for (auto i = oldRoot.m_firstChild; i < oldRoot.m_firstChild + 8; ++i) {
+            m_octants[i].m_parent = oldRootIndex;
+        }
+        m_octants[oldRootIndex] = std::move(oldRoot);
+    }
+}
+
+void Octree::countOctants(int const level, int const count) {
+    auto const depth = static_cast<size_t>(level - m_rootLevel);
+    if (depth >= m_numOctantsAtDepth.size()) {
+        m_numOctantsAtDepth.resize(depth + 1, 0);
     }
+    m_numOctantsAtDepth[depth] += count;
+    while (!m_numOctantsAtDepth.empty() && !m_numOctantsAtDepth.back()) {
+        m_numOctantsAtDepth.pop_back();
+    }
+}
 
-    // Once the vertex information is carried over from the parent to the children, it's time to remove
-    // them from the parent. Only the leaf octants should have vertices associated with them 
-    this->m_vertices.clear();
+std::span<unsigned const> Octree::getVertices(const Octree::Octant& octant) const {
+    if (!octant.isLeaf()) return {};
+    return {m_vertices.data() + octant.m_begin, octant.m_numVertices};
+}
+
+Octree::Octant::ChildOctants Octree::getChildren(const Octree::Octant& octant) const {
+    Octree::Octant::ChildOctants children {};
+    if (!octant.isLeaf()) {
+        for (unsigned i = 0; i < 8; ++i) {
+            children[i] = &m_octants[octant.m_firstChild + i];
+        }
+    }
+    return children;
+}
 
-    // Subdivide recursively
-    for (auto& childOctant : m_childOctants) {
-        childOctant->subdivide();
+Octree::Octant::LeafOctants Octree::getLeafOctants() const {
+    // An octant is a leaf if it doesn't have any children. We further restrict the definition
+    // by including only those leaves that have at least one vertex in them. This also excludes
+    // octants that were released by merges
+    Octree::Octant::LeafOctants leaves;
+    for (auto const& octant : m_octants) {
+        if (octant.isLeaf() && octant.m_numVertices) {
+            leaves.push_back(std::cref(octant));
+        }
     }
+    return leaves;
+}
+
+Octree::Octant::Octant(const Bounds& bounds, int level, unsigned parent, unsigned begin, unsigned end) :
+    m_bounds(bounds),
+    m_level(level),
+    m_parent(parent),
+    m_firstChild(0),
+    m_numVertices(0),
+    m_begin(begin),
+    m_end(end) {
+}
+
+bool Octree::Octant::contains(float const* point) const {
+    return point[0] >= m_bounds.x.min && point[0] <= m_bounds.x.max &&
+           point[1] >= m_bounds.y.min && point[1] <= m_bounds.y.max &&
+           point[2] >= m_bounds.z.min && point[2] <= m_bounds.z.max;
 }
 
-Bounds Octree::Octant::getChildOctantBounds(const OctantId childId) {
+Bounds Octree::Octant::getChildOctantBounds(const OctantId childId) const {
     switch (childId) {
         case OctantId::Bottom_Left_Back:
             return { {m_bounds.x.min, m_bounds.y.min, m_bounds.z.min}, {m_bounds.x.center(), m_bounds.y.center(), m_bounds.z.center()} };
@@ -193,7 +760,7 @@ Bounds Octree::Octant::getChildOctantBounds(const OctantId childId) {
         case OctantId::Top_Right_Front:
             return { {m_bounds.x.center(), m_bounds.y.center(), m_bounds.z.center()}, {m_bounds.x.max, m_bounds.y.max, m_bounds.z.max} };
         default:
-            throw std::runtime_error("Unknown octant id"); 
+            throw std::runtime_error("Unknown octant id");
     }
 }
 
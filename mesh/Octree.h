@@ -2,40 +2,75 @@
 #define OCTREE_H
 #include "Types.h"
 #include "MeshViewerObject.h"
+#include "Mesh.h"
 #include <array>
+#include <cstdint>
 #include <exception>
-#include <memory>
-#include <unordered_map>
-#include <unordered_set>
+#include <functional>
+#include <span>
+#include <vector>
 
 namespace mv {
 
-class Mesh;
-
+// A linear octree over the vertices of a mesh
+//
+// Vertices are assigned Morton codes by quantizing their positions to a 2^N x 2^N x 2^N grid over the mesh's bounds
+// and sorted by code with a parallel radix sort. Vertices in any octant are then contiguous in the sorted order, so
+// the tree is created top-down by splitting ranges of the sorted vertices that have more than the maximum number of
+// vertices per octant. Octants are stored in a flat array and refer to each other by index
+//
+// After construction, vertices can be inserted, removed and moved. Every octant's range of the sorted vertices is
+// split among its children, and a leaf keeps free slots after its vertices so that inserts don't move other leaves.
+// A leaf without free slots takes them from the nearest ancestor that has enough by spreading that ancestor's free
+// slots over its leaves again. Edits split overfull leaves, merge the children of octants that become underfull and
+// grow the root to contain new positions, so their cost depends on the size of the edit and not on the size of the
+// tree
 class Octree : public MeshViewerObject {
     public:
-        Octree(Mesh& mesh, const unsigned maxVerticesInOctant = 100); 
+        Octree(Mesh& mesh, const unsigned maxVerticesInOctant = 100);
         Mesh& getMesh() const { return m_mesh; }
-        unsigned char getDepth() const { return m_depth; }
-        void getNeighboringVertices(const unsigned vertexIndex, common::VertexIndices& neighbors); 
+        unsigned char getDepth() const { return static_cast<unsigned char>(m_numOctantsAtDepth.size()); }
+        unsigned getNumberOfVertices() const { return getRoot().m_numVertices; }
+        [[nodiscard]] bool hasVertex(unsigned vertexIndex) const;
+        void getNeighboringVertices(const unsigned vertexIndex, common::VertexIndices& neighbors) const;
+
+        // Spatial queries. Queries don't modify the octree, so any number of them can run concurrently
+
+        // Vertices of the leaf octant that contains the point. Points outside the octree's bounds are not in any octant
+        std::span<unsigned const> getOctantVertices(common::Point3D const& point) const;
+        // Vertices that are no farther than radius from the point, in ascending order
+        void getVerticesInRadius(common::Point3D const& point, float radius, common::VertexIndices& result) const;
+        // k vertices that are closest to the point, nearest first
+        void getNearestVertices(common::Point3D const& point, unsigned k, common::VertexIndices& result) const;
+
+        // Batched versions of the queries above that spread the points across threads. results[i] holds the result
+        // of the query for points[i]
+        void getVerticesInRadius(std::span<common::Point3D const> points, float radius,
+                                 std::vector<common::VertexIndices>& results) const;
+        void getNearestVertices(std::span<common::Point3D const> points, unsigned k,
+                                std::vector<common::VertexIndices>& results) const;
+
+        // Incremental updates. The octree reads vertex positions from the mesh instead of keeping a copy, so the
+        // mesh is edited first and the octree is then told which vertices changed. Each update reads the mesh's
+        // positions again, which picks up meshes whose positions were reallocated. Updates must not run
+        // concurrently with queries or other updates
+
+        // Adds a vertex of the mesh that is not in the octree
+        void insertVertex(unsigned vertexIndex);
+        void removeVertex(unsigned vertexIndex);
+        // Moves a vertex whose position in the mesh changed to the leaf of its new position
+        void moveVertex(unsigned vertexIndex);
 
     private:
         class Octant {
-            // Dummy default constructor to set the correct initialization
-            // order in Octree constructor
-            Octant() = default;
-
-            Octant(Octant* parent, const common::Bounds& bounds, unsigned level);
-            
-            // Reference to the mesh that this octree was built for
-            // NOTE: The pointer is static because we don't want to
-            // incur the extra overhead of a pointer for each Octant 
-            static Octree* sm_octree;
+            Octant(const common::Bounds& bounds, int level, unsigned parent, unsigned begin = 0, unsigned end = 0);
 
             // Bounds of this octant
             common::Bounds m_bounds;
 
-            // Enumeration holding child octant position identifiers
+            // Enumeration holding child octant position identifiers. Bits 0, 1 and 2 of an identifier
+            // select the upper half of the octant along x, y and z respectively, which matches the
+            // order in which Morton codes interleave the axes
             enum class OctantId : unsigned char {
                 Bottom_Left_Back,
                 Bottom_Right_Back,
@@ -46,35 +81,41 @@ class Octree : public MeshViewerObject {
                 Top_Left_Front,
                 Top_Right_Front
             };
-            
+
             // An iterator over the OctantId enumeration
             using OctantIdIterator = common::EnumIterator<OctantId, OctantId::Bottom_Left_Back, OctantId::Top_Right_Front>;
 
             // 8 child octants arranged in the order of enumeration OctantId
-            using OctantPtr = std::unique_ptr<Octant>;
-            using ChildOctants = std::array<OctantPtr, 8>;
-            ChildOctants m_childOctants;
+            using ChildOctants = std::array<Octant const*, 8>;
 
             // Alias for leaf octants
-            using LeafOctants = std::vector<std::reference_wrapper<Octant>>;
+            using LeafOctants = std::vector<std::reference_wrapper<Octant const>>;
+
+            // Level of this octant. Levels are relative to the level of the root, which decreases when the root grows
+            int m_level;
 
-            // Level of this octant within the Octree
-            unsigned m_level;
+            // Index of the parent octant in the octant array
+            unsigned m_parent;
 
-            // List of mesh vertices (by vertex index in the mesh) inside
-            // this octant
-            common::VertexIndices m_vertices;
+            // Index of the first of the 8 consecutive child octants in the octant array. The root is never
+            // a child, so 0 marks a leaf
+            unsigned m_firstChild;
 
-            void populate(const common::VertexIndices& parentVertices);
-            void subdivide();
-            common::Bounds getChildOctantBounds(const OctantId childId);
+            // Number of vertices inside this octant and its descendants
+            unsigned m_numVertices;
 
-            static Mesh& getMesh() { 
-                if (!sm_octree) throw std::runtime_error("Parent octree pointer is invalid!");
-                return sm_octree->getMesh();
-            }
+            // Range of slots in the sorted vertices. The ranges of the children partition the range of their
+            // parent. A leaf's vertices are at the beginning of its range in ascending order, and the rest of
+            // the range is free
+            unsigned m_begin;
+            unsigned m_end;
 
-            bool hasVertex(const unsigned vertexIndex) const;
+            [[nodiscard]] bool isLeaf() const { return !m_firstChild; }
+            [[nodiscard]] unsigned getNumberOfFreeSlots() const { return m_end - m_begin - m_numVertices; }
+
+            [[nodiscard]] bool contains(float const* point) const;
+
+            common::Bounds getChildOctantBounds(const OctantId childId) const;
 
             // Make the outer class a friend so, it can access data members of the inner class
             // The inner class members will be inaccessible to anyone using the outer class to
@@ -82,37 +123,87 @@ class Octree : public MeshViewerObject {
             // external code
             friend Octree;
 
-            friend std::ostream& operator << (std::ostream& os, Octree::Octant& octant);
+            friend std::ostream& operator << (std::ostream& os, Octree::Octant const& octant);
         };
 
-        friend std::ostream& operator << (std::ostream& os, Octree::Octant& octant);
+        friend std::ostream& operator << (std::ostream& os, Octree::Octant const& octant);
 
     public:
-        // Access to inner class data members. This is mostly for regression tests. 
-        const Octree::Octant& getRoot() const { return m_root; }
-        const common::Bounds& getBounds(const Octree::Octant& octant) { return octant.m_bounds; }
-        const common::VertexIndices& getVertices(const Octree::Octant& octant) { return octant.m_vertices; }
-        const Octree::Octant::ChildOctants& getChildren(const Octree::Octant& octant) { return octant.m_childOctants; } 
-        Octree::Octant::LeafOctants getLeafOctants();
-    
+        // Access to inner class data members. This is mostly for regression tests.
+        const Octree::Octant& getRoot() const { return m_octants.front(); }
+        const common::Bounds& getBounds(const Octree::Octant& octant) const { return octant.m_bounds; }
+        // Vertices inside a leaf octant in ascending order. Only leaf octants have vertices associated with them
+        std::span<unsigned const> getVertices(const Octree::Octant& octant) const;
+        // Children of an octant. Leaf octants have no children
+        Octree::Octant::ChildOctants getChildren(const Octree::Octant& octant) const;
+        Octree::Octant::LeafOctants getLeafOctants() const;
+
     private:
-        void getLeafOctants(Octree::Octant& octant, Octree::Octant::LeafOctants& leafOctants);
+        // Cell of the Morton grid that contains a point, relative to the first cell of the root. The build, point
+        // location and edits all select children by the bits of this cell, so they agree on points near split planes
+        using GridCell = std::array<uint64_t, 3>;
+
+        template<typename MortonCode>
+        void build(unsigned bitsPerAxis);
+
+        // Places the Morton grid over the bounds of a root that has no children
+        void resetGrid();
+        [[nodiscard]] GridCell getGridCell(float const* point) const;
+        // Position of the child octant at the level that contains the cell
+        [[nodiscard]] static unsigned getChildIndex(GridCell const& cell, int childLevel);
+
+        // Leaf octant that contains the point
+        [[nodiscard]] unsigned findLeaf(float const* point) const;
+        // Leaf octant whose range has the slot
+        [[nodiscard]] unsigned findLeaf(unsigned slot) const;
+        [[nodiscard]] float const* getPosition(unsigned vertexIndex) const {
+            return m_positions.getData() + 3 * size_t{vertexIndex};
+        }
+
+        // Copies vertices to slots and records their slots
+        void placeVertices(std::span<unsigned const> vertices, unsigned slot);
+        // Makes a free slot in a leaf that has none
+        void makeFreeSlot(unsigned leafIndex);
+        // Lays out the vertices of an octant's leaves in its range again with the octant's free slots spread evenly
+        // over the leaves. Free slots that don't divide evenly go to one leaf
+        void spreadFreeSlots(unsigned octantIndex, unsigned leafIndex);
+
+        // Creates 8 leaf children for an octant and returns the index of the first
+        unsigned createChildren(unsigned octantIndex);
+        void releaseChildren(unsigned octantIndex);
+        void splitLeaf(unsigned octantIndex);
+        void mergeAncestors(unsigned octantIndex);
+        void growRoot(float const* point);
+        void countOctants(int level, int count);
 
     private:
         Mesh& m_mesh;
         const unsigned m_maxVerticesInOctant;
-        Octree::Octant m_root;
-        using VertexIndexSet = std::unordered_set<unsigned>;
-        using LevelToVerticesMap = std::unordered_map<unsigned, VertexIndexSet>; 
-        LevelToVerticesMap m_levelToVerticesMap; 
-        unsigned char m_depth;
+        // Vertex positions as x, y, z triples, shared with the mesh
+        Mesh::VertexData m_positions;
+        // Octants of the tree. Root octant is the first
+        std::vector<Octree::Octant> m_octants;
+        // Vertices sorted so that the vertices of every octant are in the octant's range
+        std::vector<unsigned> m_vertices;
+        // Slot of every vertex in the sorted vertices. Vertices that are not in the octree have no slot
+        std::vector<unsigned> m_vertexSlots;
+        // Blocks of 8 octants that were released by merges and can be reused
+        std::vector<unsigned> m_freeOctants;
+        // Number of octants at each depth below the root, which gives the depth of the tree
+        std::vector<unsigned> m_numOctantsAtDepth;
+        int m_rootLevel;
+        // Morton grid. Cells are at the finest level, and the root covers 2^-rootLevel times as many cells per axis
+        // as the octree had when the grid was placed
+        std::array<float, 3> m_gridOrigin;
+        std::array<float, 3> m_gridScale;
+        std::array<int64_t, 3> m_rootCell;
 };
 
 
-inline std::ostream& operator << (std::ostream& os, Octree::Octant& octant) {
+inline std::ostream& operator << (std::ostream& os, Octree::Octant const& octant) {
     os << std::endl;
     os << "Level: " << octant.m_level << std::endl;
-    os << "Num Vertices: " << octant.m_vertices.size() << std::endl; 
+    os << "Num Vertices: " << octant.m_numVertices << std::endl;
     os << "Bounds " << octant.m_bounds << std::endl << std::endl;
     return os;
 }
@@ -0,0 +1,228 @@
+#include "PointKernels.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+// x86-64 builds target SSE2. AVX2 kernels are compiled alongside and picked at run time, so a single binary runs
+// everywhere and still uses the wider registers where they exist
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MV_AVX2_DISPATCH
+#endif
+
+using namespace std;
+
+namespace mv {
+
+using namespace common;
+
+namespace {
+    // Work per thread below which thread startup costs more than it saves
+    constexpr size_t minimumPointsPerThread = 65536;
+
+    struct Extents {
+        array<float, 3> minimum {numeric_limits<float>::max(), numeric_limits<float>::max(), numeric_limits<float>::max()};
+        array<float, 3> maximum {numeric_limits<float>::lowest(), numeric_limits<float>::lowest(), numeric_limits<float>::lowest()};
+
+        void add(float const* point) {
+            for (int i = 0; i < 3; ++i) {
+                minimum[i] = std::min(minimum[i], point[i]);
+                maximum[i] = std::max(maximum[i], point[i]);
+            }
+        }
+
+        void add(Extents const& another) {
+            add(another.minimum.data());
+            add(another.maximum.data());
+        }
+
+        // Folds lane-wise extents of consecutive x,y,z triples. Lane k holds component k % 3
+        template<size_t numLanes>
+        void addLanes(float const* minimumLanes, float const* maximumLanes) {
+            static_assert(numLanes % 3 == 0);
+            for (size_t k = 0; k < numLanes; ++k) {
+                minimum[k % 3] = std::min(minimum[k % 3], minimumLanes[k]);
+                maximum[k % 3] = std::max(maximum[k % 3], maximumLanes[k]);
+            }
+        }
+    };
+
+    // A block of N points is 3N floats, which fills exactly three N wide registers. Lane k of the registers
+    // then always holds the same component, so blocks can be reduced with plain vertical min/max and the
+    // components are separated once at the end. Each variant returns the number of points it reduced
+#if defined(__SSE__)
+    size_t addBlocksSSE(float const* points, size_t const numPoints, Extents& extents) {
+        constexpr size_t blockSize = 4;
+        if (numPoints < blockSize) return 0;
+        __m128 minimum[3] {_mm_loadu_ps(points), _mm_loadu_ps(points + 4), _mm_loadu_ps(points + 8)};
+        __m128 maximum[3] {minimum[0], minimum[1], minimum[2]};
+        size_t i = blockSize;
+        for (; i + blockSize <= numPoints; i += blockSize) {
+            auto const* block = points + 3 * i;
+            for (int r = 0; r < 3; ++r) {
+                auto const values = _mm_loadu_ps(block + 4 * r);
+                minimum[r] = _mm_min_ps(minimum[r], values);
+                maximum[r] = _mm_max_ps(maximum[r], values);
+            }
+        }
+        alignas(16) float minimumLanes[12], maximumLanes[12];
+        for (int r = 0; r < 3; ++r) {
+            _mm_store_ps(minimumLanes + 4 * r, minimum[r]);
+            _mm_store_ps(maximumLanes + 4 * r, maximum[r]);
+        }
+        extents.addLanes<12>(minimumLanes, maximumLanes);
+        return i;
+    }
+#endif
+
+#if defined(MV_AVX2_DISPATCH)
+    // Compiled for AVX2 whatever the target of the build is, and only called on processors that support it
+    __attribute__((target("avx2")))
+    size_t addBlocksAVX2(float const* points, size_t const numPoints, Extents& extents) {
+        constexpr size_t blockSize = 8;
+        if (numPoints < blockSize) return 0;
+        __m256 minimum[3] {_mm256_loadu_ps(points), _mm256_loadu_ps(points + 8), _mm256_loadu_ps(points + 16)};
+        __m256 maximum[3] {minimum[0], minimum[1], minimum[2]};
+        size_t i = blockSize;
+        for (; i + blockSize <= numPoints; i += blockSize) {
+            auto const* block = points + 3 * i;
+            for (int r = 0; r < 3; ++r) {
+                auto const values = _mm256_loadu_ps(block + 8 * r);
+                minimum[r] = _mm256_min_ps(minimum[r], values);
+                maximum[r] = _mm256_max_ps(maximum[r], values);
+            }
+        }
+        alignas(32) float minimumLanes[24], maximumLanes[24];
+        for (int r = 0; r < 3; ++r) {
+            _mm256_store_ps(minimumLanes + 8 * r, minimum[r]);
+            _mm256_store_ps(maximumLanes + 8 * r, maximum[r]);
+        }
+        extents.addLanes<24>(minimumLanes, maximumLanes);
+        return i;
+    }
+#endif
+
+    Extents computeExtents(float const* points, size_t const numPoints) {
+        Extents extents;
+        size_t i = 0;
+#if defined(MV_AVX2_DISPATCH)
+        static bool const hasAVX2 = __builtin_cpu_supports("avx2");
+        if (hasAVX2) {
+            i = addBlocksAVX2(points, numPoints, extents);
+        } else {
+            i = addBlocksSSE(points, numPoints, extents);
+        }
+#elif defined(__SSE__)
+        i = addBlocksSSE(points, numPoints, extents);
+#endif
+        for (; i < numPoints; ++i) {
+            extents.add(points + 3 * i);
+        }
+        return extents;
+    }
+
+    // Columns of the linear part and the translation of a transform matrix
+    struct AffineTransform {
+        alignas(16) float columns[4][4];
+
+        explicit AffineTransform(TransformMatrix const& transform) {
+            for (unsigned c = 0; c < 4; ++c) {
+                for (unsigned r = 0; r < 3; ++r) {
+                    columns[c][r] = transform[c][r];
+                }
+                columns[c][3] = 0.f;
+            }
+        }
+    };
+}
+
+Bounds PointKernels::computeBounds(float const* points, size_t const numPoints) {
+    if (!numPoints) return {};
+    vector<Extents> rangeExtents(getNumberOfRanges(numPoints, minimumPointsPerThread));
+    parallelFor(numPoints, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+        rangeExtents[rangeIndex] = computeExtents(points + 3 * begin, end - begin);
+    }, minimumPointsPerThread);
+    Extents extents;
+    for (auto const& e : rangeExtents) {
+        extents.add(e);
+    }
+    return {{extents.minimum[0], extents.minimum[1], extents.minimum[2]},
+            {extents.maximum[0], extents.maximum[1], extents.maximum[2]}};
+}
+
+void PointKernels::transformPoints(TransformMatrix const& transform, float const* points, size_t const numPoints,
+                                   float* transformedPoints) {
+    AffineTransform const affine(transform);
+    parallelFor(numPoints, [&](size_t const begin, size_t const end) {
+#if defined(__SSE__)
+        auto const c0 = _mm_load_ps(affine.columns[0]);
+        auto const c1 = _mm_load_ps(affine.columns[1]);
+        auto const c2 = _mm_load_ps(affine.columns[2]);
+        auto const c3 = _mm_load_ps(affine.columns[3]);
+        for (auto i = begin; i < end; ++i) {
+            auto const* point = points + 3 * i;
+            auto result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(point[0])),
+                                                _mm_mul_ps(c1, _mm_set1_ps(point[1]))),
+                                     _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(point[2])), c3));
+            // Write exactly three floats. A four float store would clobber the next point when transforming in place
+            auto* transformedPoint = transformedPoints + 3 * i;
+            _mm_storel_pi(reinterpret_cast<__m64*>(transformedPoint), result);
+            _mm_store_ss(transformedPoint + 2, _mm_movehl_ps(result, result));
+        }
+#else
+        auto const& m = affine.columns;
+        for (auto i = begin; i < end; ++i) {
+            auto const* point = points + 3 * i;
+            float const x = point[0], y = point[1], z = point[2];
+            auto* transformedPoint = transformedPoints + 3 * i;
+            transformedPoint[0] = m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0];
+            transformedPoint[1] = m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1];
+            transformedPoint[2] = m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2];
+        }
+#endif
+    }, minimumPointsPerThread);
+}
+
+void PointKernels::transformNormals(TransformMatrix const& transform, float const* normals, size_t const numNormals,
+                                    float* transformedNormals) {
+    // Cofactor matrix of the linear part. Column c of the cofactor matrix is the cross product of the two
+    // other columns of the linear part
+    float a[3][3];
+    for (unsigned c = 0; c < 3; ++c) {
+        for (unsigned r = 0; r < 3; ++r) {
+            a[c][r] = transform[c][r];
+        }
+    }
+    float cofactor[3][3];
+    for (unsigned c = 0; c < 3; ++c) {
+        auto const& u = a[(c + 1) % 3];
+        auto const& v = a[(c + 2) % 3];
+        cofactor[c][0] = u[1] * v[2] - u[2] * v[1];
+        cofactor[c][1] = u[2] * v[0] - u[0] * v[2];
+        cofactor[c][2] = u[0] * v[1] - u[1] * v[0];
+    }
+
+    parallelFor(numNormals, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            auto const* normal = normals + 3 * i;
+            float const x = normal[0], y = normal[1], z = normal[2];
+            float n[3];
+            for (unsigned r = 0; r < 3; ++r) {
+                n[r] = cofactor[0][r] * x + cofactor[1][r] * y + cofactor[2][r] * z;
+            }
+            auto const length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            auto const scale = length > 0.f ? 1.f / length : 0.f;
+            auto* transformedNormal = transformedNormals + 3 * i;
+            transformedNormal[0] = n[0] * scale;
+            transformedNormal[1] = n[1] * scale;
+            transformedNormal[2] = n[2] * scale;
+        }
+    }, minimumPointsPerThread);
+}
+
+}
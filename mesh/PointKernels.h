@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Types.h"
+#include "TransformMatrix.h"
+
+namespace mv {
+
+// Batch kernels over flat buffers of x,y,z triples. The kernels use SSE when the compiler targets it and AVX2 on
+// x86-64 processors that support it, fall back to scalar code elsewhere and split large inputs across threads
+class PointKernels {
+    public:
+        // Computes the axis aligned bounds of the points
+        [[nodiscard]]
+        static common::Bounds computeBounds(float const* points, size_t numPoints);
+
+        // Applies the affine part of the transform to the points. points and transformedPoints may be the
+        // same buffer
+        static void transformPoints(common::TransformMatrix const& transform, float const* points, size_t numPoints,
+                                    float* transformedPoints);
+
+        // Transforms unit normals by the inverse-transpose of the linear part of the transform and renormalizes
+        // them. The cofactor matrix is used in place of the inverse-transpose. The two differ only by the
+        // determinant, so normals flip under mirroring just like normals recomputed from the transformed faces
+        // would. normals and transformedNormals may be the same buffer
+        static void transformNormals(common::TransformMatrix const& transform, float const* normals, size_t numNormals,
+                                     float* transformedNormals);
+};
+
+}
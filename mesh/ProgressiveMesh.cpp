@@ -0,0 +1,169 @@
+#include "ProgressiveMesh.h"
+#include "ConfigurationReader.h"
+#include "PointKernels.h"
+#include <algorithm>
+
+namespace mv {
+
+using namespace common;
+
+namespace {
+    // Chunks uploaded per frame. A reader that outpaces the graphics card doesn't keep the viewer from responding
+    constexpr unsigned chunksPerFrame = 16;
+
+    constexpr size_t minimumBufferCapacity = 1 << 20;
+}
+
+ProgressiveMesh::ProgressiveMesh(std::shared_ptr<MeshChunkChannel> chunkChannel)
+: Drawable3D("ProgressiveMeshVertex.glsl", "ProgressiveMeshFragment.glsl", Effect::Fog)
+, chunkChannel(std::move(chunkChannel)) {}
+
+ProgressiveMesh::~ProgressiveMesh() {
+    // Previews are dropped once the mesh is read, so the memory they hold on the graphics card is given back
+    if (!shaderProgram) return;
+    glDeleteBuffers(1, &positionBuffer.id);
+    glDeleteBuffers(1, &indexBuffer.id);
+    glDeleteVertexArrays(1, &vertexArrayObject);
+    glDeleteProgram(shaderProgram);
+}
+
+Point3D ProgressiveMesh::getCentroid() const {
+    auto const bounds = getBounds();
+    return { (bounds.x.max + bounds.x.min) * 0.5f,
+             (bounds.y.max + bounds.y.min) * 0.5f,
+             (bounds.z.max + bounds.z.min) * 0.5f };
+}
+
+Bounds ProgressiveMesh::getBounds() const {
+    return bounds.value_or(Bounds{});
+}
+
+bool ProgressiveMesh::hasBounds() const {
+    return bounds.has_value();
+}
+
+bool ProgressiveMesh::requiresRedraw() const {
+    return !chunkChannel->isEmpty();
+}
+
+void ProgressiveMesh::generateRenderData() {
+
+    if (readyToRender) return;
+
+    // Buffers hold everything that has been read so far, so they are only created once
+    if (!shaderProgram) {
+        createShaderProgram();
+        glUseProgram(shaderProgram);
+        glGenVertexArrays(1, &vertexArrayObject);
+        glBindVertexArray(vertexArrayObject);
+        generateColors();
+    }
+
+    readyToRender = true;
+}
+
+void ProgressiveMesh::generateColors() {
+    auto& cfgReader = config::ConfigurationReader::getInstance();
+
+    GLint diffuseColorId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.diffuseColor");
+    glCallWithErrorCheck(glUniform3fv, diffuseColorId, 1, cfgReader.getColor("MeshDiffuseColor", true).getData());
+    GLint ambientColorId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.ambientColor");
+    glCallWithErrorCheck(glUniform3fv, ambientColorId, 1, cfgReader.getColor("MeshAmbientColor", true).getData());
+
+    GLint lightPosId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "light.position");
+    glCallWithErrorCheck(glUniform3fv, lightPosId, 1, cfgReader.getVector("LightPosition").getData());
+    GLint lightIntensityId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "light.color");
+    glCallWithErrorCheck(glUniform3fv, lightIntensityId, 1, cfgReader.getColor("LightColor", true).getData());
+}
+
+void ProgressiveMesh::update() {
+
+    if (!readyToRender) {
+        generateRenderData();
+    }
+
+    // The element buffer binding is part of the vertex array object, so it is bound before buffers are replaced
+    glBindVertexArray(vertexArrayObject);
+    for (unsigned i = 0; i < chunksPerFrame; ++i) {
+        auto chunk = chunkChannel->tryPop();
+        if (!chunk) break;
+        append(*chunk);
+    }
+}
+
+void ProgressiveMesh::render() {
+
+    if (!readyToRender) {
+        generateRenderData();
+    }
+
+    if (!indexBuffer.size) return;
+
+    glUseProgram(shaderProgram);
+
+    // Send matrices to the shader
+    setTransforms();
+
+    glBindVertexArray(vertexArrayObject);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.id);
+#ifndef EMSCRIPTEN
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+#endif
+    glDrawElements(GL_TRIANGLES,
+                   static_cast<GLsizei>(indexBuffer.size / sizeof(unsigned)),
+                   GL_UNSIGNED_INT,
+                   nullptr);
+}
+
+void ProgressiveMesh::append(MeshChunk const& chunk) {
+    if (!chunk.positions.empty()) {
+        auto const chunkBounds = PointKernels::computeBounds(chunk.positions.data(), chunk.positions.size() / 3);
+        if (!bounds) {
+            bounds = chunkBounds;
+        } else {
+            bounds->x.min = std::min(bounds->x.min, chunkBounds.x.min);
+            bounds->x.max = std::max(bounds->x.max, chunkBounds.x.max);
+            bounds->y.min = std::min(bounds->y.min, chunkBounds.y.min);
+            bounds->y.max = std::max(bounds->y.max, chunkBounds.y.max);
+            bounds->z.min = std::min(bounds->z.min, chunkBounds.z.min);
+            bounds->z.max = std::max(bounds->z.max, chunkBounds.z.max);
+        }
+        append(positionBuffer, GL_ARRAY_BUFFER, chunk.positions.data(), chunk.positions.size() * sizeof(float));
+    }
+    if (!chunk.indices.empty()) {
+        append(indexBuffer, GL_ELEMENT_ARRAY_BUFFER, chunk.indices.data(), chunk.indices.size() * sizeof(unsigned));
+    }
+}
+
+void ProgressiveMesh::append(Buffer& buffer, unsigned const target, void const* data, size_t const size) {
+    if (buffer.size + size > buffer.capacity) {
+        // Doubling the capacity copies each byte on the graphics card a constant number of times on average
+        auto const capacity = std::max({2 * buffer.capacity, buffer.size + size, minimumBufferCapacity});
+        GLuint grownBuffer;
+        glGenBuffers(1, &grownBuffer);
+        glBindBuffer(target, grownBuffer);
+        glBufferData(target, static_cast<GLsizeiptr>(capacity), nullptr, GL_DYNAMIC_DRAW);
+        if (buffer.size) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer.id);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, target, 0, 0, static_cast<GLsizeiptr>(buffer.size));
+        }
+        glDeleteBuffers(1, &buffer.id);
+        buffer.id = grownBuffer;
+        buffer.capacity = capacity;
+        if (target == GL_ARRAY_BUFFER) {
+            setPositionLayout();
+        }
+    } else {
+        glBindBuffer(target, buffer.id);
+    }
+    glBufferSubData(target, static_cast<GLintptr>(buffer.size), static_cast<GLsizeiptr>(size), data);
+    buffer.size += size;
+}
+
+void ProgressiveMesh::setPositionLayout() const {
+    GLint posAttrib = glGetAttribLocation(shaderProgram, "vertexModel");
+    glEnableVertexAttribArray(posAttrib);
+    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+}
+
+}
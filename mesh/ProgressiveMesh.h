@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Drawable3D.h"
+#include "MeshChunk.h"
+#include <memory>
+#include <optional>
+
+namespace mv {
+
+    // Draws a mesh while it is being read. Chunks that the reader hands over are appended to buffers on the graphics
+    // card, which grow as the mesh arrives. Chunks don't have normals, so the triangles are shaded flat
+    class ProgressiveMesh : public Drawable3D {
+
+    public:
+        explicit ProgressiveMesh(std::shared_ptr<MeshChunkChannel> chunkChannel);
+        ~ProgressiveMesh() override;
+
+        // Uploads the chunks that arrived since the last frame
+        void update() override;
+
+        void render() override;
+
+        [[nodiscard]]
+        common::Point3D getCentroid() const override;
+
+        // Bounds of the vertices that have been uploaded so far
+        [[nodiscard]]
+        common::Bounds getBounds() const override;
+
+        // There are no bounds until the first vertices are uploaded
+        [[nodiscard]]
+        bool hasBounds() const override;
+
+        // Chunks are waiting to be drawn
+        [[nodiscard]]
+        bool requiresRedraw() const override;
+
+        ProgressiveMesh(ProgressiveMesh const&) = delete;
+        ProgressiveMesh& operator=(ProgressiveMesh const&) = delete;
+
+    protected:
+        void generateRenderData() override;
+
+        void generateColors() override;
+
+    private:
+        struct Buffer {
+            unsigned id{};
+            size_t capacity{};
+            size_t size{};
+        };
+
+        // Uploads a chunk and grows the bounds by its vertices
+        void append(MeshChunk const& chunk);
+
+        // Appends bytes to a buffer. Buffers that are too small are replaced by buffers that are twice as large
+        void append(Buffer& buffer, unsigned target, void const* data, size_t size);
+
+        // Points the position attribute at the start of the position buffer
+        void setPositionLayout() const;
+
+    private:
+        std::shared_ptr<MeshChunkChannel> const chunkChannel;
+        Buffer positionBuffer;
+        Buffer indexBuffer;
+        std::optional<common::Bounds> bounds;
+    };
+
+}
@@ -0,0 +1,149 @@
+#include "RenderableMesh.h"
+#include "ConfigurationReader.h"
+#include <filesystem>
+
+namespace mv {
+
+using namespace common;
+
+Point3D RenderableMesh::getCentroid() const {
+    auto const bounds = getBounds();
+    return { (bounds.x.max + bounds.x.min) * 0.5f,
+             (bounds.y.max + bounds.y.min) * 0.5f,
+             (bounds.z.max + bounds.z.min) * 0.5f };
+}
+
+void RenderableMesh::generateRenderData() {
+
+    if (readyToRender) return;
+
+    // Compile and link shaders
+    createShaderProgram();
+
+    // Switch to mesh shader program
+    glUseProgram(shaderProgram);
+
+    // Create mesh vertex array object
+    glGenVertexArrays(1, &vertexArrayObject);
+    glBindVertexArray(vertexArrayObject);
+
+    // Create mesh vertex buffer object
+    GLuint meshVbo;
+    glGenBuffers(1, &meshVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVbo);
+
+    // Push vertex data to graphics card
+    const auto vertexData = getVertexData();
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexData.getDataSize()), vertexData.getData(),
+                 GL_STATIC_DRAW);
+
+    // Define layout of vertex data
+    GLint posAttrib = glGetAttribLocation(shaderProgram, "vertexModel");
+    glEnableVertexAttribArray(posAttrib);
+    glVertexAttribPointer(posAttrib,            //attrib identifier
+                          3,                    //number of values for this attribute
+                          GL_FLOAT,             //data type
+                          GL_FALSE,             //data normalization status
+                          3 * sizeof(float),      //stride--each vertex has 3 float entries
+                          nullptr               //offset into the array
+    );
+
+    // Create VBO for normals
+    GLuint meshNormalsVbo;
+    glGenBuffers(1, &meshNormalsVbo);
+
+    // Make the normals vertex buffer object the current buffer
+    glBindBuffer(GL_ARRAY_BUFFER, meshNormalsVbo);
+
+    // Upload normals to the vertex buffer object
+    auto const normalData = getNormals(common::NormalLocation::Vertex);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(normalData.getDataSize()), normalData.getData(), GL_STATIC_DRAW);
+
+    // Define layout of normal data
+    GLint normalAttrib = glGetAttribLocation(shaderProgram, "vertexNormalModel");
+    glEnableVertexAttribArray(normalAttrib);
+    glVertexAttribPointer(normalAttrib,         //attrib identifier
+                          3,                    //number of values for this attribute
+                          GL_FLOAT,             //data type
+                          GL_FALSE,             //data normalization status
+                          3 * sizeof(float),      //stride--each normal has 3 float entries
+                          nullptr                     //offset into the array
+    );
+
+    // Define element data
+    // Create element buffer object
+    glGenBuffers(1, &elementBufferObject);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferObject);
+
+    // Upload connectivity data to element buffer object
+    size_t numBytes;
+    GLuint *faceData;
+    getConnectivityData(numBytes, faceData);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(numBytes), faceData, GL_STATIC_DRAW);
+
+    generateColors();
+    readyToRender = true;
+
+    // TODO: Dump member data buffers
+}
+
+void RenderableMesh::generateColors() {
+    if (readyToRender) return;
+
+    auto& cfgReader = config::ConfigurationReader::getInstance();
+
+    // Set mesh colors
+    GLint diffuseColorId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.diffuseColor");
+    glCallWithErrorCheck(glUniform3fv, diffuseColorId, 1, cfgReader.getColor("MeshDiffuseColor", true).getData());
+    GLint ambientColorId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.ambientColor");
+    glCallWithErrorCheck(glUniform3fv, ambientColorId, 1, cfgReader.getColor("MeshAmbientColor", true).getData());
+    GLint specularColorId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.specularColor");
+    glCallWithErrorCheck(glUniform3fv, specularColorId, 1, cfgReader.getColor("MeshSpecularColor", true).getData());
+    GLint shininessId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "material.shininess");
+    glCallWithErrorCheck(glUniform1f, shininessId, std::atof(cfgReader.getValue("MeshShininess").c_str()));
+
+    // TODO: This moves to the viewport.
+    // Set light position in view coordinates
+    // The default light is a simple headlight that's positioned at the
+    // camera's location. Camera in GL is considered to be global origin
+    GLint lightPosId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "light.position");
+    glCallWithErrorCheck(glUniform3fv, lightPosId, 1, cfgReader.getVector("LightPosition").getData());
+
+    // Set light intensity
+    GLint lightIntensityId = glCallWithErrorCheck(glGetUniformLocation, shaderProgram, "light.color");
+    glCallWithErrorCheck(glUniform3fv, lightIntensityId, 1, cfgReader.getColor("LightColor", true).getData());
+}
+
+void RenderableMesh::render() {
+
+    if (!readyToRender) {
+        generateRenderData();
+    }
+
+    glUseProgram(shaderProgram);
+
+    // Send matrices to the shader
+    setTransforms();
+
+    glBindVertexArray(vertexArrayObject);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferObject);
+#ifndef EMSCRIPTEN
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+#endif
+    glDrawElements(GL_TRIANGLES,
+                   static_cast<int>(getNumberOfFaces()*3),      // Number of entries in the connectivity array
+                   GL_UNSIGNED_INT,                              // Type of element buffer data
+                   nullptr                                     // Offset into element buffer data
+                  );
+}
+
+void RenderableMesh::writeToFile(std::string const& fileName, common::TransformMatrix const& transform) const {
+    std::filesystem::path filePath = fileName;
+    if (filePath.extension() == ".STL" || filePath.extension() == ".stl") {
+        this->transform(transform)->writeToSTL(fileName);
+    } else {
+        throw std::runtime_error("Currently, only STL output for meshes is supported.");
+    }
+}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Mesh.h"
+
+namespace mv {
+
+    // Rendering logic that is common to all mesh implementations. Vertex, normal and connectivity
+    // data are obtained through the Mesh interface, so the storage scheme is left to the subclasses
+    class RenderableMesh : public Mesh {
+
+    public:
+        void render() override;
+
+        [[nodiscard]]
+        bool supportsGlyphs() const override { return true; }
+
+        // Gets the centroid of the mesh
+        [[nodiscard]]
+        common::Point3D getCentroid() const override;
+
+        void writeToFile(std::string const &fileName, common::TransformMatrix const &transform) const override;
+
+    protected:
+        void generateRenderData() override;
+
+        void generateColors() override;
+    };
+
+}
@@ -0,0 +1,294 @@
+#include "TriangleMesh.h"
+#include "MeshNormals.h"
+#include "PointKernels.h"
+#include "VertexWelder.h"
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+using namespace std;
+
+namespace mv {
+
+using namespace common;
+
+TriangleMesh::TriangleMesh()
+    : Drawable3D("MeshVertex.glsl", "Fragment.glsl", Effect::Fog)
+    , m_numVertices(0)
+    , m_numFaces(0)
+    , m_positions(0)
+    , m_verticesAdded(0)
+    , m_facesAdded(0) {
+
+}
+
+TriangleMesh::TriangleMesh(TriangleMesh const& another)
+    : Drawable3D(another.vertexShaderFileName, another.fragmentShaderFileName, Effect::Fog)
+    , m_numVertices(another.m_numVertices)
+    , m_numFaces(another.m_numFaces)
+    , m_positions(another.m_numVertices)
+    , m_indices(new unsigned[another.m_numFaces * 3])
+    , m_verticesAdded(another.m_verticesAdded)
+    , m_facesAdded(another.m_facesAdded)
+    , m_bounds(another.m_bounds)
+    // Normals are replaced rather than changed in place, so the copy shares them. This keeps normals that were
+    // supplied by a file
+    , m_vertexNormals(another.m_vertexNormals)
+    , m_faceNormals(another.m_faceNormals) {
+    memcpy(m_positions.getData(), another.m_positions.getData(), m_positions.getDataSize());
+    memcpy(m_indices.get(), another.m_indices.get(), m_numFaces * 3 * sizeof(unsigned));
+}
+
+void TriangleMesh::initialize(unsigned const numVertices, unsigned const numFaces) {
+    m_numVertices = numVertices;
+    m_numFaces = numFaces;
+    m_positions = VertexData(m_numVertices);
+    m_indices.reset(new unsigned[m_numFaces * 3]);
+    m_verticesAdded = 0;
+    m_facesAdded = 0;
+}
+
+void TriangleMesh::addVertex(float const x, float const y, float const z) {
+    if (m_verticesAdded == m_numVertices)
+        throw std::runtime_error("Cannot add vertex. Mesh was initialized with " +
+                                 std::to_string(m_numVertices) + " vertices");
+    auto* position = m_positions.getData() + 3 * m_verticesAdded++;
+    position[0] = x;
+    position[1] = y;
+    position[2] = z;
+}
+
+void TriangleMesh::addFace(initializer_list<unsigned> const& vertexIds) {
+    if (vertexIds.size() != 3)
+        throw std::runtime_error("Only triangle meshes are supported at this time");
+    if (m_facesAdded == m_numFaces)
+        throw std::runtime_error("Cannot add face. Mesh was initialized with " +
+                                 std::to_string(m_numFaces) + " faces");
+    std::copy(vertexIds.begin(), vertexIds.end(), m_indices.get() + 3 * m_facesAdded++);
+    m_vertexFaces.reset();
+}
+
+span<float> TriangleMesh::getPositionBuffer() {
+    m_verticesAdded = m_numVertices;
+    // Contents are about to change
+    m_bounds.reset();
+    m_vertexNormals.reset();
+    m_faceNormals.reset();
+    m_vertices.reset();
+    return {m_positions.getData(), size_t{m_numVertices} * 3};
+}
+
+span<unsigned> TriangleMesh::getIndexBuffer() {
+    m_facesAdded = m_numFaces;
+    m_vertexNormals.reset();
+    m_faceNormals.reset();
+    m_faces.reset();
+    m_vertexFaces.reset();
+    return {m_indices.get(), size_t{m_numFaces} * 3};
+}
+
+span<float> TriangleMesh::getVertexNormalBuffer() {
+    m_vertexNormals = NormalData(m_numVertices);
+    m_faceNormals.reset();
+    return {m_vertexNormals->getData(), size_t{m_numVertices} * 3};
+}
+
+bool TriangleMesh::setSharedBuffers(SharedBuffers const& buffers) {
+    m_numVertices = m_verticesAdded = buffers.numVertices;
+    m_numFaces = m_facesAdded = buffers.numFaces;
+    m_positions = VertexData(m_numVertices, buffers.positions);
+    m_indices = buffers.indices;
+    m_bounds = buffers.bounds;
+    m_vertexNormals.reset();
+    m_faceNormals.reset();
+    if (buffers.vertexNormals) m_vertexNormals = NormalData(m_numVertices, buffers.vertexNormals);
+    if (buffers.faceNormals) m_faceNormals = NormalData(m_numFaces, buffers.faceNormals);
+    m_vertices.reset();
+    m_faces.reset();
+    m_vertexFaces.reset();
+    return true;
+}
+
+Point3D TriangleMesh::getPosition(unsigned const vertexIndex) const {
+    auto const* position = m_positions.getData() + 3 * vertexIndex;
+    return {position[0], position[1], position[2]};
+}
+
+unsigned TriangleMesh::removeDuplicateVertices() {
+    VertexWelder const welder(m_positions.getData(), m_numVertices);
+    auto const numDuplicates = m_numVertices - welder.getNumberOfWeldedVertices();
+    if (!numDuplicates) return 0;
+
+    // Point connectivity at the retained vertices and drop triangles that collapsed
+    auto const numFaces = welder.weldTriangles({m_indices.get(), m_numFaces * 3});
+
+    // Shrink the position buffer
+    VertexData weldedPositions(welder.getNumberOfWeldedVertices());
+    welder.getWeldedPositions(weldedPositions.getData());
+    m_positions = weldedPositions;
+    m_numVertices = m_verticesAdded = welder.getNumberOfWeldedVertices();
+    m_numFaces = m_facesAdded = numFaces;
+
+    // Derived data is stale
+    m_vertexNormals.reset();
+    m_faceNormals.reset();
+    m_vertices.reset();
+    m_faces.reset();
+    m_vertexFaces.reset();
+
+    if (debug)
+        cout << "Removed " << numDuplicates << " duplicate vertices" << endl;
+    return numDuplicates;
+}
+
+unsigned TriangleMesh::getNumberOfVertices() const { return m_numVertices; }
+
+unsigned TriangleMesh::getNumberOfFaces() const { return m_numFaces; }
+
+void TriangleMesh::buildVertices() {
+    m_vertices.emplace();
+    m_vertices->reserve(m_numVertices);
+    auto const* positions = m_positions.getData();
+    for (unsigned i = 0; i < m_numVertices; ++i) {
+        m_vertices->emplace_back(positions[3*i], positions[3*i+1], positions[3*i+2]);
+    }
+}
+
+void TriangleMesh::buildFaces() {
+    m_faces.emplace();
+    m_faces->reserve(m_numFaces);
+    for (unsigned i = 0; i < m_numFaces; ++i) {
+        m_faces->emplace_back(std::initializer_list<unsigned>{m_indices[3*i], m_indices[3*i+1], m_indices[3*i+2]});
+    }
+}
+
+Mesh::Vertices const& TriangleMesh::getVertices() const {
+    if (!m_vertices) const_cast<TriangleMesh*>(this)->buildVertices();
+    return m_vertices.value();
+}
+
+Mesh::Faces const& TriangleMesh::getConnectivity() const {
+    if (!m_faces) const_cast<TriangleMesh*>(this)->buildFaces();
+    return m_faces.value();
+}
+
+const Vertex& TriangleMesh::getVertex(unsigned const vertexIndex) const {
+    if (vertexIndex >= m_numVertices)
+        throw std::runtime_error("Vertex index invalid");
+    return getVertices()[vertexIndex];
+}
+
+const Face& TriangleMesh::getFace(unsigned const faceIndex) const {
+    if (faceIndex >= m_numFaces)
+        throw std::runtime_error("Face index invalid");
+    return getConnectivity()[faceIndex];
+}
+
+void TriangleMesh::buildVertexFaces() {
+    m_vertexFaces.emplace(m_numVertices, span<unsigned const>{m_indices.get(), m_facesAdded * 3}, 3);
+}
+
+span<unsigned const> TriangleMesh::getVertexFaces(unsigned const vertexIndex) const {
+    // Built on first use after all faces are added
+    if (!m_vertexFaces) const_cast<TriangleMesh*>(this)->buildVertexFaces();
+    return m_vertexFaces->getFaces(vertexIndex);
+}
+
+Bounds TriangleMesh::getBounds() const {
+    if (!m_bounds) {
+        const_cast<TriangleMesh*>(this)->buildBounds();
+    }
+    return m_bounds.value();
+}
+
+void TriangleMesh::buildBounds() {
+    m_bounds = PointKernels::computeBounds(m_positions.getData(), m_numVertices);
+}
+
+Mesh::VertexData TriangleMesh::getVertexData() const {
+    return m_positions;
+}
+
+void TriangleMesh::getConnectivityData(size_t& numBytes, unsigned*& connData) const {
+    numBytes = m_numFaces * 3 * sizeof(unsigned);
+    connData = m_indices.get();
+}
+
+std::unique_ptr<Mesh> TriangleMesh::transform(common::TransformMatrix const& transformMatrix) const {
+    // Positions are transformed straight into the new mesh's buffer instead of being copied and then
+    // transformed in place
+    auto transformedMesh = std::make_unique<TriangleMesh>();
+    transformedMesh->initialize(m_numVertices, m_numFaces);
+    transformedMesh->m_verticesAdded = m_verticesAdded;
+    transformedMesh->m_facesAdded = m_facesAdded;
+    memcpy(transformedMesh->m_indices.get(), m_indices.get(), m_numFaces * 3 * sizeof(unsigned));
+    PointKernels::transformPoints(transformMatrix, m_positions.getData(), m_numVertices,
+                                  transformedMesh->m_positions.getData());
+
+    // Cached normals are carried over so that the transformed mesh doesn't have to recompute them. Vertex
+    // normals are cached without face normals when they were supplied by a file
+    if (m_faceNormals) {
+        transformedMesh->m_faceNormals = NormalData(m_numFaces);
+        PointKernels::transformNormals(transformMatrix, m_faceNormals->getData(), m_numFaces,
+                                       transformedMesh->m_faceNormals->getData());
+    }
+    if (m_vertexNormals) {
+        transformedMesh->m_vertexNormals = NormalData(m_numVertices);
+        PointKernels::transformNormals(transformMatrix, m_vertexNormals->getData(), m_numVertices,
+                                       transformedMesh->m_vertexNormals->getData());
+    }
+    return transformedMesh;
+}
+
+void TriangleMesh::writeToSTL(std::string const& fileName) const {
+
+    ofstream ofs(fileName, ios::binary);
+    char header[80] = "STL file generated by MeshViewer (https://github.com/mdh81/meshviewer)";
+    ofs.write(header, 80);
+    auto numTris = m_numFaces;
+    ofs.write(reinterpret_cast<char*>(&numTris), 4);
+    unsigned short dummy = 0;
+    for (unsigned i = 0; i < m_numFaces; ++i) {
+        auto A = getPosition(m_indices[3*i]);
+        auto B = getPosition(m_indices[3*i+1]);
+        auto C = getPosition(m_indices[3*i+2]);
+        auto AB = B-A;
+        auto AC = C-A;
+        auto normal = (AC * AB).normalize();
+        ofs.write(reinterpret_cast<const char*>(normal.getData()), 12);
+        ofs.write(reinterpret_cast<const char*>(A.getData()), 12);
+        ofs.write(reinterpret_cast<const char*>(B.getData()), 12);
+        ofs.write(reinterpret_cast<const char*>(C.getData()), 12);
+        ofs.write(reinterpret_cast<char*>(&dummy), 2);
+    }
+    ofs.close();
+}
+
+void TriangleMesh::generateNormals() {
+    // Face normals are computed once and both normal caches are filled together
+    span<unsigned const> const triangles {m_indices.get(), m_numFaces * 3};
+    m_faceNormals = NormalData(m_numFaces);
+    MeshNormals::computeFaceNormals(m_positions.getData(), triangles, m_faceNormals->getData());
+
+    // Vertex normals supplied by a file are kept
+    if (m_vertexNormals) return;
+
+    // Vertices of a mesh that was read from STL and not cleaned belong to a single face, so their
+    // normals are copies of the face normals and the vertex to face adjacency is not needed
+    m_vertexNormals = NormalData(m_numVertices);
+    if (MeshNormals::hasUnsharedVertices(m_numVertices, triangles)) {
+        MeshNormals::copyFaceNormalsToVertices(m_numFaces, m_faceNormals->getData(), m_vertexNormals->getData());
+    } else {
+        if (!m_vertexFaces) buildVertexFaces();
+        MeshNormals::accumulateFaceNormals(m_vertexFaces.value(), m_faceNormals->getData(),
+                                           m_vertexNormals->getData());
+    }
+}
+
+Mesh::NormalData TriangleMesh::getNormals(NormalLocation const location) const {
+    if (!m_vertexNormals || !m_faceNormals)
+        const_cast<TriangleMesh*>(this)->generateNormals();
+    return location == NormalLocation::Vertex ? m_vertexNormals.value() : m_faceNormals.value();
+}
+
+}
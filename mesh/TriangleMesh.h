@@ -0,0 +1,139 @@
+#pragma once
+
+#include "RenderableMesh.h"
+#include "VertexFaceAdjacency.h"
+
+namespace mv {
+
+    // A triangle mesh that stores its vertex positions as a single contiguous array of x,y,z
+    // floats and its connectivity as a single contiguous array of vertex index triples. Both
+    // buffers are handed out to the rendering pipeline as-is without any intermediate copies
+    //
+    // NOTE: The object based accessors of the Mesh interface (getVertices(), getVertex(),
+    // getConnectivity() and getFace()) are supported for compatibility. The first call to any
+    // of them builds Vertex and Face objects from the flat buffers, which costs as much memory
+    // as the per-face storage of MeshImpl. Performance sensitive consumers should use
+    // getVertexData() and getConnectivityData() instead
+    class TriangleMesh : public RenderableMesh {
+
+    public:
+        TriangleMesh();
+
+        ~TriangleMesh() override = default;
+
+        // Copies the buffers but not the render state, which is set up again for the copy
+        TriangleMesh(TriangleMesh const&);
+
+        // Meshes are handed around by pointer once they are set up for rendering, so they are only ever copied
+        // into a new mesh
+        TriangleMesh(TriangleMesh&&) = delete;
+        TriangleMesh& operator=(TriangleMesh const&) = delete;
+        TriangleMesh& operator=(TriangleMesh&&) = delete;
+
+        void initialize(unsigned numVertices, unsigned numFaces) override;
+
+        void addVertex(float x, float y, float z) override;
+
+        // Adds a triangle. Throws if the face doesn't have exactly 3 vertices
+        void addFace(const std::initializer_list<unsigned> &vertexIds) override;
+
+        [[nodiscard]]
+        std::span<float> getPositionBuffer() override;
+
+        [[nodiscard]]
+        std::span<unsigned> getIndexBuffer() override;
+
+        // Normals written to this buffer are returned by getNormals() instead of computed ones. Face normals are
+        // still computed
+        [[nodiscard]]
+        std::span<float> getVertexNormalBuffer() override;
+
+        // Buffers are used as they are. Normals and bounds that are supplied aren't computed
+        bool setSharedBuffers(SharedBuffers const&) override;
+
+        [[nodiscard]]
+        unsigned removeDuplicateVertices() override;
+
+        // Gets the number of vertices in this mesh
+        [[nodiscard]]
+        unsigned getNumberOfVertices() const override;
+
+        // Gets the number of faces in this mesh
+        [[nodiscard]]
+        unsigned getNumberOfFaces() const override;
+
+        // Gets all vertices in this mesh
+        [[nodiscard]]
+        const Vertices &getVertices() const override;
+
+        // Gets all faces in this mesh
+        [[nodiscard]]
+        const Faces &getConnectivity() const override;
+
+        // Returns a vertex at the specified index
+        [[nodiscard]]
+        const Vertex &getVertex(unsigned vertexIndex) const override;
+
+        // Returns a face at the specified index
+        [[nodiscard]]
+        const Face &getFace(unsigned faceIndex) const override;
+
+        // Gets the indices of the faces that share the specified vertex
+        [[nodiscard]]
+        std::span<unsigned const> getVertexFaces(unsigned vertexIndex) const override;
+
+        // Gets the bounds of the mesh
+        [[nodiscard]]
+        common::Bounds getBounds() const override;
+
+        // Gets vertices. The returned array shares the mesh's position buffer
+        [[nodiscard]]
+        VertexData getVertexData() const override;
+
+        // Gets connectivity data in the form a pointer to the mesh's index buffer
+        void getConnectivityData(size_t &numBytes, unsigned *&connData) const override;
+
+        // Transforms a copy of this mesh and returns the copy
+        [[nodiscard]]
+        std::unique_ptr<Mesh> transform(common::TransformMatrix const &transformMatrix) const override;
+
+        // Writes this mesh to a STL file
+        void writeToSTL(const std::string &stlFile) const override;
+
+        // Gets normals
+        [[nodiscard]]
+        NormalData getNormals(common::NormalLocation) const override;
+
+    private:
+        unsigned m_numVertices;
+        unsigned m_numFaces;
+        // x,y,z triples
+        VertexData m_positions;
+        // Vertex index triples
+        std::shared_ptr<unsigned[]> m_indices;
+        unsigned m_verticesAdded;
+        unsigned m_facesAdded;
+        std::optional<common::Bounds> m_bounds;
+        std::optional<NormalData> m_vertexNormals;
+        std::optional<NormalData> m_faceNormals;
+        std::optional<VertexFaceAdjacency> m_vertexFaces;
+        // Object representations of the flat buffers that are built on demand
+        std::optional<Vertices> m_vertices;
+        std::optional<Faces> m_faces;
+
+    private:
+        void buildBounds();
+
+        void generateNormals();
+
+        void buildVertices();
+
+        void buildFaces();
+
+        void buildVertexFaces();
+
+        [[nodiscard]]
+        common::Point3D getPosition(unsigned vertexIndex) const;
+    };
+
+}
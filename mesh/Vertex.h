@@ -4,7 +4,6 @@
 #include "Types.h"
 #include "Util.h"
 #include "3dmath/Vector.h"
-#include <vector>
 
 namespace mv {
 
@@ -25,18 +24,9 @@ class Vertex : public common::Point3D {
                    Util::areFloatsEqual(this->z, another.z);    
         }
 
-        void addFace(const unsigned faceId) {
-            m_faces.push_back(faceId);
-        }
-
-        void getFaces(std::vector<unsigned>& faces) const {
-            faces = m_faces;
-        }
-
-        [[nodiscard]] common::Vector3D getNormal(const Mesh&) const;
-
-    private:
-        std::vector<unsigned> m_faces;
+        // Gets the normal at a vertex of the mesh. Vertices are values that don't know their index, so the index
+        // is passed in. Vertices that aren't used by any face have a zero normal
+        [[nodiscard]] static common::Vector3D getNormal(const Mesh&, common::VertexIndex);
 };
 
 }
@@ -0,0 +1,84 @@
+#include "VertexFaceAdjacency.h"
+#include "Face.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace mv {
+
+using namespace common;
+
+namespace {
+    // Work per thread below which thread startup costs more than it saves
+    constexpr size_t minimumFacesPerThread = 16384;
+}
+
+VertexFaceAdjacency::VertexFaceAdjacency(unsigned const numVertices, span<unsigned const> const faceVertices,
+                                         unsigned const verticesPerFace) {
+    if (!verticesPerFace || faceVertices.size() % verticesPerFace)
+        throw std::runtime_error("Face vertex count does not match the number of vertices per face");
+    build(numVertices, static_cast<unsigned>(faceVertices.size() / verticesPerFace), [&](size_t const faceIndex) {
+        return faceVertices.subspan(faceIndex * verticesPerFace, verticesPerFace);
+    });
+}
+
+VertexFaceAdjacency::VertexFaceAdjacency(unsigned const numVertices, vector<Face> const& faces) {
+    build(numVertices, static_cast<unsigned>(faces.size()), [&](size_t const faceIndex) {
+        return span<unsigned const>{faces[faceIndex].data(), faces[faceIndex].size()};
+    });
+}
+
+template<typename FaceVertices>
+void VertexFaceAdjacency::build(unsigned const numVertices, unsigned const numFaces, FaceVertices const& faceVertices) {
+    // Count the faces of each vertex. Counts are stored one slot to the right so that an in-place prefix
+    // sum turns them into offsets
+    m_offsets.assign(numVertices + 1, 0);
+    parallelFor(numFaces, [&](size_t const begin, size_t const end) {
+        for (auto faceIndex = begin; faceIndex < end; ++faceIndex) {
+            for (auto vertexIndex : faceVertices(faceIndex)) {
+                if (vertexIndex >= numVertices)
+                    throw std::runtime_error("Face " + to_string(faceIndex) + " references invalid vertex " +
+                                             to_string(vertexIndex));
+                atomic_ref<unsigned>(m_offsets[vertexIndex + 1]).fetch_add(1, memory_order_relaxed);
+            }
+        }
+    }, minimumFacesPerThread);
+    for (unsigned i = 1; i <= numVertices; ++i) {
+        m_offsets[i] += m_offsets[i - 1];
+    }
+
+    // Scatter face indices into the slots of their vertices
+    m_faces.resize(m_offsets.back());
+    vector<unsigned> cursors(m_offsets.begin(), m_offsets.end() - 1);
+    auto const numRanges = getNumberOfRanges(numFaces, minimumFacesPerThread);
+    parallelFor(numFaces, [&](size_t const begin, size_t const end) {
+        for (auto faceIndex = begin; faceIndex < end; ++faceIndex) {
+            for (auto vertexIndex : faceVertices(faceIndex)) {
+                auto const slot = atomic_ref<unsigned>(cursors[vertexIndex]).fetch_add(1, memory_order_relaxed);
+                m_faces[slot] = static_cast<unsigned>(faceIndex);
+            }
+        }
+    }, minimumFacesPerThread);
+
+    // Concurrent scatter leaves each vertex's faces in arbitrary order. Sort them so that the result
+    // doesn't depend on the number of threads
+    if (numRanges > 1) {
+        parallelFor(numVertices, [&](size_t const begin, size_t const end) {
+            for (auto vertexIndex = begin; vertexIndex < end; ++vertexIndex) {
+                sort(m_faces.begin() + m_offsets[vertexIndex], m_faces.begin() + m_offsets[vertexIndex + 1]);
+            }
+        }, minimumFacesPerThread);
+    }
+}
+
+span<unsigned const> VertexFaceAdjacency::getFaces(VertexIndex const vertexIndex) const {
+    if (vertexIndex >= getNumberOfVertices())
+        throw std::runtime_error("Vertex index invalid");
+    return {m_faces.data() + m_offsets[vertexIndex], m_offsets[vertexIndex + 1] - m_offsets[vertexIndex]};
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Types.h"
+#include <span>
+#include <vector>
+
+namespace mv {
+
+class Face;
+
+// Faces incident on each vertex of a mesh in compressed sparse row form. The faces of vertex v are
+// m_faces[m_offsets[v], m_offsets[v+1]), so the whole structure lives in two allocations regardless
+// of the size of the mesh and a walk over a vertex's neighbourhood touches contiguous memory
+class VertexFaceAdjacency {
+    public:
+        VertexFaceAdjacency() = default;
+
+        // Builds adjacency for faces that have the same number of vertices and whose vertex indices are
+        // stored back to back in faceVertices
+        VertexFaceAdjacency(unsigned numVertices, std::span<unsigned const> faceVertices, unsigned verticesPerFace);
+
+        // Builds adjacency for faces of arbitrary size
+        VertexFaceAdjacency(unsigned numVertices, std::vector<Face> const& faces);
+
+        // Gets the indices of the faces that share the specified vertex in ascending order
+        [[nodiscard]]
+        std::span<unsigned const> getFaces(common::VertexIndex vertexIndex) const;
+
+        [[nodiscard]]
+        unsigned getNumberOfVertices() const {
+            return m_offsets.empty() ? 0 : static_cast<unsigned>(m_offsets.size() - 1);
+        }
+
+    private:
+        template<typename FaceVertices>
+        void build(unsigned numVertices, unsigned numFaces, FaceVertices const& faceVertices);
+
+    private:
+        std::vector<unsigned> m_offsets;
+        std::vector<unsigned> m_faces;
+};
+
+}
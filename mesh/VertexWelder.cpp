@@ -0,0 +1,217 @@
+#include "VertexWelder.h"
+#include "Face.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace mv {
+
+using namespace common;
+
+namespace {
+    // Work per thread below which thread startup costs more than it saves
+    constexpr size_t minimumItemsPerThread = 16384;
+
+    // Cell coordinate of a value on a grid with the specified cell size. Clamped so that values that are
+    // far outside the grid's range don't overflow
+    inline int64_t getCell(float const value, double const cellSize) {
+        constexpr double limit = static_cast<double>(1LL << 62);
+        return static_cast<int64_t>(std::clamp(std::floor(value / cellSize), -limit, limit));
+    }
+
+    inline size_t hashCell(int64_t const x, int64_t const y, int64_t const z) {
+        return static_cast<size_t>(x * 73856093LL ^ y * 19349663LL ^ z * 83492791LL);
+    }
+
+    // Splits [0, count) into ranges, counts the items in each range for which isSelected is true and
+    // returns the number of selected items before each range followed by the total
+    template<typename IsSelected>
+    vector<unsigned> countSelected(size_t const count, IsSelected const& isSelected) {
+        vector<unsigned> offsets(getNumberOfRanges(count, minimumItemsPerThread) + 1);
+        parallelFor(count, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+            unsigned numSelected = 0;
+            for (auto i = begin; i < end; ++i) {
+                numSelected += isSelected(i) ? 1 : 0;
+            }
+            offsets[rangeIndex + 1] = numSelected;
+        }, minimumItemsPerThread);
+        for (size_t i = 1; i < offsets.size(); ++i) {
+            offsets[i] += offsets[i - 1];
+        }
+        return offsets;
+    }
+}
+
+VertexWelder::VertexWelder(float const* positions, unsigned const numVertices, float const tolerance)
+: m_positions(positions)
+, m_numVertices(numVertices)
+, m_numWeldedVertices(0)
+, m_representatives(numVertices)
+, m_weldedIndices(numVertices) {
+
+    if (!(tolerance > 0.f))
+        throw std::runtime_error("Weld tolerance has to be greater than zero");
+    if (!numVertices) return;
+
+    // Bucket vertices by the hash of the grid cell they are in. Buckets are stored in compressed sparse row form
+    double const cellSize = 2.0 * tolerance;
+    auto const numBuckets = std::bit_ceil(2 * static_cast<size_t>(numVertices));
+    auto const bucketMask = numBuckets - 1;
+    auto getBucket = [&](unsigned const vertexIndex) {
+        auto const* position = positions + 3 * vertexIndex;
+        return hashCell(getCell(position[0], cellSize), getCell(position[1], cellSize),
+                        getCell(position[2], cellSize)) & bucketMask;
+    };
+    vector<unsigned> bucketOffsets(numBuckets + 1, 0);
+    parallelFor(numVertices, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            atomic_ref<unsigned>(bucketOffsets[getBucket(i) + 1]).fetch_add(1, memory_order_relaxed);
+        }
+    }, minimumItemsPerThread);
+    for (size_t i = 1; i <= numBuckets; ++i) {
+        bucketOffsets[i] += bucketOffsets[i - 1];
+    }
+    vector<unsigned> bucketVertices(numVertices);
+    {
+        vector<unsigned> cursors(bucketOffsets.begin(), bucketOffsets.end() - 1);
+        parallelFor(numVertices, [&](size_t const begin, size_t const end) {
+            for (auto i = begin; i < end; ++i) {
+                auto const slot = atomic_ref<unsigned>(cursors[getBucket(i)]).fetch_add(1, memory_order_relaxed);
+                bucketVertices[slot] = static_cast<unsigned>(i);
+            }
+        }, minimumItemsPerThread);
+    }
+
+    // Find the lowest indexed duplicate of each vertex. Duplicates are within tolerance of the vertex on every
+    // axis and cells are twice as wide as the tolerance, so they can only be in the one or two cells per axis
+    // that the tolerance box around the vertex overlaps
+    parallelFor(numVertices, [&](size_t const begin, size_t const end) {
+        for (auto i = static_cast<unsigned>(begin); i < end; ++i) {
+            auto const* position = positions + 3 * i;
+            int64_t lower[3], upper[3];
+            for (int axis = 0; axis < 3; ++axis) {
+                lower[axis] = getCell(position[axis] - tolerance, cellSize);
+                upper[axis] = getCell(position[axis] + tolerance, cellSize);
+            }
+            auto representative = i;
+            for (auto x = lower[0]; x <= upper[0]; ++x) {
+                for (auto y = lower[1]; y <= upper[1]; ++y) {
+                    for (auto z = lower[2]; z <= upper[2]; ++z) {
+                        auto const bucket = hashCell(x, y, z) & bucketMask;
+                        for (auto slot = bucketOffsets[bucket]; slot < bucketOffsets[bucket + 1]; ++slot) {
+                            auto const candidate = bucketVertices[slot];
+                            if (candidate >= representative) continue;
+                            auto const* candidatePosition = positions + 3 * candidate;
+                            if (std::fabs(candidatePosition[0] - position[0]) < tolerance &&
+                                std::fabs(candidatePosition[1] - position[1]) < tolerance &&
+                                std::fabs(candidatePosition[2] - position[2]) < tolerance) {
+                                representative = candidate;
+                            }
+                        }
+                    }
+                }
+            }
+            m_representatives[i] = representative;
+        }
+    }, minimumItemsPerThread);
+
+    // Vertices within tolerance of a duplicate, but not of the duplicate's representative, form chains.
+    // Representatives always have lower indices, so a single forward pass collapses the chains
+    for (unsigned i = 0; i < numVertices; ++i) {
+        m_representatives[i] = m_representatives[m_representatives[i]];
+    }
+
+    // Representatives keep their relative order in the welded vertex array
+    auto const offsets = countSelected(numVertices, [this](size_t const i) { return m_representatives[i] == i; });
+    m_numWeldedVertices = offsets.back();
+    parallelFor(numVertices, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+        auto weldedIndex = offsets[rangeIndex];
+        for (auto i = begin; i < end; ++i) {
+            if (m_representatives[i] == i) m_weldedIndices[i] = weldedIndex++;
+        }
+    }, minimumItemsPerThread);
+    parallelFor(numVertices, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            m_weldedIndices[i] = m_weldedIndices[m_representatives[i]];
+        }
+    }, minimumItemsPerThread);
+}
+
+void VertexWelder::getWeldedPositions(float* weldedPositions) const {
+    // Welded positions never move to a higher index, so compacting in place is safe as long as it's done in order
+    if (weldedPositions == m_positions) {
+        for (unsigned i = 0; i < m_numVertices; ++i) {
+            if (m_representatives[i] == i && m_weldedIndices[i] != i) {
+                memcpy(weldedPositions + 3 * m_weldedIndices[i], m_positions + 3 * i, 3 * sizeof(float));
+            }
+        }
+        return;
+    }
+    parallelFor(m_numVertices, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            if (m_representatives[i] == i) {
+                memcpy(weldedPositions + 3 * m_weldedIndices[i], m_positions + 3 * i, 3 * sizeof(float));
+            }
+        }
+    }, minimumItemsPerThread);
+}
+
+unsigned VertexWelder::weldTriangles(span<unsigned> const triangles) const {
+    auto const numTriangles = triangles.size() / 3;
+    vector<char> isValid(numTriangles);
+    parallelFor(numTriangles, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            auto* triangle = triangles.data() + 3 * i;
+            for (int j = 0; j < 3; ++j) {
+                triangle[j] = m_weldedIndices[triangle[j]];
+            }
+            isValid[i] = triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[2] != triangle[0];
+        }
+    }, minimumItemsPerThread);
+
+    unsigned numValidTriangles = 0;
+    for (size_t i = 0; i < numTriangles; ++i) {
+        if (!isValid[i]) continue;
+        if (numValidTriangles != i) {
+            memcpy(triangles.data() + 3 * numValidTriangles, triangles.data() + 3 * i, 3 * sizeof(unsigned));
+        }
+        ++numValidTriangles;
+    }
+    return numValidTriangles;
+}
+
+void VertexWelder::weldFaces(vector<Face>& faces) const {
+    vector<char> isValid(faces.size());
+    parallelFor(faces.size(), [&](size_t const begin, size_t const end) {
+        vector<unsigned> vertexIds;
+        for (auto i = begin; i < end; ++i) {
+            auto const& face = faces[i];
+            vertexIds.clear();
+            for (size_t j = 0; j < face.size(); ++j) {
+                auto const weldedIndex = m_weldedIndices[face.data()[j]];
+                if (vertexIds.empty() || vertexIds.back() != weldedIndex) vertexIds.push_back(weldedIndex);
+            }
+            while (vertexIds.size() > 1 && vertexIds.back() == vertexIds.front()) {
+                vertexIds.pop_back();
+            }
+            isValid[i] = vertexIds.size() >= std::min<size_t>(face.size(), 3) && vertexIds.size() > 1;
+            faces[i] = Face(vertexIds);
+        }
+    }, minimumItemsPerThread);
+
+    size_t numValidFaces = 0;
+    for (size_t i = 0; i < faces.size(); ++i) {
+        if (!isValid[i]) continue;
+        if (numValidFaces != i) faces[numValidFaces] = std::move(faces[i]);
+        ++numValidFaces;
+    }
+    faces.resize(numValidFaces);
+}
+
+}
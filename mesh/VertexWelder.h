@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Types.h"
+#include "Util.h"
+#include <span>
+#include <vector>
+
+namespace mv {
+
+class Face;
+
+// Merges vertices that are within a tolerance of each other. Vertices are hashed into a grid whose cells are
+// twice the tolerance wide, so the neighbours of a vertex are found in at most eight cells regardless of the
+// size of the mesh. Each vertex is merged into the lowest indexed vertex it is a duplicate of. All passes are
+// linear in the number of vertices and faces and split across threads for large meshes
+class VertexWelder {
+    public:
+        // Finds duplicate vertices among numVertices x,y,z triples. Two vertices are duplicates if all
+        // their coordinates differ by less than tolerance, which is the same test Vertex::operator== uses
+        VertexWelder(float const* positions, unsigned numVertices, float tolerance = Util::tolerance);
+
+        // Gets the number of vertices after welding
+        [[nodiscard]]
+        unsigned getNumberOfWeldedVertices() const { return m_numWeldedVertices; }
+
+        // Gets the index of a vertex in the welded vertex array
+        [[nodiscard]]
+        common::VertexIndex getWeldedIndex(common::VertexIndex vertexIndex) const { return m_weldedIndices[vertexIndex]; }
+
+        // Writes the positions of the welded vertices. weldedPositions has to hold getNumberOfWeldedVertices()
+        // x,y,z triples. weldedPositions may be the positions the welder was created with
+        void getWeldedPositions(float* weldedPositions) const;
+
+        // Points triangles at the welded vertices and removes triangles that collapse into a point or a line.
+        // The remaining triangles are moved to the front of triangles in their original order. Returns the
+        // number of remaining triangles
+        [[nodiscard]]
+        unsigned weldTriangles(std::span<unsigned> triangles) const;
+
+        // Points faces at the welded vertices. Consecutive vertices of a face that merge are collapsed. Faces
+        // that collapse into a point, and polygons that collapse into a line, are removed
+        void weldFaces(std::vector<Face>& faces) const;
+
+    private:
+        float const* m_positions;
+        unsigned m_numVertices;
+        unsigned m_numWeldedVertices;
+        // Index of the vertex that each vertex merges into. Lowest index among the duplicates
+        std::vector<unsigned> m_representatives;
+        // Index of each vertex in the welded vertex array
+        std::vector<unsigned> m_weldedIndices;
+};
+
+}
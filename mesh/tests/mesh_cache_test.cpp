@@ -0,0 +1,170 @@
+#include "gtest/gtest.h"
+#include "TriangleMesh.h"
+#include "ReaderFactory.h"
+#include "MeshCacheWriter.h"
+#include "MeshCacheFormat.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace mv;
+using namespace mv::readers;
+using namespace mv::writers;
+
+namespace {
+
+    // A mesh that owns its storage and has to be filled with copies
+    class OwningTriangleMesh : public TriangleMesh {
+    public:
+        bool setSharedBuffers(SharedBuffers const&) override { return false; }
+    };
+
+    vector<float> toVector(Mesh::NormalData const& data) {
+        return {data.getData(), data.getData() + data.getSize() * 3};
+    }
+
+    vector<unsigned> getIndices(Mesh const& mesh) {
+        size_t numBytes;
+        unsigned* indices;
+        mesh.getConnectivityData(numBytes, indices);
+        return {indices, indices + numBytes / sizeof(unsigned)};
+    }
+
+    void assertEqual(Mesh const& expected, Mesh const& actual) {
+        ASSERT_EQ(expected.getNumberOfVertices(), actual.getNumberOfVertices());
+        ASSERT_EQ(expected.getNumberOfFaces(), actual.getNumberOfFaces());
+        ASSERT_EQ(toVector(expected.getVertexData()), toVector(actual.getVertexData()));
+        ASSERT_EQ(getIndices(expected), getIndices(actual));
+        ASSERT_EQ(toVector(expected.getNormals(common::NormalLocation::Vertex)),
+                  toVector(actual.getNormals(common::NormalLocation::Vertex)));
+        ASSERT_EQ(toVector(expected.getNormals(common::NormalLocation::Face)),
+                  toVector(actual.getNormals(common::NormalLocation::Face)));
+    }
+
+}
+
+class MeshCacheFixture : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            auto* pData = getenv("modelsDir");
+            if (!pData) throw std::runtime_error("modelsDir environment variable not set");
+            m_modelsDir = pData;
+            m_cacheFile = m_modelsDir/"cubeCacheOut.mvmesh";
+            filesystem::remove(m_cacheFile);
+        }
+
+        filesystem::path m_modelsDir;
+        filesystem::path m_cacheFile;
+};
+
+TEST_F(MeshCacheFixture, RoundTrip) {
+    auto const mesh = ReaderFactory{}.getReader(m_modelsDir/"cube.ply")->getOutput();
+    MeshCacheWriter{m_cacheFile}.write(*mesh);
+    ASSERT_EQ(filesystem::file_size(m_cacheFile) % common::meshcache::sectionAlignment, 6 * sizeof(float))
+        << "Sections should start at page boundaries";
+
+    auto cachedMesh = ReaderFactory{}.getReader(m_cacheFile)->getOutput();
+    assertEqual(*mesh, *cachedMesh);
+    auto const bounds = cachedMesh->getBounds();
+    ASSERT_FLOAT_EQ(bounds.x.min, mesh->getBounds().x.min);
+    ASSERT_FLOAT_EQ(bounds.z.max, mesh->getBounds().z.max);
+
+    // Meshes that can't share the file's storage get copies
+    Mesh::MeshPointer owningMesh = make_unique<OwningTriangleMesh>();
+    owningMesh = ReaderFactory{}.getReader(m_cacheFile)->getOutput(std::move(owningMesh));
+    assertEqual(*mesh, *owningMesh);
+}
+
+TEST_F(MeshCacheFixture, EditsDontChangeTheFile) {
+    auto const mesh = ReaderFactory{}.getReader(m_modelsDir/"cube.ply")->getOutput();
+    MeshCacheWriter{m_cacheFile}.write(*mesh);
+    auto cachedMesh = ReaderFactory{}.getReader(m_cacheFile)->getOutput();
+    auto const positions = cachedMesh->getPositionBuffer();
+    fill(positions.begin(), positions.end(), 0.f);
+    ASSERT_GT(cachedMesh->removeDuplicateVertices(), 0);
+    assertEqual(*mesh, *ReaderFactory{}.getReader(m_cacheFile)->getOutput());
+}
+
+TEST_F(MeshCacheFixture, InvalidFile) {
+    auto const mesh = ReaderFactory{}.getReader(m_modelsDir/"cube.ply")->getOutput();
+    MeshCacheWriter{m_cacheFile}.write(*mesh);
+    vector<char> contents(filesystem::file_size(m_cacheFile));
+    ifstream{m_cacheFile, ios::binary}.read(contents.data(), static_cast<streamsize>(contents.size()));
+    auto readModified = [&](size_t const size, size_t const offset, char const* bytes, size_t numBytes) {
+        auto modified = contents;
+        modified.resize(size);
+        memcpy(modified.data() + offset, bytes, numBytes);
+        ofstream{m_cacheFile, ios::binary}.write(modified.data(), static_cast<streamsize>(modified.size()));
+        return ReaderFactory{}.getReader(m_cacheFile)->getOutput();
+    };
+    ASSERT_NO_THROW(readModified(contents.size(), 0, contents.data(), 8));
+    // Truncated
+    ASSERT_THROW(readModified(contents.size() - 1, 0, contents.data(), 8), std::runtime_error);
+    ASSERT_THROW(readModified(16, 0, contents.data(), 8), std::runtime_error);
+    // Not a mvmesh file
+    ASSERT_THROW(readModified(contents.size(), 0, "MVMESH\n\n", 8), std::runtime_error);
+    // Newer version
+    uint32_t const version = common::meshcache::version + 1;
+    ASSERT_THROW(readModified(contents.size(), 8, reinterpret_cast<char const*>(&version), 4), std::runtime_error);
+    // Vertex index out of range
+    common::meshcache::Section indices {};
+    for (size_t offset = sizeof(common::meshcache::Header); indices.type != common::meshcache::SectionType::Indices;
+         offset += sizeof(indices)) {
+        memcpy(&indices, contents.data() + offset, sizeof(indices));
+    }
+    auto const numVertices = mesh->getNumberOfVertices();
+    ASSERT_THROW(readModified(contents.size(), indices.offset + indices.size - sizeof(unsigned),
+                              reinterpret_cast<char const*>(&numVertices), sizeof(numVertices)), std::runtime_error);
+}
+
+TEST_F(MeshCacheFixture, ReadThroughDerivedDataCache) {
+    auto const cacheDirectory = filesystem::temp_directory_path() / "meshCacheTest";
+    filesystem::remove_all(cacheDirectory);
+    auto const modelFile = cacheDirectory / "models" / "cube.stl";
+    filesystem::create_directories(modelFile.parent_path());
+    filesystem::copy_file(m_modelsDir/"cube.stl", modelFile);
+    auto const cache = make_shared<DerivedDataCache const>(cacheDirectory / "derivedData", 1 << 30);
+    auto getEntries = [&cacheDirectory](string_view const extension) {
+        vector<filesystem::path> entries;
+        for (auto const& entry : filesystem::directory_iterator(cacheDirectory / "derivedData")) {
+            if (entry.path().extension() == extension) entries.push_back(entry.path());
+        }
+        return entries;
+    };
+    ReaderFactory readerFactory;
+    readerFactory.setCleanupOnImport(true);
+    readerFactory.setDerivedDataCache(cache);
+    auto const mesh = readerFactory.getReader(modelFile.string())->getOutput();
+    ASSERT_EQ(mesh->getNumberOfVertices(), 8) << "Mesh should be cleaned up";
+    // Entries are written after the mesh is handed over
+    cache->waitForBackgroundStores();
+    auto const entries = getEntries(".mvmesh");
+    ASSERT_EQ(entries.size(), 1);
+    ASSERT_EQ(getEntries(".mvkey").size(), 1);
+
+    // Files that were read before are opened from the cache
+    auto const otherMesh = ReaderFactory{}.getReader(m_modelsDir/"cube.ply")->getOutput();
+    MeshCacheWriter{entries.front()}.write(*otherMesh);
+    assertEqual(*otherMesh, *readerFactory.getReader(modelFile.string())->getOutput());
+
+    // Including files that were only touched, which are found by their contents
+    filesystem::last_write_time(modelFile, filesystem::last_write_time(modelFile) + chrono::hours(1));
+    assertEqual(*otherMesh, *readerFactory.getReader(modelFile.string())->getOutput());
+    cache->waitForBackgroundStores();
+    ASSERT_EQ(getEntries(".mvkey").size(), 2);
+
+    // Unless they are read with other settings
+    readerFactory.setCleanupOnImport(false);
+    ASSERT_EQ(readerFactory.getReader(modelFile.string())->getOutput()->getNumberOfVertices(), 36);
+
+    // Files that changed are read again
+    filesystem::copy_file(m_modelsDir/"tet.stl", modelFile, filesystem::copy_options::overwrite_existing);
+    filesystem::last_write_time(modelFile, filesystem::last_write_time(modelFile) + chrono::hours(2));
+    assertEqual(*ReaderFactory{}.getReader((m_modelsDir/"tet.stl").string())->getOutput(),
+                *readerFactory.getReader(modelFile.string())->getOutput());
+    cache->waitForBackgroundStores();
+    filesystem::remove_all(cacheDirectory);
+}
@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "MeshNormals.h"
+#include "VertexFaceAdjacency.h"
+#include "TriangleMesh.h"
+#include "Face.h"
+#include <cmath>
+#include <vector>
+using namespace std;
+using namespace mv;
+
+namespace {
+    // Two triangles that share the edge 0-1. First is in the XY plane and the second is in the YZ plane
+    vector<float> const positions {5, 0, 0,  5, 5, 0,  -5, 5, 0,  5, 5, -5};
+    vector<unsigned> const triangles {0, 1, 2, 0, 1, 3};
+
+    void expectNormal(float const* normal, float x, float y, float z) {
+        EXPECT_NEAR(normal[0], x, 1e-6);
+        EXPECT_NEAR(normal[1], y, 1e-6);
+        EXPECT_NEAR(normal[2], z, 1e-6);
+    }
+}
+
+TEST(MeshNormals, FaceNormals) {
+    vector<float> faceNormals(6);
+    MeshNormals::computeFaceNormals(positions.data(), triangles, faceNormals.data());
+    expectNormal(&faceNormals[0], 0, 0, 1);
+    expectNormal(&faceNormals[3], -1, 0, 0);
+
+    // Polygon faces give the same normals and lines get a zero normal
+    vector<Face> faces {{0, 1, 2}, {0, 1, 3}, {0, 1}};
+    vector<float> polygonNormals(9, 1.f);
+    MeshNormals::computeFaceNormals(positions.data(), faces, polygonNormals.data());
+    expectNormal(&polygonNormals[0], 0, 0, 1);
+    expectNormal(&polygonNormals[3], -1, 0, 0);
+    expectNormal(&polygonNormals[6], 0, 0, 0);
+}
+
+TEST(MeshNormals, DegenerateFace) {
+    vector<float> collinear {0, 0, 0, 1, 0, 0, 2, 0, 0};
+    vector<unsigned> triangle {0, 1, 2};
+    vector<float> faceNormal(3, 1.f);
+    MeshNormals::computeFaceNormals(collinear.data(), triangle, faceNormal.data());
+    expectNormal(faceNormal.data(), 0, 0, 0);
+}
+
+TEST(MeshNormals, SharedVertices) {
+    ASSERT_FALSE(MeshNormals::hasUnsharedVertices(4, triangles));
+    vector<float> faceNormals(6);
+    MeshNormals::computeFaceNormals(positions.data(), triangles, faceNormals.data());
+    vector<float> vertexNormals(12);
+    MeshNormals::accumulateFaceNormals(VertexFaceAdjacency(4, triangles, 3), faceNormals.data(), vertexNormals.data());
+    auto const component = 1.f / std::sqrt(2.f);
+    expectNormal(&vertexNormals[0], -component, 0, component);
+    expectNormal(&vertexNormals[3], -component, 0, component);
+    expectNormal(&vertexNormals[6], 0, 0, 1);
+    expectNormal(&vertexNormals[9], -1, 0, 0);
+}
+
+TEST(MeshNormals, UnsharedVertices) {
+    vector<unsigned> unshared {0, 1, 2, 3, 4, 5};
+    ASSERT_TRUE(MeshNormals::hasUnsharedVertices(6, unshared));
+    ASSERT_FALSE(MeshNormals::hasUnsharedVertices(7, unshared));
+    vector<float> faceNormals {0, 0, 1, -1, 0, 0};
+    vector<float> vertexNormals(18);
+    MeshNormals::copyFaceNormalsToVertices(2, faceNormals.data(), vertexNormals.data());
+    for (int i = 0; i < 3; ++i) {
+        expectNormal(&vertexNormals[3 * i], 0, 0, 1);
+        expectNormal(&vertexNormals[9 + 3 * i], -1, 0, 0);
+    }
+}
+
+TEST(MeshNormals, UnweldedTriangleMesh) {
+    // Same triangles as above with private vertices, as read from a STL file
+    TriangleMesh m;
+    m.initialize(6, 2);
+    for (auto index : triangles) {
+        m.addVertex(positions[3 * index], positions[3 * index + 1], positions[3 * index + 2]);
+    }
+    m.addFace({0, 1, 2});
+    m.addFace({3, 4, 5});
+    auto vertexNormals = m.getNormals(common::NormalLocation::Vertex);
+    ASSERT_EQ(vertexNormals.getSize(), 6);
+    expectNormal(vertexNormals.getData(), 0, 0, 1);
+    expectNormal(vertexNormals.getData() + 15, -1, 0, 0);
+}
@@ -1,11 +1,13 @@
 #include "gtest/gtest.h"
 #include "MeshImpl.h"
+#include "Util.h"
 #include "ReaderFactory.h"
 #include "glm/glm.hpp"
 #include <vector>
 #include <initializer_list>
 #include <string>
 #include <filesystem>
+#include <cmath>
 #include <cstdlib>
 using namespace std;
 using namespace mv;
@@ -23,7 +25,6 @@ class MeshFixture : public ::testing::Test {
 };
 
 TEST_F(MeshFixture, RemoveDuplicateVertices) {
-    GTEST_SKIP() << "Removal of duplicate vertices is not tested until reindexing implementation is complete";
     auto spMesh = ReaderFactory{}.getReader(m_modelsDir/"cube.stl")->getOutput();
     int numOrigVertices = spMesh->getNumberOfVertices();
     spMesh->removeDuplicateVertices();
@@ -32,6 +33,46 @@ TEST_F(MeshFixture, RemoveDuplicateVertices) {
     ASSERT_EQ(numNewVertices, 8);
 }
 
+TEST_F(MeshFixture, CleanupOnImport) {
+    ReaderFactory readerFactory;
+    readerFactory.setCleanupOnImport(true);
+    auto spMesh = readerFactory.getReader(m_modelsDir/"cube.stl")->getOutput();
+    ASSERT_EQ(spMesh->getNumberOfVertices(), 8);
+    ASSERT_EQ(spMesh->getNumberOfFaces(), 12);
+}
+
+TEST(Mesh, RemoveDuplicateVertices) {
+    // Two triangles and a line with private vertices. Vertex 3 is a near duplicate of vertex 2, one float step
+    // away, and vertex 8 is just too far from vertex 2 to be its duplicate
+    MeshImpl m;
+    m.initialize(9, 3);
+    m.addVertex(0, 0, 0);
+    m.addVertex(5, 0, 0);
+    m.addVertex(5, 5, 0);
+    m.addVertex(5, std::nextafter(5.f, 6.f), 0);
+    m.addVertex(0, 5, 0);
+    m.addVertex(0, 0, 0);
+    m.addVertex(0, 0, 0);
+    m.addVertex(5, 5, 0);
+    m.addVertex(5, 5 + 2 * Util::tolerance, 0);
+    m.addFace({0, 1, 2});
+    m.addFace({3, 4, 5});
+    // Collapses into a point
+    m.addFace({6, 0});
+    ASSERT_NE(m.getVertex(3).y, m.getVertex(2).y);
+    ASSERT_NE(m.getVertex(8).y, m.getVertex(2).y);
+    ASSERT_EQ(m.removeDuplicateVertices(), 4);
+    ASSERT_EQ(m.getNumberOfVertices(), 5);
+    ASSERT_EQ(m.getVertices().size(), 5);
+    ASSERT_FLOAT_EQ(m.getVertex(3).y, 5);
+    ASSERT_GT(m.getVertex(4).y, 5 + Util::tolerance);
+    ASSERT_EQ(m.getNumberOfFaces(), 2);
+    ASSERT_EQ(m.getFace(1).at(0), 2);
+    ASSERT_EQ(m.getFace(1).at(1), 3);
+    ASSERT_EQ(m.getFace(1).at(2), 0);
+    ASSERT_EQ(m.getVertexFaces(0).size(), 2);
+}
+
 TEST(Mesh, TestCentroid) {
     MeshImpl m;
     m.initialize(2, 1);
@@ -3,10 +3,13 @@
 #include "Mesh.h"
 #include "ReaderFactory.h"
 #include "Types.h"
+#include "TriangleMesh.h"
 #include <vector>
 #include <numeric>
 #include <algorithm>
 #include <filesystem>
+#include <random>
+#include <thread>
 using namespace std;
 using namespace mv;
 using namespace mv::common;
@@ -44,7 +47,7 @@ TEST_F(OctreeFixture, RootOctant) {
     vector<unsigned> vec(spMesh->getNumberOfVertices());
     iota(vec.begin(), vec.end(), 0);
     for (size_t i = 0; i < vec.size(); ++i) {
-        ASSERT_EQ(octree.getVertices(octree.getRoot()).at(i), vec.at(i));
+        ASSERT_EQ(octree.getVertices(octree.getRoot())[i], vec.at(i));
     }
 }
 
@@ -64,7 +67,7 @@ TEST_F(OctreeFixture, Subdivision) {
     // Assert that child octants are in the correct position
     auto& rootOctant = octree1.getRoot();
     auto parentBounds = octree1.getBounds(rootOctant);
-    auto& children = octree1.getChildren(rootOctant);
+    auto children = octree1.getChildren(rootOctant);
     Bounds childBoundsUnion;
     for (auto& child : children) {
         childBoundsUnion.x.min = min(octree1.getBounds(*child).x.min, childBoundsUnion.x.min);
@@ -93,7 +96,7 @@ TEST_F(OctreeFixture, Subdivision) {
     // Assert that all vertices in the mesh are present in the leaf octant
     unordered_map<unsigned, bool> vertIndexMap;
     for (auto& leaf : leaves) {
-        mv::common::VertexIndices vi = octree1.getVertices(leaf.get());
+        auto vi = octree1.getVertices(leaf.get());
         for (auto v : vi) {
             // Assert no duplicates are present either within a leaf octant
             // or across a leaf octants
@@ -134,3 +137,400 @@ TEST_F(OctreeFixture, NeighboringVertices) {
     ASSERT_EQ(neighbors.size(), 36);
 
 }
+
+TEST(Octree, LargePointSet) {
+    // Clustered points exercise uneven subdivision
+    mt19937 generator(42);
+    uniform_real_distribution<float> uniform(-10.f, 10.f);
+    normal_distribution<float> cluster(5.f, 0.5f);
+    unsigned const numVertices = 200000;
+    TriangleMesh mesh;
+    mesh.initialize(numVertices, 0);
+    for (unsigned i = 0; i < numVertices; ++i) {
+        if (i % 2) {
+            mesh.addVertex(uniform(generator), uniform(generator), uniform(generator));
+        } else {
+            mesh.addVertex(cluster(generator), cluster(generator), cluster(generator));
+        }
+    }
+
+    Octree octree(mesh, 64);
+    ASSERT_GT(octree.getDepth(), 4);
+
+    // Every vertex is in exactly one leaf and the leaf's bounds contain it
+    vector<unsigned> leafCount(numVertices, 0);
+    for (auto& leaf : octree.getLeafOctants()) {
+        auto vertices = octree.getVertices(leaf.get());
+        ASSERT_LE(vertices.size(), 64);
+        ASSERT_TRUE(is_sorted(vertices.begin(), vertices.end()));
+        auto& bounds = octree.getBounds(leaf.get());
+        for (auto v : vertices) {
+            ++leafCount[v];
+            auto position = mesh.getVertexData().getData() + 3 * v;
+            ASSERT_GE(position[0], bounds.x.min - 1e-4);
+            ASSERT_LE(position[0], bounds.x.max + 1e-4);
+            ASSERT_GE(position[1], bounds.y.min - 1e-4);
+            ASSERT_LE(position[1], bounds.y.max + 1e-4);
+            ASSERT_GE(position[2], bounds.z.min - 1e-4);
+            ASSERT_LE(position[2], bounds.z.max + 1e-4);
+        }
+    }
+    ASSERT_TRUE(all_of(leafCount.begin(), leafCount.end(), [](unsigned c) { return c == 1; }));
+
+    // Neighbors of a vertex are the vertices of its leaf
+    VertexIndices neighbors;
+    octree.getNeighboringVertices(12345, neighbors);
+    ASSERT_NE(find(neighbors.begin(), neighbors.end(), 12345), neighbors.end());
+    ASSERT_LE(neighbors.size(), 64);
+    ASSERT_THROW(octree.getNeighboringVertices(numVertices, neighbors), std::runtime_error);
+}
+
+TEST(Octree, CoincidentVertices) {
+    // Vertices that can't be separated stop subdividing at the resolution of the tree
+    TriangleMesh mesh;
+    mesh.initialize(20, 0);
+    for (unsigned i = 0; i < 19; ++i) mesh.addVertex(1, 1, 1);
+    mesh.addVertex(2, 2, 2);
+    Octree octree(mesh, 4);
+    auto leaves = octree.getLeafOctants();
+    ASSERT_EQ(leaves.size(), 2);
+    VertexIndices neighbors;
+    octree.getNeighboringVertices(0, neighbors);
+    ASSERT_EQ(neighbors.size(), 19);
+}
+
+namespace {
+    // Appends vertices to a mesh and keeps the positions of its vertices
+    void appendVertices(TriangleMesh& mesh, vector<Point3D> const& positions) {
+        auto const vertexData = mesh.getVertexData();
+        auto const* oldPositions = vertexData.getData();
+        auto const numVertices = mesh.getNumberOfVertices();
+        mesh.initialize(numVertices + static_cast<unsigned>(positions.size()), 0);
+        for (unsigned v = 0; v < numVertices; ++v) {
+            mesh.addVertex(oldPositions[3 * v], oldPositions[3 * v + 1], oldPositions[3 * v + 2]);
+        }
+        for (auto& position : positions) {
+            mesh.addVertex(position.x, position.y, position.z);
+        }
+    }
+
+    void setPosition(TriangleMesh& mesh, unsigned vertexIndex, Point3D const& position) {
+        auto positions = mesh.getPositionBuffer();
+        std::copy_n(position.getData(), 3, positions.begin() + 3 * vertexIndex);
+    }
+}
+
+TEST(Octree, PointsOnSplitPlanes) {
+    // Vertices of a lattice lie on the planes that split octants. Point location finds each of them in the leaf
+    // that the build put it in, including vertices that are inserted later
+    TriangleMesh mesh;
+    mesh.initialize(17 * 17 * 17, 0);
+    for (unsigned i = 0; i < 17 * 17 * 17; ++i) {
+        mesh.addVertex(static_cast<float>(i % 17) / 16.f, static_cast<float>(i / 17 % 17) / 3.f,
+                       static_cast<float>(i / 289) * 0.1f);
+    }
+    Octree octree(mesh, 8);
+    auto const* positions = mesh.getVertexData().getData();
+    for (unsigned v = 0; v < mesh.getNumberOfVertices(); ++v) {
+        auto const* position = positions + 3 * v;
+        auto vertices = octree.getOctantVertices(Point3D{position[0], position[1], position[2]});
+        ASSERT_TRUE(binary_search(vertices.begin(), vertices.end(), v)) << v;
+    }
+    vector<Point3D> insertedPositions;
+    for (unsigned v = 0; v < 64; ++v) {
+        insertedPositions.push_back({static_cast<float>(v % 4) / 2.f, static_cast<float>(v / 4 % 4) * 4.f / 3.f, 0.8f});
+    }
+    auto const numVertices = mesh.getNumberOfVertices();
+    appendVertices(mesh, insertedPositions);
+    for (unsigned v = 0; v < 64; ++v) {
+        octree.insertVertex(numVertices + v);
+        auto vertices = octree.getOctantVertices(insertedPositions[v]);
+        ASSERT_TRUE(binary_search(vertices.begin(), vertices.end(), numVertices + v)) << v;
+    }
+}
+
+class OctreeQueries : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            mt19937 generator(7);
+            uniform_real_distribution<float> uniform(-1.f, 1.f);
+            m_mesh.initialize(numVertices, 0);
+            for (unsigned i = 0; i < numVertices; ++i) {
+                m_mesh.addVertex(uniform(generator), uniform(generator), uniform(generator));
+            }
+            for (unsigned i = 0; i < 500; ++i) {
+                // Some queries are outside the mesh bounds
+                m_queries.push_back({1.2f * uniform(generator), 1.2f * uniform(generator), 1.2f * uniform(generator)});
+            }
+        }
+
+        float getSquaredDistance(unsigned vertexIndex, Point3D const& point) const {
+            auto position = m_mesh.getVertexData().getData() + 3 * vertexIndex;
+            return (position[0] - point.x) * (position[0] - point.x) +
+                   (position[1] - point.y) * (position[1] - point.y) +
+                   (position[2] - point.z) * (position[2] - point.z);
+        }
+
+        static constexpr unsigned numVertices = 20000;
+        TriangleMesh m_mesh;
+        vector<Point3D> m_queries;
+};
+
+TEST_F(OctreeQueries, PointLocation) {
+    Octree octree(m_mesh, 32);
+    for (unsigned v = 0; v < numVertices; v += 97) {
+        auto position = m_mesh.getVertexData().getData() + 3 * v;
+        auto vertices = octree.getOctantVertices(Point3D{position[0], position[1], position[2]});
+        ASSERT_TRUE(binary_search(vertices.begin(), vertices.end(), v));
+        VertexIndices neighbors;
+        octree.getNeighboringVertices(v, neighbors);
+        ASSERT_TRUE(equal(vertices.begin(), vertices.end(), neighbors.begin(), neighbors.end()));
+    }
+    ASSERT_TRUE(octree.getOctantVertices(Point3D{5, 0, 0}).empty());
+}
+
+TEST_F(OctreeQueries, Radius) {
+    Octree octree(m_mesh, 32);
+    float const radius = 0.1f;
+    VertexIndices result;
+    for (auto& query : m_queries) {
+        octree.getVerticesInRadius(query, radius, result);
+        VertexIndices expected;
+        for (unsigned v = 0; v < numVertices; ++v) {
+            if (getSquaredDistance(v, query) <= radius * radius) expected.push_back(v);
+        }
+        ASSERT_EQ(result, expected);
+    }
+    ASSERT_THROW(octree.getVerticesInRadius(m_queries.front(), -1.f, result), std::runtime_error);
+
+    vector<VertexIndices> results;
+    octree.getVerticesInRadius(m_queries, radius, results);
+    ASSERT_EQ(results.size(), m_queries.size());
+    for (size_t i = 0; i < m_queries.size(); ++i) {
+        octree.getVerticesInRadius(m_queries[i], radius, result);
+        ASSERT_EQ(results[i], result);
+    }
+}
+
+TEST_F(OctreeQueries, NearestNeighbors) {
+    Octree octree(m_mesh, 32);
+    unsigned const k = 10;
+    VertexIndices result;
+    vector<pair<float, unsigned>> distances(numVertices);
+    for (auto& query : m_queries) {
+        octree.getNearestVertices(query, k, result);
+        for (unsigned v = 0; v < numVertices; ++v) {
+            distances[v] = {getSquaredDistance(v, query), v};
+        }
+        partial_sort(distances.begin(), distances.begin() + k, distances.end());
+        ASSERT_EQ(result.size(), k);
+        for (unsigned i = 0; i < k; ++i) {
+            ASSERT_EQ(result[i], distances[i].second);
+        }
+    }
+
+    octree.getNearestVertices(m_queries.front(), 0, result);
+    ASSERT_TRUE(result.empty());
+    octree.getNearestVertices(m_queries.front(), numVertices + 10, result);
+    ASSERT_EQ(result.size(), numVertices);
+
+    vector<VertexIndices> results;
+    octree.getNearestVertices(m_queries, k, results);
+    ASSERT_EQ(results.size(), m_queries.size());
+    for (size_t i = 0; i < m_queries.size(); ++i) {
+        octree.getNearestVertices(m_queries[i], k, result);
+        ASSERT_EQ(results[i], result);
+    }
+}
+
+TEST_F(OctreeQueries, ConcurrentOctrees) {
+    // Octrees share no state, so they can be built and queried concurrently
+    vector<TriangleMesh> meshes(4);
+    mt19937 generator(11);
+    uniform_real_distribution<float> uniform(-1.f, 1.f);
+    for (auto& mesh : meshes) {
+        mesh.initialize(5000, 0);
+        for (unsigned i = 0; i < 5000; ++i) {
+            mesh.addVertex(uniform(generator), uniform(generator), uniform(generator));
+        }
+        static_cast<void>(mesh.getBounds());
+    }
+    vector<unique_ptr<Octree>> octrees(meshes.size());
+    vector<thread> builders;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        builders.emplace_back([&, i] { octrees[i] = make_unique<Octree>(meshes[i], 16); });
+    }
+    for (auto& builder : builders) builder.join();
+
+    // Concurrent queries against one octree match the queries issued from this thread
+    Octree octree(m_mesh, 32);
+    vector<VertexIndices> results(4);
+    vector<thread> queries;
+    for (size_t i = 0; i < results.size(); ++i) {
+        queries.emplace_back([&, i] { octree.getNearestVertices(m_queries[i], 8, results[i]); });
+    }
+    for (auto& query : queries) query.join();
+    VertexIndices expected;
+    for (size_t i = 0; i < results.size(); ++i) {
+        octree.getNearestVertices(m_queries[i], 8, expected);
+        ASSERT_EQ(results[i], expected);
+    }
+
+    // Each octree indexes its own mesh
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        ASSERT_EQ(&octrees[i]->getMesh(), &meshes[i]);
+        auto position = meshes[i].getVertexData().getData();
+        auto vertices = octrees[i]->getOctantVertices(Point3D{position[0], position[1], position[2]});
+        ASSERT_TRUE(binary_search(vertices.begin(), vertices.end(), 0u));
+    }
+}
+
+namespace {
+    // Asserts that every vertex in the reference set is in exactly one leaf, inside the leaf's bounds, and that
+    // queries agree with a brute force search over the reference set
+    void validateOctree(Octree const& octree, unordered_map<unsigned, Point3D> const& reference,
+                        unsigned maxVerticesInOctant, vector<Point3D> const& queries) {
+        ASSERT_EQ(octree.getNumberOfVertices(), reference.size());
+        unordered_map<unsigned, unsigned> leafCount;
+        for (auto& leaf : octree.getLeafOctants()) {
+            auto vertices = octree.getVertices(leaf.get());
+            ASSERT_LE(vertices.size(), maxVerticesInOctant);
+            ASSERT_TRUE(is_sorted(vertices.begin(), vertices.end()));
+            auto& bounds = octree.getBounds(leaf.get());
+            for (auto v : vertices) {
+                ++leafCount[v];
+                auto& position = reference.at(v);
+                ASSERT_TRUE(position.x >= bounds.x.min && position.x <= bounds.x.max &&
+                            position.y >= bounds.y.min && position.y <= bounds.y.max &&
+                            position.z >= bounds.z.min && position.z <= bounds.z.max);
+            }
+        }
+        ASSERT_EQ(leafCount.size(), reference.size());
+        VertexIndices neighbors;
+        for (auto& [vertex, count] : leafCount) {
+            ASSERT_EQ(count, 1);
+            ASSERT_TRUE(octree.hasVertex(vertex));
+            octree.getNeighboringVertices(vertex, neighbors);
+            ASSERT_TRUE(binary_search(neighbors.begin(), neighbors.end(), vertex));
+        }
+
+        VertexIndices result;
+        vector<pair<float, unsigned>> distances;
+        for (auto& query : queries) {
+            distances.clear();
+            for (auto& [vertex, position] : reference) {
+                distances.emplace_back((position.x - query.x) * (position.x - query.x) +
+                                       (position.y - query.y) * (position.y - query.y) +
+                                       (position.z - query.z) * (position.z - query.z), vertex);
+            }
+            sort(distances.begin(), distances.end());
+            octree.getNearestVertices(query, 5, result);
+            ASSERT_EQ(result.size(), min<size_t>(5, distances.size()));
+            for (size_t i = 0; i < result.size(); ++i) {
+                ASSERT_EQ(result[i], distances[i].second);
+            }
+        }
+    }
+}
+
+TEST_F(OctreeQueries, IncrementalUpdates) {
+    unsigned const maxVerticesInOctant = 16;
+    Octree octree(m_mesh, maxVerticesInOctant);
+    unordered_map<unsigned, Point3D> reference;
+    auto const* positions = m_mesh.getVertexData().getData();
+    for (unsigned v = 0; v < numVertices; ++v) {
+        reference.emplace(v, Point3D{positions[3 * v], positions[3 * v + 1], positions[3 * v + 2]});
+    }
+    vector<Point3D> queries(m_queries.begin(), m_queries.begin() + 20);
+
+    // Remove most vertices from one corner so that octants merge
+    auto const depth = octree.getDepth();
+    auto const numLeaves = octree.getLeafOctants().size();
+    for (unsigned v = 0; v < numVertices; ++v) {
+        auto& position = reference.at(v);
+        if (position.x > 0 && position.y > 0 && position.z > 0) {
+            octree.removeVertex(v);
+            reference.erase(v);
+        }
+    }
+    ASSERT_LT(octree.getLeafOctants().size(), numLeaves);
+    validateOctree(octree, reference, maxVerticesInOctant, queries);
+
+    // Insert vertices that are appended to the mesh, including ones outside the bounds of the octree
+    mt19937 generator(3);
+    uniform_real_distribution<float> uniform(-1.f, 1.f);
+    vector<Point3D> appendedPositions;
+    for (unsigned v = numVertices; v < numVertices + 3000; ++v) {
+        Point3D position {0.5f + 0.1f * uniform(generator), 0.5f + 0.1f * uniform(generator), 2.f * uniform(generator)};
+        if (v % 100 == 0) {
+            position = Point3D{4.f * uniform(generator), 4.f * uniform(generator), 4.f * uniform(generator)};
+        }
+        appendedPositions.push_back(position);
+        reference.emplace(v, position);
+    }
+    appendVertices(m_mesh, appendedPositions);
+    for (unsigned v = numVertices; v < numVertices + 3000; ++v) {
+        octree.insertVertex(v);
+    }
+    ASSERT_GT(octree.getDepth(), depth);
+    auto const& rootBounds = octree.getBounds(octree.getRoot());
+    ASSERT_LE(rootBounds.x.min, -1.f);
+    ASSERT_GE(rootBounds.x.max, 1.f);
+    validateOctree(octree, reference, maxVerticesInOctant, queries);
+
+    // Move vertices, some within their leaves and some across the octree
+    for (unsigned v = 0; v < numVertices + 3000; v += 7) {
+        if (!reference.contains(v)) continue;
+        auto position = reference.at(v);
+        if (v % 2) {
+            position = Point3D{position.x + 1e-4f, position.y, position.z};
+        } else {
+            position = Point3D{uniform(generator), uniform(generator), uniform(generator)};
+        }
+        setPosition(m_mesh, v, position);
+        octree.moveVertex(v);
+        reference[v] = position;
+    }
+    validateOctree(octree, reference, maxVerticesInOctant, queries);
+
+    // Invalid edits
+    ASSERT_THROW(octree.insertVertex(1), std::runtime_error);
+    ASSERT_THROW(octree.insertVertex(numVertices + 5000), std::runtime_error);
+    ASSERT_THROW(octree.removeVertex(numVertices + 5000), std::runtime_error);
+    ASSERT_THROW(octree.moveVertex(numVertices + 5000), std::runtime_error);
+
+    // Removing all vertices merges the octree back into its root
+    for (auto& [vertex, position] : reference) {
+        octree.removeVertex(vertex);
+    }
+    reference.clear();
+    ASSERT_EQ(octree.getDepth(), 1);
+    ASSERT_TRUE(octree.getLeafOctants().empty());
+    validateOctree(octree, reference, maxVerticesInOctant, queries);
+
+    // Emptied octree can be refilled
+    setPosition(m_mesh, 3, Point3D{10, 10, 10});
+    octree.insertVertex(3);
+    reference.emplace(3, Point3D{10, 10, 10});
+    validateOctree(octree, reference, maxVerticesInOctant, queries);
+}
+
+TEST(Octree, InsertIntoEmptyOctree) {
+    TriangleMesh mesh;
+    mesh.initialize(0, 0);
+    Octree octree(mesh, 4);
+    ASSERT_EQ(octree.getNumberOfVertices(), 0);
+    ASSERT_TRUE(octree.getOctantVertices(Point3D{0, 0, 0}).empty());
+    unordered_map<unsigned, Point3D> reference;
+    vector<Point3D> positions;
+    for (unsigned v = 0; v < 50; ++v) {
+        positions.push_back({static_cast<float>(v), static_cast<float>(v % 7), 1.f});
+        reference.emplace(v, positions.back());
+    }
+    appendVertices(mesh, positions);
+    for (unsigned v = 0; v < 50; ++v) {
+        octree.insertVertex(v);
+    }
+    ASSERT_GT(octree.getDepth(), 1);
+    validateOctree(octree, reference, 4, {Point3D{0, 0, 0}, Point3D{25, 3, 1}, Point3D{100, 100, 100}});
+}
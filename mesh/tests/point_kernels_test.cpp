@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include "PointKernels.h"
+#include "MeshNormals.h"
+#include "TriangleMesh.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+using namespace std;
+using namespace mv;
+
+namespace {
+    vector<float> getRandomPoints(size_t numPoints) {
+        mt19937 generator(numPoints);
+        uniform_real_distribution<float> distribution(-100.f, 100.f);
+        vector<float> points(3 * numPoints);
+        generate(points.begin(), points.end(), [&] { return distribution(generator); });
+        return points;
+    }
+
+    common::TransformMatrix getTransform() {
+        // Rotation about z by 90 degrees, non-uniform scale, mirror about the YZ plane and translation
+        common::TransformMatrix transform;
+        transform[0] = math3d::Vector4<float>{0, -2, 0, 0};
+        transform[1] = math3d::Vector4<float>{3, 0, 0, 0};
+        transform[2] = math3d::Vector4<float>{0, 0, 0.5f, 0};
+        transform[3] = math3d::Vector4<float>{10, 20, 30, 1};
+        return transform;
+    }
+}
+
+TEST(PointKernels, Bounds) {
+    // Sizes that exercise the vector blocks, the scalar remainder and multiple ranges
+    for (size_t numPoints : {1, 3, 4, 5, 8, 17, 250001}) {
+        auto points = getRandomPoints(numPoints);
+        auto bounds = PointKernels::computeBounds(points.data(), numPoints);
+        float minimum[3] {points[0], points[1], points[2]};
+        float maximum[3] {points[0], points[1], points[2]};
+        for (size_t i = 0; i < 3 * numPoints; ++i) {
+            minimum[i % 3] = std::min(minimum[i % 3], points[i]);
+            maximum[i % 3] = std::max(maximum[i % 3], points[i]);
+        }
+        ASSERT_FLOAT_EQ(bounds.x.min, minimum[0]) << numPoints << " points";
+        ASSERT_FLOAT_EQ(bounds.y.min, minimum[1]) << numPoints << " points";
+        ASSERT_FLOAT_EQ(bounds.z.min, minimum[2]) << numPoints << " points";
+        ASSERT_FLOAT_EQ(bounds.x.max, maximum[0]) << numPoints << " points";
+        ASSERT_FLOAT_EQ(bounds.y.max, maximum[1]) << numPoints << " points";
+        ASSERT_FLOAT_EQ(bounds.z.max, maximum[2]) << numPoints << " points";
+    }
+}
+
+TEST(PointKernels, TransformPointsInPlace) {
+    auto const transform = getTransform();
+    auto points = getRandomPoints(1001);
+    auto const original = points;
+    PointKernels::transformPoints(transform, points.data(), 1001, points.data());
+    for (size_t i = 0; i < 1001; ++i) {
+        auto expected = transform * math3d::Vector4<float>{original[3*i], original[3*i+1], original[3*i+2], 1.f};
+        ASSERT_NEAR(points[3*i], expected.x, 1e-3);
+        ASSERT_NEAR(points[3*i+1], expected.y, 1e-3);
+        ASSERT_NEAR(points[3*i+2], expected.z, 1e-3);
+    }
+}
+
+TEST(PointKernels, TransformNormals) {
+    // Transformed face normals should match the normals of the transformed faces
+    auto const transform = getTransform();
+    auto points = getRandomPoints(300);
+    vector<unsigned> triangles(300);
+    for (unsigned i = 0; i < 300; ++i) triangles[i] = i;
+    vector<float> normals(300);
+    MeshNormals::computeFaceNormals(points.data(), triangles, normals.data());
+    PointKernels::transformNormals(transform, normals.data(), 100, normals.data());
+
+    PointKernels::transformPoints(transform, points.data(), 300, points.data());
+    vector<float> expectedNormals(300);
+    MeshNormals::computeFaceNormals(points.data(), triangles, expectedNormals.data());
+    for (size_t i = 0; i < 300; ++i) {
+        ASSERT_NEAR(normals[i], expectedNormals[i], 1e-4);
+    }
+}
+
+TEST(PointKernels, TransformMeshWithCachedNormals) {
+    TriangleMesh m;
+    m.initialize(4, 2);
+    m.addVertex(5, 0, 0);
+    m.addVertex(5, 5, 0);
+    m.addVertex(-5, 5, 0);
+    m.addVertex(5, 5, -5);
+    m.addFace({0, 1, 2});
+    m.addFace({0, 1, 3});
+    auto normals = m.getNormals(common::NormalLocation::Face);
+
+    // Uniform scale doesn't change normals
+    common::TransformMatrix scale;
+    scale[0] = math3d::Vector4<float>{3, 0, 0, 0};
+    scale[1] = math3d::Vector4<float>{0, 3, 0, 0};
+    scale[2] = math3d::Vector4<float>{0, 0, 3, 0};
+    auto transformed = m.transform(scale);
+    auto transformedNormals = transformed->getNormals(common::NormalLocation::Face);
+    ASSERT_NE(transformedNormals.getData(), normals.getData());
+    for (unsigned i = 0; i < 6; ++i) {
+        ASSERT_FLOAT_EQ(transformedNormals.getData()[i], normals.getData()[i]);
+    }
+    ASSERT_FLOAT_EQ(transformed->getBounds().x.min, -15);
+    ASSERT_FLOAT_EQ(transformed->getBounds().z.min, -15);
+}
@@ -0,0 +1,254 @@
+#include "gtest/gtest.h"
+#include "TriangleMesh.h"
+#include "MeshFactory.h"
+#include "ReaderFactory.h"
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <cstdlib>
+using namespace std;
+using namespace mv;
+using namespace mv::readers;
+
+class TriangleMeshFixture : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            auto* pData = getenv("modelsDir");
+            if (!pData) throw std::runtime_error("modelsDir environment variable not set");
+            m_modelsDir = pData;
+        }
+
+        filesystem::path m_modelsDir;
+};
+
+TEST(TriangleMesh, FactoryCreatesTriangleMesh) {
+    auto mesh = MeshFactory{}.createMesh();
+    ASSERT_NE(dynamic_cast<TriangleMesh*>(mesh.get()), nullptr) << "Mesh factory should create flat triangle meshes";
+}
+
+TEST(TriangleMesh, TestCentroid) {
+    TriangleMesh m;
+    m.initialize(2, 0);
+    m.addVertex(-5, 0, 0);
+    m.addVertex(+5, 0, 0);
+    auto centroid = m.getCentroid();
+    ASSERT_FLOAT_EQ(centroid.x, 0.0) << "Centroid X coordinate is incorrect" << endl;
+    ASSERT_FLOAT_EQ(centroid.y, 0.0) << "Centroid Y coordinate is incorrect" << endl;
+    ASSERT_FLOAT_EQ(centroid.z, 0.0) << "Centroid Z coordinate is incorrect" << endl;
+}
+
+TEST(TriangleMesh, OnlyTrianglesAreAccepted) {
+    TriangleMesh m;
+    m.initialize(2, 1);
+    m.addVertex(0, 0, 0);
+    m.addVertex(5, 0, 0);
+    ASSERT_THROW(m.addFace({0, 1}), std::runtime_error);
+}
+
+TEST(TriangleMesh, CapacityIsEnforced) {
+    TriangleMesh m;
+    m.initialize(3, 1);
+    m.addVertex(0, 0, 0);
+    m.addVertex(5, 0, 0);
+    m.addVertex(5, 5, 0);
+    ASSERT_THROW(m.addVertex(0, 5, 0), std::runtime_error);
+    m.addFace({0, 1, 2});
+    ASSERT_THROW(m.addFace({0, 1, 2}), std::runtime_error);
+}
+
+TEST(TriangleMesh, DataIsNotCopied) {
+    TriangleMesh m;
+    m.initialize(4, 2);
+    m.addVertex(-5, -5, 0);
+    m.addVertex(+5, -5, 0);
+    m.addVertex(+5, +5, 0);
+    m.addVertex(-5, +5, 0);
+    m.addFace({0, 1, 3});
+    m.addFace({1, 2, 3});
+
+    size_t numBytes = 0;
+    unsigned* connData;
+    m.getConnectivityData(numBytes, connData);
+    ASSERT_EQ(24, numBytes);
+    vector<unsigned> expected {0, 1, 3, 1, 2, 3};
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i], connData[i]);
+    }
+    unsigned* connData1;
+    m.getConnectivityData(numBytes, connData1);
+    ASSERT_EQ(connData, connData1) << "Connectivity data should be handed out without copying";
+
+    auto vertexData = m.getVertexData();
+    ASSERT_EQ(vertexData.getSize(), 4);
+    ASSERT_EQ(vertexData.getDataSize(), 4 * 12);
+    ASSERT_FLOAT_EQ(vertexData.getData()[3], 5);
+    ASSERT_FLOAT_EQ(vertexData.getData()[4], -5);
+    ASSERT_EQ(vertexData.getData(), m.getVertexData().getData()) << "Vertex data should be handed out without copying";
+}
+
+TEST(TriangleMesh, BufferAccess) {
+    TriangleMesh m;
+    m.initialize(3, 1);
+    auto positions = m.getPositionBuffer();
+    auto indices = m.getIndexBuffer();
+    ASSERT_EQ(positions.size(), 9);
+    ASSERT_EQ(indices.size(), 3);
+    float const data[] {0, 0, 0, 5, 0, 0, 5, 5, 0};
+    std::copy(std::begin(data), std::end(data), positions.begin());
+    indices[0] = 0; indices[1] = 1; indices[2] = 2;
+    // Writing the buffers adds all vertices and faces
+    ASSERT_THROW(m.addVertex(1, 1, 1), std::runtime_error);
+    ASSERT_THROW(m.addFace({0, 1, 2}), std::runtime_error);
+    ASSERT_FLOAT_EQ(m.getBounds().x.max, 5);
+    ASSERT_FLOAT_EQ(m.getVertex(2).y, 5);
+    ASSERT_EQ(m.getVertexFaces(1).size(), 1);
+    // Cached data is rebuilt after the buffers are accessed again
+    m.getPositionBuffer()[3] = 7;
+    ASSERT_FLOAT_EQ(m.getBounds().x.max, 7);
+}
+
+TEST(TriangleMesh, ObjectAccessors) {
+    TriangleMesh m;
+    m.initialize(4, 2);
+    m.addVertex(5, 0, 0);
+    m.addVertex(5, 5, 0);
+    m.addVertex(-5, 5, 0);
+    m.addVertex(5, 5, -5);
+    m.addFace({0, 1, 2});
+    m.addFace({0, 1, 3});
+    ASSERT_EQ(m.getVertices().size(), 4);
+    ASSERT_FLOAT_EQ(m.getVertex(2).x, -5);
+    ASSERT_FLOAT_EQ(m.getVertex(3).z, -5);
+    ASSERT_EQ(m.getConnectivity().size(), 2);
+    ASSERT_EQ(m.getFace(1).at(2), 3);
+    auto faces = m.getVertexFaces(1);
+    ASSERT_EQ(faces.size(), 2);
+    ASSERT_EQ(faces[0], 0);
+    ASSERT_EQ(faces[1], 1);
+    ASSERT_EQ(m.getVertexFaces(2).size(), 1);
+    ASSERT_THROW(static_cast<void>(m.getVertexFaces(4)), std::runtime_error);
+    ASSERT_THROW(static_cast<void>(m.getVertex(4)), std::runtime_error);
+    ASSERT_THROW(static_cast<void>(m.getFace(2)), std::runtime_error);
+}
+
+TEST(TriangleMesh, TransformMesh) {
+    TriangleMesh m;
+    m.initialize(3, 1);
+    m.addVertex(0, 0, 0);
+    m.addVertex(5, 0, 0);
+    m.addVertex(5, 5, 0);
+    m.addFace({0, 1, 2});
+    common::TransformMatrix translate;
+    translate[3] = math3d::Vector4<float>{10, 10, 10, 1.0};
+    std::unique_ptr<Mesh> m1 (m.transform(translate));
+    auto v = m1->getVertexData();
+    ASSERT_FLOAT_EQ(v.getData()[0], 10);
+    ASSERT_FLOAT_EQ(v.getData()[1], 10);
+    ASSERT_FLOAT_EQ(v.getData()[2], 10);
+    ASSERT_FLOAT_EQ(v.getData()[3], 15);
+    ASSERT_FLOAT_EQ(v.getData()[4], 10);
+    ASSERT_FLOAT_EQ(v.getData()[5], 10);
+    // Source mesh is unchanged
+    ASSERT_FLOAT_EQ(m.getVertexData().getData()[0], 0);
+    size_t numBytes;
+    unsigned* connData;
+    m1->getConnectivityData(numBytes, connData);
+    ASSERT_EQ(numBytes, 12);
+    ASSERT_EQ(connData[0], 0);
+    ASSERT_EQ(connData[1], 1);
+    ASSERT_EQ(connData[2], 2);
+}
+
+TEST(TriangleMesh, Normals) {
+    TriangleMesh m;
+    m.initialize(4, 2);
+    m.addVertex(5, 0, 0);
+    m.addVertex(5, 5, 0);
+    m.addVertex(-5, 5, 0);
+    m.addVertex(5, 5, -5);
+    m.addFace({0,1,2});
+    m.addFace({0,1,3});
+
+    auto vnormals = m.getNormals(common::NormalLocation::Vertex);
+    ASSERT_EQ(vnormals.getSize(), 4);
+    ASSERT_EQ(vnormals.getDataSize(), 4 * 12);
+    // Vertex 2 has a normal of +z
+    math3d::Vector<float, 3> v{vnormals.getData()[6], vnormals.getData()[7], vnormals.getData()[8]};
+    ASSERT_FLOAT_EQ(v.dot(math3d::Vector<float,3>{0,0,1}), 1);
+    // Vertex 3 has a normal of -x
+    math3d::Vector<float, 3> v1{vnormals.getData()[9], vnormals.getData()[10], vnormals.getData()[11]};
+    ASSERT_FLOAT_EQ(v1.dot(math3d::Vector<float,3>{-1,0,0}), 1);
+    // Shared vertices have the average normal
+    math3d::Vector<float, 3> avg{-1, 0, 1};
+    avg.normalize();
+    math3d::Vector<float, 3> v0{vnormals.getData()[0], vnormals.getData()[1], vnormals.getData()[2]};
+    ASSERT_FLOAT_EQ(v0.dot(avg), 1);
+
+    auto fnormals = m.getNormals(common::NormalLocation::Face);
+    ASSERT_EQ(fnormals.getSize(), 2);
+    ASSERT_FLOAT_EQ((
+                math3d::Vector<float,3>{fnormals.getData()[0], fnormals.getData()[1], fnormals.getData()[2]}.dot(
+                        math3d::Vector<float,3>{0,0,1})), 1);
+    ASSERT_FLOAT_EQ((
+                math3d::Vector<float,3>{fnormals.getData()[3], fnormals.getData()[4], fnormals.getData()[5]}.dot(
+                        math3d::Vector<float,3>{-1,0,0})), 1);
+}
+
+TEST(TriangleMesh, SuppliedNormals) {
+    TriangleMesh m;
+    m.initialize(3, 1);
+    float const positions[] {0, 0, 0, 5, 0, 0, 5, 5, 0};
+    std::copy(std::begin(positions), std::end(positions), m.getPositionBuffer().begin());
+    unsigned const indices[] {0, 1, 2};
+    std::copy(std::begin(indices), std::end(indices), m.getIndexBuffer().begin());
+    auto normals = m.getVertexNormalBuffer();
+    ASSERT_EQ(normals.size(), 9);
+    float const suppliedNormals[] {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    std::copy(std::begin(suppliedNormals), std::end(suppliedNormals), normals.begin());
+
+    // Supplied vertex normals are used as they are and face normals are computed
+    auto const vertexNormals = m.getNormals(common::NormalLocation::Vertex);
+    ASSERT_TRUE(std::equal(std::begin(suppliedNormals), std::end(suppliedNormals), vertexNormals.getData()));
+    auto const faceNormals = m.getNormals(common::NormalLocation::Face);
+    ASSERT_FLOAT_EQ(faceNormals.getData()[2], 1);
+
+    // Supplied normals are transformed with the mesh
+    auto const transformed = m.transform(common::TransformMatrix{});
+    ASSERT_TRUE(std::equal(std::begin(suppliedNormals), std::end(suppliedNormals),
+                           transformed->getNormals(common::NormalLocation::Vertex).getData()));
+
+    // and kept by copies
+    TriangleMesh const copy {m};
+    ASSERT_TRUE(std::equal(std::begin(suppliedNormals), std::end(suppliedNormals),
+                           copy.getNormals(common::NormalLocation::Vertex).getData()));
+
+    // and discarded when positions change
+    m.getPositionBuffer();
+    ASSERT_FLOAT_EQ(m.getNormals(common::NormalLocation::Vertex).getData()[0], 0);
+}
+
+TEST_F(TriangleMeshFixture, RemoveDuplicateVertices) {
+    auto spMesh = ReaderFactory{}.getReader(m_modelsDir/"cube.stl")->getOutput();
+    ASSERT_EQ(spMesh->getNumberOfVertices(), 36);
+    ASSERT_EQ(spMesh->removeDuplicateVertices(), 28);
+    ASSERT_EQ(spMesh->getNumberOfVertices(), 8);
+    ASSERT_EQ(spMesh->getNumberOfFaces(), 12);
+    size_t numBytes;
+    unsigned* connData;
+    spMesh->getConnectivityData(numBytes, connData);
+    for (size_t i = 0; i < numBytes / sizeof(unsigned); ++i) {
+        ASSERT_LT(connData[i], 8);
+    }
+    ASSERT_EQ(spMesh->getNormals(common::NormalLocation::Vertex).getSize(), 8);
+}
+
+TEST_F(TriangleMeshFixture, WriteSTL) {
+    auto inputPath = m_modelsDir/"cube.stl";
+    auto spMesh = ReaderFactory{}.getReader(inputPath)->getOutput();
+    auto outputPath = m_modelsDir/"cubeTriangleMeshOut.stl";
+    filesystem::remove(outputPath);
+    spMesh->writeToSTL(outputPath);
+    ASSERT_EQ(filesystem::file_size(inputPath), filesystem::file_size(outputPath))
+        << "Output STL was supposed to be identical to the input";
+}
@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+#include "VertexFaceAdjacency.h"
+#include "Face.h"
+#include <vector>
+using namespace std;
+using namespace mv;
+
+TEST(VertexFaceAdjacency, Triangles) {
+    // Two triangles sharing the edge 1-2 and an unreferenced vertex 4
+    vector<unsigned> indices {0, 1, 2, 2, 1, 3};
+    VertexFaceAdjacency adjacency(5, indices, 3);
+    ASSERT_EQ(adjacency.getNumberOfVertices(), 5);
+    ASSERT_EQ(adjacency.getFaces(0).size(), 1);
+    ASSERT_EQ(adjacency.getFaces(3).size(), 1);
+    ASSERT_EQ(adjacency.getFaces(3)[0], 1);
+    ASSERT_TRUE(adjacency.getFaces(4).empty());
+    auto faces = adjacency.getFaces(2);
+    ASSERT_EQ(vector<unsigned>(faces.begin(), faces.end()), (vector<unsigned>{0, 1}));
+    ASSERT_THROW(static_cast<void>(adjacency.getFaces(5)), std::runtime_error);
+}
+
+TEST(VertexFaceAdjacency, Polygons) {
+    vector<Face> faces {{0, 1}, {0, 1, 2, 3}, {3, 0, 2}};
+    VertexFaceAdjacency adjacency(4, faces);
+    auto vertexFaces = adjacency.getFaces(0);
+    ASSERT_EQ(vector<unsigned>(vertexFaces.begin(), vertexFaces.end()), (vector<unsigned>{0, 1, 2}));
+    ASSERT_EQ(adjacency.getFaces(1).size(), 2);
+    ASSERT_EQ(adjacency.getFaces(3).size(), 2);
+}
+
+TEST(VertexFaceAdjacency, InvalidInput) {
+    vector<unsigned> indices {0, 1, 2, 2};
+    ASSERT_THROW(VertexFaceAdjacency(3, indices, 3), std::runtime_error);
+    indices = {0, 1, 3};
+    ASSERT_THROW(VertexFaceAdjacency(3, indices, 3), std::runtime_error);
+}
+
+TEST(VertexFaceAdjacency, LargeMesh) {
+    // Triangle strip with enough faces to be processed in parallel. Each interior
+    // vertex is shared by three consecutive faces
+    unsigned const numVertices = 200000;
+    vector<unsigned> indices;
+    indices.reserve((numVertices - 2) * 3);
+    for (unsigned i = 0; i < numVertices - 2; ++i) {
+        indices.insert(indices.end(), {i, i + 1, i + 2});
+    }
+    VertexFaceAdjacency adjacency(numVertices, indices, 3);
+    for (unsigned i = 2; i < numVertices - 2; ++i) {
+        auto faces = adjacency.getFaces(i);
+        ASSERT_EQ(faces.size(), 3);
+        ASSERT_EQ(faces[0], i - 2);
+        ASSERT_EQ(faces[1], i - 1);
+        ASSERT_EQ(faces[2], i);
+    }
+}
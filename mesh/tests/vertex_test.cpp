@@ -11,13 +11,12 @@ TEST(Vertex, FaceAssociation) {
     m.addVertex(0, 0, 0);
     m.addVertex(5, 0, 0);
     m.addFace({0,1});
-    vector<unsigned> faces;
-    m.getVertex(0).getFaces(faces);
+    auto faces = m.getVertexFaces(0);
     ASSERT_EQ(faces.size(), 1);
-    ASSERT_EQ(faces.at(0), 0);
-    m.getVertex(1).getFaces(faces);
+    ASSERT_EQ(faces[0], 0);
+    faces = m.getVertexFaces(1);
     ASSERT_EQ(faces.size(), 1);
-    ASSERT_EQ(faces.at(0), 0);
+    ASSERT_EQ(faces[0], 0);
 }
 
 TEST(Vertex, Normals) {
@@ -32,11 +31,11 @@ TEST(Vertex, Normals) {
     
     // Normals at vertices that are not shared by faces should
     // be equal to face normals 
-    auto vnormal1 = m.getVertex(2).getNormal(m);
+    auto vnormal1 = Vertex::getNormal(m, 2);
     auto fnormal1 = m.getFace(0).getNormal(m);
     ASSERT_FLOAT_EQ(vnormal1.dot(fnormal1), 1); 
     
-    auto vnormal2 = m.getVertex(3).getNormal(m);
+    auto vnormal2 = Vertex::getNormal(m, 3);
     auto fnormal2 = m.getFace(1).getNormal(m);
     ASSERT_FLOAT_EQ(vnormal2.dot(fnormal2), 1); 
 
@@ -49,11 +48,23 @@ TEST(Vertex, Normals) {
     avgNormal.normalize();
     
     // Both normals should be the same 
-    auto vnormal3 = m.getVertex(0).getNormal(m);
-    auto vnormal4 = m.getVertex(1).getNormal(m);
+    auto vnormal3 = Vertex::getNormal(m, 0);
+    auto vnormal4 = Vertex::getNormal(m, 1);
     ASSERT_FLOAT_EQ(vnormal3.dot(vnormal4), 1);
 
     // It should be the average
     ASSERT_FLOAT_EQ(vnormal3.dot(avgNormal), 1);
 
 }
+
+TEST(Vertex, NormalOfUnusedVertex) {
+    MeshImpl m;
+    m.initialize(4, 1);
+    m.addVertex(0, 0, 0);
+    m.addVertex(5, 0, 0);
+    m.addVertex(5, 5, 0);
+    m.addVertex(9, 9, 9);
+    m.addFace({0,1,2});
+    auto const normal = Vertex::getNormal(m, 3);
+    ASSERT_FLOAT_EQ(normal.dot(normal), 0);
+}
@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+#include "VertexWelder.h"
+#include "Face.h"
+#include <vector>
+using namespace std;
+using namespace mv;
+
+TEST(VertexWelder, Tolerance) {
+    vector<float> positions {0, 0, 0,
+                             1, 0, 0,
+                             1e-7f, 0, 0,
+                             1, 0, 1e-3f};
+    VertexWelder welder(positions.data(), 4);
+    ASSERT_EQ(welder.getNumberOfWeldedVertices(), 3);
+    ASSERT_EQ(welder.getWeldedIndex(0), 0);
+    ASSERT_EQ(welder.getWeldedIndex(1), 1);
+    ASSERT_EQ(welder.getWeldedIndex(2), 0);
+    ASSERT_EQ(welder.getWeldedIndex(3), 2);
+
+    // A looser tolerance merges the last vertex too
+    VertexWelder looseWelder(positions.data(), 4, 1e-2f);
+    ASSERT_EQ(looseWelder.getNumberOfWeldedVertices(), 2);
+    ASSERT_EQ(looseWelder.getWeldedIndex(3), 1);
+
+    ASSERT_THROW(VertexWelder(positions.data(), 4, 0.f), std::runtime_error);
+}
+
+TEST(VertexWelder, Chains) {
+    // Each vertex is within tolerance of its neighbours but not of vertices further down the chain
+    vector<float> positions {0, 0, 0, 0.6f, 0, 0, 1.2f, 0, 0};
+    VertexWelder welder(positions.data(), 3, 1.f);
+    ASSERT_EQ(welder.getNumberOfWeldedVertices(), 1);
+    ASSERT_EQ(welder.getWeldedIndex(2), 0);
+}
+
+TEST(VertexWelder, CompactInPlace) {
+    vector<float> positions {0, 0, 0, 1, 1, 1, 0, 0, 0, 2, 2, 2};
+    VertexWelder welder(positions.data(), 4);
+    welder.getWeldedPositions(positions.data());
+    vector<float> expected {0, 0, 0, 1, 1, 1, 2, 2, 2};
+    ASSERT_EQ(vector<float>(positions.begin(), positions.begin() + 9), expected);
+}
+
+TEST(VertexWelder, DegenerateFaces) {
+    // Vertices 0, 3 and 4 are coincident
+    vector<float> positions {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0};
+    VertexWelder welder(positions.data(), 6);
+    ASSERT_EQ(welder.getNumberOfWeldedVertices(), 4);
+
+    vector<unsigned> triangles {0, 1, 2, 3, 1, 4, 4, 2, 5};
+    ASSERT_EQ(welder.weldTriangles(triangles), 2);
+    ASSERT_EQ(vector<unsigned>(triangles.begin(), triangles.begin() + 6), (vector<unsigned>{0, 1, 2, 0, 2, 3}));
+
+    vector<Face> faces {{0, 1, 2, 3}, {3, 1, 4}, {0, 3}, {0, 1}, {4, 2, 5, 0}};
+    welder.weldFaces(faces);
+    ASSERT_EQ(faces.size(), 3);
+    ASSERT_EQ(faces[0].size(), 3);
+    ASSERT_EQ(faces[1].size(), 2);
+    ASSERT_EQ(faces[2].size(), 3);
+    ASSERT_EQ(faces[2].at(0), 0);
+    ASSERT_EQ(faces[2].at(2), 3);
+}
+
+TEST(VertexWelder, UnweldedGrid) {
+    // Grid of quads split into triangles with private vertices, as read from a STL file
+    unsigned const numCells = 200;
+    vector<float> positions;
+    vector<unsigned> triangles;
+    auto addVertex = [&](unsigned i, unsigned j) {
+        triangles.push_back(static_cast<unsigned>(positions.size() / 3));
+        positions.insert(positions.end(), {static_cast<float>(i), static_cast<float>(j), 0.f});
+    };
+    for (unsigned i = 0; i < numCells; ++i) {
+        for (unsigned j = 0; j < numCells; ++j) {
+            addVertex(i, j); addVertex(i + 1, j); addVertex(i + 1, j + 1);
+            addVertex(i, j); addVertex(i + 1, j + 1); addVertex(i, j + 1);
+        }
+    }
+    auto const numVertices = static_cast<unsigned>(positions.size() / 3);
+    VertexWelder welder(positions.data(), numVertices);
+    ASSERT_EQ(welder.getNumberOfWeldedVertices(), (numCells + 1) * (numCells + 1));
+    ASSERT_EQ(welder.weldTriangles(triangles), 2 * numCells * numCells);
+    vector<float> weldedPositions(3 * welder.getNumberOfWeldedVertices());
+    welder.getWeldedPositions(weldedPositions.data());
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        ASSERT_LT(triangles[i], welder.getNumberOfWeldedVertices());
+    }
+    // First triangle is unchanged
+    ASSERT_FLOAT_EQ(weldedPositions[3 * triangles[2]], 1);
+    ASSERT_FLOAT_EQ(weldedPositions[3 * triangles[2] + 1], 1);
+}
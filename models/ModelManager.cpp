@@ -1,14 +1,125 @@
 #include "ModelManager.h"
 #include "EventHandler.h"
 #include "ReaderFactory.h"
+#include "Parallel.h"
 #include "Types.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <format>
+#include <future>
+#include <iostream>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <utility>
 
 namespace mv::models {
 
+    namespace {
+        // Chunks a reader can get ahead of the viewer that draws them
+        constexpr size_t chunkChannelCapacity = 16;
+
+        // Stop source that is stopped as soon as either of two tokens is
+        class JointStopSource {
+        public:
+            JointStopSource(std::stop_token const& first, std::stop_token const& second)
+            : firstCallback(first, Stop{source})
+            , secondCallback(second, Stop{source}) {}
+
+            [[nodiscard]] std::stop_token getToken() const { return source.get_token(); }
+
+        private:
+            struct Stop {
+                std::stop_source& source;
+                void operator()() const { source.request_stop(); }
+            };
+            std::stop_source source;
+            std::stop_callback<Stop> firstCallback;
+            std::stop_callback<Stop> secondCallback;
+        };
+
+        // Budget for the memory of the files that are read at once. A file that needs more than the whole budget
+        // is read on its own
+        class MemoryBudget {
+        public:
+            explicit MemoryBudget(size_t const bytes) : available(bytes), total(bytes) {}
+
+            void acquire(size_t const bytes) {
+                std::unique_lock lock{mutex};
+                released.wait(lock, [this, needed = std::min(bytes, total)] { return available >= needed; });
+                available -= std::min(bytes, total);
+            }
+
+            // Takes the bytes if they are available without waiting
+            bool tryAcquire(size_t const bytes) {
+                std::lock_guard lock{mutex};
+                if (available < std::min(bytes, total)) return false;
+                available -= std::min(bytes, total);
+                return true;
+            }
+
+            void release(size_t const bytes) {
+                {
+                    std::lock_guard lock{mutex};
+                    available += std::min(bytes, total);
+                }
+                released.notify_all();
+            }
+
+        private:
+            std::mutex mutex;
+            std::condition_variable released;
+            size_t available;
+            size_t const total;
+        };
+
+        // Memory a read is expected to hold. Readers keep the decoded geometry and the mesh that is built from it,
+        // which take about twice the size of a binary file. Files whose size can't be determined count as empty
+        size_t getReadMemory(std::filesystem::path const& modelFile) {
+            std::error_code errorCode;
+            auto const fileSize = std::filesystem::file_size(modelFile, errorCode);
+            return errorCode ? 0 : 2 * static_cast<size_t>(fileSize);
+        }
+
+        // Normals are the costliest part of a mesh's render data that doesn't need the graphics card, so meshes that
+        // are read in the background compute them there instead of in the first frame that draws them
+        void computeNormals(Drawable::DrawablePointer const& drawable) {
+            if (auto* mesh = dynamic_cast<Mesh*>(drawable.get())) {
+                static_cast<void>(mesh->getNormals(common::NormalLocation::Vertex));
+            }
+        }
+
+        std::unique_ptr<Octree const> buildSpatialIndex(Drawable::DrawablePointer const& drawable) {
+            auto* mesh = dynamic_cast<Mesh*>(drawable.get());
+            return mesh && mesh->getNumberOfVertices() ? std::make_unique<Octree const>(*mesh) : nullptr;
+        }
+    }
+
+    template<typename Task>
+    void ModelManager::runInBackground(Task&& task) {
+#ifdef EMSCRIPTEN
+        // Web builds have a small, fixed pool of workers, so models are read on the main thread
+        task();
+#else
+        // Tasks that are done are dropped, so that they don't pile up over a long session
+        std::erase_if(backgroundTasks, [](auto const& backgroundTask) {
+            return backgroundTask.wait_for(std::chrono::seconds{}) == std::future_status::ready;
+        });
+        backgroundTasks.push_back(std::async(std::launch::async, std::forward<Task>(task)));
+#endif
+    }
+
+    template<typename Task>
+    void ModelManager::postToViewer(Task&& task) {
+        // The manager is destroyed on the thread that renders, so it is either gone before the task runs or stays
+        // until the task is done
+        viewer.post([alive = std::weak_ptr{alive}, task = std::forward<Task>(task)] {
+            if (!alive.expired()) task();
+        });
+    }
+
     ModelManager::ModelDrawablePair::ModelDrawablePair(std::filesystem::path file,
                                                        Drawable::DrawablePointer&& drawable)
     : modelFile(std::move(file))
@@ -20,7 +131,10 @@ namespace mv::models {
     , mode(mode)
     , loaded(false)
     , viewer(viewer)
-    , readerFactory(std::move(readerFactory)) {
+    , readerFactory(std::move(readerFactory))
+    , memoryBudget(size_t{2} << 30)
+    , prefetchCount{}
+    , alive(std::make_shared<bool>(true)) {
         events::EventHandler{}.registerBasicEventCallback(
                 events::Event{GLFW_KEY_M, GLFW_MOD_SHIFT},
                 *this,
@@ -37,36 +151,218 @@ namespace mv::models {
         }
     }
 
+    void ModelManager::setMemoryBudget(size_t const bytes) {
+        std::lock_guard lock{modelLoadMutex};
+        memoryBudget = bytes;
+    }
+
+    void ModelManager::setPrefetchCount(size_t const count) {
+        std::lock_guard lock{modelLoadMutex};
+        prefetchCount = count;
+    }
+
     void ModelManager::loadModelFiles(std::vector<std::string> const& modelFiles) {
+        addModelFiles(modelFiles);
+        if (mode == Mode::DisplayMultipleModels) {
+            setModels(readModelFiles(getModelFiles(), stopSource.get_token()));
+        } else if (!modelDrawables.empty()) {
+            auto& model = modelDrawables[currentModel];
+            model.modelDrawable = readModelFile(model.modelFile, stopSource.get_token());
+            prefetchModels();
+        }
+        addModelsToViewer();
+    }
+
+    std::future<void> ModelManager::loadModelFilesAsync(std::vector<std::string> const& modelFiles,
+                                                        std::stop_token stopToken) {
+        addModelFiles(modelFiles);
+        auto loaded = std::make_shared<std::promise<void>>();
+        auto future = loaded->get_future();
+        auto onLoaded = [loaded](std::exception_ptr const& exception) {
+            exception ? loaded->set_exception(exception) : loaded->set_value();
+        };
+
+        if (mode == Mode::DisplaySingleModel) {
+            if (modelDrawables.empty()) {
+                onLoaded(nullptr);
+            } else {
+                readModel(0, std::move(stopToken), onLoaded);
+                prefetchModels();
+            }
+            return future;
+        }
+
+        runInBackground([this, modelFiles = getModelFiles(), stopToken = std::move(stopToken), onLoaded] {
+            try {
+                JointStopSource stop {stopToken, stopSource.get_token()};
+                auto loadedModels = std::make_shared<std::vector<LoadedModel>>(
+                        readModelFiles(modelFiles, stop.getToken()));
+                postToViewer([this, loadedModels, onLoaded] {
+                    setModels(std::move(*loadedModels));
+                    addModelsToViewer();
+                    onLoaded(nullptr);
+                });
+            } catch (...) {
+                onLoaded(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+    void ModelManager::addModelFiles(std::vector<std::string> const& modelFiles) {
         std::lock_guard lock{modelLoadMutex};
         if (loaded) {
             throw std::runtime_error(std::format("Error in {}. "
                                                  "At this time, {} does not support loading models "
                                                  "more than once", __PRETTY_FUNCTION__, common::AppName));
         }
-
-        for (decltype(currentModel) i = 0; i < modelFiles.size(); ++i) {
+        for (auto const& modelFile : modelFiles) {
             // Filter out duplicates (including models with same name and different extension)
-            if (auto modelName = std::filesystem::path{modelFiles[i]}.stem(); !modelNames.contains(modelName)) {
+            if (auto modelName = std::filesystem::path{modelFile}.stem(); !modelNames.contains(modelName)) {
                 modelNames.insert(modelName);
-                if (mode == Mode::DisplayMultipleModels) {
-                    modelDrawables.emplace_back(modelFiles[i], readerFactory->getReader(modelFiles[i])->getOutput());
-                } else {
-                    modelDrawables.emplace_back(modelFiles[i],
-                                                !i ? readerFactory->getReader(modelFiles[i])->getOutput() : nullptr);
+                modelDrawables.emplace_back(modelFile, nullptr);
+            }
+        }
+        loaded = true;
+    }
+
+    std::vector<std::filesystem::path> ModelManager::getModelFiles() const {
+        std::vector<std::filesystem::path> modelFiles;
+        std::transform(modelDrawables.begin(), modelDrawables.end(), std::back_inserter(modelFiles),
+                       [](auto const& drawableEntry) { return drawableEntry.modelFile; });
+        return modelFiles;
+    }
+
+    std::vector<ModelManager::LoadedModel> ModelManager::readModelFiles(
+            std::vector<std::filesystem::path> const& modelFiles, std::stop_token const& stopToken) const {
+        // Largest files are read first, so that a large file that is read last doesn't keep the other threads idle
+        std::vector<size_t> readMemory(modelFiles.size());
+        std::transform(modelFiles.begin(), modelFiles.end(), readMemory.begin(), getReadMemory);
+        std::vector<size_t> readOrder(modelFiles.size());
+        std::iota(readOrder.begin(), readOrder.end(), 0);
+        std::stable_sort(readOrder.begin(), readOrder.end(),
+                         [&readMemory](size_t const a, size_t const b) { return readMemory[a] > readMemory[b]; });
+
+        // The calling thread hands the files to the pool in the read order, each once it fits in the budget, so that
+        // threads of the pool never wait for the budget. While a file doesn't fit, the calling thread reads files that
+        // the pool hasn't started yet. A reader that runs on a thread of the pool does its parallel work on that
+        // thread instead of adding threads per file
+        std::vector<LoadedModel> loadedModels(modelFiles.size());
+        MemoryBudget budget {memoryBudget};
+        auto readFile = [&](size_t const fileIndex) {
+            try {
+                auto& loadedModel = loadedModels[fileIndex];
+                loadedModel.drawable = readModelFile(modelFiles[fileIndex], stopToken);
+                computeNormals(loadedModel.drawable);
+                loadedModel.spatialIndex = buildSpatialIndex(loadedModel.drawable);
+            } catch (readers::ReadCancelled const&) {
+                // The batch ends once the files that were handed over are done
+            } catch (...) {
+                reportLoadFailure(modelFiles[fileIndex], std::current_exception());
+            }
+            budget.release(readMemory[fileIndex]);
+        };
+
+        // Tasks of the pool that start after the files they were submitted for were read return without touching the
+        // caller's state
+        struct HandedOverFiles {
+            std::deque<size_t> notStarted;
+            size_t numNotDone = 0;
+            std::mutex mutex;
+            std::condition_variable filesDone;
+        };
+        auto const handedOver = std::make_shared<HandedOverFiles>();
+        auto readNextFile = [handedOver, &readFile] {
+            size_t fileIndex;
+            {
+                std::lock_guard lock{handedOver->mutex};
+                if (handedOver->notStarted.empty()) return false;
+                fileIndex = handedOver->notStarted.front();
+                handedOver->notStarted.pop_front();
+            }
+            readFile(fileIndex);
+            std::lock_guard lock{handedOver->mutex};
+            if (!--handedOver->numNotDone) handedOver->filesDone.notify_one();
+            return true;
+        };
+
+        auto& threadPool = common::getThreadPool();
+        auto const useThreadPool = !common::ThreadPool::isPoolThread() && threadPool.getNumberOfThreads();
+        for (auto const fileIndex : readOrder) {
+            if (stopToken.stop_requested()) break;
+            while (!budget.tryAcquire(readMemory[fileIndex])) {
+                // Files that were handed over and are not read by the calling thread are read by the pool, which
+                // gives their budget back
+                if (!readNextFile()) {
+                    budget.acquire(readMemory[fileIndex]);
+                    break;
                 }
             }
+            {
+                std::lock_guard lock{handedOver->mutex};
+                handedOver->notStarted.push_back(fileIndex);
+                ++handedOver->numNotDone;
+            }
+            if (useThreadPool) {
+                threadPool.submit([readNextFile] { readNextFile(); });
+            }
+        }
+        while (readNextFile()) {}
+        {
+            std::unique_lock lock{handedOver->mutex};
+            handedOver->filesDone.wait(lock, [&handedOver] { return !handedOver->numNotDone; });
+        }
+        if (stopToken.stop_requested()) {
+            throw readers::ReadCancelled("Loading the models was stopped");
+        }
+        return loadedModels;
+    }
+
+    Drawable::DrawablePointer ModelManager::readModelFile(std::filesystem::path const& modelFile,
+                                                          std::stop_token const& stopToken,
+                                                          std::shared_ptr<MeshChunkChannel> chunkChannel) const {
+        auto reader = readerFactory->getReader(modelFile);
+        reader->setStopToken(stopToken);
+        reader->setChunkChannel(std::move(chunkChannel));
+        // Events are raised on the thread that renders, since event handlers aren't thread safe
+        reader->setProgressCallback([this, modelFile = modelFile.string()](readers::ReadProgress const& progress) {
+            viewer.post([modelFile, progress] {
+                events::EventHandler{}.raiseEvent(events::Event{events::EventId::ModelLoadProgressed},
+                                                  {modelFile, progress.bytesRead, progress.totalBytes,
+                                                   progress.elementsRead});
+            });
+        });
+        return reader->getOutput();
+    }
+
+    void ModelManager::reportLoadFailure(std::filesystem::path const& modelFile,
+                                         std::exception_ptr const& exception) const {
+        std::string reason = "Unknown error";
+        try {
+            std::rethrow_exception(exception);
+        } catch (std::exception const& ex) {
+            reason = ex.what();
+        } catch (...) {}
+        std::cerr << std::format("Unable to load {}. {}", modelFile.string(), reason) << std::endl;
+        viewer.post([modelFile = modelFile.string(), reason] {
+            events::EventHandler{}.raiseEvent(events::Event{events::EventId::ModelLoadFailed}, {modelFile, reason});
+        });
+    }
+
+    void ModelManager::setModels(std::vector<LoadedModel>&& loadedModels) {
+        for (size_t i = 0; i < modelDrawables.size(); ++i) {
+            modelDrawables[i].modelDrawable = std::move(loadedModels[i].drawable);
+            modelDrawables[i].spatialIndex = std::move(loadedModels[i].spatialIndex);
         }
+    }
 
-        // render loaded models
+    void ModelManager::addModelsToViewer() {
         std::vector<Drawable::DrawablePointer> drawablesToRender;
         std::transform(modelDrawables.begin(), modelDrawables.end(), std::back_inserter(drawablesToRender),
                        [](auto &drawableEntry) { return drawableEntry.modelDrawable; });
         drawablesToRender.erase(std::remove(drawablesToRender.begin(), drawablesToRender.end(), nullptr),
                                 drawablesToRender.end());
         viewer.add(drawablesToRender);
-
-        loaded = true;
     }
 
     void ModelManager::loadModelFilesFromDirectory(std::filesystem::path const& modelFilesDirectory) {
@@ -87,21 +383,141 @@ namespace mv::models {
             throw std::runtime_error("Cannot cycle through models when there all the loaded models are displayed");
         }
         if (modelDrawables.size() > 1) {
-            viewer.remove(modelDrawables[currentModel].modelDrawable);
+            hideModel(currentModel);
             ++currentModel;
             if (currentModel == modelDrawables.size()) {
                 currentModel = 0;
             }
-            if (!modelDrawables[currentModel].modelDrawable) {
-                modelDrawables[currentModel].modelDrawable =
-                        std::move(readerFactory->getReader(modelDrawables[currentModel].modelFile)->getOutput());
+            showModel(currentModel);
+            prefetchModels();
+        }
+    }
+
+    void ModelManager::showModel(size_t const modelIndex) {
+        auto& model = modelDrawables[modelIndex];
+        // Models that are being read are added when they are read
+        if (!model.modelDrawable && !model.chunkChannel) {
+            readModel(modelIndex);
+        }
+        if (model.modelDrawable) {
+            viewer.add(model.modelDrawable);
+        }
+    }
+
+    void ModelManager::hideModel(size_t const modelIndex) {
+        auto& model = modelDrawables[modelIndex];
+        if (model.modelDrawable) {
+            viewer.remove(model.modelDrawable);
+        } else if (model.preview) {
+            // The model is still read, but what has been read so far is no longer shown
+            viewer.remove(model.preview);
+            model.preview.reset();
+            model.chunkChannel->close();
+        }
+    }
+
+    void ModelManager::readModel(size_t const modelIndex, std::stop_token stopToken, ReadCallback onRead) {
+        auto& model = modelDrawables[modelIndex];
+        auto chunkChannel = std::make_shared<MeshChunkChannel>(chunkChannelCapacity);
+        auto const isCurrent = modelIndex == currentModel;
+#ifndef EMSCRIPTEN
+        // Web builds read on the main thread, where nothing would draw the chunks while the model is read
+        if (isCurrent) {
+            model.preview = readerFactory->getMeshFactory().createProgressiveMesh(chunkChannel);
+        }
+#endif
+        if (isCurrent && !model.preview && !onRead) {
+            model.modelDrawable = readModelFile(model.modelFile, stopSource.get_token());
+            return;
+        }
+
+        // The channel marks the model as being read
+        model.chunkChannel = chunkChannel;
+        if (model.preview) {
+            viewer.add(model.preview);
+        }
+        runInBackground([this, modelIndex, modelFile = model.modelFile, chunkChannel, hasPreview = !!model.preview,
+                         stopToken = std::move(stopToken), onRead = std::move(onRead)] {
+            Drawable::DrawablePointer modelDrawable;
+            std::exception_ptr exception;
+            try {
+                JointStopSource stop {stopToken, stopSource.get_token()};
+                modelDrawable = readModelFile(modelFile, stop.getToken(), hasPreview ? chunkChannel : nullptr);
+                computeNormals(modelDrawable);
+            } catch (readers::ReadCancelled const&) {
+                exception = std::current_exception();
+            } catch (...) {
+                exception = std::current_exception();
+                reportLoadFailure(modelFile, exception);
+            }
+            chunkChannel->close();
+
+            // The viewer and the models are only changed on the thread that renders
+            postToViewer([this, modelIndex, modelDrawable, exception, onRead] {
+                auto& model = modelDrawables[modelIndex];
+                if (model.preview) {
+                    viewer.remove(model.preview);
+                    model.preview.reset();
+                }
+                model.chunkChannel.reset();
+                model.modelDrawable = modelDrawable;
+                if (model.modelDrawable && modelIndex == currentModel) {
+                    viewer.add(model.modelDrawable);
+                }
+                if (onRead) {
+                    onRead(exception);
+                }
+            });
+        });
+    }
+
+    void ModelManager::prefetchModels() {
+#ifndef EMSCRIPTEN
+        // Web builds read on the main thread, where reading models that aren't shown would keep the viewer waiting
+        if (mode != Mode::DisplaySingleModel || !prefetchCount) return;
+        auto const numModels = modelDrawables.size();
+        for (size_t modelIndex = 0; modelIndex < numModels; ++modelIndex) {
+            // Models are cycled through in a loop, so the last model is next to the first
+            auto const offset = (modelIndex + numModels - currentModel) % numModels;
+            auto const distance = std::min(offset, numModels - offset);
+            auto& model = modelDrawables[modelIndex];
+            if (!distance || model.chunkChannel) {
+                continue;
+            }
+            if (distance <= prefetchCount) {
+                if (!model.modelDrawable) readModel(modelIndex);
+            } else {
+                model.spatialIndex.reset();
+                model.modelDrawable.reset();
             }
-            viewer.add(modelDrawables[currentModel].modelDrawable);
         }
+#endif
+    }
+
+    ModelManager::~ModelManager() {
+        // Readers stop after the piece they are reading. Readers that wait for room in their channel are let go by
+        // closing it
+        stopSource.request_stop();
+        for (auto& model : modelDrawables) {
+            if (model.chunkChannel) model.chunkChannel->close();
+        }
+        for (auto& backgroundTask : backgroundTasks) {
+            backgroundTask.wait();
+        }
+        // Reset once nothing posts any more tasks
+        alive.reset();
     }
 
     size_t ModelManager::getNumberOfModels() const {
         return modelDrawables.size();
     }
 
+    Octree const* ModelManager::getSpatialIndex(size_t const modelIndex) const {
+        if (modelIndex >= modelDrawables.size()) {
+            throw std::runtime_error(std::format("Error in {}. Model index {} is invalid", __PRETTY_FUNCTION__,
+                                                 modelIndex));
+        }
+        return modelDrawables[modelIndex].spatialIndex.get();
+    }
+
 }
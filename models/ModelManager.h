@@ -4,7 +4,13 @@
 #include "ReaderFactory.h"
 #include "ViewerFactory.h"
 #include "Drawable.h"
+#include "Octree.h"
+#include <exception>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stop_token>
 #include <vector>
 #include <string>
 #include <unordered_set>
@@ -27,13 +33,33 @@ namespace mv::models {
                      std::unique_ptr<readers::IReaderFactory const>&& = std::make_unique<readers::ReaderFactory>(),
                      viewer::Viewer& = viewer::ViewerFactory::getViewer());
         void setMode(Mode);
+        // Bytes that the reads of models in DisplayMultipleModels mode may hold at once. Files are read on as many
+        // threads as there are cores, as long as the files being read fit in the budget
+        void setMemoryBudget(size_t bytes);
+        // Models before and after the current model in DisplaySingleModel mode that are read in the background, so
+        // that cycling to them shows them at once. Models further away are released
+        void setPrefetchCount(size_t count);
+        // Returns once the models are read and handed to the viewer. Throws the error of the model in
+        // DisplaySingleModel mode, while the models it prefetches are still read in the background
         void loadModelFiles(std::vector<std::string> const&);
+        // Reads the models on worker threads and hands them to the viewer on the thread that renders, which keeps
+        // drawing while they are read. Progress is raised as ModelLoadProgressed events on the thread that renders.
+        // The future is ready once the models are handed to the viewer. It holds readers::ReadCancelled if a stop was
+        // requested through the token, or the error of the model in DisplaySingleModel mode. Call before rendering
+        // starts or on the thread that renders
+        std::future<void> loadModelFilesAsync(std::vector<std::string> const&, std::stop_token = {});
         void loadModelFilesFromDirectory(std::filesystem::path const&);
         [[nodiscard]] size_t getNumberOfModels() const;
+        // Spatial index of a model. Indices are built for all models when they are loaded in DisplayMultipleModels
+        // mode. Models that are not loaded or have no vertices don't have an index
+        [[nodiscard]] Octree const* getSpatialIndex(size_t modelIndex) const;
 
         // Implementation logic
         void cycleThroughModels();
 
+        // Waits for the models that are read in the background. Call on the thread that renders, if it is rendering
+        ~ModelManager();
+
         // No copy or move semantics
         ModelManager(ModelManager const&) = delete;
         ModelManager(ModelManager&&) = delete;
@@ -44,8 +70,47 @@ namespace mv::models {
         struct ModelDrawablePair {
             std::filesystem::path modelFile;
             Drawable::DrawablePointer modelDrawable;
+            // Refers to the model drawable's mesh, so it is declared after the drawable to be destroyed first
+            std::unique_ptr<Octree const> spatialIndex;
+            // Shows the model while it is read in the background. The channel is set while the model is read
+            Drawable::DrawablePointer preview;
+            std::shared_ptr<MeshChunkChannel> chunkChannel;
             ModelDrawablePair(std::filesystem::path  file, Drawable::DrawablePointer&& drawable);
         };
+        struct LoadedModel {
+            Drawable::DrawablePointer drawable;
+            std::unique_ptr<Octree const> spatialIndex;
+        };
+        using ReadCallback = std::function<void(std::exception_ptr)>;
+        // Adds the files to the models, skipping files of models that were added before
+        void addModelFiles(std::vector<std::string> const&);
+        [[nodiscard]] std::vector<std::filesystem::path> getModelFiles() const;
+        // Reads the files on the calling thread and the threads of common::getThreadPool() and indexes the meshes,
+        // returning the models in the order of the files. Files that can't be read are reported and leave their model
+        // empty. Only a stop ends the batch
+        std::vector<LoadedModel> readModelFiles(std::vector<std::filesystem::path> const&,
+                                                std::stop_token const&) const;
+        // Reads a model file on the calling thread
+        Drawable::DrawablePointer readModelFile(std::filesystem::path const&, std::stop_token const&,
+                                                std::shared_ptr<MeshChunkChannel> = nullptr) const;
+        // Prints why a model could not be loaded and raises a ModelLoadFailed event on the thread that renders
+        void reportLoadFailure(std::filesystem::path const&, std::exception_ptr const&) const;
+        void setModels(std::vector<LoadedModel>&&);
+        void addModelsToViewer();
+        // Reads a model. Models that aren't current, models the mesh factory can show while they are read and
+        // models with an onRead are read on threads of their own, and the current model is shown while it is read.
+        // A model is added to the viewer once it is read if it is current by then, after which onRead is called on
+        // the thread that renders
+        void readModel(size_t modelIndex, std::stop_token = {}, ReadCallback onRead = {});
+        // Reads the models around the current model in the background and releases the others
+        void prefetchModels();
+        void showModel(size_t modelIndex);
+        void hideModel(size_t modelIndex);
+        template<typename Task>
+        void runInBackground(Task&&);
+        // Runs a task on the thread that renders, unless the manager is destroyed before it runs
+        template<typename Task>
+        void postToViewer(Task&&);
         std::vector<ModelDrawablePair> modelDrawables;
         std::vector<ModelDrawablePair>::size_type currentModel;
         Mode mode;
@@ -53,7 +118,14 @@ namespace mv::models {
         bool loaded;
         viewer::Viewer& viewer;
         std::mutex modelLoadMutex;
+        size_t memoryBudget;
+        size_t prefetchCount;
         std::unordered_set<std::string> modelNames;
+        std::vector<std::future<void>> backgroundTasks;
+        // Stops the background reads when the manager is destroyed
+        std::stop_source stopSource;
+        // Tasks posted to the viewer hold it weakly and are skipped once it is reset
+        std::shared_ptr<bool> alive;
     };
 
 }
\ No newline at end of file
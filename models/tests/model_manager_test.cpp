@@ -4,7 +4,11 @@
 #include "EventHandler.h"
 #include "MockViewer.h"
 #include "ModelManager.h"
+#include "Parallel.h"
 #include "gmock/gmock.h"
+#include <mutex>
+#include <set>
+#include <thread>
 using namespace mv::models;
 using namespace testing;
 
@@ -57,6 +61,122 @@ namespace mv {
         ASSERT_EQ(modelManager.getNumberOfModels(), 3) << "Wrong number of models";
     }
 
+    TEST(ModelManager, ShowTheFirstModelWhileItIsRead) {
+        auto mrf = std::make_unique<MockReaderFactory>();
+        mrf->mockMeshFactory.createsProgressiveMeshes = true;
+        mrf->readers.emplace("a", std::make_unique<MockReader>());
+        mrf->readers.emplace("b", std::make_unique<MockReader>());
+        MockViewer mockViewer;
+        ModelManager modelManager {ModelManager::Mode::DisplaySingleModel, std::move(mrf), mockViewer};
+        auto loaded = modelManager.loadModelFilesAsync({"a" , "b"});
+        ASSERT_TRUE(mockViewer.addSingleDrawableCalled) << "Model not shown while it is read";
+        ASSERT_EQ(mockViewer.numDrawables, 0) << "Model added before it was read";
+
+        // Once the model is read, the drawable that showed it is replaced by the model's mesh on the thread that
+        // renders
+        mockViewer.addSingleDrawableCalled = false;
+        ASSERT_TRUE(mockViewer.runPostedTasks()) << "Model not handed to the viewer after it was read";
+        ASSERT_TRUE(mockViewer.removeCalled) << "Drawable that showed the model while it was read not removed";
+        ASSERT_TRUE(mockViewer.addSingleDrawableCalled) << "Model not added after it was read";
+        ASSERT_NO_THROW(loaded.get());
+    }
+
+    TEST(ModelManager, LoadTheFirstModelThatFails) {
+        // The model is read on the calling thread, so its error reaches the caller
+        auto mrf = std::make_unique<MockReaderFactory>();
+        mrf->mockMeshFactory.createsProgressiveMeshes = true;
+        auto failingReader = std::make_unique<MockReader>();
+        EXPECT_CALL(*failingReader, getOutput(_)).WillOnce(Throw(std::runtime_error("Corrupt file")));
+        mrf->readers.emplace("a", std::move(failingReader));
+        MockViewer mockViewer;
+        ModelManager modelManager {ModelManager::Mode::DisplaySingleModel, std::move(mrf), mockViewer};
+        ASSERT_THROW(modelManager.loadModelFiles({"a"}), std::runtime_error);
+        ASSERT_FALSE(mockViewer.addSingleDrawableCalled) << "Model shown while it was read";
+        ASSERT_EQ(mockViewer.numDrawables, 0) << "Model that failed added";
+    }
+
+    TEST(ModelManager, LoadModelsAsynchronously) {
+        auto mrf = std::make_unique<MockReaderFactory>();
+        mrf->readers.emplace("a", std::make_unique<MockReader>());
+        mrf->readers.emplace("b", std::make_unique<MockReader>());
+        MockViewer mockViewer;
+        ModelManager modelManager {ModelManager::Mode::DisplayMultipleModels, std::move(mrf), mockViewer};
+        auto loaded = modelManager.loadModelFilesAsync({"a" , "b"});
+        ASSERT_EQ(modelManager.getNumberOfModels(), 2) << "Wrong number of models";
+
+        // Models are handed to the viewer on the thread that renders
+        ASSERT_TRUE(mockViewer.runPostedTasks()) << "Models not handed to the viewer after they were read";
+        ASSERT_EQ(loaded.wait_for(std::chrono::seconds{}), std::future_status::ready);
+        ASSERT_NO_THROW(loaded.get());
+        ASSERT_EQ(mockViewer.numDrawables, 2) << "Wrong number of drawables";
+    }
+
+    TEST(ModelManager, DestroyBeforeModelsAreHandedOver) {
+        // Models that are read after the manager is gone are dropped instead of being handed to the viewer
+        MockViewer mockViewer;
+        std::future<void> loaded;
+        {
+            auto mrf = std::make_unique<MockReaderFactory>();
+            mrf->readers.emplace("a", std::make_unique<MockReader>());
+            ModelManager modelManager {ModelManager::Mode::DisplayMultipleModels, std::move(mrf), mockViewer};
+            loaded = modelManager.loadModelFilesAsync({"a"});
+            // The models are read and wait for the thread that renders
+            for (bool posted = false; !posted; std::this_thread::yield()) {
+                std::lock_guard lock{mockViewer.postedTasksMutex};
+                posted = !mockViewer.postedTasks.empty();
+            }
+        }
+        ASSERT_TRUE(mockViewer.runPostedTasks());
+        ASSERT_EQ(mockViewer.numDrawables, 0) << "Models handed to the viewer after the manager was destroyed";
+        ASSERT_THROW(loaded.get(), std::future_error);
+    }
+
+    TEST(ModelManager, LoadModelsThatFail) {
+        // Files that can't be read leave their model empty without keeping the other models from loading
+        auto mrf = std::make_unique<MockReaderFactory>();
+        auto failingReader = std::make_unique<MockReader>();
+        EXPECT_CALL(*failingReader, getOutput(_)).WillOnce(Throw(std::runtime_error("Corrupt file")));
+        mrf->readers.emplace("a", std::make_unique<MockReader>());
+        mrf->readers.emplace("b", std::move(failingReader));
+        mrf->readers.emplace("c", std::make_unique<MockReader>());
+        MockViewer mockViewer;
+        ModelManager modelManager {ModelManager::Mode::DisplayMultipleModels, std::move(mrf), mockViewer};
+        modelManager.setMemoryBudget(0);
+        testing::internal::CaptureStderr();
+        modelManager.loadModelFiles({"a" , "b", "c"});
+        ASSERT_THAT(testing::internal::GetCapturedStderr(), HasSubstr("Unable to load b. Corrupt file"));
+        ASSERT_EQ(modelManager.getNumberOfModels(), 3) << "Wrong number of models";
+        ASSERT_EQ(mockViewer.numDrawables, 2) << "Wrong number of drawables";
+    }
+
+    TEST(ModelManager, LoadModelsWithoutNestingThreads) {
+        // Readers that work in parallel while other files are read share the threads that read the files
+        std::mutex threadsMutex;
+        std::set<std::thread::id> threads;
+        auto createReader = [&] {
+            auto reader = std::make_unique<MockReader>();
+            ON_CALL(*reader, getOutput).WillByDefault([&](Mesh::MeshPointer) {
+                common::parallelFor(common::getConcurrency() * 4, [&](size_t, size_t) {
+                    std::lock_guard lock{threadsMutex};
+                    threads.insert(std::this_thread::get_id());
+                }, 1);
+                return std::make_unique<MockMesh>();
+            });
+            return reader;
+        };
+        auto mrf = std::make_unique<MockReaderFactory>();
+        std::vector<std::string> modelFiles;
+        for (unsigned i = 0; i < 2 * common::getConcurrency(); ++i) {
+            modelFiles.push_back(std::to_string(i));
+            mrf->readers.emplace(modelFiles.back(), createReader());
+        }
+        MockViewer mockViewer;
+        ModelManager modelManager {ModelManager::Mode::DisplayMultipleModels, std::move(mrf), mockViewer};
+        modelManager.loadModelFiles(modelFiles);
+        ASSERT_EQ(mockViewer.numDrawables, modelFiles.size()) << "Wrong number of drawables";
+        ASSERT_LE(threads.size(), common::getConcurrency()) << "Reads started threads of their own";
+    }
+
     TEST(ModelManager, LoadModelFilesFromDirectory) {
         auto mrf = std::make_unique<MockReaderFactory>();
         MockViewer mockViewer;
@@ -117,6 +237,29 @@ namespace mv {
         ASSERT_TRUE(mockViewer.addSingleDrawableCalled) << "Drawable not added during model cycle through event";
     }
 
+    TEST(ModelManager, PrefetchModels) {
+        // The models next to the current model are read in the background, so cycling to them shows them at once.
+        // Models are cycled through in a loop, so the last model comes before the first
+        auto mrf = std::make_unique<MockReaderFactory>();
+        EXPECT_CALL(*mrf, getReader("a")).Times(Exactly(1));
+        EXPECT_CALL(*mrf, getReader("b")).Times(Exactly(1));
+        EXPECT_CALL(*mrf, getReader("c")).Times(Exactly(1));
+        EXPECT_CALL(*mrf, getReader("d")).Times(Exactly(0));
+        EXPECT_CALL(*mrf, getReader("e")).Times(Exactly(1));
+        for (auto const* name : {"a", "b", "c", "d", "e"}) {
+            mrf->readers.emplace(name, std::make_unique<MockReader>());
+        }
+        MockViewer mockViewer;
+        ModelManager modelManager {ModelManager::Mode::DisplaySingleModel, std::move(mrf), mockViewer};
+        modelManager.setPrefetchCount(1);
+        modelManager.loadModelFiles({"a" , "b", "c", "d", "e"});
+        ASSERT_TRUE(mockViewer.runPostedTasks(2)) << "Models next to the first model not read";
+
+        modelManager.cycleThroughModels();
+        ASSERT_TRUE(mockViewer.addSingleDrawableCalled) << "Prefetched model not shown at once";
+        ASSERT_TRUE(mockViewer.runPostedTasks()) << "Model after the current model not read";
+    }
+
     TEST(ModelManager, ChangeMode) {
         std::unique_ptr<MockReaderFactory> mrf {std::make_unique<MockReaderFactory>()};
         MockViewer mockViewer;
@@ -133,4 +276,45 @@ namespace mv {
         ASSERT_EQ(modelManager.getNumberOfModels(), 3) << "Wrong number of models";
         ASSERT_EQ(mockViewer.numDrawables, 3) << "Wrong number of drawables";
     }
+
+    TEST(ModelManager, SpatialIndices) {
+        // Each model in DisplayMultipleModels mode gets a spatial index
+        auto createReader = [](unsigned const numVertices) {
+            auto reader = std::make_unique<MockReader>();
+            ON_CALL(*reader, getOutput).WillByDefault([numVertices](Mesh::MeshPointer) {
+                auto mesh = std::make_unique<NiceMock<MockMesh>>();
+                Mesh::VertexData vertexData(numVertices);
+                for (unsigned i = 0; i < numVertices * 3; ++i) {
+                    vertexData.getData()[i] = static_cast<float>(i);
+                }
+                ON_CALL(*mesh, getNumberOfVertices).WillByDefault(Return(numVertices));
+                ON_CALL(*mesh, getVertexData).WillByDefault(Return(vertexData));
+                ON_CALL(*mesh, getBounds).WillByDefault(
+                        Return(common::Bounds{{0, 1, 2}, {3.f * numVertices - 3, 3.f * numVertices - 2, 3.f * numVertices - 1}}));
+                return mesh;
+            });
+            return reader;
+        };
+        auto mrf = std::make_unique<MockReaderFactory>();
+        mrf->readers.emplace("a", createReader(500));
+        mrf->readers.emplace("b", createReader(2000));
+        mrf->readers.emplace("c", std::make_unique<MockReader>());
+        MockViewer mockViewer;
+        ModelManager modelManager {ModelManager::Mode::DisplayMultipleModels, std::move(mrf), mockViewer};
+        modelManager.loadModelFiles({"a" , "b", "c"});
+        ASSERT_NE(modelManager.getSpatialIndex(0), nullptr);
+        ASSERT_EQ(modelManager.getSpatialIndex(0)->getMesh().getNumberOfVertices(), 500);
+        ASSERT_NE(modelManager.getSpatialIndex(1), nullptr);
+        ASSERT_EQ(modelManager.getSpatialIndex(1)->getMesh().getNumberOfVertices(), 2000);
+        // Models without vertices aren't indexed
+        ASSERT_EQ(modelManager.getSpatialIndex(2), nullptr);
+        ASSERT_THROW(static_cast<void>(modelManager.getSpatialIndex(3)), std::runtime_error);
+
+        // Spatial indices are not built in DisplaySingleModel mode
+        auto mrf1 = std::make_unique<MockReaderFactory>();
+        mrf1->readers.emplace("a", createReader(500));
+        ModelManager modelManager1 {ModelManager::Mode::DisplaySingleModel, std::move(mrf1), mockViewer};
+        modelManager1.loadModelFiles({"a"});
+        ASSERT_EQ(modelManager1.getSpatialIndex(0), nullptr);
+    }
 }
\ No newline at end of file
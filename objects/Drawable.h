@@ -50,6 +50,13 @@ class Drawable : public Renderable {
 
         [[nodiscard]] virtual bool is3D() const { return false; }
 
+        // Drawables that change without the viewer being told, e.g. because another thread feeds them, have to be
+        // drawn again
+        [[nodiscard]] virtual bool requiresRedraw() const { return false; }
+
+        // Takes in what changed since the last frame. Viewports call this before the camera looks at the bounds
+        virtual void update() {}
+
     protected:
         // Set the shader transform matrix inputs
         virtual void setTransforms() = 0;
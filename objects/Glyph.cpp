@@ -81,6 +81,7 @@ void Glyph::generateRenderData() {
 
 size_t Glyph::buildVertexNormalData() {
 
+    auto const vertexData = m_mesh.getVertexData();
     auto const normalData =
         m_mesh.getNormals(common::NormalLocation::Vertex);
 
@@ -95,25 +96,29 @@ size_t Glyph::buildVertexNormalData() {
     // 6 floats per glyph, 3 floats per end point
     m_vertexData = std::make_unique<float[]>(6*m_numGlyphs);
     numBytes = (6*m_numGlyphs) * sizeof(float);
-    for (size_t i = 0; i < m_numGlyphs; ++i) {
-        const auto& v = m_mesh.getVertex(i);
-        const auto& vn = v.getNormal(m_mesh);
+    auto const* v = vertexData.getData();
+    auto const* vn = normalData.getData();
+    for (size_t i = 0; i < m_numGlyphs; ++i, v += 3, vn += 3) {
         // End point 1
-        m_vertexData[6*i]   = v.x;
-        m_vertexData[6*i+1] = v.y;
-        m_vertexData[6*i+2] = v.z;
+        m_vertexData[6*i]   = v[0];
+        m_vertexData[6*i+1] = v[1];
+        m_vertexData[6*i+2] = v[2];
         // End point 2
-        m_vertexData[6*i+3] = v.x + scale * (vn[0]);
-        m_vertexData[6*i+4] = v.y + scale * (vn[1]);
-        m_vertexData[6*i+5] = v.z + scale * (vn[2]);
+        m_vertexData[6*i+3] = v[0] + scale * (vn[0]);
+        m_vertexData[6*i+4] = v[1] + scale * (vn[1]);
+        m_vertexData[6*i+5] = v[2] + scale * (vn[2]);
     }
     return numBytes;
 }
 
 size_t Glyph::buildFaceNormalData() {
 
+    auto const vertexData = m_mesh.getVertexData();
     auto const normalData =
         m_mesh.getNormals(common::NormalLocation::Face);
+    size_t connectivityDataSize;
+    unsigned* connectivityData;
+    m_mesh.getConnectivityData(connectivityDataSize, connectivityData);
 
     // Render normal glyphs a 10th of the mesh size
     auto scale = m_mesh.getBounds().length() * 0.1f;
@@ -122,18 +127,24 @@ size_t Glyph::buildFaceNormalData() {
     m_numGlyphs = m_mesh.getNumberOfFaces();
     m_vertexData = std::make_unique<float[]>(6*m_numGlyphs);
     size_t numBytes = (6*m_numGlyphs) * sizeof(float);
-    for (size_t i = 0; i < m_numGlyphs; ++i) {
-        const auto& f = m_mesh.getFace(i);
-        const auto& c = m_mesh.getFace(i).getCentroid(m_mesh);
-        const auto& fn = f.getNormal(m_mesh);
+    auto const* vertices = vertexData.getData();
+    auto const* fn = normalData.getData();
+    // NOTE: Like the mesh's render logic, this assumes the mesh is triangulated
+    for (size_t i = 0; i < m_numGlyphs; ++i, fn += 3) {
+        auto const* a = vertices + 3 * connectivityData[3*i];
+        auto const* b = vertices + 3 * connectivityData[3*i+1];
+        auto const* c = vertices + 3 * connectivityData[3*i+2];
+        common::Point3D centroid {(a[0] + b[0] + c[0]) / 3.f,
+                                  (a[1] + b[1] + c[1]) / 3.f,
+                                  (a[2] + b[2] + c[2]) / 3.f};
         // End point 1
-        m_vertexData[6*i]   = c.x;
-        m_vertexData[6*i+1] = c.y;
-        m_vertexData[6*i+2] = c.z;
+        m_vertexData[6*i]   = centroid.x;
+        m_vertexData[6*i+1] = centroid.y;
+        m_vertexData[6*i+2] = centroid.z;
         // End point 2
-        m_vertexData[6*i+3] = c.x + scale * (fn[0]);
-        m_vertexData[6*i+4] = c.y + scale * (fn[1]);
-        m_vertexData[6*i+5] = c.z + scale * (fn[2]);
+        m_vertexData[6*i+3] = centroid.x + scale * (fn[0]);
+        m_vertexData[6*i+4] = centroid.y + scale * (fn[1]);
+        m_vertexData[6*i+5] = centroid.z + scale * (fn[2]);
     }
     return numBytes;
 }
@@ -28,6 +28,10 @@ public:
     [[nodiscard]]
     virtual common::Bounds getBounds() const = 0;
 
+    // Renderables that have nothing to show yet have no bounds, so their bounds and centroid are left out of the view
+    [[nodiscard]]
+    virtual bool hasBounds() const { return true; }
+
     virtual void notifyDisplayResized(common::DisplayDimensions const& displayDimensions) {
         aspectRatio =
             static_cast<float>(displayDimensions.frameBufferWidth) /
@@ -0,0 +1,115 @@
+#include "CachedReader.h"
+#include "MappedFile.h"
+#include "MeshCacheFormat.h"
+#include "MeshCacheReader.h"
+#include "MeshCacheWriter.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace mv::readers {
+
+namespace {
+    using MeshPointer = Reader::MeshPointer;
+
+    // Has to be changed when readers change the meshes they create from a file, so that meshes that were cached
+    // by earlier versions are read again
+    constexpr unsigned readerVersion = 1;
+    constexpr string_view cacheExtension = "mvmesh";
+    // Entries that hold the key of a file's contents
+    constexpr string_view keyExtension = "mvkey";
+}
+
+CachedReader::CachedReader(std::string fn, IMeshFactory const& meshFactory, std::unique_ptr<Reader> reader,
+                           std::shared_ptr<DerivedDataCache const> cache)
+    : Reader(std::move(fn), meshFactory)
+    , reader(std::move(reader))
+    , cache(std::move(cache)) {
+}
+
+MeshPointer CachedReader::getOutput(MeshPointer mesh) {
+    // The mesh depends on the reader, which is chosen by the file's extension, and on the import settings
+    auto const parameters = filesystem::path{fileName}.extension().string() + ' ' +
+                            to_string(common::meshcache::version) + ' ' + to_string(readerVersion) +
+                            (cleanupOnImport ? " cleanup" : "");
+
+    // Files that didn't change since they were cached are found by their path, size and modification time, which
+    // point at the key of their contents, without reading them. Other files are found by their contents, so that
+    // copies and files that were only touched are found too
+    auto const fileKey = DerivedDataCache::getFileKey(fileName, parameters);
+    if (fileKey) {
+        if (auto const key = findContentKey(*fileKey); key && readEntry(*key, mesh)) {
+            return std::move(mesh);
+        }
+    }
+    auto const key = getContentKey(parameters);
+    if (readEntry(key, mesh)) {
+        if (fileKey) storeContentKey(*fileKey, key);
+        return std::move(mesh);
+    }
+
+    reader->setChunkChannel(chunkChannel);
+    reader->setProgressCallback(progressCallback);
+    reader->setStopToken(stopToken);
+    mesh = reader->getOutput(std::move(mesh));
+
+    // The entry is written while the mesh is used. What is written is taken from the mesh now, since the mesh can
+    // change or be destroyed before the entry is written
+    cache->storeInBackground(key, string{cacheExtension},
+                             [contents = writers::MeshCacheWriter::getContents(*mesh)](filesystem::path const& path) {
+        writers::MeshCacheWriter{path.string()}.write(contents);
+    });
+    // Stored after the entry, so that it doesn't point at an entry that isn't written yet
+    if (fileKey) storeContentKey(*fileKey, key);
+    return std::move(mesh);
+}
+
+string CachedReader::getContentKey(string const& parameters) const {
+    MappedFile const file(fileName);
+    vector<char> fileData;
+    if (!file.isMapped()) {
+        ifstream ifs(fileName, ios::binary);
+        if (!ifs) {
+            throw std::runtime_error("Unable to open file " + fileName + '!');
+        }
+        fileData.assign(istreambuf_iterator<char>(ifs), istreambuf_iterator<char>());
+    }
+    return DerivedDataCache::getKey(file.isMapped() ? file.getData() : fileData, parameters);
+}
+
+optional<string> CachedReader::findContentKey(string const& fileKey) const {
+    auto const entry = cache->find(fileKey, keyExtension);
+    if (!entry) return nullopt;
+    string key;
+    // Another process can remove the entry before it is read
+    if (!getline(ifstream{*entry}, key) || key.empty()) return nullopt;
+    return key;
+}
+
+void CachedReader::storeContentKey(string const& fileKey, string const& key) const {
+    cache->storeInBackground(fileKey, string{keyExtension}, [key](filesystem::path const& path) {
+        ofstream ofs(path);
+        ofs << key << '\n';
+        ofs.close();
+        if (!ofs) throw std::runtime_error("Unable to write " + path.string());
+    });
+}
+
+bool CachedReader::readEntry(string const& key, MeshPointer& mesh) const {
+    auto const entry = cache->find(key, cacheExtension);
+    if (!entry) return false;
+    try {
+        mesh = MeshCacheReader{entry->string(), meshFactory}.readFile(mesh);
+        return true;
+    } catch (std::exception const& ex) {
+        // Another process removed the entry before it could be opened or the entry is damaged
+        if (debug) cout << "Unable to read " << *entry << " from the cache. " << ex.what() << endl;
+        return false;
+    }
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <string>
+#include "Reader.h"
+#include "DerivedDataCache.h"
+
+namespace mv::readers {
+
+// Reads files through another reader and keeps the meshes it reads, along with their normals and bounds, in a
+// derived data cache as .mvmesh files. Meshes are written to the cache in the background after they are handed
+// over. Files that were read before are opened from the cache instead
+class CachedReader : public Reader {
+    public:
+        MeshPointer getOutput(Mesh::MeshPointer = nullptr) override;
+    private:
+        CachedReader(std::string fileName, IMeshFactory const&, std::unique_ptr<Reader> reader,
+                     std::shared_ptr<DerivedDataCache const> cache);
+        // Hashes the whole file
+        [[nodiscard]] std::string getContentKey(std::string const& parameters) const;
+        // Key of the contents of the file that was stored for the key of its status
+        [[nodiscard]] std::optional<std::string> findContentKey(std::string const& fileKey) const;
+        void storeContentKey(std::string const& fileKey, std::string const& key) const;
+        // Leaves the mesh as it is if there is no entry or it can't be read
+        bool readEntry(std::string const& key, Mesh::MeshPointer&) const;
+
+        std::unique_ptr<Reader> const reader;
+        std::shared_ptr<DerivedDataCache const> const cache;
+
+    friend class ReaderFactory;
+};
+
+}
@@ -0,0 +1,22 @@
+#include "CompressedReader.h"
+using namespace std;
+
+namespace mv::readers {
+
+CompressedReader::CompressedReader(std::string fn, IMeshFactory const& meshFactory, std::unique_ptr<Reader> reader,
+                                   Compression const compression)
+    : Reader(std::move(fn), meshFactory)
+    , reader(std::move(reader))
+    , compression(compression) {
+}
+
+Reader::MeshPointer CompressedReader::getOutput(MeshPointer mesh) {
+    DecompressingStream stream(fileName, compression);
+    reader->setChunkChannel(chunkChannel);
+    // Progress is measured in decompressed bytes, whose total isn't known up front
+    reader->setProgressCallback(progressCallback);
+    reader->setStopToken(stopToken);
+    return reader->readStream(stream, std::move(mesh));
+}
+
+}
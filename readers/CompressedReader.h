@@ -0,0 +1,23 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "Reader.h"
+#include "DecompressingStream.h"
+
+namespace mv::readers {
+
+// Reads compressed files through the reader of the format they were compressed from. The file is decompressed
+// while the reader parses it, see DecompressingStream
+class CompressedReader : public Reader {
+    public:
+        MeshPointer getOutput(Mesh::MeshPointer = nullptr) override;
+    private:
+        CompressedReader(std::string fileName, IMeshFactory const&, std::unique_ptr<Reader> reader, Compression);
+
+        std::unique_ptr<Reader> const reader;
+        Compression const compression;
+
+    friend class ReaderFactory;
+};
+
+}
@@ -0,0 +1,257 @@
+#include "DecompressingStream.h"
+#include "BoundedQueue.h"
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+#include <vector>
+#ifdef HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+using namespace std;
+
+namespace mv::readers {
+
+namespace {
+    // Size of the buffers decompressed data is handed over in and the number of them. Decompression waits for the
+    // stream when all of them are full
+    constexpr size_t bufferSize = 1 << 20;
+    constexpr size_t numBuffers = 4;
+
+    // Size of the reads of compressed data
+    constexpr size_t inputSize = 1 << 18;
+
+    // A buffer of decompressed data. Buffers are full except for the last one
+    struct Chunk {
+        vector<char> data;
+        size_t size;
+    };
+}
+
+class DecompressingStream::Buffer : public std::streambuf {
+    public:
+        Buffer(string fileName, Compression const compression)
+            : m_fileName(std::move(fileName))
+            , m_filled(numBuffers)
+            , m_free(numBuffers) {
+            if (!isSupported(compression)) {
+                throw std::runtime_error("Unable to read " + m_fileName + ". Its compression format is not supported");
+            }
+            m_file.open(m_fileName, ios::binary);
+            if (!m_file) {
+                throw std::runtime_error("Unable to open file " + m_fileName + '!');
+            }
+            for (size_t i = 0; i < numBuffers; ++i) {
+                m_free.push(vector<char>(bufferSize));
+            }
+            m_thread = thread(&Buffer::decompress, this, compression);
+        }
+
+        ~Buffer() override {
+            // Stops decompression if the stream isn't read to its end
+            m_filled.close();
+            m_free.close();
+            m_thread.join();
+        }
+
+    protected:
+        int_type underflow() override {
+            if (m_current) {
+                m_free.push(std::move(m_current->data));
+                m_current.reset();
+            }
+            m_current = m_filled.pop();
+            if (!m_current) {
+                if (m_error) rethrow_exception(m_error);
+                return traits_type::eof();
+            }
+            auto* data = m_current->data.data();
+            setg(data, data, data + m_current->size);
+            return traits_type::to_int_type(*data);
+        }
+
+    private:
+        // Fills buffers and hands them to the stream. Returns false when the stream is destroyed
+        class Output {
+            public:
+                explicit Output(Buffer& buffer) : m_buffer(buffer) {}
+
+                bool start() {
+                    m_data = m_buffer.m_free.pop();
+                    m_size = 0;
+                    return m_data.has_value();
+                }
+
+                [[nodiscard]] char* getNext() { return m_data->data() + m_size; }
+                [[nodiscard]] size_t getAvailable() const { return bufferSize - m_size; }
+
+                // Hands the buffer over when it is full and continues with a free one
+                bool advance(size_t const size) {
+                    m_size += size;
+                    return m_size < bufferSize || (flush() && start());
+                }
+
+                bool flush() {
+                    return !m_size || m_buffer.m_filled.push({std::move(*m_data), m_size});
+                }
+
+            private:
+                Buffer& m_buffer;
+                optional<vector<char>> m_data;
+                size_t m_size = 0;
+        };
+
+        // Reads the next piece of the compressed file. Returns 0 at the end of the file
+        size_t read(vector<char>& input) {
+            m_file.read(input.data(), static_cast<streamsize>(input.size()));
+            if (m_file.bad()) {
+                throw std::runtime_error("Unable to read file " + m_fileName + '!');
+            }
+            return static_cast<size_t>(m_file.gcount());
+        }
+
+        [[noreturn]] void throwTruncated() const {
+            throw std::runtime_error("Compressed file " + m_fileName + " is truncated");
+        }
+
+        void decompress(Compression const compression) {
+            try {
+                Output output {*this};
+                if (!output.start()) return;
+                if (compression == Compression::Gzip ? gunzip(output) : unzstd(output)) {
+                    output.flush();
+                }
+            } catch (...) {
+                m_error = current_exception();
+            }
+            m_filled.close();
+        }
+
+        // Each decompression function returns false if the stream was destroyed before the file was decompressed.
+        // Decompressors can hold back output when the buffer they write to fills up, so they are called again
+        // without new input until they leave room in the buffer
+
+        bool gunzip([[maybe_unused]] Output& output) {
+#ifdef HAS_ZLIB
+            z_stream stream{};
+            // Detects gzip and zlib headers
+            if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+                throw std::runtime_error("Unable to decompress " + m_fileName);
+            }
+            unique_ptr<z_stream, int(*)(z_stream*)> const end {&stream, inflateEnd};
+            vector<char> input(inputSize);
+            bool isOutputFull = false;
+            // Files can be several gzip members one after the other. They have to end with a complete member
+            bool isMemberComplete = false;
+            while (true) {
+                if (!stream.avail_in && !isOutputFull) {
+                    stream.next_in = reinterpret_cast<Bytef*>(input.data());
+                    stream.avail_in = static_cast<uInt>(read(input));
+                    if (!stream.avail_in) break;
+                }
+                stream.next_out = reinterpret_cast<Bytef*>(output.getNext());
+                stream.avail_out = static_cast<uInt>(output.getAvailable());
+                auto const result = inflate(&stream, Z_NO_FLUSH);
+                if (result == Z_STREAM_END) {
+                    inflateReset(&stream);
+                    isMemberComplete = true;
+                } else if (result == Z_OK) {
+                    isMemberComplete = false;
+                } else if (result != Z_BUF_ERROR) {
+                    throw std::runtime_error(m_fileName + " is not a valid gzip file. " +
+                                             (stream.msg ? stream.msg : "Error " + to_string(result)));
+                }
+                isOutputFull = !stream.avail_out;
+                if (!output.advance(output.getAvailable() - stream.avail_out)) return false;
+            }
+            if (!isMemberComplete) throwTruncated();
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        bool unzstd([[maybe_unused]] Output& output) {
+#ifdef HAS_ZSTD
+            unique_ptr<ZSTD_DStream, size_t(*)(ZSTD_DStream*)> const stream {ZSTD_createDStream(), ZSTD_freeDStream};
+            if (!stream || ZSTD_isError(ZSTD_initDStream(stream.get()))) {
+                throw std::runtime_error("Unable to decompress " + m_fileName);
+            }
+            vector<char> input(inputSize);
+            ZSTD_inBuffer in {input.data(), 0, 0};
+            bool isOutputFull = false;
+            // Frames are complete when the decompressor has no more data to return
+            size_t result = 0;
+            bool hasInput = false;
+            while (true) {
+                if (in.pos == in.size && !isOutputFull) {
+                    in.size = read(input);
+                    in.pos = 0;
+                    if (!in.size) break;
+                    hasInput = true;
+                }
+                ZSTD_outBuffer out {output.getNext(), output.getAvailable(), 0};
+                result = ZSTD_decompressStream(stream.get(), &out, &in);
+                if (ZSTD_isError(result)) {
+                    throw std::runtime_error(m_fileName + " is not a valid zstd file. " + ZSTD_getErrorName(result));
+                }
+                isOutputFull = out.pos == out.size;
+                if (!output.advance(out.pos)) return false;
+            }
+            if (result || !hasInput) throwTruncated();
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        string const m_fileName;
+        ifstream m_file;
+        // Buffers that hold decompressed data and buffers that the stream is done with
+        common::BoundedQueue<Chunk> m_filled;
+        common::BoundedQueue<vector<char>> m_free;
+        // Buffer the stream reads from
+        optional<Chunk> m_current;
+        // Set before m_filled is closed
+        exception_ptr m_error;
+        thread m_thread;
+};
+
+DecompressingStream::DecompressingStream(std::string const& fileName, Compression const compression)
+    : std::istream(nullptr)
+    , m_buffer(make_unique<Buffer>(fileName, compression)) {
+    rdbuf(m_buffer.get());
+    // Decompression errors are thrown by the buffer, which the stream only passes on when it is asked to
+    exceptions(ios::badbit);
+}
+
+DecompressingStream::~DecompressingStream() = default;
+
+std::optional<Compression> DecompressingStream::getCompression(std::filesystem::path const& file) {
+    auto extension = file.extension().string();
+    transform(extension.begin(), extension.end(), extension.begin(), [](char const c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+    });
+    if (extension == ".gz") return Compression::Gzip;
+    if (extension == ".zst") return Compression::Zstd;
+    return nullopt;
+}
+
+bool DecompressingStream::isSupported(Compression const compression) {
+    switch (compression) {
+#ifdef HAS_ZLIB
+        case Compression::Gzip: return true;
+#endif
+#ifdef HAS_ZSTD
+        case Compression::Zstd: return true;
+#endif
+        default: return false;
+    }
+}
+
+}
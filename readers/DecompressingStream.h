@@ -0,0 +1,39 @@
+#pragma once
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace mv::readers {
+
+    // Formats of compressed files
+    enum class Compression {
+        Gzip,
+        Zstd,
+    };
+
+    // A stream of the decompressed contents of a compressed file. The file is decompressed on a thread of its own
+    // into a few fixed size buffers, which are handed to the stream through a bounded queue and reused once the
+    // stream is done with them. Decompression overlaps with parsing and the decompressed contents are never held in
+    // memory as a whole. Errors found while decompressing are thrown by the stream's read functions
+    class DecompressingStream : public std::istream {
+    public:
+        DecompressingStream(std::string const& fileName, Compression);
+        ~DecompressingStream() override;
+
+        DecompressingStream(DecompressingStream const&) = delete;
+        DecompressingStream& operator=(DecompressingStream const&) = delete;
+
+        // Compression of a file by its extension, e.g. .gz or .zst. Files with other extensions aren't compressed
+        static std::optional<Compression> getCompression(std::filesystem::path const&);
+
+        // Whether this build is linked with the library that decompresses the format
+        static bool isSupported(Compression);
+
+    private:
+        class Buffer;
+        std::unique_ptr<Buffer> m_buffer;
+    };
+
+}
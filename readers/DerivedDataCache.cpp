@@ -0,0 +1,210 @@
+#include "DerivedDataCache.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace mv::readers {
+
+namespace {
+    // XXH64. Its four independent accumulators keep the multipliers busy, so a thread hashes several GB/s
+    class Hash {
+    public:
+        static uint64_t get(char const* data, size_t const size, uint64_t const seed = 0) {
+            auto const* end = data + size;
+            uint64_t hash;
+            if (size >= 32) {
+                array<uint64_t, 4> accumulators {seed + prime1 + prime2, seed + prime2, seed, seed - prime1};
+                for (; end - data >= 32; data += 32) {
+                    for (unsigned i = 0; i < 4; ++i) {
+                        accumulators[i] = round(accumulators[i], read<uint64_t>(data + 8 * i));
+                    }
+                }
+                hash = rotl(accumulators[0], 1) + rotl(accumulators[1], 7) +
+                       rotl(accumulators[2], 12) + rotl(accumulators[3], 18);
+                for (auto const accumulator : accumulators) {
+                    hash = (hash ^ round(0, accumulator)) * prime1 + prime4;
+                }
+            } else {
+                hash = seed + prime5;
+            }
+            hash += size;
+            for (; end - data >= 8; data += 8) {
+                hash = rotl(hash ^ round(0, read<uint64_t>(data)), 27) * prime1 + prime4;
+            }
+            if (end - data >= 4) {
+                hash = rotl(hash ^ read<uint32_t>(data) * prime1, 23) * prime2 + prime3;
+                data += 4;
+            }
+            for (; data != end; ++data) {
+                hash = rotl(hash ^ static_cast<unsigned char>(*data) * prime5, 11) * prime1;
+            }
+            hash = (hash ^ hash >> 33) * prime2;
+            hash = (hash ^ hash >> 29) * prime3;
+            return hash ^ hash >> 32;
+        }
+
+    private:
+        static constexpr uint64_t prime1 = 0x9E3779B185EBCA87;
+        static constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4F;
+        static constexpr uint64_t prime3 = 0x165667B19E3779F9;
+        static constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63;
+        static constexpr uint64_t prime5 = 0x27D4EB2F165667C5;
+
+        static uint64_t rotl(uint64_t const value, int const shift) { return std::rotl(value, shift); }
+
+        static uint64_t round(uint64_t const accumulator, uint64_t const input) {
+            return rotl(accumulator + input * prime2, 31) * prime1;
+        }
+
+        template<typename T>
+        static uint64_t read(char const* data) {
+            T value;
+            memcpy(&value, data, sizeof(T));
+            return value;
+        }
+    };
+
+    // Files are hashed in chunks of a fixed size, so that keys don't depend on the number of threads
+    constexpr size_t chunkSize = 1 << 22;
+
+    // Temporary files of entries that are being written. Ones older than this were left by processes that died
+    constexpr auto abandonedFileAge = chrono::hours(1);
+    constexpr string_view temporaryExtension = ".tmp";
+}
+
+DerivedDataCache::DerivedDataCache(fs::path directory, uint64_t const maximumSize)
+    : directory(std::move(directory))
+    , maximumSize(maximumSize) {
+}
+
+DerivedDataCache::~DerivedDataCache() {
+    waitForBackgroundStores();
+}
+
+string DerivedDataCache::getKey(span<char const> const fileData, string_view const parameters) {
+    vector<uint64_t> hashes((fileData.size() + chunkSize - 1) / chunkSize + 1);
+    common::parallelFor(hashes.size() - 1, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            auto const offset = i * chunkSize;
+            hashes[i] = Hash::get(fileData.data() + offset, min(chunkSize, fileData.size() - offset));
+        }
+    }, 1);
+    hashes.back() = Hash::get(parameters.data(), parameters.size(), fileData.size());
+    auto const hash = Hash::get(reinterpret_cast<char const*>(hashes.data()), hashes.size() * sizeof(uint64_t));
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+    return key;
+}
+
+optional<string> DerivedDataCache::getFileKey(fs::path const& file, string_view const parameters) {
+    error_code error;
+    auto const status = fs::status(file, error);
+    if (error || !fs::is_regular_file(status)) return nullopt;
+    auto const size = fs::file_size(file, error);
+    if (error) return nullopt;
+    auto const lastWriteTime = fs::last_write_time(file, error);
+    if (error) return nullopt;
+    auto path = fs::weakly_canonical(file, error);
+    if (error) path = fs::absolute(file);
+    auto const fileStatus = path.string() + '\n' + to_string(size) + '\n' +
+                            to_string(lastWriteTime.time_since_epoch().count());
+    // Parameters are told apart from the ones of keys of file contents
+    return getKey(fileStatus, string{parameters} + " status");
+}
+
+fs::path DerivedDataCache::getPath(string const& key, string_view const extension) const {
+    return directory / (key + '.' + string{extension});
+}
+
+optional<fs::path> DerivedDataCache::find(string const& key, string_view const extension) const {
+    auto path = getPath(key, extension);
+    error_code error;
+    // Fails if the entry doesn't exist, e.g. because another process evicted it
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    if (error) return nullopt;
+    return path;
+}
+
+bool DerivedDataCache::store(string const& key, string_view const extension,
+                             function<void(fs::path const&)> const& writeEntry) const {
+    auto const path = getPath(key, extension);
+    auto temporaryPath = path;
+    temporaryPath += '.' + to_string(random_device{}()) + string{temporaryExtension};
+    try {
+        fs::create_directories(directory);
+        writeEntry(temporaryPath);
+        // Replaces an entry that another process wrote in the meantime
+        fs::rename(temporaryPath, path);
+        evict(path);
+        return true;
+    } catch (std::exception const& ex) {
+        if (debug) cout << "Unable to cache " << path << ". " << ex.what() << endl;
+        error_code error;
+        fs::remove(temporaryPath, error);
+        return false;
+    }
+}
+
+void DerivedDataCache::storeInBackground(string key, string extension,
+                                         function<void(fs::path const&)> writeEntry) const {
+    {
+        lock_guard lock{backgroundStoresMutex};
+        ++numBackgroundStores;
+    }
+    backgroundStoreThread.submit([this, key = std::move(key), extension = std::move(extension),
+                                  writeEntry = std::move(writeEntry)] {
+        // Failed writes are reported by store
+        store(key, extension, writeEntry);
+        lock_guard lock{backgroundStoresMutex};
+        if (--numBackgroundStores == 0) backgroundStoresDone.notify_all();
+    });
+}
+
+void DerivedDataCache::waitForBackgroundStores() const {
+    unique_lock lock{backgroundStoresMutex};
+    backgroundStoresDone.wait(lock, [this] { return numBackgroundStores == 0; });
+}
+
+void DerivedDataCache::evict(fs::path const& entryToKeep) const {
+    struct Entry {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type lastUsed;
+    };
+    vector<Entry> entries;
+    uint64_t totalSize = 0;
+    auto const now = fs::file_time_type::clock::now();
+    error_code error;
+    for (auto const& file : fs::directory_iterator(directory, error)) {
+        // Entries can be removed by other processes at any time
+        Entry entry {file.path(), file.file_size(error), {}};
+        if (error) continue;
+        entry.lastUsed = file.last_write_time(error);
+        if (error) continue;
+        if (entry.path.extension() == temporaryExtension) {
+            if (now - entry.lastUsed > abandonedFileAge) fs::remove(entry.path, error);
+            continue;
+        }
+        totalSize += entry.size;
+        if (entry.path != entryToKeep) entries.push_back(std::move(entry));
+    }
+    if (totalSize <= maximumSize) return;
+
+    sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) { return a.lastUsed < b.lastUsed; });
+    for (auto const& entry : entries) {
+        if (totalSize <= maximumSize) break;
+        // Processes that use the entry keep reading it after it is removed
+        fs::remove(entry.path, error);
+        totalSize -= entry.size;
+    }
+}
+
+}
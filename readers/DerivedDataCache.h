@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include "MeshViewerObject.h"
+#include "ThreadPool.h"
+
+namespace mv::readers {
+
+    // A directory of files that hold data derived from input files, e.g. meshes that were read and cleaned up, so
+    // that the data isn't derived again when the same file is opened later. Entries are named by keys that depend
+    // on the contents of the input file and on the parameters the data was derived with
+    //
+    // Any number of processes can share a directory. Entries are written under temporary names and renamed into
+    // place, so readers see either a complete entry or none. When the entries take more than the maximum size,
+    // the least recently used ones are removed. Entries are marked as used by updating their modification time
+    class DerivedDataCache : public MeshViewerObject {
+    public:
+        DerivedDataCache(std::filesystem::path directory, uint64_t maximumSize);
+
+        // Waits for the entries that are stored in the background
+        ~DerivedDataCache();
+
+        // Key of the data derived from the file contents with the parameters
+        [[nodiscard]] static std::string getKey(std::span<char const> fileData, std::string_view parameters);
+
+        // Key of the data derived from the file with the parameters that depends on the file's path, size and
+        // modification time instead of its contents, so the file isn't read. Empty for files that aren't regular
+        // files
+        [[nodiscard]] static std::optional<std::string> getFileKey(std::filesystem::path const& file,
+                                                                   std::string_view parameters);
+
+        // Path of the entry with the key and extension and marks it as used. Empty if there is no such entry
+        [[nodiscard]] std::optional<std::filesystem::path> find(std::string const& key,
+                                                                std::string_view extension) const;
+
+        // Adds or replaces the entry with the key and extension. writeEntry is called to write the entry's contents
+        // to the path it is given. Returns false if the entry couldn't be written
+        bool store(std::string const& key, std::string_view extension,
+                   std::function<void(std::filesystem::path const&)> const& writeEntry) const;
+
+        // Like store, but the entry is written on a thread of the cache, one entry at a time in the order they are
+        // stored, and the call returns at once
+        void storeInBackground(std::string key, std::string extension,
+                               std::function<void(std::filesystem::path const&)> writeEntry) const;
+
+        // Waits for the entries that are stored in the background
+        void waitForBackgroundStores() const;
+
+    private:
+        [[nodiscard]] std::filesystem::path getPath(std::string const& key, std::string_view extension) const;
+        void evict(std::filesystem::path const& entryToKeep) const;
+
+        std::filesystem::path const directory;
+        uint64_t const maximumSize;
+        mutable std::mutex backgroundStoresMutex;
+        mutable std::condition_variable backgroundStoresDone;
+        mutable size_t numBackgroundStores = 0;
+        // Declared last, so that it finishes the stores before the rest of the cache is destroyed
+        mutable common::ThreadPool backgroundStoreThread {1};
+    };
+
+}
@@ -0,0 +1,501 @@
+#include "GLBReader.h"
+#include "Json.h"
+#include "MappedFile.h"
+#include "MeshFactory.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+using namespace std;
+using namespace mv;
+
+namespace mv::readers {
+
+namespace {
+    using MeshPointer = Reader::MeshPointer;
+
+    // GLB layout
+    // UINT32       - Magic ("glTF")
+    // UINT32       - Version
+    // UINT32       - Length of the file
+    // foreach chunk:
+    //     UINT32   - Length of the chunk data
+    //     UINT32   - Chunk type
+    //     UINT8[]  - Chunk data, padded to 4 bytes
+    // end
+    // The first chunk holds the JSON description of the scene and the optional second chunk the binary buffer
+    constexpr uint32_t magic = 0x46546C67;
+    constexpr uint32_t jsonChunk = 0x4E4F534A;
+    constexpr uint32_t binaryChunk = 0x004E4942;
+    constexpr size_t headerSize = 12;
+    constexpr size_t chunkHeaderSize = 8;
+
+    // Accessor component types
+    constexpr unsigned unsignedByte = 5121;
+    constexpr unsigned unsignedShort = 5123;
+    constexpr unsigned unsignedInt = 5125;
+    constexpr unsigned floatComponent = 5126;
+
+    constexpr unsigned trianglesMode = 4;
+
+    // Column major, as stored in glTF
+    using Matrix = array<float, 16>;
+    constexpr Matrix identity {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    uint32_t readUInt32(char const* data) {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    [[noreturn]] void throwInvalid(string const& fileName, string const& reason) {
+        throw std::runtime_error("Invalid GLB file " + fileName + ". " + reason);
+    }
+
+    struct Chunks {
+        string_view json;
+        span<char const> binary;
+    };
+
+    Chunks getChunks(span<char const> const data, string const& fileName) {
+        if (data.size() < headerSize + chunkHeaderSize || readUInt32(data.data()) != magic) {
+            throwInvalid(fileName, "Header is incorrect");
+        }
+        if (readUInt32(data.data() + 4) != 2) {
+            throwInvalid(fileName, "Only version 2 is supported");
+        }
+        auto const length = std::min<size_t>(readUInt32(data.data() + 8), data.size());
+        Chunks chunks;
+        for (size_t offset = headerSize; offset + chunkHeaderSize <= length;) {
+            size_t const chunkLength = readUInt32(data.data() + offset);
+            auto const chunkType = readUInt32(data.data() + offset + 4);
+            offset += chunkHeaderSize;
+            if (chunkLength > length - offset) {
+                throwInvalid(fileName, "Chunk is truncated");
+            }
+            auto const chunk = data.subspan(offset, chunkLength);
+            if (chunkType == jsonChunk && chunks.json.empty()) {
+                chunks.json = {chunk.data(), chunk.size()};
+            } else if (chunkType == binaryChunk && chunks.binary.empty()) {
+                chunks.binary = chunk;
+            }
+            offset += (chunkLength + 3) & ~size_t{3};
+        }
+        if (chunks.json.empty()) {
+            throwInvalid(fileName, "JSON chunk is missing");
+        }
+        return chunks;
+    }
+
+    // Sizes, counts and indices are non-negative integers
+    size_t toSize(Json const& value, string const& fileName) {
+        auto const number = value.getNumber();
+        if (number < 0 || number != std::floor(number) || number > static_cast<double>(1ull << 53)) {
+            throwInvalid(fileName, "Expected a non-negative integer");
+        }
+        return static_cast<size_t>(number);
+    }
+
+    size_t getSize(Json const& object, string_view const name, string const& fileName, size_t const defaultValue) {
+        auto const* member = object.find(name);
+        return member ? toSize(*member, fileName) : defaultValue;
+    }
+
+    Json const& getMember(Json const& object, string_view const name, string const& fileName) {
+        auto const* member = object.find(name);
+        if (!member) {
+            throwInvalid(fileName, "Missing " + string{name});
+        }
+        return *member;
+    }
+
+    Json const& getElement(Json const& gltf, string_view const arrayName, size_t const index, string const& fileName) {
+        auto const& array = getMember(gltf, arrayName, fileName).getArray();
+        if (index >= array.size()) {
+            throwInvalid(fileName, string{arrayName} + " index " + to_string(index) + " is out of range");
+        }
+        return array[index];
+    }
+
+    Json const& getElement(Json const& gltf, string_view const arrayName, Json const& index, string const& fileName) {
+        return getElement(gltf, arrayName, toSize(index, fileName), fileName);
+    }
+
+    // Elements of an accessor in the binary chunk. Elements need not be aligned
+    struct Accessor {
+        char const* data;
+        size_t count;
+        size_t stride;
+        unsigned componentType;
+    };
+
+    size_t getComponentSize(unsigned const componentType) {
+        switch (componentType) {
+            case unsignedByte: return 1;
+            case unsignedShort: return 2;
+            default: return 4;
+        }
+    }
+
+    Accessor getAccessor(Json const& gltf, Json const& index, span<char const> const binary, string_view const type,
+                         initializer_list<unsigned> const componentTypes, string const& fileName) {
+        auto const& accessor = getElement(gltf, "accessors", index, fileName);
+        if (accessor.find("sparse")) {
+            throwInvalid(fileName, "Sparse accessors are not supported");
+        }
+        if (auto const* normalized = accessor.find("normalized"); normalized && normalized->getBool()) {
+            throwInvalid(fileName, "Normalized accessors are not supported");
+        }
+        auto const componentType = static_cast<unsigned>(toSize(getMember(accessor, "componentType", fileName),
+                                                                fileName));
+        if (getMember(accessor, "type", fileName).getString() != type ||
+            std::find(componentTypes.begin(), componentTypes.end(), componentType) == componentTypes.end()) {
+            throwInvalid(fileName, "Accessor of an unsupported type");
+        }
+        auto const count = toSize(getMember(accessor, "count", fileName), fileName);
+        auto const* bufferViewIndex = accessor.find("bufferView");
+        if (!bufferViewIndex) {
+            throwInvalid(fileName, "Accessors without buffer views are not supported");
+        }
+
+        auto const& bufferView = getElement(gltf, "bufferViews", *bufferViewIndex, fileName);
+        if (getSize(bufferView, "buffer", fileName, 0) != 0 || binary.empty()) {
+            throwInvalid(fileName, "External buffers are not supported");
+        }
+        auto const viewOffset = getSize(bufferView, "byteOffset", fileName, 0);
+        auto const viewLength = toSize(getMember(bufferView, "byteLength", fileName), fileName);
+        if (viewOffset > binary.size() || viewLength > binary.size() - viewOffset) {
+            throwInvalid(fileName, "Buffer view is out of range");
+        }
+        auto const elementSize = (type == "VEC3" ? 3 : 1) * getComponentSize(componentType);
+        auto const stride = getSize(bufferView, "byteStride", fileName, elementSize);
+        auto const offset = getSize(accessor, "byteOffset", fileName, 0);
+        if (count && (stride < elementSize || offset > viewLength || viewLength - offset < elementSize ||
+                      (viewLength - offset - elementSize) / stride < count - 1)) {
+            throwInvalid(fileName, "Accessor is out of range");
+        }
+        return {binary.data() + viewOffset + offset, count, stride, componentType};
+    }
+
+    Matrix multiply(Matrix const& a, Matrix const& b) {
+        Matrix result {};
+        for (unsigned column = 0; column < 4; ++column) {
+            for (unsigned row = 0; row < 4; ++row) {
+                for (unsigned k = 0; k < 4; ++k) {
+                    result[4 * column + row] += a[4 * k + row] * b[4 * column + k];
+                }
+            }
+        }
+        return result;
+    }
+
+    // A node's transform is either a matrix or a translation, a rotation and a scale that are applied in reverse
+    // order
+    Matrix getLocalTransform(Json const& node, string const& fileName) {
+        auto getNumbers = [&](string_view const name, auto defaultValue) {
+            auto const* member = node.find(name);
+            if (!member) return defaultValue;
+            auto const& array = member->getArray();
+            if (array.size() != defaultValue.size()) {
+                throwInvalid(fileName, "Node " + string{name} + " has the wrong number of values");
+            }
+            for (size_t i = 0; i < array.size(); ++i) {
+                defaultValue[i] = static_cast<float>(array[i].getNumber());
+            }
+            return defaultValue;
+        };
+        if (node.find("matrix")) {
+            return getNumbers("matrix", identity);
+        }
+        auto const t = getNumbers("translation", array<float, 3>{0, 0, 0});
+        auto const q = getNumbers("rotation", array<float, 4>{0, 0, 0, 1});
+        auto const s = getNumbers("scale", array<float, 3>{1, 1, 1});
+        auto const [x, y, z, w] = q;
+        float const rotation[3][3] {
+            {1 - 2 * (y * y + z * z), 2 * (x * y - z * w), 2 * (x * z + y * w)},
+            {2 * (x * y + z * w), 1 - 2 * (x * x + z * z), 2 * (y * z - x * w)},
+            {2 * (x * z - y * w), 2 * (y * z + x * w), 1 - 2 * (x * x + y * y)},
+        };
+        Matrix transform = identity;
+        for (unsigned column = 0; column < 3; ++column) {
+            for (unsigned row = 0; row < 3; ++row) {
+                transform[4 * column + row] = rotation[row][column] * s[column];
+            }
+            transform[12 + column] = t[column];
+        }
+        return transform;
+    }
+
+    // Cofactors of the upper 3x3 part, in row major order
+    array<float, 9> getCofactors(Matrix const& m) {
+        auto a = [&m](unsigned const row, unsigned const column) { return m[4 * column + row]; };
+        return {
+            a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1), a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2),
+            a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0),
+            a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2), a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0),
+            a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1),
+            a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1), a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2),
+            a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0),
+        };
+    }
+
+    float getDeterminant(Matrix const& m) {
+        auto const cofactors = getCofactors(m);
+        return m[0] * cofactors[0] + m[4] * cofactors[1] + m[8] * cofactors[2];
+    }
+
+    struct Instance {
+        size_t mesh;
+        Matrix transform;
+    };
+
+    // Adds the meshes of a node and its descendants
+    void addInstances(Json const& gltf, Json const& nodeIndex, Matrix const& parentTransform, size_t const depth,
+                      vector<Instance>& instances, string const& fileName) {
+        auto const& node = getElement(gltf, "nodes", nodeIndex, fileName);
+        // A node can't be its own ancestor, so deeper hierarchies have cycles
+        if (depth > getMember(gltf, "nodes", fileName).getArray().size()) {
+            throwInvalid(fileName, "Node hierarchy has a cycle");
+        }
+        auto const transform = multiply(parentTransform, getLocalTransform(node, fileName));
+        if (auto const* mesh = node.find("mesh")) {
+            instances.push_back({toSize(*mesh, fileName), transform});
+        }
+        if (auto const* children = node.find("children")) {
+            for (auto const& child : children->getArray()) {
+                addInstances(gltf, child, transform, depth + 1, instances, fileName);
+            }
+        }
+    }
+
+    // Meshes of the default scene. Files without scenes are treated as a scene with each mesh at the origin
+    vector<Instance> getInstances(Json const& gltf, string const& fileName) {
+        vector<Instance> instances;
+        auto const* scenes = gltf.find("scenes");
+        if (!scenes || scenes->getArray().empty()) {
+            if (auto const* meshes = gltf.find("meshes")) {
+                for (size_t i = 0; i < meshes->getArray().size(); ++i) {
+                    instances.push_back({i, identity});
+                }
+            }
+            return instances;
+        }
+        auto const& scene = getElement(gltf, "scenes", getSize(gltf, "scene", fileName, 0), fileName);
+        if (auto const* nodes = scene.find("nodes")) {
+            for (auto const& node : nodes->getArray()) {
+                addInstances(gltf, node, identity, 0, instances, fileName);
+            }
+        }
+        return instances;
+    }
+
+    struct Primitive {
+        Accessor positions;
+        optional<Accessor> normals;
+        optional<Accessor> indices;
+        Matrix const* transform;
+        size_t firstVertex;
+        size_t firstTriangle;
+    };
+
+    size_t getNumberOfTriangles(Primitive const& primitive) {
+        return (primitive.indices ? primitive.indices->count : primitive.positions.count) / 3;
+    }
+
+    void decodePositions(Primitive const& primitive, float* positions) {
+        auto const& [data, count, stride, componentType] = primitive.positions;
+        // Positions that are packed the way the mesh stores them are copied in one go
+        if (*primitive.transform == identity && stride == 3 * sizeof(float)) {
+            memcpy(positions, data, count * stride);
+            return;
+        }
+        auto const& m = *primitive.transform;
+        common::parallelFor(count, [&](size_t const begin, size_t const end) {
+            for (auto i = begin; i < end; ++i) {
+                float p[3];
+                memcpy(p, data + i * stride, sizeof(p));
+                for (unsigned row = 0; row < 3; ++row) {
+                    positions[3 * i + row] = m[row] * p[0] + m[4 + row] * p[1] + m[8 + row] * p[2] + m[12 + row];
+                }
+            }
+        });
+    }
+
+    void decodeNormals(Primitive const& primitive, float* normals) {
+        auto const& [data, count, stride, componentType] = *primitive.normals;
+        if (*primitive.transform == identity && stride == 3 * sizeof(float)) {
+            memcpy(normals, data, count * stride);
+            return;
+        }
+        // Normals are transformed by the inverse transpose, which is the cofactor matrix divided by the determinant.
+        // Normals are normalized afterwards, so only the sign of the determinant matters
+        auto m = getCofactors(*primitive.transform);
+        if (getDeterminant(*primitive.transform) < 0) {
+            for (auto& element : m) element = -element;
+        }
+        common::parallelFor(count, [&](size_t const begin, size_t const end) {
+            for (auto i = begin; i < end; ++i) {
+                float n[3];
+                memcpy(n, data + i * stride, sizeof(n));
+                float transformed[3];
+                for (unsigned row = 0; row < 3; ++row) {
+                    transformed[row] = m[3 * row] * n[0] + m[3 * row + 1] * n[1] + m[3 * row + 2] * n[2];
+                }
+                auto const length = std::sqrt(transformed[0] * transformed[0] + transformed[1] * transformed[1] +
+                                              transformed[2] * transformed[2]);
+                for (unsigned row = 0; row < 3; ++row) {
+                    normals[3 * i + row] = length > 0 ? transformed[row] / length : 0;
+                }
+            }
+        });
+    }
+
+    // Writes the triangles of a primitive with indices that refer to the merged vertices. Transforms that mirror
+    // the mesh reverse the winding of its triangles, which is undone
+    void decodeTriangles(Primitive const& primitive, unsigned* triangles, string const& fileName) {
+        auto const numTriangles = getNumberOfTriangles(primitive);
+        auto const numVertices = primitive.positions.count;
+        auto const firstVertex = static_cast<unsigned>(primitive.firstVertex);
+        bool const isMirrored = getDeterminant(*primitive.transform) < 0;
+        auto decode = [&]<typename Index>(Index, Accessor const* indices) {
+            common::parallelFor(numTriangles, [&](size_t const begin, size_t const end) {
+                for (auto i = begin; i < end; ++i) {
+                    size_t vertices[3];
+                    for (unsigned j = 0; j < 3; ++j) {
+                        if (indices) {
+                            Index index;
+                            memcpy(&index, indices->data + (3 * i + j) * indices->stride, sizeof(Index));
+                            vertices[j] = index;
+                        } else {
+                            vertices[j] = 3 * i + j;
+                        }
+                        if (vertices[j] >= numVertices) {
+                            throw std::runtime_error("Vertex index " + to_string(vertices[j]) + " in " + fileName +
+                                                     " is out of range");
+                        }
+                    }
+                    if (isMirrored) std::swap(vertices[1], vertices[2]);
+                    for (unsigned j = 0; j < 3; ++j) {
+                        triangles[3 * i + j] = firstVertex + static_cast<unsigned>(vertices[j]);
+                    }
+                }
+            });
+        };
+        auto const* indices = primitive.indices ? &*primitive.indices : nullptr;
+        switch (indices ? indices->componentType : unsignedInt) {
+            case unsignedByte: decode(uint8_t{}, indices); break;
+            case unsignedShort: decode(uint16_t{}, indices); break;
+            default: decode(uint32_t{}, indices); break;
+        }
+    }
+}
+
+GLBReader::GLBReader(std::string fn, IMeshFactory const& meshFactory)
+    : Reader(std::move(fn), meshFactory) {
+}
+
+MeshPointer GLBReader::getOutput(MeshPointer mesh) {
+    MappedFile const file(fileName);
+    if (!file.isMapped()) {
+        ifstream ifs(fileName, ios::binary);
+        if (!ifs) {
+            throw std::runtime_error("Unable to open file " + fileName + '!');
+        }
+        return std::move(getOutput(ifs, mesh));
+    }
+    return std::move(read(file.getData(), mesh));
+}
+
+MeshPointer GLBReader::getOutput(istream& inputStream, MeshPointer& mesh) {
+    vector<char> const fileData{istreambuf_iterator<char>(inputStream), istreambuf_iterator<char>()};
+    return std::move(read(fileData, mesh));
+}
+
+void GLBReader::createMesh(MeshPointer& mesh, unsigned const numVertices, unsigned const numFaces) const {
+    // To allow a mock mesh to be injected into this object for unit testing
+    if (!mesh) {
+        mesh = meshFactory.createMesh();
+    }
+    mesh->initialize(numVertices, numFaces);
+}
+
+MeshPointer GLBReader::read(span<char const> const fileData, MeshPointer& mesh) const {
+    auto const chunks = getChunks(fileData, fileName);
+    auto const gltf = Json::parse(chunks.json);
+    auto const instances = getInstances(gltf, fileName);
+
+    // Triangle lists are merged. Other primitives (points, lines, strips and fans) are skipped
+    vector<Primitive> primitives;
+    size_t numVertices = 0;
+    size_t numTriangles = 0;
+    for (auto const& instance : instances) {
+        auto const& mesh = getElement(gltf, "meshes", instance.mesh, fileName);
+        for (auto const& primitive : getMember(mesh, "primitives", fileName).getArray()) {
+            if (getSize(primitive, "mode", fileName, trianglesMode) != trianglesMode) continue;
+            auto const& attributes = getMember(primitive, "attributes", fileName);
+            Primitive decoded {getAccessor(gltf, getMember(attributes, "POSITION", fileName), chunks.binary, "VEC3",
+                                           {floatComponent}, fileName), {}, {}, &instance.transform, numVertices,
+                               numTriangles};
+            if (auto const* normals = attributes.find("NORMAL")) {
+                decoded.normals = getAccessor(gltf, *normals, chunks.binary, "VEC3", {floatComponent}, fileName);
+                if (decoded.normals->count != decoded.positions.count) {
+                    throwInvalid(fileName, "Primitive has a different number of normals and positions");
+                }
+            }
+            if (auto const* indices = primitive.find("indices")) {
+                decoded.indices = getAccessor(gltf, *indices, chunks.binary, "SCALAR",
+                                              {unsignedByte, unsignedShort, unsignedInt}, fileName);
+            }
+            numVertices += decoded.positions.count;
+            numTriangles += getNumberOfTriangles(decoded);
+            primitives.push_back(decoded);
+        }
+    }
+    if (numVertices > numeric_limits<unsigned>::max() / 3 || numTriangles > numeric_limits<unsigned>::max() / 3) {
+        throw std::runtime_error(fileName + " has too many vertices or faces");
+    }
+    createMesh(mesh, static_cast<unsigned>(numVertices), static_cast<unsigned>(numTriangles));
+
+    // Meshes that don't expose their buffers are filled from temporary ones and compute their own normals
+    auto positions = mesh->getPositionBuffer();
+    auto triangles = mesh->getIndexBuffer();
+    vector<float> positionData;
+    vector<unsigned> triangleData;
+    bool const hasBuffers = !positions.empty() && !triangles.empty();
+    if (!hasBuffers) {
+        positionData.resize(3 * numVertices);
+        triangleData.resize(3 * numTriangles);
+        positions = positionData;
+        triangles = triangleData;
+    }
+    bool const hasNormals = hasBuffers && !primitives.empty() &&
+        std::all_of(primitives.begin(), primitives.end(), [](auto const& primitive) { return primitive.normals; });
+    auto const normals = hasNormals ? mesh->getVertexNormalBuffer() : span<float>{};
+
+    for (auto const& primitive : primitives) {
+        decodePositions(primitive, positions.data() + 3 * primitive.firstVertex);
+        decodeTriangles(primitive, triangles.data() + 3 * primitive.firstTriangle, fileName);
+        if (!normals.empty()) {
+            decodeNormals(primitive, normals.data() + 3 * primitive.firstVertex);
+        }
+    }
+
+    if (!hasBuffers) {
+        for (size_t i = 0; i < positionData.size(); i += 3) {
+            mesh->addVertex(positionData[i], positionData[i + 1], positionData[i + 2]);
+        }
+        for (size_t i = 0; i < triangleData.size(); i += 3) {
+            mesh->addFace({triangleData[i], triangleData[i + 1], triangleData[i + 2]});
+        }
+    }
+    return std::move(mesh);
+}
+
+}
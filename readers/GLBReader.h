@@ -0,0 +1,25 @@
+#pragma once
+#include <istream>
+#include <span>
+#include <string>
+#include "Reader.h"
+
+namespace mv::readers {
+
+// Reads the triangle meshes of binary glTF (GLB) files. Meshes of all the nodes of the default scene are merged
+// into one, with node transforms applied. Vertex normals in the file are used when every primitive has them
+class GLBReader : public Reader {
+    public:
+        // Reads the file from a memory mapping. Files that can't be mapped are read as streams
+        MeshPointer getOutput(Mesh::MeshPointer = nullptr) override;
+    private:
+        explicit GLBReader(std::string fileName, IMeshFactory const&);
+        MeshPointer getOutput(std::istream&, Mesh::MeshPointer&);
+        MeshPointer read(std::span<char const> fileData, Mesh::MeshPointer&) const;
+        void createMesh(Mesh::MeshPointer&, unsigned numVertices, unsigned numFaces) const;
+
+    friend class GLBReaderFixture;
+    friend class ReaderFactory;
+};
+
+}
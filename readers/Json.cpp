@@ -0,0 +1,211 @@
+#include "Json.h"
+#include <charconv>
+#include <stdexcept>
+
+using namespace std;
+
+namespace mv::readers {
+
+    class Json::Parser {
+    public:
+        explicit Parser(string_view const text)
+            : m_next(text.data())
+            , m_end(text.data() + text.size()) {
+        }
+
+        Json parseDocument() {
+            auto document = parseValue(0);
+            skipSpace();
+            if (m_next != m_end) throwInvalid("Unexpected text after the end of the document");
+            return document;
+        }
+
+    private:
+        // Deeper documents are rejected instead of overflowing the stack
+        static constexpr unsigned maximumDepth = 256;
+
+        Json parseValue(unsigned const depth) {
+            if (depth > maximumDepth) throwInvalid("Document is nested too deeply");
+            skipSpace();
+            if (m_next == m_end) throwInvalid("Unexpected end of the document");
+            Json value;
+            switch (*m_next) {
+                case '{': value.m_value = parseObject(depth); break;
+                case '[': value.m_value = parseArray(depth); break;
+                case '"': value.m_value = parseString(); break;
+                case 't': expect("true"); value.m_value = true; break;
+                case 'f': expect("false"); value.m_value = false; break;
+                case 'n': expect("null"); break;
+                default: value.m_value = parseNumber(); break;
+            }
+            return value;
+        }
+
+        Object parseObject(unsigned const depth) {
+            ++m_next;
+            Object object;
+            skipSpace();
+            if (consume('}')) return object;
+            do {
+                skipSpace();
+                if (m_next == m_end || *m_next != '"') throwInvalid("Expected a member name");
+                auto name = parseString();
+                skipSpace();
+                if (!consume(':')) throwInvalid("Expected ':' after a member name");
+                object.emplace_back(std::move(name), parseValue(depth + 1));
+                skipSpace();
+            } while (consume(','));
+            if (!consume('}')) throwInvalid("Expected ',' or '}' in an object");
+            return object;
+        }
+
+        Array parseArray(unsigned const depth) {
+            ++m_next;
+            Array array;
+            skipSpace();
+            if (consume(']')) return array;
+            do {
+                array.push_back(parseValue(depth + 1));
+                skipSpace();
+            } while (consume(','));
+            if (!consume(']')) throwInvalid("Expected ',' or ']' in an array");
+            return array;
+        }
+
+        string parseString() {
+            ++m_next;
+            string result;
+            while (m_next != m_end && *m_next != '"') {
+                auto const c = *m_next++;
+                if (static_cast<unsigned char>(c) < 0x20) throwInvalid("Control character in a string");
+                if (c != '\\') {
+                    result += c;
+                    continue;
+                }
+                if (m_next == m_end) break;
+                switch (auto const escaped = *m_next++) {
+                    case '"': case '\\': case '/': result += escaped; break;
+                    case 'b': result += '\b'; break;
+                    case 'f': result += '\f'; break;
+                    case 'n': result += '\n'; break;
+                    case 'r': result += '\r'; break;
+                    case 't': result += '\t'; break;
+                    case 'u': appendCodePoint(result); break;
+                    default: throwInvalid("Invalid escape sequence in a string");
+                }
+            }
+            if (!consume('"')) throwInvalid("Unterminated string");
+            return result;
+        }
+
+        // Appends the UTF-8 encoding of a \uXXXX escape sequence, which can be a pair of UTF-16 surrogates
+        void appendCodePoint(string& result) {
+            auto codePoint = parseHexQuad();
+            if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+                if (!consume('\\') || !consume('u')) throwInvalid("Unpaired surrogate in a string");
+                auto const low = parseHexQuad();
+                if (low < 0xDC00 || low >= 0xE000) throwInvalid("Unpaired surrogate in a string");
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            if (codePoint < 0x80) {
+                result += static_cast<char>(codePoint);
+            } else if (codePoint < 0x800) {
+                result += static_cast<char>(0xC0 | codePoint >> 6);
+                result += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else if (codePoint < 0x10000) {
+                result += static_cast<char>(0xE0 | codePoint >> 12);
+                result += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+                result += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else {
+                result += static_cast<char>(0xF0 | codePoint >> 18);
+                result += static_cast<char>(0x80 | (codePoint >> 12 & 0x3F));
+                result += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+                result += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        unsigned parseHexQuad() {
+            unsigned value = 0;
+            if (m_end - m_next < 4) throwInvalid("Invalid escape sequence in a string");
+            auto const [end, error] = from_chars(m_next, m_next + 4, value, 16);
+            if (error != errc{} || end != m_next + 4) throwInvalid("Invalid escape sequence in a string");
+            m_next = end;
+            return value;
+        }
+
+        double parseNumber() {
+            // from_chars accepts forms that JSON doesn't, e.g. "inf" and "nan"
+            if (*m_next != '-' && (*m_next < '0' || *m_next > '9')) throwInvalid("Unexpected character");
+            double value;
+            auto const [end, error] = from_chars(m_next, m_end, value);
+            if (error != errc{}) throwInvalid("Invalid number");
+            m_next = end;
+            return value;
+        }
+
+        void expect(string_view const literal) {
+            if (string_view{m_next, static_cast<size_t>(m_end - m_next)}.substr(0, literal.size()) != literal) {
+                throwInvalid("Unexpected character");
+            }
+            m_next += literal.size();
+        }
+
+        bool consume(char const c) {
+            if (m_next == m_end || *m_next != c) return false;
+            ++m_next;
+            return true;
+        }
+
+        void skipSpace() {
+            while (m_next != m_end && (*m_next == ' ' || *m_next == '\t' || *m_next == '\n' || *m_next == '\r')) {
+                ++m_next;
+            }
+        }
+
+        [[noreturn]] static void throwInvalid(string const& reason) {
+            throw std::runtime_error("Invalid JSON. " + reason);
+        }
+
+        char const* m_next;
+        char const* const m_end;
+    };
+
+    Json Json::parse(string_view const text) {
+        return Parser{text}.parseDocument();
+    }
+
+    namespace {
+        template<typename T>
+        T const& get(auto const& value, char const* typeName) {
+            if (auto const* typedValue = std::get_if<T>(&value)) {
+                return *typedValue;
+            }
+            throw std::runtime_error(string{"JSON value is not "} + typeName);
+        }
+    }
+
+    bool Json::getBool() const { return get<bool>(m_value, "a boolean"); }
+
+    double Json::getNumber() const { return get<double>(m_value, "a number"); }
+
+    string const& Json::getString() const { return get<string>(m_value, "a string"); }
+
+    Json::Array const& Json::getArray() const { return get<Array>(m_value, "an array"); }
+
+    Json::Object const& Json::getObject() const { return get<Object>(m_value, "an object"); }
+
+    Json const* Json::find(string_view const name) const {
+        if (auto const* object = std::get_if<Object>(&m_value)) {
+            for (auto const& [memberName, member] : *object) {
+                if (memberName == name) return &member;
+            }
+        }
+        return nullptr;
+    }
+
+    double Json::getNumber(string_view const name, double const defaultValue) const {
+        auto const* member = find(name);
+        return member ? member->getNumber() : defaultValue;
+    }
+
+}
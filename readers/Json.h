@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace mv::readers {
+
+    // A parsed JSON document. Meant for the small JSON headers of binary formats like glTF, so values are
+    // stored in a simple tree and members of objects are looked up linearly
+    class Json {
+    public:
+        using Array = std::vector<Json>;
+        using Object = std::vector<std::pair<std::string, Json>>;
+
+        // Throws std::runtime_error if the text is not valid JSON
+        static Json parse(std::string_view text);
+
+        Json() = default;
+
+        [[nodiscard]] bool isNull() const { return std::holds_alternative<std::nullptr_t>(m_value); }
+        [[nodiscard]] bool isNumber() const { return std::holds_alternative<double>(m_value); }
+        [[nodiscard]] bool isString() const { return std::holds_alternative<std::string>(m_value); }
+        [[nodiscard]] bool isArray() const { return std::holds_alternative<Array>(m_value); }
+        [[nodiscard]] bool isObject() const { return std::holds_alternative<Object>(m_value); }
+
+        // Accessors throw std::runtime_error if the value is of another type
+        [[nodiscard]] bool getBool() const;
+        [[nodiscard]] double getNumber() const;
+        [[nodiscard]] std::string const& getString() const;
+        [[nodiscard]] Array const& getArray() const;
+        [[nodiscard]] Object const& getObject() const;
+
+        // Member of an object. Returns nullptr if the value is not an object or has no such member
+        [[nodiscard]] Json const* find(std::string_view name) const;
+
+        // Number member of an object or the default value if the object has no such member
+        [[nodiscard]] double getNumber(std::string_view name, double defaultValue) const;
+
+    private:
+        class Parser;
+
+        std::variant<std::nullptr_t, bool, double, std::string, Array, Object> m_value;
+    };
+
+}
@@ -0,0 +1,56 @@
+#include "MappedFile.h"
+#include <utility>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mv::readers {
+
+    MappedFile::MappedFile(std::string const& fileName, Access const access)
+    : data(nullptr)
+    , size(0) {
+#ifndef _WIN32
+        auto const fileDescriptor = open(fileName.c_str(), O_RDONLY);
+        if (fileDescriptor < 0) {
+            return;
+        }
+        struct stat fileStatus{};
+        if (fstat(fileDescriptor, &fileStatus) == 0 && S_ISREG(fileStatus.st_mode) && fileStatus.st_size > 0) {
+            auto const fileSize = static_cast<size_t>(fileStatus.st_size);
+            auto const protection = access == Access::CopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+            auto* mapping = mmap(nullptr, fileSize, protection, MAP_PRIVATE, fileDescriptor, 0);
+            if (mapping != MAP_FAILED) {
+                if (access == Access::Sequential) madvise(mapping, fileSize, MADV_SEQUENTIAL);
+                data = static_cast<char*>(mapping);
+                size = fileSize;
+            }
+        }
+        // The mapping remains valid after the file is closed
+        close(fileDescriptor);
+#endif
+    }
+
+    MappedFile::~MappedFile() {
+#ifndef _WIN32
+        if (data) {
+            munmap(data, size);
+        }
+#endif
+    }
+
+    MappedFile::MappedFile(MappedFile&& another) noexcept
+    : data(std::exchange(another.data, nullptr))
+    , size(std::exchange(another.size, 0)) {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& another) noexcept {
+        // The other file unmaps this file's mapping when it is destroyed
+        std::swap(data, another.data);
+        std::swap(size, another.size);
+        return *this;
+    }
+
+}
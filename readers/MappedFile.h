@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+namespace mv::readers {
+
+    // A read-only memory mapping of a file. Files that can't be mapped (e.g. pipes, empty files and files on
+    // platforms without mmap) are reported as not mapped and readers fall back to reading them as streams
+    class MappedFile {
+    public:
+        enum class Access {
+            // Read once from start to end
+            Sequential,
+            // Accessed in any order and writable. Written pages are private copies, so the file is never modified
+            CopyOnWrite,
+        };
+
+        explicit MappedFile(std::string const& fileName, Access = Access::Sequential);
+        ~MappedFile();
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+        MappedFile(MappedFile&&) noexcept;
+        MappedFile& operator=(MappedFile&&) noexcept;
+
+        [[nodiscard]] bool isMapped() const { return data != nullptr; }
+
+        // Contents of the file. Empty if the file is not mapped
+        [[nodiscard]] std::span<char const> getData() const { return {data, size}; }
+
+        // Writable contents of a file that is mapped for copy on write access
+        [[nodiscard]] std::span<char> getWritableData() { return {data, size}; }
+
+    private:
+        char* data;
+        size_t size;
+    };
+
+}
@@ -0,0 +1,167 @@
+#include "MeshCacheReader.h"
+#include "MeshCacheFormat.h"
+#include "MappedFile.h"
+#include "MeshFactory.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <vector>
+using namespace std;
+using namespace mv;
+
+namespace mv::readers {
+
+namespace {
+    using MeshPointer = Reader::MeshPointer;
+    using namespace common::meshcache;
+
+    // Work per thread below which thread startup costs more than it saves
+    constexpr size_t minimumIndicesPerThread = 1 << 20;
+
+    [[noreturn]] void throwInvalid(string const& fileName, string const& reason) {
+        throw std::runtime_error("Invalid mvmesh file " + fileName + ". " + reason);
+    }
+
+    // Largest of the indices, found on as many threads as the number of indices warrants
+    unsigned getMaximumIndex(unsigned const* indices, size_t const numIndices) {
+        vector<unsigned> maximumIndices(common::getNumberOfRanges(numIndices, minimumIndicesPerThread));
+        common::parallelFor(numIndices, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+            unsigned maximum = 0;
+            for (auto i = begin; i < end; ++i) {
+                maximum = std::max(maximum, indices[i]);
+            }
+            maximumIndices[rangeIndex] = maximum;
+        }, minimumIndicesPerThread);
+        return maximumIndices.empty() ? 0 : *std::max_element(maximumIndices.begin(), maximumIndices.end());
+    }
+
+    // Section of the file that has the expected size, or null if the file doesn't have the section
+    template<typename T>
+    shared_ptr<T[]> getSection(shared_ptr<char[]> const& fileData, vector<Section> const& sections,
+                               SectionType const type, uint64_t const expectedSize, string const& fileName) {
+        for (auto const& section : sections) {
+            if (section.type != type) continue;
+            if (section.size != expectedSize) {
+                throwInvalid(fileName, "Section " + to_string(static_cast<uint32_t>(type)) + " has " +
+                                       to_string(section.size) + " bytes instead of " + to_string(expectedSize));
+            }
+            // Aliases the file data, which is kept alive by the section
+            return {fileData, reinterpret_cast<T*>(fileData.get() + section.offset)};
+        }
+        return nullptr;
+    }
+}
+
+MeshCacheReader::MeshCacheReader(std::string fn, IMeshFactory const& meshFactory)
+    : Reader(std::move(fn), meshFactory) {
+}
+
+MeshPointer MeshCacheReader::getOutput(MeshPointer mesh) {
+    return readFile(mesh);
+}
+
+MeshPointer MeshCacheReader::readFile(MeshPointer& mesh) {
+    // Sections are accessed in any order, e.g. when only normals are needed. Meshes that modify their buffers get
+    // private copies of the pages they write
+    auto file = make_shared<MappedFile>(fileName, MappedFile::Access::CopyOnWrite);
+    if (!file->isMapped()) {
+        ifstream ifs(fileName, ios::binary);
+        if (!ifs) {
+            throw std::runtime_error("Unable to open file " + fileName + '!');
+        }
+        return std::move(getOutput(ifs, mesh));
+    }
+    auto const data = file->getWritableData();
+    return std::move(read({file, data.data()}, data.size(), mesh));
+}
+
+MeshPointer MeshCacheReader::getOutput(istream& inputStream, MeshPointer& mesh) {
+    auto fileData = make_shared<vector<char>>(istreambuf_iterator<char>(inputStream), istreambuf_iterator<char>());
+    return std::move(read({fileData, fileData->data()}, fileData->size(), mesh));
+}
+
+MeshPointer MeshCacheReader::read(shared_ptr<char[]> const& fileData, size_t const fileSize, MeshPointer& mesh) const {
+    Header header;
+    if (fileSize < sizeof(Header)) throwInvalid(fileName, "File is too short");
+    memcpy(&header, fileData.get(), sizeof(Header));
+    if (header.magic != magic) throwInvalid(fileName, "File is not a mvmesh file");
+    if (header.version != version) {
+        throwInvalid(fileName, "Version " + to_string(header.version) + " is not supported");
+    }
+    if (header.byteOrderMark != byteOrderMark) throwInvalid(fileName, "File was written with another byte order");
+    if (header.numSections > (fileSize - sizeof(Header)) / sizeof(Section)) {
+        throwInvalid(fileName, "Section table is truncated");
+    }
+
+    vector<Section> sections(header.numSections);
+    memcpy(sections.data(), fileData.get() + sizeof(Header), sections.size() * sizeof(Section));
+    for (auto const& section : sections) {
+        if (section.offset > fileSize || section.size > fileSize - section.offset) {
+            throwInvalid(fileName, "Section " + to_string(static_cast<uint32_t>(section.type)) + " is truncated");
+        }
+        if (section.offset % sizeof(float)) {
+            throwInvalid(fileName, "Section " + to_string(static_cast<uint32_t>(section.type)) + " is misaligned");
+        }
+    }
+
+    // Indices past the last vertex would make the mesh read out of bounds, so they are checked in one pass over
+    // the index section. Other sections are used as they are
+    auto const numVertices = header.numVertices;
+    auto const numFaces = header.numFaces;
+    auto const vertexDataSize = numVertices * 3ull * sizeof(float);
+    auto const faceDataSize = numFaces * 3ull * sizeof(float);
+    Mesh::SharedBuffers buffers {
+        numVertices,
+        numFaces,
+        getSection<float>(fileData, sections, SectionType::Positions, vertexDataSize, fileName),
+        getSection<unsigned>(fileData, sections, SectionType::Indices, numFaces * 3ull * sizeof(unsigned), fileName),
+        getSection<float>(fileData, sections, SectionType::VertexNormals, vertexDataSize, fileName),
+        getSection<float>(fileData, sections, SectionType::FaceNormals, faceDataSize, fileName),
+        nullopt,
+    };
+    if (!buffers.positions || !buffers.indices) throwInvalid(fileName, "Positions or indices are missing");
+    if (numFaces) {
+        auto const maximumIndex = getMaximumIndex(buffers.indices.get(), numFaces * 3ull);
+        if (maximumIndex >= numVertices) {
+            throwInvalid(fileName, "Vertex index " + to_string(maximumIndex) + " is out of range for " +
+                                   to_string(numVertices) + " vertices");
+        }
+    }
+    if (auto const bounds = getSection<float>(fileData, sections, SectionType::Bounds, 6 * sizeof(float), fileName)) {
+        buffers.bounds = common::Bounds{{bounds[0], bounds[1], bounds[2]}, {bounds[3], bounds[4], bounds[5]}};
+    }
+
+    // To allow a mock mesh to be injected into this object for unit testing
+    if (!mesh) {
+        mesh = meshFactory.createMesh();
+    }
+    if (mesh->setSharedBuffers(buffers)) {
+        return std::move(mesh);
+    }
+
+    // Meshes that own their storage get copies
+    mesh->initialize(numVertices, numFaces);
+    auto const positions = mesh->getPositionBuffer();
+    auto const indices = mesh->getIndexBuffer();
+    if (!positions.empty() && !indices.empty()) {
+        memcpy(positions.data(), buffers.positions.get(), vertexDataSize);
+        memcpy(indices.data(), buffers.indices.get(), numFaces * 3ull * sizeof(unsigned));
+        if (buffers.vertexNormals) {
+            auto const normals = mesh->getVertexNormalBuffer();
+            if (!normals.empty()) memcpy(normals.data(), buffers.vertexNormals.get(), vertexDataSize);
+        }
+    } else {
+        for (unsigned i = 0; i < numVertices; ++i) {
+            mesh->addVertex(buffers.positions[3 * i], buffers.positions[3 * i + 1], buffers.positions[3 * i + 2]);
+        }
+        for (unsigned i = 0; i < numFaces; ++i) {
+            mesh->addFace({buffers.indices[3 * i], buffers.indices[3 * i + 1], buffers.indices[3 * i + 2]});
+        }
+    }
+    return std::move(mesh);
+}
+
+}
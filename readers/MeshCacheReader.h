@@ -0,0 +1,28 @@
+#pragma once
+#include <istream>
+#include <memory>
+#include <span>
+#include <string>
+#include "Reader.h"
+
+namespace mv::readers {
+
+// Reads MeshViewer's native .mvmesh files (see MeshCacheFormat.h). Meshes that can share storage are backed by a
+// copy on write mapping of the file, so sections aren't copied. The index section is scanned once, in parallel, to
+// check that its indices refer to vertices of the file. Normals and bounds stored in the file are used as they are
+class MeshCacheReader : public Reader {
+    public:
+        MeshPointer getOutput(Mesh::MeshPointer = nullptr) override;
+    private:
+        explicit MeshCacheReader(std::string fileName, IMeshFactory const&);
+        // Leaves the mesh as it is if the file can't be read
+        MeshPointer readFile(Mesh::MeshPointer&);
+        MeshPointer getOutput(std::istream&, Mesh::MeshPointer&);
+        // The file's sections are shared with the mesh, which keeps fileData alive
+        MeshPointer read(std::shared_ptr<char[]> const& fileData, size_t fileSize, Mesh::MeshPointer&) const;
+
+    friend class CachedReader;
+    friend class ReaderFactory;
+};
+
+}
@@ -0,0 +1,267 @@
+#include "OBJReader.h"
+#include "MappedFile.h"
+#include "MeshFactory.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <vector>
+using namespace std;
+using namespace mv;
+
+namespace mv::readers {
+
+namespace {
+    using MeshPointer = Reader::MeshPointer;
+
+    // Fewer bytes than this aren't worth parsing on a separate thread
+    constexpr size_t minimumBytesPerThread = 1 << 20;
+
+    // Splits text into blocks that end right after a line end, so that every line is in one block
+    vector<string_view> splitAtLines(string_view const text) {
+        auto const numBlocks = common::getNumberOfRanges(text.size(), minimumBytesPerThread);
+        vector<string_view> blocks;
+        blocks.reserve(numBlocks);
+        size_t blockBegin = 0;
+        for (size_t i = 1; i <= numBlocks && blockBegin < text.size(); ++i) {
+            auto blockEnd = text.size();
+            if (i < numBlocks) {
+                auto const lineEnd = text.find('\n', std::max(blockBegin, i * text.size() / numBlocks));
+                if (lineEnd != string_view::npos) {
+                    blockEnd = lineEnd + 1;
+                }
+            }
+            blocks.push_back(text.substr(blockBegin, blockEnd - blockBegin));
+            blockBegin = blockEnd;
+        }
+        return blocks;
+    }
+
+    // Vertices and faces of a block. Faces keep the vertex indices as they are written, because negative indices
+    // are relative to the vertices before the face and the vertices in the blocks before this one aren't known
+    // while it is parsed
+    struct Block {
+        struct Face {
+            unsigned numIndices;
+            // Number of vertices of the block before the face
+            unsigned numVerticesBefore;
+        };
+
+        vector<float> positions;
+        vector<Face> faces;
+        vector<int64_t> indices;
+        size_t numTriangles = 0;
+    };
+
+    // Reads the values of a line. Values are parsed from views into the text, so nothing is allocated per line
+    class LineParser {
+        public:
+            LineParser(string_view const line, string const& fileName)
+                : m_line(line)
+                , m_next(line.data())
+                , m_end(line.data() + line.size())
+                , m_fileName(fileName) {
+            }
+
+            string_view getKeyword() {
+                skipSpace();
+                auto const* keywordBegin = m_next;
+                while (m_next != m_end && !isSpace(*m_next)) ++m_next;
+                return {keywordBegin, static_cast<size_t>(m_next - keywordBegin)};
+            }
+
+            float getFloat() {
+                skipSpace();
+                // from_chars doesn't accept a leading plus sign
+                if (m_next != m_end && *m_next == '+') ++m_next;
+                float value;
+                auto const [end, error] = from_chars(m_next, m_end, value);
+                if (error != errc{} || (end != m_end && !isSpace(*end))) throwInvalid();
+                m_next = end;
+                return value;
+            }
+
+            // Reads the vertex index of the next v, v/vt, v//vn or v/vt/vn tuple. Returns false at the end of the
+            // line
+            bool getVertexIndex(int64_t& index) {
+                skipSpace();
+                if (m_next == m_end) return false;
+                auto const [end, error] = from_chars(m_next, m_end, index);
+                if (error != errc{} || index == 0 || (end != m_end && !isSpace(*end) && *end != '/')) throwInvalid();
+                m_next = end;
+                // Texture coordinate and normal indices
+                while (m_next != m_end && !isSpace(*m_next)) {
+                    if (*m_next != '/' && *m_next != '-' && (*m_next < '0' || *m_next > '9')) throwInvalid();
+                    ++m_next;
+                }
+                return true;
+            }
+
+        private:
+            static bool isSpace(char const c) {
+                return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+            }
+
+            void skipSpace() {
+                while (m_next != m_end && isSpace(*m_next)) ++m_next;
+            }
+
+            [[noreturn]] void throwInvalid() const {
+                throw std::runtime_error("Cannot parse " + string{m_line} + " in file " + m_fileName);
+            }
+
+            string_view const m_line;
+            char const* m_next;
+            char const* const m_end;
+            string const& m_fileName;
+    };
+
+    void parseBlock(string_view text, string const& fileName, Block& block) {
+        while (!text.empty()) {
+            auto const lineEnd = std::min(text.find('\n'), text.size());
+            LineParser parser {text.substr(0, lineEnd), fileName};
+            text.remove_prefix(std::min(lineEnd + 1, text.size()));
+
+            // Lines of other types (comments, groups, materials, texture coordinates, normals, ...) are skipped
+            auto const keyword = parser.getKeyword();
+            if (keyword == "v") {
+                for (unsigned i = 0; i < 3; ++i) {
+                    block.positions.push_back(parser.getFloat());
+                }
+            } else if (keyword == "f") {
+                auto const firstIndex = block.indices.size();
+                int64_t index;
+                while (parser.getVertexIndex(index)) {
+                    block.indices.push_back(index);
+                }
+                auto const numIndices = static_cast<unsigned>(block.indices.size() - firstIndex);
+                block.faces.push_back({numIndices, static_cast<unsigned>(block.positions.size() / 3)});
+                block.numTriangles += numIndices > 2 ? numIndices - 2 : 0;
+            }
+        }
+    }
+
+    // Converts the 1-based and relative vertex indices of the faces of a block to 0-based ones and writes the
+    // triangle fans of the faces
+    void writeTriangles(Block const& block, size_t const firstVertex, size_t const numVertices,
+                        string const& fileName, unsigned* triangles) {
+        auto const* index = block.indices.data();
+        for (auto const& face : block.faces) {
+            auto getVertex = [&](unsigned const i) {
+                auto const objIndex = index[i];
+                auto const vertex = objIndex > 0 ? objIndex - 1 :
+                        static_cast<int64_t>(firstVertex + face.numVerticesBefore) + objIndex;
+                if (vertex < 0 || static_cast<size_t>(vertex) >= numVertices) {
+                    throw std::runtime_error("Vertex index " + to_string(objIndex) + " in " + fileName +
+                                             " is out of range");
+                }
+                return static_cast<unsigned>(vertex);
+            };
+            if (face.numIndices > 2) {
+                auto const first = getVertex(0);
+                auto previous = getVertex(1);
+                for (unsigned i = 2; i < face.numIndices; ++i) {
+                    auto const current = getVertex(i);
+                    *triangles++ = first;
+                    *triangles++ = previous;
+                    *triangles++ = current;
+                    previous = current;
+                }
+            }
+            index += face.numIndices;
+        }
+    }
+}
+
+OBJReader::OBJReader(std::string fn, IMeshFactory const& meshFactory)
+    : Reader(std::move(fn), meshFactory) {
+}
+
+MeshPointer OBJReader::getOutput(MeshPointer mesh) {
+    MappedFile const file(fileName);
+    if (!file.isMapped()) {
+        ifstream ifs(fileName, ios::binary);
+        if (!ifs) {
+            throw std::runtime_error("Unable to open file " + fileName + '!');
+        }
+        return std::move(getOutput(ifs, mesh));
+    }
+    return std::move(read(file.getData(), mesh));
+}
+
+MeshPointer OBJReader::getOutput(istream& inputStream, MeshPointer& mesh) {
+    vector<char> const fileData{istreambuf_iterator<char>(inputStream), istreambuf_iterator<char>()};
+    return std::move(read(fileData, mesh));
+}
+
+void OBJReader::createMesh(MeshPointer& mesh, unsigned const numVertices, unsigned const numFaces) const {
+    // To allow a mock mesh to be injected into this object for unit testing
+    if (!mesh) {
+        mesh = meshFactory.createMesh();
+    }
+    mesh->initialize(numVertices, numFaces);
+}
+
+MeshPointer OBJReader::read(span<char const> const fileData, MeshPointer& mesh) const {
+    // Blocks of the file are parsed concurrently into their own vertex and face lists
+    auto const textBlocks = splitAtLines({fileData.data(), fileData.size()});
+    vector<Block> blocks(textBlocks.size());
+    common::parallelFor(blocks.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            parseBlock(textBlocks[i], fileName, blocks[i]);
+        }
+    }, 1);
+
+    // The vertices and triangles of a block follow those of all the blocks before it
+    vector<size_t> firstVertices(blocks.size() + 1);
+    vector<size_t> firstTriangles(blocks.size() + 1);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        firstVertices[i + 1] = firstVertices[i] + blocks[i].positions.size() / 3;
+        firstTriangles[i + 1] = firstTriangles[i] + blocks[i].numTriangles;
+    }
+    auto const numVertices = firstVertices.back();
+    auto const numTriangles = firstTriangles.back();
+    if (numVertices > numeric_limits<unsigned>::max() / 3 || numTriangles > numeric_limits<unsigned>::max() / 3) {
+        throw std::runtime_error(fileName + " has too many vertices or faces");
+    }
+    createMesh(mesh, static_cast<unsigned>(numVertices), static_cast<unsigned>(numTriangles));
+
+    // Meshes that don't expose their buffers are filled from temporary ones
+    auto positions = mesh->getPositionBuffer();
+    auto triangles = mesh->getIndexBuffer();
+    vector<float> positionData;
+    vector<unsigned> triangleData;
+    bool const hasBuffers = !positions.empty() && !triangles.empty();
+    if (!hasBuffers) {
+        positionData.resize(3 * numVertices);
+        triangleData.resize(3 * numTriangles);
+        positions = positionData;
+        triangles = triangleData;
+    }
+
+    common::parallelFor(blocks.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            std::copy(blocks[i].positions.begin(), blocks[i].positions.end(),
+                      positions.begin() + 3 * firstVertices[i]);
+            writeTriangles(blocks[i], firstVertices[i], numVertices, fileName,
+                           triangles.data() + 3 * firstTriangles[i]);
+            // Release memory as soon as it is copied
+            blocks[i] = {};
+        }
+    }, 1);
+
+    if (!hasBuffers) {
+        for (size_t i = 0; i < positionData.size(); i += 3) {
+            mesh->addVertex(positionData[i], positionData[i + 1], positionData[i + 2]);
+        }
+        for (size_t i = 0; i < triangleData.size(); i += 3) {
+            mesh->addFace({triangleData[i], triangleData[i + 1], triangleData[i + 2]});
+        }
+    }
+    return std::move(mesh);
+}
+
+}
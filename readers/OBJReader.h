@@ -0,0 +1,25 @@
+#pragma once
+#include <istream>
+#include <span>
+#include <string>
+#include "Reader.h"
+
+namespace mv::readers {
+
+// Reads the polygonal geometry of Wavefront OBJ files. Faces are split into triangle fans. Texture coordinates and
+// normals that faces refer to are accepted but not read, since meshes only store positions
+class OBJReader : public Reader {
+    public:
+        // Reads the file from a memory mapping. Files that can't be mapped are read as streams
+        MeshPointer getOutput(Mesh::MeshPointer = nullptr) override;
+    private:
+        explicit OBJReader(std::string fileName, IMeshFactory const&);
+        MeshPointer getOutput(std::istream&, Mesh::MeshPointer&);
+        MeshPointer read(std::span<char const> fileData, Mesh::MeshPointer&) const;
+        void createMesh(Mesh::MeshPointer&, unsigned numVertices, unsigned numFaces) const;
+
+    friend class OBJReaderFixture;
+    friend class ReaderFactory;
+};
+
+}
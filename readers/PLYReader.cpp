@@ -1,26 +1,581 @@
 #include "PLYReader.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <spanstream>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "MappedFile.h"
 #include "MeshFactory.h"
+#include "Parallel.h"
 
 namespace {
-    // Get a 3-tuple of the specified type from a space delimited string
-    template<typename T, unsigned N>
-    std::vector<T> getAsNTuple(std::string const& str) {
-        std::vector<T> result(N);
-        auto start = str.c_str();
-        char* end;
-        for(unsigned i = 0; i < N; ++i, start = end) {
-            result[i] =
-                    static_cast<T>(std::is_integral<T>::value ?
-                    strtoul(start, &end, 10) : strtod(start, &end));
-            if (((*end < '0' || *end > '9') && !isspace(*end) && *end != '\0') || errno == ERANGE) {
-                throw std::runtime_error("Cannot parse " + str);
+    using MeshPointer = mv::readers::Reader::MeshPointer;
+    using PropertyType = mv::readers::PLYReader::PropertyType;
+    using Property = mv::readers::PLYReader::Property;
+    using Element = mv::readers::PLYReader::Element;
+
+    size_t getSize(PropertyType const type) {
+        constexpr size_t sizes[] = {1, 1, 2, 2, 4, 4, 4, 8};
+        return sizes[static_cast<unsigned>(type)];
+    }
+
+    bool isInteger(PropertyType const type) {
+        return type != PropertyType::Float32 && type != PropertyType::Float64;
+    }
+
+    // Type names in the header. Both the original names and the sized names are in common use
+    PropertyType getPropertyType(std::string_view const name) {
+        constexpr std::pair<std::string_view, PropertyType> typeNames[] = {
+            {"char", PropertyType::Int8}, {"int8", PropertyType::Int8},
+            {"uchar", PropertyType::UInt8}, {"uint8", PropertyType::UInt8},
+            {"short", PropertyType::Int16}, {"int16", PropertyType::Int16},
+            {"ushort", PropertyType::UInt16}, {"uint16", PropertyType::UInt16},
+            {"int", PropertyType::Int32}, {"int32", PropertyType::Int32},
+            {"uint", PropertyType::UInt32}, {"uint32", PropertyType::UInt32},
+            {"float", PropertyType::Float32}, {"float32", PropertyType::Float32},
+            {"double", PropertyType::Float64}, {"float64", PropertyType::Float64},
+        };
+        for (auto const& [typeName, type] : typeNames) {
+            if (typeName == name) return type;
+        }
+        throw std::runtime_error("Unknown PLY property type " + std::string{name});
+    }
+
+    // Calls function with a value of the C++ type that stores a property type, so that the function is
+    // instantiated for each type
+    template<typename Function>
+    decltype(auto) visitType(PropertyType const type, Function&& function) {
+        switch (type) {
+            case PropertyType::Int8: return function(int8_t{});
+            case PropertyType::UInt8: return function(uint8_t{});
+            case PropertyType::Int16: return function(int16_t{});
+            case PropertyType::UInt16: return function(uint16_t{});
+            case PropertyType::Int32: return function(int32_t{});
+            case PropertyType::UInt32: return function(uint32_t{});
+            case PropertyType::Float32: return function(float{});
+            case PropertyType::Float64: return function(double{});
+        }
+        std::unreachable();
+    }
+
+    // Same as visitType for the integer types that list counts and vertex indices are stored as
+    template<typename Function>
+    decltype(auto) visitIntegerType(PropertyType const type, Function&& function) {
+        switch (type) {
+            case PropertyType::Int8: return function(int8_t{});
+            case PropertyType::UInt8: return function(uint8_t{});
+            case PropertyType::Int16: return function(int16_t{});
+            case PropertyType::UInt16: return function(uint16_t{});
+            case PropertyType::Int32: return function(int32_t{});
+            case PropertyType::UInt32: return function(uint32_t{});
+            default: break;
+        }
+        throw std::runtime_error("PLY list counts and vertex indices have to be integers");
+    }
+
+    // Reads a value that is stored in the byte order of the file. Data need not be aligned
+    template<typename T, bool swapBytes>
+    T load(char const* data) {
+        if constexpr (swapBytes && sizeof(T) > 1) {
+            using Bits = std::conditional_t<sizeof(T) == 2, uint16_t,
+                                            std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+            Bits bits;
+            memcpy(&bits, data, sizeof(bits));
+            return std::bit_cast<T>(std::byteswap(bits));
+        } else {
+            T value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+    }
+
+    template<typename T>
+    size_t toCount(T const count) {
+        if constexpr (std::is_signed_v<T>) {
+            if (count < 0) throw std::runtime_error("PLY list has a negative count");
+        }
+        return static_cast<size_t>(count);
+    }
+
+    template<bool swapBytes>
+    size_t loadCount(PropertyType const type, char const* data) {
+        return visitIntegerType(type, [data]<typename T>(T) { return toCount(load<T, swapBytes>(data)); });
+    }
+
+    void throwTruncated(std::string const& fileName) {
+        throw std::runtime_error("Data in " + fileName + " is truncated or doesn't match its header");
+    }
+
+    // Size of the value of a property that starts at data. Lists are skipped without their items being decoded
+    template<bool swapBytes>
+    size_t getPropertySize(char const* data, char const* end, Property const& property,
+                           std::string const& fileName) {
+        auto const available = static_cast<size_t>(end - data);
+        if (!property.isList) {
+            if (available < getSize(property.type)) throwTruncated(fileName);
+            return getSize(property.type);
+        }
+        if (available < getSize(property.countType)) throwTruncated(fileName);
+        auto const count = loadCount<swapBytes>(property.countType, data);
+        if ((available - getSize(property.countType)) / getSize(property.type) < count) throwTruncated(fileName);
+        return getSize(property.countType) + count * getSize(property.type);
+    }
+
+    // Size of a row with lists
+    template<bool swapBytes>
+    size_t getRowSize(char const* row, char const* end, std::vector<Property> const& properties,
+                      std::string const& fileName) {
+        auto const* next = row;
+        for (auto const& property : properties) {
+            next += getPropertySize<swapBytes>(next, end, property, fileName);
+        }
+        return next - row;
+    }
+
+    // Size of the data of an element that starts at data
+    template<bool swapBytes>
+    size_t getSectionSize(std::span<char const> const data, Element const& element, std::string const& fileName) {
+        if (auto const rowSize = element.getRowSize()) {
+            if (data.size() / rowSize < element.count) throwTruncated(fileName);
+            return element.count * rowSize;
+        }
+        size_t size = 0;
+        for (unsigned i = 0; i < element.count; ++i) {
+            size += getRowSize<swapBytes>(data.data() + size, data.data() + data.size(), element.properties, fileName);
+        }
+        return size;
+    }
+
+    // Positions of the x, y and z properties in a vertex row
+    struct VertexLayout {
+        size_t rowSize;
+        size_t offsets[3];
+        PropertyType types[3];
+    };
+
+    VertexLayout getVertexLayout(Element const& vertexElement) {
+        VertexLayout layout {vertexElement.getRowSize(), {}, {}};
+        if (!layout.rowSize) {
+            throw std::runtime_error("PLY vertices with list properties are not supported");
+        }
+        bool found[3] = {};
+        size_t offset = 0;
+        for (auto const& property : vertexElement.properties) {
+            auto const axis = std::string_view{"xyz"}.find(property.name);
+            if (property.name.size() == 1 && axis != std::string_view::npos) {
+                layout.offsets[axis] = offset;
+                layout.types[axis] = property.type;
+                found[axis] = true;
             }
+            offset += getSize(property.type);
+        }
+        if (!found[0] || !found[1] || !found[2]) {
+            throw std::runtime_error("PLY vertices have to have x, y and z properties");
         }
-        return result;
+        return layout;
     }
 
-    using MeshPointer = mv::readers::Reader::MeshPointer;
+    // Decodes vertex positions into x,y,z float triples. Other vertex properties (normals, colors, quality, ...)
+    // are strided over. Coordinates that share a type, which is the usual case, are decoded in one pass
+    template<bool swapBytes>
+    void decodePositions(char const* rows, VertexLayout const& layout, size_t const numVertices, float* positions) {
+        if (layout.types[0] == layout.types[1] && layout.types[1] == layout.types[2]) {
+            visitType(layout.types[0], [&]<typename T>(T) {
+                auto const* row = rows;
+                for (size_t i = 0; i < numVertices; ++i, row += layout.rowSize) {
+                    for (unsigned axis = 0; axis < 3; ++axis) {
+                        positions[3 * i + axis] = static_cast<float>(load<T, swapBytes>(row + layout.offsets[axis]));
+                    }
+                }
+            });
+            return;
+        }
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            visitType(layout.types[axis], [&]<typename T>(T) {
+                auto const* coordinate = rows + layout.offsets[axis];
+                for (size_t i = 0; i < numVertices; ++i, coordinate += layout.rowSize) {
+                    positions[3 * i + axis] = static_cast<float>(load<T, swapBytes>(coordinate));
+                }
+            });
+        }
+    }
+
+    // Position of the vertex index list in a face row
+    size_t getIndexListProperty(Element const& faceElement) {
+        for (size_t i = 0; i < faceElement.properties.size(); ++i) {
+            auto const& property = faceElement.properties[i];
+            if (property.isList && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                if (!isInteger(property.type) || !isInteger(property.countType)) {
+                    throw std::runtime_error("PLY list counts and vertex indices have to be integers");
+                }
+                return i;
+            }
+        }
+        throw std::runtime_error("PLY faces have to have a vertex_indices list property");
+    }
+
+    // Splits faces into triangle fans. Faces with fewer than 3 vertices are skipped
+    class FanWriter {
+        public:
+            FanWriter(unsigned* triangles, unsigned const numVertices, std::string const& fileName)
+                : m_next(triangles)
+                , m_numVertices(numVertices)
+                , m_fileName(fileName) {
+            }
+
+            template<typename GetIndex>
+            void writeFace(size_t const count, GetIndex const& getIndex) {
+                if (count < 3) return;
+                auto const first = check(getIndex(0));
+                auto previous = check(getIndex(1));
+                for (size_t i = 2; i < count; ++i) {
+                    auto const current = check(getIndex(i));
+                    *m_next++ = first;
+                    *m_next++ = previous;
+                    *m_next++ = current;
+                    previous = current;
+                }
+            }
+
+        private:
+            template<typename Index>
+            unsigned check(Index const index) const {
+                bool isNegative = false;
+                if constexpr (std::is_signed_v<Index>) isNegative = index < 0;
+                if (isNegative || static_cast<std::make_unsigned_t<Index>>(index) >= m_numVertices) {
+                    throw std::runtime_error("Vertex index " + std::to_string(index) + " in " + m_fileName +
+                                             " is out of range");
+                }
+                return static_cast<unsigned>(index);
+            }
+
+            unsigned* m_next;
+            unsigned const m_numVertices;
+            std::string const& m_fileName;
+    };
+
+    // Faces are decoded in blocks, which are independent of each other once the position of their data and the
+    // index of their first triangle are known. Vertices are decoded in blocks of the same size
+    constexpr unsigned facesPerBlock = 16384;
+    constexpr unsigned verticesPerBlock = 16384;
+
+    // Decoding fewer blocks than this on a separate thread isn't worth the cost of starting it
+    constexpr size_t minimumBlocksPerThread = 2;
+
+    // Checking fewer face sizes than this on a separate thread isn't worth the cost of starting it
+    constexpr size_t minimumFacesPerThread = 65536;
+
+    struct FaceBlock {
+        size_t offset;
+        size_t firstTriangle;
+    };
+
+    // Decodes faces whose rows hold only their vertex index list, which is how nearly all files store faces.
+    // Instantiated for each combination of count and index type
+    template<typename Count, typename Index, bool swapBytes>
+    struct IndexListDecoder {
+        // Counts the triangles the faces are split into, finds where each block of faces starts and returns the
+        // size of the face data
+        static size_t scan(std::span<char const> const data, unsigned const numFaces, std::vector<FaceBlock>& blocks,
+                           size_t& numTriangles, std::string const& fileName) {
+            blocks.clear();
+            if (auto const rowSize = getFixedRowSize(data, numFaces)) {
+                auto const count = (rowSize - sizeof(Count)) / sizeof(Index);
+                auto const trianglesPerFace = count > 2 ? count - 2 : 0;
+                for (size_t i = 0; i < numFaces; i += facesPerBlock) {
+                    blocks.push_back({i * rowSize, i * trianglesPerFace});
+                }
+                numTriangles = numFaces * trianglesPerFace;
+                return numFaces * rowSize;
+            }
+
+            numTriangles = 0;
+            size_t offset = 0;
+            for (unsigned i = 0; i < numFaces; ++i) {
+                if (i % facesPerBlock == 0) blocks.push_back({offset, numTriangles});
+                if (data.size() - offset < sizeof(Count)) throwTruncated(fileName);
+                auto const count = toCount(load<Count, swapBytes>(data.data() + offset));
+                offset += sizeof(Count);
+                if ((data.size() - offset) / sizeof(Index) < count) throwTruncated(fileName);
+                offset += count * sizeof(Index);
+                numTriangles += count > 2 ? count - 2 : 0;
+            }
+            return offset;
+        }
+
+        // Files usually have faces of a single size, which makes their rows fixed size. Returns the size of a row
+        // if all faces have as many vertices as the first one and 0 otherwise. Faces are checked in parallel
+        static size_t getFixedRowSize(std::span<char const> const data, unsigned const numFaces) {
+            if (!numFaces || data.size() < sizeof(Count)) return 0;
+            auto const count = load<Count, swapBytes>(data.data());
+            if constexpr (std::is_signed_v<Count>) {
+                if (count < 0) return 0;
+            }
+            auto const rowSize = sizeof(Count) + static_cast<size_t>(count) * sizeof(Index);
+            if (data.size() / rowSize < numFaces) return 0;
+            std::atomic<bool> isFixed = true;
+            mv::common::parallelFor(numFaces, [&](size_t const begin, size_t const end) {
+                for (auto i = begin; i < end; ++i) {
+                    if (load<Count, swapBytes>(data.data() + i * rowSize) != count) {
+                        isFixed = false;
+                        return;
+                    }
+                }
+            }, minimumFacesPerThread);
+            return isFixed ? rowSize : 0;
+        }
+
+        static void decode(char const* data, unsigned const numFaces, FanWriter& writer) {
+            for (unsigned i = 0; i < numFaces; ++i) {
+                auto const count = static_cast<size_t>(load<Count, swapBytes>(data));
+                auto const* indices = data + sizeof(Count);
+                writer.writeFace(count, [indices](size_t const j) {
+                    return load<Index, swapBytes>(indices + j * sizeof(Index));
+                });
+                data = indices + count * sizeof(Index);
+            }
+        }
+    };
+
+    // Decodes faces with properties other than the vertex index list, e.g. colors or other lists
+    template<bool swapBytes>
+    struct FaceRowDecoder {
+        // Calls onFace(row, count, indices) with the vertex index list of each face and returns the size of the
+        // face data
+        template<typename OnFace>
+        static size_t walk(std::span<char const> const data, unsigned const numFaces,
+                           std::vector<Property> const& properties, size_t const indexProperty,
+                           std::string const& fileName, OnFace const& onFace) {
+            auto const* next = data.data();
+            auto const* end = data.data() + data.size();
+            for (unsigned i = 0; i < numFaces; ++i) {
+                auto const* row = next;
+                for (size_t j = 0; j < properties.size(); ++j) {
+                    auto const size = getPropertySize<swapBytes>(next, end, properties[j], fileName);
+                    if (j == indexProperty) {
+                        onFace(row, loadCount<swapBytes>(properties[j].countType, next),
+                               next + getSize(properties[j].countType));
+                    }
+                    next += size;
+                }
+            }
+            return next - data.data();
+        }
+
+        static size_t scan(std::span<char const> const data, Element const& faceElement, size_t const indexProperty,
+                           std::vector<FaceBlock>& blocks, size_t& numTriangles, std::string const& fileName) {
+            blocks.clear();
+            numTriangles = 0;
+            unsigned faceIndex = 0;
+            return walk(data, faceElement.count, faceElement.properties, indexProperty, fileName,
+                        [&](char const* row, size_t const count, char const*) {
+                if (faceIndex++ % facesPerBlock == 0) {
+                    blocks.push_back({static_cast<size_t>(row - data.data()), numTriangles});
+                }
+                numTriangles += count > 2 ? count - 2 : 0;
+            });
+        }
+
+        static void decode(std::span<char const> const data, unsigned const numFaces, Element const& faceElement,
+                           size_t const indexProperty, FanWriter& writer, std::string const& fileName) {
+            visitIntegerType(faceElement.properties[indexProperty].type, [&]<typename Index>(Index) {
+                walk(data, numFaces, faceElement.properties, indexProperty, fileName,
+                     [&writer](char const*, size_t const count, char const* indices) {
+                    writer.writeFace(count, [indices](size_t const j) {
+                        return load<Index, swapBytes>(indices + j * sizeof(Index));
+                    });
+                });
+            });
+        }
+    };
+}
+
+namespace {
+    // Calls decode(positions, triangles) with the buffers of the mesh. Meshes that don't expose their buffers are
+    // filled from temporary ones
+    template<typename Decode>
+    void decodeIntoMesh(MeshPointer const& mesh, size_t const numVertices, size_t const numTriangles,
+                        Decode const& decode) {
+        auto positions = mesh->getPositionBuffer();
+        auto triangles = mesh->getIndexBuffer();
+        if (!positions.empty() && !triangles.empty()) {
+            decode(positions, triangles);
+            return;
+        }
+        std::vector<float> positionData(3 * numVertices);
+        std::vector<unsigned> triangleData(3 * numTriangles);
+        decode(std::span<float>{positionData}, std::span<unsigned>{triangleData});
+        for (size_t i = 0; i < positionData.size(); i += 3) {
+            mesh->addVertex(positionData[i], positionData[i + 1], positionData[i + 2]);
+        }
+        for (size_t i = 0; i < triangleData.size(); i += 3) {
+            mesh->addFace({triangleData[i], triangleData[i + 1], triangleData[i + 2]});
+        }
+    }
+
+    // ASCII files are parsed in blocks of whole lines. Fewer bytes than this aren't worth parsing on a separate
+    // thread
+    constexpr size_t minimumBytesPerThread = 1 << 20;
+
+    // Splits text into blocks that end right after a line end, so that every row is in one block
+    std::vector<std::string_view> splitAtLines(std::string_view const text, size_t const numBlocks) {
+        std::vector<std::string_view> blocks;
+        blocks.reserve(numBlocks);
+        size_t blockBegin = 0;
+        for (size_t i = 1; i <= numBlocks && blockBegin < text.size(); ++i) {
+            auto blockEnd = text.size();
+            if (i < numBlocks) {
+                auto const lineEnd = text.find('\n', std::max(blockBegin, i * text.size() / numBlocks));
+                if (lineEnd != std::string_view::npos) {
+                    blockEnd = lineEnd + 1;
+                }
+            }
+            blocks.push_back(text.substr(blockBegin, blockEnd - blockBegin));
+            blockBegin = blockEnd;
+        }
+        return blocks;
+    }
+
+    // Splits text into a block per thread
+    std::vector<std::string_view> splitAtLines(std::string_view const text) {
+        return splitAtLines(text, mv::common::getNumberOfRanges(text.size(), minimumBytesPerThread));
+    }
+
+    // Number of lines in a block. The last line of a file need not end with a line end
+    size_t countLines(std::string_view const block) {
+        auto const lineEnds = static_cast<size_t>(std::count(block.begin(), block.end(), '\n'));
+        return lineEnds + (!block.empty() && block.back() != '\n' ? 1 : 0);
+    }
+
+    // Reads the values of a row of an ASCII file. Values are parsed from views into the text, so nothing is
+    // allocated per row
+    class AsciiRow {
+        public:
+            AsciiRow(std::string_view const line, std::string const& fileName)
+                : m_line(line)
+                , m_next(line.data())
+                , m_end(line.data() + line.size())
+                , m_fileName(fileName) {
+            }
+
+            template<typename T>
+            T getNext() {
+                skipSpace();
+                // from_chars doesn't accept a leading plus sign
+                if (m_next != m_end && *m_next == '+') ++m_next;
+                T value;
+                auto const [end, error] = std::from_chars(m_next, m_end, value);
+                if (error != std::errc{} || (end != m_end && !isSpace(*end))) {
+                    throw std::runtime_error("Cannot parse " + std::string{m_line} + " in file " + m_fileName);
+                }
+                m_next = end;
+                return value;
+            }
+
+            void skip(Property const& property) {
+                auto const count = property.isList ? toCount(getNext<int64_t>()) : 1;
+                for (size_t i = 0; i < count; ++i) {
+                    skipSpace();
+                    if (m_next == m_end) {
+                        throw std::runtime_error("Cannot parse " + std::string{m_line} + " in file " + m_fileName);
+                    }
+                    while (m_next != m_end && !isSpace(*m_next)) ++m_next;
+                }
+            }
+
+        private:
+            static bool isSpace(char const c) {
+                return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+            }
+
+            void skipSpace() {
+                while (m_next != m_end && isSpace(*m_next)) ++m_next;
+            }
+
+            std::string_view const m_line;
+            char const* m_next;
+            char const* const m_end;
+            std::string const& m_fileName;
+    };
+
+    // Calls onRow(element, row, line) for each line of a block. firstLine is the number of the block's first line
+    // and elementFirstLines the number of the first line of each element, followed by the number of lines of all
+    // elements. Lines after the last element are ignored
+    template<typename OnRow>
+    void forEachRow(std::string_view block, size_t line, std::vector<size_t> const& elementFirstLines,
+                    OnRow const& onRow) {
+        size_t element = 0;
+        for (; !block.empty(); ++line) {
+            auto const lineEnd = std::min(block.find('\n'), block.size());
+            while (element + 1 < elementFirstLines.size() && line >= elementFirstLines[element + 1]) ++element;
+            if (element + 1 == elementFirstLines.size()) return;
+            onRow(element, line - elementFirstLines[element], block.substr(0, lineEnd));
+            block.remove_prefix(std::min(lineEnd + 1, block.size()));
+        }
+    }
+
+    // Position of the x, y and z properties in a vertex row
+    std::array<size_t, 3> getAxisProperties(std::vector<Property> const& vertexProperties) {
+        std::array<size_t, 3> axisProperties {};
+        bool found[3] = {};
+        for (size_t i = 0; i < vertexProperties.size(); ++i) {
+            auto const axis = std::string_view{"xyz"}.find(vertexProperties[i].name);
+            if (vertexProperties[i].name.size() == 1 && axis != std::string_view::npos &&
+                !vertexProperties[i].isList) {
+                axisProperties[axis] = i;
+                found[axis] = true;
+            }
+        }
+        if (!found[0] || !found[1] || !found[2]) {
+            throw std::runtime_error("PLY vertices have to have x, y and z properties");
+        }
+        return axisProperties;
+    }
+
+    void readVertex(AsciiRow& row, std::vector<Property> const& vertexProperties,
+                    std::array<size_t, 3> const& axisProperties, float* position) {
+        for (size_t j = 0; j < vertexProperties.size(); ++j) {
+            auto const axis = std::find(axisProperties.begin(), axisProperties.end(), j) - axisProperties.begin();
+            if (axis < 3) {
+                position[axis] = row.getNext<float>();
+            } else {
+                row.skip(vertexProperties[j]);
+            }
+        }
+    }
+
+    void readFaceIndices(AsciiRow& row, std::vector<Property> const& faceProperties, size_t const indexProperty,
+                         std::vector<int64_t>& indices) {
+        for (size_t j = 0; j < indexProperty; ++j) row.skip(faceProperties[j]);
+        indices.resize(toCount(row.getNext<int64_t>()));
+        for (auto& index : indices) index = row.getNext<int64_t>();
+    }
+
+    // Appends the triangle fan of a face to triangles
+    template<typename GetIndex>
+    void appendFace(std::vector<unsigned>& triangles, size_t const count, GetIndex const& getIndex,
+                    unsigned const numVertices, std::string const& fileName) {
+        auto const firstIndex = triangles.size();
+        triangles.resize(firstIndex + 3 * (count > 2 ? count - 2 : 0));
+        FanWriter{triangles.data() + firstIndex, numVertices, fileName}.writeFace(count, getIndex);
+    }
+}
+
+size_t mv::readers::PLYReader::Element::getRowSize() const {
+    size_t rowSize = 0;
+    for (auto const& property : properties) {
+        if (property.isList) return 0;
+        rowSize += ::getSize(property.type);
+    }
+    return rowSize;
 }
 
 mv::readers::PLYReader::PLYReader(std::string fileName, IMeshFactory const &meshFactory)
@@ -32,84 +587,426 @@ mv::readers::PLYReader::PLYReader(std::string fileName, IMeshFactory const &mesh
 }
 
 MeshPointer mv::readers::PLYReader::getOutput(MeshPointer mesh) {
-    std::ifstream ifs(fileName, std::ios::binary);
-    if (!ifs) {
-        throw std::runtime_error("Unable to open file " + fileName + '!');
+    MappedFile const file(fileName);
+    if (!file.isMapped()) {
+        std::ifstream ifs(fileName, std::ios::binary);
+        if (!ifs) {
+            throw std::runtime_error("Unable to open file " + fileName + '!');
+        }
+        return readStream(ifs, std::move(mesh));
     }
-    return getOutput(ifs, mesh);
+
+    // The header is parsed from the mapping and binary data is decoded straight from it
+    std::ispanstream stream{file.getData()};
+    readHeader(stream);
+    auto const headerSize = stream.eof() ? file.getData().size() : static_cast<size_t>(stream.tellg());
+    auto const data = file.getData().subspan(headerSize);
+    return isBinary ? readBinary(data, mesh) : readASCII(data, mesh);
 }
 
-MeshPointer mv::readers::PLYReader::getOutput(std::istream& inputStream, MeshPointer& mesh) {
+MeshPointer mv::readers::PLYReader::readStream(std::istream& inputStream, MeshPointer mesh) {
     readHeader(inputStream);
-    return isBinary ? readBinary(inputStream, mesh) : readASCII(inputStream, mesh);
+
+    // Geometry is decoded as the data arrives. The mesh can only be created once all faces are split into
+    // triangles, so the decoded geometry is copied into it at the end
+    std::vector<float> positions(3 * size_t{numVertices});
+    std::vector<unsigned> triangles;
+    if (isBinary) {
+        std::cout << "Parsing PLY data in binary format" << std::endl;
+        if (isLittleEndian != (std::endian::native == std::endian::little)) {
+            streamBinary<true>(*inputStream.rdbuf(), positions, triangles);
+        } else {
+            streamBinary<false>(*inputStream.rdbuf(), positions, triangles);
+        }
+    } else {
+        std::cout << "Parsing PLY data in ASCII format" << std::endl;
+        streamASCII(inputStream, positions, triangles);
+    }
+    emitDecoded(positions, triangles, numVertices, triangles.size() / 3);
+
+    auto const numTriangles = triangles.size() / 3;
+    if (numTriangles > std::numeric_limits<unsigned>::max() / 3) {
+        throw std::runtime_error(fileName + " has too many faces");
+    }
+    createMesh(mesh, static_cast<unsigned>(numTriangles));
+    decodeIntoMesh(mesh, numVertices, numTriangles, [&](std::span<float> const meshPositions,
+                                                        std::span<unsigned> const meshTriangles) {
+        std::copy(positions.begin(), positions.end(), meshPositions.begin());
+        std::copy(triangles.begin(), triangles.end(), meshTriangles.begin());
+    });
+    return std::move(mesh);
+}
+
+template<bool swapBytes>
+void mv::readers::PLYReader::streamBinary(std::streambuf& buffer, std::vector<float>& positions,
+                                          std::vector<unsigned>& triangles) {
+    size_t bytesRead = 0;
+    auto read = [&](char* data, size_t const size) {
+        if (static_cast<size_t>(buffer.sgetn(data, static_cast<std::streamsize>(size))) != size) {
+            throwTruncated(fileName);
+        }
+        bytesRead += size;
+    };
+    auto const& vertexElement = *std::find_if(elements.begin(), elements.end(),
+                                              [](auto const& element) { return element.name == "vertex"; });
+    auto const& faceElement = *std::find_if(elements.begin(), elements.end(),
+                                            [](auto const& element) { return element.name == "face"; });
+    auto const vertexLayout = getVertexLayout(vertexElement);
+    auto const indexProperty = getIndexListProperty(faceElement);
+
+    std::vector<char> rows;
+    char value[8];
+    size_t numDecodedVertices = 0;
+    size_t numRowsRead = 0;
+    for (auto const& element : elements) {
+        // Fixed size rows are read in blocks
+        if (auto const rowSize = element.getRowSize()) {
+            for (size_t firstRow = 0; firstRow < element.count; firstRow += verticesPerBlock) {
+                auto const numRows = std::min<size_t>(verticesPerBlock, element.count - firstRow);
+                rows.resize(numRows * rowSize);
+                read(rows.data(), rows.size());
+                if (&element == &vertexElement) {
+                    decodePositions<swapBytes>(rows.data(), vertexLayout, numRows, positions.data() + 3 * firstRow);
+                    numDecodedVertices = firstRow + numRows;
+                    emitDecoded(positions, triangles, numDecodedVertices, triangles.size() / 3);
+                }
+                numRowsRead += numRows;
+                reportDataProgress(bytesRead, 0, numRowsRead);
+            }
+            continue;
+        }
+
+        // Rows with lists are read a property at a time
+        for (unsigned i = 0; i < element.count; ++i) {
+            if (++numRowsRead % verticesPerBlock == 0) {
+                reportDataProgress(bytesRead, 0, numRowsRead);
+            }
+            for (size_t j = 0; j < element.properties.size(); ++j) {
+                auto const& property = element.properties[j];
+                if (!property.isList) {
+                    read(value, getSize(property.type));
+                    continue;
+                }
+                read(value, getSize(property.countType));
+                auto const count = loadCount<swapBytes>(property.countType, value);
+                rows.resize(count * getSize(property.type));
+                read(rows.data(), rows.size());
+                if (&element == &faceElement && j == indexProperty) {
+                    visitIntegerType(property.type, [&]<typename Index>(Index) {
+                        appendFace(triangles, count, [&rows](size_t const k) {
+                            return load<Index, swapBytes>(rows.data() + k * sizeof(Index));
+                        }, numVertices, fileName);
+                    });
+                    if (triangles.size() / 3 >= getNumberOfEmittedTriangles() + trianglesPerMeshChunk) {
+                        emitDecoded(positions, triangles, numDecodedVertices, triangles.size() / 3);
+                    }
+                }
+            }
+        }
+    }
 }
 
-void mv::readers::PLYReader::createMesh(MeshPointer& mesh) const {
+void mv::readers::PLYReader::streamASCII(std::istream& inputStream, std::vector<float>& positions,
+                                         std::vector<unsigned>& triangles) {
+    auto findElement = [this](std::string const& name) {
+        return static_cast<size_t>(std::find_if(elements.begin(), elements.end(),
+                                   [&name](auto const& element) { return element.name == name; }) - elements.begin());
+    };
+    auto const vertexElement = findElement("vertex");
+    auto const faceElement = findElement("face");
+    auto const& vertexProperties = elements[vertexElement].properties;
+    auto const& faceProperties = elements[faceElement].properties;
+    auto const indexProperty = getIndexListProperty(elements[faceElement]);
+    auto const axisProperties = getAxisProperties(vertexProperties);
+    std::vector<size_t> elementFirstLines(elements.size() + 1);
+    for (size_t i = 0; i < elements.size(); ++i) {
+        elementFirstLines[i + 1] = elementFirstLines[i] + elements[i].count;
+    }
+
+    // Text is read in pieces that all threads can parse at once. Each piece is parsed up to its last line end and
+    // the rest of it is carried over to the next piece. Blocks of a piece collect the triangles of their faces,
+    // which are appended in the order of the blocks
+    auto const pieceSize = minimumBytesPerThread * common::getConcurrency();
+    std::string text;
+    size_t firstLine = 0;
+    size_t bytesRead = 0;
+    for (bool isLastPiece = false; !isLastPiece && firstLine < elementFirstLines.back();) {
+        auto const carriedSize = text.size();
+        text.resize(carriedSize + pieceSize);
+        inputStream.read(text.data() + carriedSize, static_cast<std::streamsize>(pieceSize));
+        text.resize(carriedSize + static_cast<size_t>(inputStream.gcount()));
+        isLastPiece = text.size() < carriedSize + pieceSize;
+        auto parsedSize = text.size();
+        if (!isLastPiece) {
+            auto const lineEnd = std::string_view{text}.rfind('\n');
+            parsedSize = lineEnd == std::string_view::npos ? 0 : lineEnd + 1;
+        }
+
+        auto const blocks = splitAtLines(std::string_view{text}.substr(0, parsedSize));
+        std::vector<size_t> blockFirstLines(blocks.size() + 1);
+        blockFirstLines[0] = firstLine;
+        common::parallelFor(blocks.size(), [&](size_t const begin, size_t const end) {
+            for (auto i = begin; i < end; ++i) {
+                blockFirstLines[i + 1] = countLines(blocks[i]);
+            }
+        }, 1);
+        std::partial_sum(blockFirstLines.begin(), blockFirstLines.end(), blockFirstLines.begin());
+
+        std::vector<std::vector<unsigned>> blockTriangles(blocks.size());
+        common::parallelFor(blocks.size(), [&](size_t const begin, size_t const end) {
+            std::vector<int64_t> indices;
+            for (auto i = begin; i < end; ++i) {
+                forEachRow(blocks[i], blockFirstLines[i], elementFirstLines,
+                           [&](size_t const element, size_t const rowIndex, std::string_view const line) {
+                    AsciiRow row {line, fileName};
+                    if (element == vertexElement) {
+                        readVertex(row, vertexProperties, axisProperties, positions.data() + 3 * rowIndex);
+                    } else if (element == faceElement) {
+                        readFaceIndices(row, faceProperties, indexProperty, indices);
+                        appendFace(blockTriangles[i], indices.size(), [&indices](size_t const k) {
+                            return indices[k];
+                        }, numVertices, fileName);
+                    }
+                });
+            }
+        }, 1);
+        for (auto const& block : blockTriangles) {
+            triangles.insert(triangles.end(), block.begin(), block.end());
+        }
+
+        firstLine = blockFirstLines.back();
+        text.erase(0, parsedSize);
+        auto const vertexLines = std::clamp(firstLine, elementFirstLines[vertexElement],
+                                            elementFirstLines[vertexElement + 1]);
+        emitDecoded(positions, triangles, vertexLines - elementFirstLines[vertexElement], triangles.size() / 3);
+        bytesRead += parsedSize;
+        reportDataProgress(bytesRead, 0, std::min(firstLine, elementFirstLines.back()));
+    }
+    if (firstLine < elementFirstLines.back()) {
+        throwTruncated(fileName);
+    }
+}
+
+void mv::readers::PLYReader::emitDecoded(std::span<float const> const positions,
+                                         std::span<unsigned const> const triangles,
+                                         size_t const numDecodedVertices, size_t numDecodedTriangles) {
+    if (!isEmittingChunks()) return;
+    auto const firstVertex = std::min(getNumberOfEmittedVertices(), numDecodedVertices);
+    auto const firstTriangle = getNumberOfEmittedTriangles();
+    if (numDecodedVertices < numVertices || numDecodedTriangles < firstTriangle) {
+        numDecodedTriangles = firstTriangle;
+    }
+    emitChunks(positions.subspan(3 * firstVertex, 3 * (numDecodedVertices - firstVertex)),
+               triangles.subspan(3 * firstTriangle, 3 * (numDecodedTriangles - firstTriangle)));
+}
+
+void mv::readers::PLYReader::createMesh(MeshPointer& mesh, unsigned const numTriangles) const {
     // This is to allow a mock mesh to be injected into this object for unit testing
     if (!mesh) {
         mesh = meshFactory.createMesh();
     }
-    mesh->initialize(numVertices, numFaces);
+    mesh->initialize(numVertices, numTriangles);
 }
 
-MeshPointer mv::readers::PLYReader::readBinary(std::istream& ifs, MeshPointer& mesh) const {
+void mv::readers::PLYReader::reportDataProgress(size_t const dataBytesRead, size_t const dataSize,
+                                               size_t const elementsRead) const {
+    reportProgress(headerSize + dataBytesRead, dataSize ? headerSize + dataSize : 0, elementsRead);
+}
+
+MeshPointer mv::readers::PLYReader::readBinary(std::span<char const> const data, MeshPointer& mesh) {
     std::cout << "Parsing PLY data in binary format" << std::endl;
-    createMesh(mesh);
-    // Assumptions:
-    // 1. Vertex data type is float
-    // 2. Mesh is a triangle mesh
-    // 3. Num Vertices entry is a byte
-    // 5. Vertex indices are 4-bytes
-    {
-        auto const vertexDataNumBytes = numVertices * sizeof(float) * 3;
-        std::unique_ptr<char[]> const vertexData{new char[vertexDataNumBytes]};
-        ifs.read(vertexData.get(), vertexDataNumBytes);
-        for (unsigned i = 0; i < numVertices; ++i) {
-            auto const xyz = reinterpret_cast<float*>(vertexData.get() + 3 * sizeof(float) * i);
-            mesh->addVertex(xyz[0], xyz[1], xyz[2]);
-        }
-    }
-    auto const currentPosition = ifs.tellg();
-    ifs.seekg(0, std::ios_base::end);
-    auto const size = ifs.tellg();
-    auto constexpr tupleSize = 3 * sizeof(unsigned int) + sizeof(char);
-    auto const indexDataNumBytes = numFaces * tupleSize;
-    if (size - currentPosition != indexDataNumBytes) {
-        throw std::runtime_error{"Data is invalid. It's possible mesh has mixed element types"
-                                 " Only triangle meshes are supported at this time"};
-    }
-
-    {
-        ifs.seekg(currentPosition, std::ios_base::beg);
-        std::unique_ptr<char[]> const indexData{new char[indexDataNumBytes]};
-        ifs.read(indexData.get(), indexDataNumBytes);
-        for (unsigned i = 0; i < numFaces; ++i) {
-            auto const tuple = indexData.get() + i * tupleSize;
-            auto const indices = reinterpret_cast<unsigned int*>(&tuple[1]);
-            mesh->addFace({indices[0], indices[1], indices[2]});
+    auto const swapBytes = isLittleEndian != (std::endian::native == std::endian::little);
+    return swapBytes ? decodeBinary<true>(data, mesh) : decodeBinary<false>(data, mesh);
+}
+
+template<bool swapBytes>
+MeshPointer mv::readers::PLYReader::decodeBinary(std::span<char const> const data, MeshPointer& mesh) {
+    auto findElement = [this](std::string const& name) {
+        return std::find_if(elements.begin(), elements.end(),
+                            [&name](auto const& element) { return element.name == name; });
+    };
+    auto const vertexElement = findElement("vertex");
+    auto const faceElement = findElement("face");
+    auto const vertexLayout = getVertexLayout(*vertexElement);
+    auto const indexProperty = getIndexListProperty(*faceElement);
+    auto const& indexList = faceElement->properties[indexProperty];
+    auto const hasOnlyIndices = faceElement->properties.size() == 1;
+
+    // Locate the vertex and face sections. Sections of elements with fixed size rows are skipped without being
+    // read. Faces are split into triangles, so the triangles are counted while the face section is measured
+    std::span<char const> vertexData, faceData;
+    std::vector<FaceBlock> faceBlocks;
+    size_t numTriangles = 0;
+    size_t offset = 0;
+    for (auto element = elements.begin(); element != elements.end(); ++element) {
+        auto const remainingData = data.subspan(offset);
+        size_t size;
+        if (element == faceElement && hasOnlyIndices) {
+            size = visitIntegerType(indexList.countType, [&]<typename Count>(Count) {
+                return visitIntegerType(indexList.type, [&]<typename Index>(Index) {
+                    return IndexListDecoder<Count, Index, swapBytes>::scan(remainingData, numFaces, faceBlocks,
+                                                                           numTriangles, fileName);
+                });
+            });
+        } else if (element == faceElement) {
+            size = FaceRowDecoder<swapBytes>::scan(remainingData, *faceElement, indexProperty, faceBlocks,
+                                                   numTriangles, fileName);
+        } else {
+            size = getSectionSize<swapBytes>(remainingData, *element, fileName);
         }
+        if (element == vertexElement) vertexData = remainingData.first(size);
+        if (element == faceElement) faceData = remainingData.first(size);
+        offset += size;
     }
+    if (numTriangles > std::numeric_limits<unsigned>::max() / 3) {
+        throw std::runtime_error(fileName + " has too many faces");
+    }
+    createMesh(mesh, static_cast<unsigned>(numTriangles));
+
+    // Blocks of vertices and blocks of faces are decoded concurrently, each straight into its part of the buffers
+    auto const numVertexBlocks = (size_t{numVertices} + verticesPerBlock - 1) / verticesPerBlock;
+    auto decodeVertexBlock = [&](size_t const block, float* positions) {
+        auto const firstVertex = block * verticesPerBlock;
+        decodePositions<swapBytes>(vertexData.data() + firstVertex * vertexLayout.rowSize, vertexLayout,
+                                   std::min<size_t>(verticesPerBlock, numVertices - firstVertex),
+                                   positions + 3 * firstVertex);
+    };
+    auto decodeFaceBlock = [&](size_t const block, unsigned* triangles) {
+        auto const firstFace = block * facesPerBlock;
+        auto const blockFaces = static_cast<unsigned>(std::min<size_t>(facesPerBlock, numFaces - firstFace));
+        auto const blockData = faceData.subspan(faceBlocks[block].offset);
+        FanWriter writer {triangles + 3 * faceBlocks[block].firstTriangle, numVertices, fileName};
+        if (hasOnlyIndices) {
+            visitIntegerType(indexList.countType, [&]<typename Count>(Count) {
+                visitIntegerType(indexList.type, [&]<typename Index>(Index) {
+                    IndexListDecoder<Count, Index, swapBytes>::decode(blockData.data(), blockFaces, writer);
+                });
+            });
+        } else {
+            FaceRowDecoder<swapBytes>::decode(blockData, blockFaces, *faceElement, indexProperty, writer, fileName);
+        }
+    };
+    auto const numBlocks = numVertexBlocks + faceBlocks.size();
+    decodeIntoMesh(mesh, numVertices, numTriangles, [&](std::span<float> const positions,
+                                                        std::span<unsigned> const triangles) {
+        // Files that are read in pieces are decoded a wave of blocks at a time in file order
+        auto const blocksPerWave = isReadInPieces() ?
+            std::max<size_t>(minimumBlocksPerThread, trianglesPerMeshChunk / facesPerBlock) * common::getConcurrency() :
+            numBlocks;
+        for (size_t firstBlock = 0; firstBlock < numBlocks; firstBlock += blocksPerWave) {
+            auto const numWaveBlocks = std::min(blocksPerWave, numBlocks - firstBlock);
+            common::parallelFor(numWaveBlocks, [&](size_t const begin, size_t const end) {
+                for (auto block = firstBlock + begin; block < firstBlock + end; ++block) {
+                    if (block < numVertexBlocks) {
+                        decodeVertexBlock(block, positions.data());
+                    } else {
+                        decodeFaceBlock(block - numVertexBlocks, triangles.data());
+                    }
+                }
+            }, minimumBlocksPerThread);
+            auto const endBlock = firstBlock + numWaveBlocks;
+            auto const endFaceBlock = std::max(endBlock, numVertexBlocks) - numVertexBlocks;
+            auto const numDecodedVertices = std::min<size_t>(numVertices, endBlock * verticesPerBlock);
+            auto const numDecodedFaces = std::min<size_t>(numFaces, endFaceBlock * facesPerBlock);
+            emitDecoded(positions, triangles, numDecodedVertices,
+                        endFaceBlock < faceBlocks.size() ? faceBlocks[endFaceBlock].firstTriangle : numTriangles);
+            auto const bytesRead = endFaceBlock ?
+                static_cast<size_t>(faceData.data() - data.data()) +
+                    (endFaceBlock < faceBlocks.size() ? faceBlocks[endFaceBlock].offset : faceData.size()) :
+                static_cast<size_t>(vertexData.data() - data.data()) + numDecodedVertices * vertexLayout.rowSize;
+            reportDataProgress(bytesRead, data.size(), numDecodedVertices + numDecodedFaces);
+        }
+    });
     return std::move(mesh);
 }
 
-MeshPointer mv::readers::PLYReader::readASCII(std::istream& inputStream, MeshPointer& mesh) const {
+MeshPointer mv::readers::PLYReader::readASCII(std::span<char const> const data, MeshPointer& mesh) {
     std::cout << "Parsing PLY data in ASCII format" << std::endl;
-    createMesh(mesh);
-    std::string line;
-    for (unsigned i = 0; i < numVertices; ++i) {
-        getline(inputStream, line);
-        auto vertex = getAsNTuple<float, 3>(line);
-        mesh->addVertex(vertex.at(0), vertex.at(1), vertex.at(2));
+    auto findElement = [this](std::string const& name) {
+        return static_cast<size_t>(std::find_if(elements.begin(), elements.end(),
+                                   [&name](auto const& element) { return element.name == name; }) - elements.begin());
+    };
+    auto const vertexElement = findElement("vertex");
+    auto const faceElement = findElement("face");
+    auto const& vertexProperties = elements[vertexElement].properties;
+    auto const& faceProperties = elements[faceElement].properties;
+    auto const indexProperty = getIndexListProperty(elements[faceElement]);
+    auto const axisProperties = getAxisProperties(vertexProperties);
+
+    // Each row is a line, so the rows of an element are located by numbering the lines of the blocks
+    std::vector<size_t> elementFirstLines(elements.size() + 1);
+    for (size_t i = 0; i < elements.size(); ++i) {
+        elementFirstLines[i + 1] = elementFirstLines[i] + elements[i].count;
+    }
+    // Text that is read in pieces is split into more blocks than threads, which are parsed a wave of blocks at a
+    // time
+    std::string_view const text {data.data(), data.size()};
+    auto const inPieces = isReadInPieces();
+    auto const blocks = inPieces ? splitAtLines(text, std::max<size_t>(1, text.size() / minimumBytesPerThread))
+                                 : splitAtLines(text);
+    auto const blocksPerWave = inPieces ? size_t{common::getConcurrency()} : std::max<size_t>(1, blocks.size());
+    std::vector<size_t> blockFirstLines(blocks.size() + 1);
+    common::parallelFor(blocks.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            blockFirstLines[i + 1] = countLines(blocks[i]);
+        }
+    }, 1);
+    std::partial_sum(blockFirstLines.begin(), blockFirstLines.end(), blockFirstLines.begin());
+    if (blockFirstLines.back() < elementFirstLines.back()) {
+        throwTruncated(fileName);
     }
 
-    for (unsigned i = 0; i < numFaces; ++i) {
-        getline(inputStream, line);
-        auto tri = getAsNTuple<unsigned, 4>(line);
-        if (tri.at(0) != 3) {
-            throw std::runtime_error("Only triangle meshes are supported at this time");
+    // Faces are split into triangle fans, so the triangles of each block are counted to find where they go
+    std::vector<size_t> blockFirstTriangles(blocks.size() + 1);
+    common::parallelFor(blocks.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            forEachRow(blocks[i], blockFirstLines[i], elementFirstLines,
+                       [&](size_t const element, size_t, std::string_view const line) {
+                if (element != faceElement) return;
+                AsciiRow row {line, fileName};
+                for (size_t j = 0; j < indexProperty; ++j) row.skip(faceProperties[j]);
+                auto const count = toCount(row.getNext<int64_t>());
+                blockFirstTriangles[i + 1] += count > 2 ? count - 2 : 0;
+            });
         }
-        mesh->addFace({tri.at(1), tri.at(2), tri.at(3)});
+    }, 1);
+    std::partial_sum(blockFirstTriangles.begin(), blockFirstTriangles.end(), blockFirstTriangles.begin());
+    auto const numTriangles = blockFirstTriangles.back();
+    if (numTriangles > std::numeric_limits<unsigned>::max() / 3) {
+        throw std::runtime_error(fileName + " has too many faces");
     }
+    createMesh(mesh, static_cast<unsigned>(numTriangles));
+
+    decodeIntoMesh(mesh, numVertices, numTriangles, [&](std::span<float> const positions,
+                                                        std::span<unsigned> const triangles) {
+        for (size_t firstBlock = 0; firstBlock < blocks.size(); firstBlock += blocksPerWave) {
+            auto const endBlock = std::min(blocks.size(), firstBlock + blocksPerWave);
+            common::parallelFor(endBlock - firstBlock, [&](size_t const begin, size_t const end) {
+                // Reused by the faces of the blocks, so that polygons of any size don't allocate per face
+                std::vector<int64_t> indices;
+                for (auto i = firstBlock + begin; i < firstBlock + end; ++i) {
+                    FanWriter writer {triangles.data() + 3 * blockFirstTriangles[i], numVertices, fileName};
+                    forEachRow(blocks[i], blockFirstLines[i], elementFirstLines,
+                               [&](size_t const element, size_t const rowIndex, std::string_view const line) {
+                        AsciiRow row {line, fileName};
+                        if (element == vertexElement) {
+                            readVertex(row, vertexProperties, axisProperties, positions.data() + 3 * rowIndex);
+                        } else if (element == faceElement) {
+                            readFaceIndices(row, faceProperties, indexProperty, indices);
+                            writer.writeFace(indices.size(), [&indices](size_t const k) { return indices[k]; });
+                        }
+                    });
+                }
+            }, 1);
+            auto const vertexLines = std::clamp(blockFirstLines[endBlock], elementFirstLines[vertexElement],
+                                                elementFirstLines[vertexElement + 1]);
+            emitDecoded(positions, triangles, vertexLines - elementFirstLines[vertexElement],
+                        blockFirstTriangles[endBlock]);
+            auto const& lastBlock = blocks[endBlock - 1];
+            reportDataProgress(static_cast<size_t>(lastBlock.data() + lastBlock.size() - text.data()), text.size(),
+                               std::min(blockFirstLines[endBlock], elementFirstLines.back()));
+        }
+    });
     return std::move(mesh);
 }
 
@@ -117,58 +1014,83 @@ void mv::readers::PLYReader::readHeader(std::istream& inputStream) {
 
     bool endHeader = false;
     bool isPly = false;
-    bool hasVertices = false;
-    bool hasFaces = false;
     bool hasFormat = false;
-    std::string const vertexElementId = "element vertex ";
-    std::string const faceElementId = "element face ";
-    std::string const formatId = "format ";
+    elements.clear();
+
+    auto isNumber = [](std::string_view const str) {
+        return !str.empty() && std::all_of(str.cbegin(), str.cend(), [](auto c) { return c >= '0' && c <= '9'; });
+    };
 
-    auto isNumber = [](std::string const& str) {
-        return std::all_of(str.cbegin(), str.cend(), [](auto c) { return c >= '0' && c <= '9'; });
+    // Splits a header line into its space separated words
+    std::vector<std::string_view> words;
+    auto split = [&words](std::string_view line) {
+        words.clear();
+        while (!line.empty()) {
+            auto const wordBegin = line.find_first_not_of(" \t");
+            if (wordBegin == std::string_view::npos) break;
+            line.remove_prefix(wordBegin);
+            auto const wordEnd = std::min(line.find_first_of(" \t"), line.size());
+            words.push_back(line.substr(0, wordEnd));
+            line.remove_prefix(wordEnd);
+        }
     };
 
     std::string headerLine;
-    while(!endHeader) {
-        getline(inputStream, headerLine);
-        if (!isPly && headerLine == "ply") {
-            isPly = true;
+    headerSize = 0;
+    while(!endHeader && getline(inputStream, headerLine)) {
+        headerSize += headerLine.size() + 1;
+        // Files written on Windows have CRLF line endings
+        if (headerLine.ends_with('\r')) headerLine.pop_back();
+        if (!isPly) {
+            isPly = headerLine == "ply";
+            if (!isPly) break;
             continue;
         }
-        if (isPly && !hasFormat) {
-            if (headerLine.starts_with(formatId)) {
-                auto format = headerLine.substr(formatId.size());
-                isBinary = format.starts_with("binary_little_endian");
-                hasFormat = true;
-            }
+        split(headerLine);
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info") {
+            continue;
         }
-        if (isPly && !hasVertices) {
-            if (headerLine.starts_with(vertexElementId)) {
-                auto numVerticesStr = headerLine.substr(vertexElementId.size());
-                if (!isNumber(numVerticesStr)) {
-                    throw std::runtime_error("Number of vertices is invalid. Found " + numVerticesStr + " when parsing vertex element");
-                }
-                numVertices = std::atoi(numVerticesStr.c_str()); // NOLINT: string validated by lambda isNumber
-                hasVertices = true;
-                continue;
+        if (words[0] == "format" && words.size() >= 2) {
+            isBinary = words[1].starts_with("binary");
+            isLittleEndian = words[1] == "binary_little_endian";
+            if (!isBinary && words[1] != "ascii") {
+                throw std::runtime_error("Unknown PLY format " + std::string{words[1]});
             }
-        }
-        if (isPly && !hasFaces) {
-            if (headerLine.starts_with(faceElementId)) {
-                auto numFacesStr = headerLine.substr(faceElementId.size());
-                if (!isNumber(numFacesStr)) {
-                    throw std::runtime_error("Number of faces is invalid. Found " + numFacesStr + " when parsing face element");
-                }
-                numFaces = std::atoi(numFacesStr.c_str()); // NOLINT: string validated by lambda isNumber
-                hasFaces = true;
+            hasFormat = true;
+        } else if (words[0] == "element" && words.size() == 3) {
+            auto const& name = words[1];
+            if (!isNumber(words[2])) {
+                auto const elementName = name == "vertex" ? "vertices" : name == "face" ? "faces" : std::string{name};
+                throw std::runtime_error("Number of " + elementName + " is invalid. Found " + std::string{words[2]} +
+                                         " when parsing " + std::string{name} + " element");
             }
-            continue;
+            elements.push_back({std::string{name}, static_cast<unsigned>(std::stoul(std::string{words[2]})), {}});
+        } else if (words[0] == "property" && !elements.empty()) {
+            if (words.size() == 5 && words[1] == "list") {
+                elements.back().properties.push_back({std::string{words[4]}, getPropertyType(words[3]), true,
+                                                      getPropertyType(words[2])});
+            } else if (words.size() == 3) {
+                elements.back().properties.push_back({std::string{words[2]}, getPropertyType(words[1]), false,
+                                                      PropertyType::UInt8});
+            } else {
+                throw std::runtime_error("Invalid PLY property " + headerLine);
+            }
+        } else {
+            endHeader = headerLine == "end_header";
         }
-        endHeader = headerLine == "end_header";
     }
-    if (!isPly || !hasVertices || !hasFaces || !hasFormat) {
+
+    auto findElement = [this](std::string const& name) {
+        return std::find_if(elements.begin(), elements.end(),
+                            [&name](auto const& element) { return element.name == name; });
+    };
+    auto const vertexElement = findElement("vertex");
+    auto const faceElement = findElement("face");
+    if (!isPly || vertexElement == elements.end() || faceElement == elements.end() || !hasFormat) {
         throw std::runtime_error("Invalid PLY file. Header is incorrect!");
     }
+    numVertices = vertexElement->count;
+    numFaces = faceElement->count;
 
     std::cout << "Parsing PLY file with " << numVertices << " vertices and " << numFaces << " faces" << std::endl;
 
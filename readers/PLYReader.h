@@ -1,29 +1,82 @@
 #pragma once
 
 #include "Reader.h"
+#include <istream>
+#include <span>
+#include <streambuf>
+#include <string>
+#include <vector>
 
 namespace mv::readers {
 
 class PLYReader : public Reader {
     public:
+        // Scalar types of PLY properties
+        enum class PropertyType : unsigned char {
+            Int8,
+            UInt8,
+            Int16,
+            UInt16,
+            Int32,
+            UInt32,
+            Float32,
+            Float64
+        };
+
+        // A property of an element. List properties have a count of type countType followed by that many items
+        // of type type
+        struct Property {
+            std::string name;
+            PropertyType type;
+            bool isList;
+            PropertyType countType;
+        };
+
+        // An element of the header and its properties in the order they appear in the data
+        struct Element {
+            std::string name;
+            unsigned count;
+            std::vector<Property> properties;
+
+            // Size of a row in binary files. Rows that contain lists vary in size and have a row size of 0
+            [[nodiscard]] size_t getRowSize() const;
+        };
+
         MeshPointer getOutput(MeshPointer = nullptr) override;
+        // Decodes binary data a block of rows at a time and parses ASCII data a piece of text at a time
+        MeshPointer readStream(std::istream&, MeshPointer = nullptr) override;
         bool isInputFileBinary() const { return isBinary; }
         bool isInputFileLittleEndian() const { return isLittleEndian; }
         unsigned getNumberOfVertices() const { return numVertices; }
         unsigned getNumberOfFaces() const { return numFaces; }
+        std::vector<Element> const& getElements() const { return elements; }
     private:
         explicit PLYReader(std::string fileName, IMeshFactory const&);
-        MeshPointer getOutput(std::istream& inputStream, MeshPointer&);
-        MeshPointer readBinary(std::istream& inputStream, MeshPointer&) const;
-        MeshPointer readASCII(std::istream&inputStream, MeshPointer&) const;
+        MeshPointer readBinary(std::span<char const> data, MeshPointer&);
+        template<bool swapBytes>
+        MeshPointer decodeBinary(std::span<char const> data, MeshPointer&);
+        MeshPointer readASCII(std::span<char const> data, MeshPointer&);
+        // Decode the data that follows the header into the positions of all vertices and the triangles of the
+        // faces
+        template<bool swapBytes>
+        void streamBinary(std::streambuf&, std::vector<float>& positions, std::vector<unsigned>& triangles);
+        void streamASCII(std::istream&, std::vector<float>& positions, std::vector<unsigned>& triangles);
+        // Hands over the vertices and triangles among the first numDecodedVertices and numDecodedTriangles that
+        // weren't handed over yet. Faces can refer to any vertex, so triangles wait until all vertices are decoded
+        void emitDecoded(std::span<float const> positions, std::span<unsigned const> triangles,
+                         size_t numDecodedVertices, size_t numDecodedTriangles);
+        // Reports progress through the data that follows the header as progress through the file
+        void reportDataProgress(size_t dataBytesRead, size_t dataSize, size_t elementsRead) const;
         void readHeader(std::istream& ifs);
-        void createMesh(MeshPointer&) const;
+        void createMesh(MeshPointer&, unsigned numTriangles) const;
 
     private:
         bool isBinary;
         bool isLittleEndian;
         unsigned numVertices;
         unsigned numFaces;
+        std::vector<Element> elements;
+        size_t headerSize{};
 
     // For testing
     friend class PLYReaderFixture;
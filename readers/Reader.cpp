@@ -0,0 +1,54 @@
+#include "Reader.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+using namespace std;
+
+namespace mv::readers {
+
+void Reader::reportProgress(size_t const bytesRead, size_t const totalBytes, size_t const elementsRead) const {
+    if (stopToken.stop_requested()) {
+        throw ReadCancelled("Reading " + fileName + " was stopped");
+    }
+    if (progressCallback) {
+        progressCallback({bytesRead, totalBytes, elementsRead});
+    }
+}
+
+void Reader::emitChunks(span<float const> const positions, span<unsigned const> const indices) {
+    if (!chunkChannel) return;
+    numEmittedVertices += positions.size() / 3;
+    numEmittedTriangles += indices.size() / 3;
+
+    // Vertices are handed over first, so that no chunk has triangles whose vertices haven't arrived. Chunks are only
+    // copied while the channel is open, since nothing takes them once it is closed
+    for (size_t first = 0; first < positions.size(); first += 3 * verticesPerMeshChunk) {
+        if (chunkChannel->isClosed()) return;
+        auto const chunk = positions.subspan(first, std::min(3 * verticesPerMeshChunk, positions.size() - first));
+        if (!chunkChannel->push({{chunk.begin(), chunk.end()}, {}})) return;
+    }
+    for (size_t first = 0; first < indices.size(); first += 3 * trianglesPerMeshChunk) {
+        if (chunkChannel->isClosed()) return;
+        auto const chunk = indices.subspan(first, std::min(3 * trianglesPerMeshChunk, indices.size() - first));
+        if (!chunkChannel->push({{}, {chunk.begin(), chunk.end()}})) return;
+    }
+}
+
+void Reader::emitTriangleSoup(char const* positions, size_t const stride, size_t const numTriangles) {
+    if (!chunkChannel) return;
+    for (size_t first = 0; first < numTriangles; first += trianglesPerMeshChunk) {
+        if (chunkChannel->isClosed()) return;
+        auto const count = std::min(trianglesPerMeshChunk, numTriangles - first);
+        MeshChunk chunk {vector<float>(9 * count), vector<unsigned>(3 * count)};
+        for (size_t i = 0; i < count; ++i) {
+            memcpy(chunk.positions.data() + 9 * i, positions + (first + i) * stride, 9 * sizeof(float));
+        }
+        iota(chunk.indices.begin(), chunk.indices.end(), static_cast<unsigned>(numEmittedVertices));
+        numEmittedVertices += 3 * count;
+        numEmittedTriangles += count;
+        if (!chunkChannel->push(std::move(chunk))) return;
+    }
+}
+
+}
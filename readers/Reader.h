@@ -1,11 +1,32 @@
 #pragma once
+#include <cstddef>
+#include <functional>
+#include <istream>
 #include <memory>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
 #include "MeshViewerObject.h"
+#include "MeshChunk.h"
 #include "MeshFactory.h"
 #include <utility>
 
 namespace mv::readers {
 
+// Thrown by readers that stop because a stop was requested through their stop token
+struct ReadCancelled : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// How far a read has got
+struct ReadProgress {
+    size_t bytesRead;
+    // Zero when the size of the input isn't known, e.g. for streams
+    size_t totalBytes;
+    // Elements of the file that have been read, e.g. the triangles of an STL file or the rows of a PLY file
+    size_t elementsRead;
+};
+
 class Reader : public MeshViewerObject {
 public:
     using MeshPointer = Mesh::MeshPointer;
@@ -13,11 +34,63 @@ public:
     : fileName(std::move(fileName))
     , meshFactory(meshFactory) {}
     virtual Mesh::MeshPointer getOutput(Mesh::MeshPointer = nullptr) = 0;
+    // Reads the file's contents from a stream that can only be read once from start to end, e.g. the decompressed
+    // contents of a compressed file. Readers of formats that can't be read this way throw
+    virtual Mesh::MeshPointer readStream(std::istream&, Mesh::MeshPointer = nullptr) {
+        throw std::runtime_error(fileName + " can't be read as a stream");
+    }
     virtual ~Reader() = default;
 
+    // Removes duplicate vertices from the meshes that are read when set. Readers of formats that
+    // don't duplicate vertices ignore this setting
+    void setCleanupOnImport(bool const cleanup) { cleanupOnImport = cleanup; }
+
+    // Makes the reader hand the geometry it has read to the channel in chunks while it reads the rest, so that the
+    // mesh can be drawn before it is complete. Readers of formats that are read at once hand over nothing. Closing
+    // the channel stops the hand over but not the reading
+    void setChunkChannel(std::shared_ptr<MeshChunkChannel> channel) { chunkChannel = std::move(channel); }
+
+    // The callback is called on the thread that reads after each piece of the file that is read. Readers of formats
+    // that are read at once don't call it
+    using ProgressCallback = std::function<void(ReadProgress const&)>;
+    void setProgressCallback(ProgressCallback callback) { progressCallback = std::move(callback); }
+
+    // Readers check the token between the pieces of the file they read and throw ReadCancelled once a stop is
+    // requested
+    void setStopToken(std::stop_token token) { stopToken = std::move(token); }
+
 protected:
+    [[nodiscard]] bool isEmittingChunks() const { return chunkChannel && !chunkChannel->isClosed(); }
+
+    // Files that are read while something watches the read are read in pieces
+    [[nodiscard]] bool isReadInPieces() const {
+        return isEmittingChunks() || progressCallback || stopToken.stop_possible();
+    }
+
+    // Called by readers after each piece they read. Throws ReadCancelled if a stop was requested
+    void reportProgress(size_t bytesRead, size_t totalBytes, size_t elementsRead) const;
+
+    // Hands vertices that follow the ones handed over before and triangles to the chunk channel. Triangles can
+    // refer to any of the vertices that were handed over, including these
+    void emitChunks(std::span<float const> positions, std::span<unsigned const> indices);
+
+    // Hands over triangles that don't share vertices. The 9 coordinates of each triangle's vertices start stride
+    // bytes after the ones of the triangle before it
+    void emitTriangleSoup(char const* positions, size_t stride, size_t numTriangles);
+
+    [[nodiscard]] size_t getNumberOfEmittedVertices() const { return numEmittedVertices; }
+    [[nodiscard]] size_t getNumberOfEmittedTriangles() const { return numEmittedTriangles; }
+
     std::string const fileName;
     IMeshFactory const& meshFactory;
+    bool cleanupOnImport = false;
+    std::shared_ptr<MeshChunkChannel> chunkChannel;
+    ProgressCallback progressCallback;
+    std::stop_token stopToken;
+
+private:
+    size_t numEmittedVertices = 0;
+    size_t numEmittedTriangles = 0;
 };
 
 }
@@ -1,13 +1,21 @@
 #include "ReaderFactory.h"
+#include "CachedReader.h"
+#include "CompressedReader.h"
+#include "DecompressingStream.h"
 #include "STLReader.h"
 #include "PLYReader.h"
+#include "OBJReader.h"
+#include "GLBReader.h"
+#include "MeshCacheReader.h"
 #include <filesystem>
 #include <memory>
 #include <algorithm>
 
 namespace mv::readers {
 
-    std::unordered_set<std::string> ReaderFactory::supportedExtensions {"stl", "ply"};
+    std::unordered_set<std::string> ReaderFactory::supportedExtensions {"stl", "ply", "obj", "glb", "mvmesh"};
+    // Formats whose readers can read compressed files while they are decompressed
+    std::unordered_set<std::string> ReaderFactory::streamableExtensions {"stl", "ply"};
 
     ReaderFactory::ReaderFactory(std::unique_ptr<IMeshFactory const>&& meshFactory)
     : meshFactory(std::move(meshFactory)) {
@@ -15,24 +23,32 @@ namespace mv::readers {
 
     bool ReaderFactory::isFileTypeSupported(std::filesystem::path const& file) const {
         if (std::filesystem::is_regular_file(file)) {
-            std::string lowerCaseExtension = file.extension();
+            // Compressed files are identified by the extension of the file that was compressed, e.g. .stl.gz
+            auto const compression = DecompressingStream::getCompression(file);
+            if (compression && !DecompressingStream::isSupported(*compression)) {
+                return false;
+            }
+            std::string lowerCaseExtension = compression ? file.stem().extension() : file.extension();
             for (auto &c: lowerCaseExtension) {
                 if (c >= 'A' && c <= 'Z') {
                     c += 'a' - 'A';
                 }
             }
             return !lowerCaseExtension.empty() &&
-                supportedExtensions.contains(lowerCaseExtension.substr(1));
+                (compression ? streamableExtensions : supportedExtensions).contains(lowerCaseExtension.substr(1));
         }
         return false;
     }
 
     ReaderPointer ReaderFactory::getReader(std::string const &fileName) const {
-        std::filesystem::path file = fileName;
+        // Compressed files are read by the reader of the format of the file that was compressed
+        auto const compression = DecompressingStream::getCompression(fileName);
+        auto const file = compression ? std::filesystem::path{fileName}.replace_extension()
+                                      : std::filesystem::path{fileName};
         if (!file.has_extension()) {
             throw std::runtime_error(fileName + " has no extension. Unable to find type");
         }
-        if (!std::filesystem::exists(file)) {
+        if (!std::filesystem::exists(fileName)) {
             throw std::runtime_error(fileName + " does not exist");
         }
 
@@ -52,10 +68,33 @@ namespace mv::readers {
                            file.extension().compare('.' + oppositeCaseExtension) == 0;
                 };
 
+        std::unique_ptr<Reader> reader;
         if (isExtension(file, "stl")) {
-            return std::unique_ptr<Reader>(new STLReader(fileName, getMeshFactory()));
+            reader.reset(new STLReader(fileName, getMeshFactory()));
         } else if (isExtension(file, "ply")) {
-            return std::unique_ptr<Reader>(new PLYReader(fileName, getMeshFactory()));
+            reader.reset(new PLYReader(fileName, getMeshFactory()));
+        } else if (isExtension(file, "obj")) {
+            reader.reset(new OBJReader(fileName, getMeshFactory()));
+        } else if (isExtension(file, "glb")) {
+            reader.reset(new GLBReader(fileName, getMeshFactory()));
+        } else if (isExtension(file, "mvmesh")) {
+            reader.reset(new MeshCacheReader(fileName, getMeshFactory()));
+        }
+        if (reader) {
+            reader->setCleanupOnImport(cleanupOnImport);
+            if (compression) {
+                if (!isExtension(file, "stl") && !isExtension(file, "ply")) {
+                    throw std::runtime_error("Unable to read " + fileName + ". Only STL and PLY files can be read "
+                                             "compressed");
+                }
+                reader.reset(new CompressedReader(fileName, getMeshFactory(), std::move(reader), *compression));
+            }
+            // Cached meshes are files of the cache's own format, which are opened as they are
+            if (derivedDataCache && !isExtension(file, "mvmesh")) {
+                reader.reset(new CachedReader(fileName, getMeshFactory(), std::move(reader), derivedDataCache));
+                reader->setCleanupOnImport(cleanupOnImport);
+            }
+            return reader;
         }
         throw std::runtime_error(fileName + " has no extension. Unable to find type");
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Reader.h"
+#include "DerivedDataCache.h"
 #include <filesystem>
 #include <unordered_set>
 #include <memory>
@@ -21,9 +22,17 @@ class ReaderFactory : public IReaderFactory, public MeshViewerObject {
         ReaderPointer getReader(std::string const &fileName) const override;
         IMeshFactory const& getMeshFactory() const override;
         bool isFileTypeSupported(std::filesystem::path const&) const override;
+        // Makes readers created by this factory remove duplicate vertices from the meshes they read
+        void setCleanupOnImport(bool const cleanup) { cleanupOnImport = cleanup; }
+        // Makes readers created by this factory keep the meshes they read in the cache and open files that were
+        // read before from the cache
+        void setDerivedDataCache(std::shared_ptr<DerivedDataCache const> cache) { derivedDataCache = std::move(cache); }
     private:
         std::unique_ptr<IMeshFactory const> meshFactory;
+        bool cleanupOnImport = false;
+        std::shared_ptr<DerivedDataCache const> derivedDataCache;
         static std::unordered_set<std::string> supportedExtensions;
+        static std::unordered_set<std::string> streamableExtensions;
 };
 
 }
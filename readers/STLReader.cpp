@@ -1,5 +1,15 @@
 #include "STLReader.h"
+#include "MappedFile.h"
 #include "MeshFactory.h"
+#include "Parallel.h"
+#include "TriangleWelder.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <string_view>
+#include <vector>
 using namespace std;
 using namespace mv;
 
@@ -7,6 +17,238 @@ namespace mv::readers {
 
 namespace {
     using MeshPointer = Reader::MeshPointer;
+
+    // Binary STL layout
+    // UINT8[80]    – Header                 - 80 bytes
+    // UINT32       – Number of triangles    -  4 bytes
+    // foreach triangle                      - 50 bytes:
+    //     REAL32[3] – Normal vector             - 12 bytes
+    //     REAL32[3] – Vertex 1                  - 12 bytes
+    //     REAL32[3] – Vertex 2                  - 12 bytes
+    //     REAL32[3] – Vertex 3                  - 12 bytes
+    //     UINT16    – Attribute byte count      -  2 bytes
+    // end
+    constexpr size_t headerSize = 80;
+    constexpr size_t triangleRecordsOffset = headerSize + 4;
+    constexpr size_t triangleRecordSize = 50;
+    constexpr size_t normalSize = 12;
+
+    // Number of triangle records the stream reader reads at a time
+    constexpr unsigned trianglesPerStreamRead = 65536;
+
+    // Decoding fewer triangles than this on a separate thread isn't worth the cost of starting it
+    constexpr size_t minimumTrianglesPerThread = 32768;
+
+    unsigned getNumberOfTriangles(span<char const> const fileData) {
+        unsigned numTris;
+        memcpy(&numTris, fileData.data() + headerSize, sizeof(numTris));
+        return numTris;
+    }
+
+    // Binary STLs are identified by their size since their headers can start with "solid" just like ASCII STLs
+    bool isBinary(span<char const> const fileData) {
+        if (fileData.size() < triangleRecordsOffset) {
+            return false;
+        }
+        if (triangleRecordsOffset + getNumberOfTriangles(fileData) * triangleRecordSize == fileData.size()) {
+            return true;
+        }
+        return string_view{fileData.data(), headerSize}.find("solid") == string_view::npos;
+    }
+
+    // Streams can't be measured, so binary files whose headers start with "solid" are told apart from ASCII files
+    // by their triangle count and header padding, which nearly always have bytes that aren't text
+    bool isText(string_view const data) {
+        return all_of(data.begin(), data.end(), [](char const c) {
+            return (c >= ' ' && c <= '~') || (c >= '\t' && c <= '\r');
+        });
+    }
+
+    // Decodes triangle records into a mesh. STL doesn't share vertices between triangles, so vertex 3i + j is
+    // vertex j of triangle i
+    void decodeTriangleRange(char const* records, unsigned const firstTriangle, unsigned const numTriangles,
+                         span<float> const positions, span<unsigned> const indices) {
+        auto* position = positions.data() + size_t{firstTriangle} * 9;
+        auto* index = indices.data() + size_t{firstTriangle} * 3;
+        auto vertexIndex = firstTriangle * 3;
+        for (unsigned i = 0; i < numTriangles; ++i, records += triangleRecordSize, position += 9) {
+            memcpy(position, records + normalSize, 9 * sizeof(float));
+            *index++ = vertexIndex++;
+            *index++ = vertexIndex++;
+            *index++ = vertexIndex++;
+        }
+    }
+
+    // Records are fixed size, so each thread decodes a contiguous range of them into the parts of the buffers
+    // that belong to those triangles
+    void decodeTriangles(char const* records, unsigned const firstTriangle, unsigned const numTriangles,
+                         span<float> const positions, span<unsigned> const indices) {
+        common::parallelFor(numTriangles, [&](size_t const begin, size_t const end) {
+            decodeTriangleRange(records + begin * triangleRecordSize, firstTriangle + static_cast<unsigned>(begin),
+                                static_cast<unsigned>(end - begin), positions, indices);
+        }, minimumTrianglesPerThread);
+    }
+
+    // Files that are read in pieces are decoded a few chunks of triangles at a time, so that the first ones can be
+    // drawn and the progress reported before the rest are decoded
+    template<typename ProcessWave>
+    void forEachWave(unsigned const numTriangles, bool const inWaves, ProcessWave const& processWave) {
+        auto const waveSize = inWaves ? static_cast<unsigned>(trianglesPerMeshChunk * common::getConcurrency())
+                                      : numTriangles;
+        for (unsigned firstTriangle = 0; firstTriangle < numTriangles; firstTriangle += waveSize) {
+            processWave(firstTriangle, std::min(waveSize, numTriangles - firstTriangle));
+        }
+    }
+
+    size_t countTriangles(vector<vector<float>> const& rangePositions) {
+        return transform_reduce(rangePositions.begin(), rangePositions.end(), size_t{}, plus<>{},
+                                [](vector<float> const& positions) { return positions.size() / 9; });
+    }
+
+    // Adds triangles one vertex and face at a time to meshes that don't expose their buffers
+    void addTriangles(char const* records, unsigned const firstTriangle, unsigned const numTriangles, Mesh& mesh) {
+        auto vertexIndex = firstTriangle * 3;
+        float vertices[9];
+        for (unsigned i = 0; i < numTriangles; ++i, records += triangleRecordSize) {
+            memcpy(vertices, records + normalSize, sizeof(vertices));
+            for (unsigned j = 0; j < 3; ++j) {
+                mesh.addVertex(vertices[3 * j], vertices[3 * j + 1], vertices[3 * j + 2]);
+            }
+            mesh.addFace({vertexIndex, vertexIndex + 1, vertexIndex + 2});
+            vertexIndex += 3;
+        }
+    }
+
+    // ASCII STL layout
+    // solid name
+    // foreach triangle
+    //     facet normal ni nj nk
+    //         outer loop
+    //             vertex v1x v1y v1z
+    //             vertex v2x v2y v2z
+    //             vertex v3x v3y v3z
+    //         endloop
+    //     endfacet
+    // end
+    // endsolid name
+    constexpr string_view endFacetKeyword = "endfacet";
+
+    // Splitting text smaller than this across threads isn't worth the cost of starting them
+    constexpr size_t minimumBytesPerThread = 1 << 20;
+
+    // Size of a facet as most exporters write it, which is used to guess the number of triangles of a text
+    constexpr size_t typicalBytesPerFacet = 256;
+
+    // Parses the vertex positions of the facets in a range of an ASCII STL. Tokens are views into the text, so
+    // nothing is allocated per line. Facet normals are ignored since they are recomputed from the vertices
+    class AsciiParser {
+        public:
+            AsciiParser(string_view const text, string const& fileName)
+                : m_next(text.data())
+                , m_end(text.data() + text.size())
+                , m_fileName(fileName) {
+            }
+
+            void parse(vector<float>& positions) {
+                unsigned verticesInFacet = 0;
+                for (auto token = getNextToken(); !token.empty(); token = getNextToken()) {
+                    if (token == "vertex") {
+                        for (unsigned i = 0; i < 3; ++i) {
+                            positions.push_back(getNextFloat());
+                        }
+                        ++verticesInFacet;
+                    } else if (token == endFacetKeyword) {
+                        if (verticesInFacet != 3) {
+                            throw std::runtime_error("Facet with " + std::to_string(verticesInFacet) +
+                                                     " vertices in file " + m_fileName +
+                                                     ". Only triangles are supported");
+                        }
+                        verticesInFacet = 0;
+                    } else if (token == "solid" || token == "endsolid") {
+                        // Names can contain keywords
+                        skipLine();
+                    }
+                }
+                if (verticesInFacet) {
+                    throw std::runtime_error("File " + m_fileName + " ends in the middle of a facet");
+                }
+            }
+
+        private:
+            static bool isSpace(char const c) {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+            }
+
+            void skipSpace() {
+                while (m_next != m_end && isSpace(*m_next)) ++m_next;
+            }
+
+            string_view getNextToken() {
+                skipSpace();
+                auto const* tokenBegin = m_next;
+                while (m_next != m_end && !isSpace(*m_next)) ++m_next;
+                return {tokenBegin, static_cast<size_t>(m_next - tokenBegin)};
+            }
+
+            float getNextFloat() {
+                skipSpace();
+                // from_chars doesn't accept a leading plus sign
+                if (m_next != m_end && *m_next == '+') ++m_next;
+                float value;
+                auto const [end, error] = from_chars(m_next, m_end, value);
+                if (error != errc{}) {
+                    throw std::runtime_error("Invalid vertex coordinate " + string{getNextToken()} + " in file " +
+                                             m_fileName);
+                }
+                m_next = end;
+                return value;
+            }
+
+            void skipLine() {
+                while (m_next != m_end && *m_next != '\n') ++m_next;
+            }
+
+            char const* m_next;
+            char const* const m_end;
+            string const& m_fileName;
+    };
+
+    // Splits the text into ranges that end right after an endfacet keyword, so that every facet is in one range
+    vector<string_view> splitAtFacets(string_view const text) {
+        auto const numRanges = common::getNumberOfRanges(text.size(), minimumBytesPerThread);
+        vector<string_view> ranges;
+        ranges.reserve(numRanges);
+        size_t rangeBegin = 0;
+        for (size_t i = 1; i <= numRanges && rangeBegin < text.size(); ++i) {
+            auto rangeEnd = text.size();
+            if (i < numRanges) {
+                auto const endFacet = text.find(endFacetKeyword, std::max(rangeBegin, i * text.size() / numRanges));
+                if (endFacet != string_view::npos) {
+                    rangeEnd = endFacet + endFacetKeyword.size();
+                }
+            }
+            ranges.push_back(text.substr(rangeBegin, rangeEnd - rangeBegin));
+            rangeBegin = rangeEnd;
+        }
+        return ranges;
+    }
+
+    // Splits the text into pieces of at least pieceSize bytes that end right after an endfacet keyword
+    vector<string_view> splitIntoPieces(string_view text, size_t const pieceSize) {
+        vector<string_view> pieces;
+        while (!text.empty()) {
+            auto pieceEnd = text.size();
+            if (pieceSize < text.size()) {
+                auto const endFacet = text.find(endFacetKeyword, pieceSize);
+                if (endFacet != string_view::npos) {
+                    pieceEnd = endFacet + endFacetKeyword.size();
+                }
+            }
+            pieces.push_back(text.substr(0, pieceEnd));
+            text.remove_prefix(pieceEnd);
+        }
+        return pieces;
+    }
 }
 
 STLReader::STLReader(std::string fn, IMeshFactory const& meshFactory)
@@ -14,67 +256,357 @@ STLReader::STLReader(std::string fn, IMeshFactory const& meshFactory)
 }
 
 MeshPointer STLReader::getOutput(MeshPointer mesh) {
-    // TODO: Turn on clean by default
-    bool clean = false;
-    ifstream ifs(fileName, ios::binary);
-    if (!ifs) {
-        throw std::runtime_error("Unable to open file " + fileName + '!');
+    MappedFile const file(fileName);
+    if (!file.isMapped()) {
+        ifstream ifs(fileName, ios::binary);
+        if (!ifs) {
+            throw std::runtime_error("Unable to open file " + fileName + '!');
+        }
+        return std::move(getOutput(ifs, mesh, cleanupOnImport));
+    }
+
+    if (isBinary(file.getData())) {
+        return std::move(readBinary(file.getData(), cleanupOnImport, mesh));
+    } else {
+        return std::move(readAscii(file.getData(), cleanupOnImport, mesh));
     }
-    return std::move(getOutput(ifs, mesh));
 }
 
 MeshPointer STLReader::getOutput(std::ifstream& ifs, MeshPointer& mesh, bool clean) {
     string header;
     header.resize(80);
     ifs.read(header.data(), 80);
+    header.resize(ifs.gcount());
+    if (header.find("solid") != string::npos) {
+        // Binary files can have headers that start with "solid" too, so the whole file is read to find out
+        // what it is
+        vector<char> fileData{header.begin(), header.end()};
+        fileData.insert(fileData.end(), istreambuf_iterator<char>(ifs), istreambuf_iterator<char>());
+        if (isBinary(fileData)) {
+            return std::move(readBinary(fileData, clean, mesh));
+        } else {
+            return std::move(readAscii(fileData, clean, mesh));
+        }
+    }
     if (!ifs) {
         throw std::runtime_error("Unable to read file" + fileName + '!');
     }
-    if(header.find("solid") == string::npos) {
-        return std::move(readBinary(ifs, clean, mesh));
-    } else {
-        throw std::runtime_error("ASCII STLs not supported!");
+    // Read 4 bytes following the 80 byte header
+    unsigned numTris;
+    if (!ifs.read(reinterpret_cast<char*>(&numTris), 4)) {
+        throw std::runtime_error("File " + fileName + " is truncated");
     }
+    return std::move(readBinary(ifs, numTris, clean, mesh));
 }
 
-MeshPointer STLReader::readBinary(ifstream& ifs, bool const clean, Mesh::MeshPointer& mesh) {
-    if (ifs.gcount() != 80) {
-        throw std::runtime_error("File stream in unexpected state");
+MeshPointer STLReader::readStream(std::istream& inputStream, MeshPointer mesh) {
+    char start[triangleRecordsOffset];
+    inputStream.read(start, triangleRecordsOffset);
+    string_view const startData {start, static_cast<size_t>(inputStream.gcount())};
+    if (startData.substr(0, headerSize).find("solid") != string_view::npos && isText(startData)) {
+        return std::move(readAscii(inputStream, startData, cleanupOnImport, mesh));
     }
-    // Read 4 bytes following the 80 byte header (read in the caller)
-    unsigned numTris;
-    ifs.read(reinterpret_cast<char*>(&numTris), 4);
+    if (startData.size() < triangleRecordsOffset) {
+        throw std::runtime_error("File " + fileName + " is truncated");
+    }
+    return std::move(readBinary(inputStream, getNumberOfTriangles(startData), cleanupOnImport, mesh));
+}
 
+void STLReader::createMesh(MeshPointer& mesh, unsigned const numVertices, unsigned const numFaces) const {
     // To allow a mock mesh to be injected into this object for unit testing
     if (!mesh) {
         mesh = meshFactory.createMesh();
     }
-    mesh->initialize(numTris*3, numTris);
+    mesh->initialize(numVertices, numFaces);
+}
+
+void STLReader::createWeldedMesh(TriangleWelder& welder, function<void(span<unsigned>)> const& writeIndices,
+                                 MeshPointer& mesh) const {
+    createMesh(mesh, welder.getNumberOfVertices(), welder.getNumberOfTriangles());
+    auto const positions = mesh->getPositionBuffer();
+    auto const indices = mesh->getIndexBuffer();
+    if (!positions.empty() && !indices.empty()) {
+        welder.getPositions(positions);
+        writeIndices(indices);
+        return;
+    }
+
+    vector<float> weldedPositions(3 * size_t{welder.getNumberOfVertices()});
+    vector<unsigned> weldedIndices(3 * size_t{welder.getNumberOfTriangles()});
+    welder.getPositions(weldedPositions);
+    writeIndices(weldedIndices);
+    for (size_t i = 0; i < weldedPositions.size(); i += 3) {
+        mesh->addVertex(weldedPositions[i], weldedPositions[i + 1], weldedPositions[i + 2]);
+    }
+    for (size_t i = 0; i < weldedIndices.size(); i += 3) {
+        mesh->addFace({weldedIndices[i], weldedIndices[i + 1], weldedIndices[i + 2]});
+    }
+}
 
-    // Read triangles
-    /* foreach triangle                      - 50 bytes:
-    REAL32[3] – Normal vector             - 12 bytes
-    REAL32[3] – Vertex 1                  - 12 bytes
-    REAL32[3] – Vertex 2                  - 12 bytes
-    REAL32[3] – Vertex 3                  - 12 bytes
-    UINT16    – Attribute byte count      -  2 bytes
-    end  */
+void STLReader::reportTriangles(size_t const numTrianglesRead, size_t const numTriangles) const {
+    reportProgress(triangleRecordsOffset + numTrianglesRead * triangleRecordSize,
+                   triangleRecordsOffset + numTriangles * triangleRecordSize, numTrianglesRead);
+}
+
+MeshPointer STLReader::readBinary(span<char const> const fileData, bool const clean, MeshPointer& mesh) {
+    auto const numTris = getNumberOfTriangles(fileData);
+    if (fileData.size() < triangleRecordsOffset + numTris * triangleRecordSize) {
+        throw std::runtime_error("File " + fileName + " is truncated. Expected " + std::to_string(numTris) +
+                                 " triangles");
+    }
+    auto const* records = fileData.data() + triangleRecordsOffset;
+    auto const inWaves = isReadInPieces();
 
-    unsigned vId = 0;
-    char buffer[50];
-    for (unsigned i = 0; i < numTris; ++i) {
-        ifs.read(buffer, 50);
-        for (char j = 0; j < 3; ++j) {
-            float* vertex = reinterpret_cast<float*>(buffer + 12 * (j+1));
-            mesh->addVertex(vertex[0], vertex[1], vertex[2]);
+    // Vertices are welded as they are decoded, so the mesh is only ever created with its welded size
+    if (clean) {
+        TriangleWelder welder(numTris);
+        forEachWave(numTris, inWaves, [&](unsigned const firstTriangle, unsigned const numTriangles) {
+            auto const* positions = records + size_t{firstTriangle} * triangleRecordSize + normalSize;
+            welder.addTriangles(positions, triangleRecordSize, numTriangles);
+            emitTriangleSoup(positions, triangleRecordSize, numTriangles);
+            reportTriangles(firstTriangle + numTriangles, numTris);
+        });
+        createWeldedMesh(welder, [&](span<unsigned> const indices) {
+            welder.getIndices(records + normalSize, triangleRecordSize, numTris, indices);
+        }, mesh);
+        return std::move(mesh);
+    }
+
+    // Positions are copied straight from the mapped file into the mesh
+    createMesh(mesh, 3 * numTris, numTris);
+    auto const positions = mesh->getPositionBuffer();
+    auto const indices = mesh->getIndexBuffer();
+    if (!positions.empty() && !indices.empty()) {
+        forEachWave(numTris, inWaves, [&](unsigned const firstTriangle, unsigned const numTriangles) {
+            auto const* wave = records + size_t{firstTriangle} * triangleRecordSize;
+            decodeTriangles(wave, firstTriangle, numTriangles, positions, indices);
+            emitTriangleSoup(wave + normalSize, triangleRecordSize, numTriangles);
+            reportTriangles(firstTriangle + numTriangles, numTris);
+        });
+    } else {
+        addTriangles(records, 0, numTris, *mesh);
+    }
+
+    return std::move(mesh);
+}
+
+MeshPointer STLReader::readBinary(istream& inputStream, unsigned const numTris, bool const clean,
+                                  Mesh::MeshPointer& mesh) {
+    // Triangles are read in blocks to keep the number of reads low
+    vector<char> buffer(std::min(numTris, trianglesPerStreamRead) * triangleRecordSize);
+    auto readBlocks = [&](auto const& processBlock) {
+        for (unsigned firstTriangle = 0; firstTriangle < numTris; firstTriangle += trianglesPerStreamRead) {
+            auto const numTriangles = std::min(numTris - firstTriangle, trianglesPerStreamRead);
+            inputStream.read(buffer.data(), static_cast<streamsize>(numTriangles * triangleRecordSize));
+            if (!inputStream) {
+                throw std::runtime_error("File " + fileName + " is truncated. Expected " + std::to_string(numTris) +
+                                         " triangles");
+            }
+            processBlock(firstTriangle, numTriangles);
         }
-        mesh->addFace({vId, vId + 1, vId + 2});
-        vId += 3;
+    };
+
+    // Welded meshes need the triangles twice, once to find the welded vertices and once to index them. Streams
+    // that can't be read again keep the positions of the triangles instead
+    if (clean) {
+        auto const recordsBegin = inputStream.tellg();
+        if (recordsBegin == -1) {
+            vector<vector<float>> soup;
+            readBlocks([&](unsigned const firstTriangle, unsigned const numTriangles) {
+                auto& positions = soup.emplace_back(9 * size_t{numTriangles});
+                for (unsigned i = 0; i < numTriangles; ++i) {
+                    memcpy(positions.data() + 9 * i, buffer.data() + i * triangleRecordSize + normalSize,
+                           9 * sizeof(float));
+                }
+                emitTriangleSoup(reinterpret_cast<char const*>(positions.data()), 9 * sizeof(float), numTriangles);
+                reportTriangles(firstTriangle + numTriangles, numTris);
+            });
+            return std::move(createSoupMesh(soup, clean, mesh));
+        }
+        TriangleWelder welder(numTris);
+        readBlocks([&](unsigned const firstTriangle, unsigned const numTriangles) {
+            welder.addTriangles(buffer.data() + normalSize, triangleRecordSize, numTriangles);
+            emitTriangleSoup(buffer.data() + normalSize, triangleRecordSize, numTriangles);
+            reportTriangles(firstTriangle + numTriangles, numTris);
+        });
+        createWeldedMesh(welder, [&](span<unsigned> const indices) {
+            inputStream.seekg(recordsBegin);
+            readBlocks([&](unsigned, unsigned const numTriangles) {
+                welder.getIndices(buffer.data() + normalSize, triangleRecordSize, numTriangles, indices);
+            });
+        }, mesh);
+        return std::move(mesh);
     }
-    ifs.close();
 
-    if (clean)
-        mesh->removeDuplicateVertices();
+    createMesh(mesh, 3 * numTris, numTris);
+    auto const positions = mesh->getPositionBuffer();
+    auto const indices = mesh->getIndexBuffer();
+    readBlocks([&](unsigned const firstTriangle, unsigned const numTriangles) {
+        if (!positions.empty() && !indices.empty()) {
+            decodeTriangles(buffer.data(), firstTriangle, numTriangles, positions, indices);
+        } else {
+            addTriangles(buffer.data(), firstTriangle, numTriangles, *mesh);
+        }
+        emitTriangleSoup(buffer.data() + normalSize, triangleRecordSize, numTriangles);
+        reportTriangles(firstTriangle + numTriangles, numTris);
+    });
+
+    return std::move(mesh);
+}
+
+void STLReader::parseRanges(span<string_view const> const ranges, span<vector<float>> const rangePositions) const {
+    // Ranges of the text are parsed concurrently into their own position lists
+    common::parallelFor(ranges.size(), [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            AsciiParser{ranges[i], fileName}.parse(rangePositions[i]);
+        }
+    }, 1);
+}
+
+void STLReader::parseAscii(string_view const text, vector<vector<float>>& rangePositions) {
+    auto const ranges = splitAtFacets(text);
+    auto const firstRange = rangePositions.size();
+    rangePositions.resize(firstRange + ranges.size());
+    parseRanges(ranges, span{rangePositions}.subspan(firstRange));
+    for (auto i = firstRange; i < rangePositions.size(); ++i) {
+        emitTriangleSoup(reinterpret_cast<char const*>(rangePositions[i].data()), 9 * sizeof(float),
+                         rangePositions[i].size() / 9);
+    }
+}
+
+MeshPointer STLReader::readAscii(span<char const> const fileData, bool const clean, MeshPointer& mesh) {
+    // Text that is read in pieces is parsed a piece at a time, which all threads parse at once
+    string_view const text {fileData.data(), fileData.size()};
+    auto const piecesAreBounded = clean || isReadInPieces();
+    auto const pieces = splitIntoPieces(text, piecesAreBounded ? minimumBytesPerThread * common::getConcurrency()
+                                                               : text.size());
+    if (clean) {
+        return std::move(readWeldedAscii(pieces, text.size(), mesh));
+    }
+
+    vector<vector<float>> rangePositions;
+    size_t bytesRead = 0;
+    for (auto const piece : pieces) {
+        parseAscii(piece, rangePositions);
+        bytesRead += piece.size();
+        reportProgress(bytesRead, text.size(), countTriangles(rangePositions));
+    }
+    return std::move(createSoupMesh(rangePositions, clean, mesh));
+}
+
+MeshPointer STLReader::readWeldedAscii(span<string_view const> const pieces, size_t const textSize,
+                                       MeshPointer& mesh) {
+    // Only the triangles of one piece are held at a time. They are added to the welder and released, and the
+    // pieces are parsed again to index the triangles, in the same ranges as the first time
+    vector<vector<string_view>> pieceRanges;
+    pieceRanges.reserve(pieces.size());
+    TriangleWelder welder(textSize / typicalBytesPerFacet);
+    size_t numTrianglesRead = 0;
+    size_t bytesRead = 0;
+    for (auto const piece : pieces) {
+        auto const& ranges = pieceRanges.emplace_back(splitAtFacets(piece));
+        vector<vector<float>> rangePositions(ranges.size());
+        parseRanges(ranges, rangePositions);
+        for (auto const& positions : rangePositions) {
+            auto const* triangles = reinterpret_cast<char const*>(positions.data());
+            auto const numTriangles = static_cast<unsigned>(positions.size() / 9);
+            welder.addTriangles(triangles, 9 * sizeof(float), numTriangles);
+            emitTriangleSoup(triangles, 9 * sizeof(float), numTriangles);
+            numTrianglesRead += numTriangles;
+        }
+        bytesRead += piece.size();
+        reportProgress(bytesRead, textSize, numTrianglesRead);
+    }
+    createWeldedMesh(welder, [&](span<unsigned> const indices) {
+        for (auto const& ranges : pieceRanges) {
+            vector<vector<float>> rangePositions(ranges.size());
+            parseRanges(ranges, rangePositions);
+            for (auto const& positions : rangePositions) {
+                welder.getIndices(reinterpret_cast<char const*>(positions.data()), 9 * sizeof(float),
+                                  static_cast<unsigned>(positions.size() / 9), indices);
+            }
+        }
+    }, mesh);
+    return std::move(mesh);
+}
+
+MeshPointer STLReader::readAscii(istream& inputStream, string_view const start, bool const clean,
+                                 MeshPointer& mesh) {
+    // Text is read in pieces that all threads can parse at once. Each piece is parsed up to its last endfacet
+    // keyword and the rest of it is carried over to the next piece. Streams can't be parsed again, so welded
+    // meshes hold all of the triangles until they are welded
+    auto const pieceSize = minimumBytesPerThread * common::getConcurrency();
+    string text {start};
+    size_t bytesRead = 0;
+    vector<vector<float>> rangePositions;
+    for (bool isLastPiece = false; !isLastPiece;) {
+        auto const carriedSize = text.size();
+        text.resize(carriedSize + pieceSize);
+        inputStream.read(text.data() + carriedSize, static_cast<streamsize>(pieceSize));
+        text.resize(carriedSize + static_cast<size_t>(inputStream.gcount()));
+        isLastPiece = text.size() < carriedSize + pieceSize;
+        auto parsedSize = text.size();
+        if (!isLastPiece) {
+            auto const endFacet = string_view{text}.rfind(endFacetKeyword);
+            parsedSize = endFacet == string_view::npos ? 0 : endFacet + endFacetKeyword.size();
+        }
+        parseAscii(string_view{text}.substr(0, parsedSize), rangePositions);
+        text.erase(0, parsedSize);
+        bytesRead += parsedSize;
+        reportProgress(bytesRead, 0, countTriangles(rangePositions));
+    }
+    return std::move(createSoupMesh(rangePositions, clean, mesh));
+}
+
+MeshPointer STLReader::createSoupMesh(vector<vector<float>>& rangePositions, bool const clean,
+                                      MeshPointer& mesh) const {
+    // The triangles of a range follow the triangles of all the ranges before it
+    vector<unsigned> firstTriangles(rangePositions.size() + 1);
+    transform_inclusive_scan(rangePositions.begin(), rangePositions.end(), firstTriangles.begin() + 1, plus<>{},
+                             [](vector<float> const& positions) { return static_cast<unsigned>(positions.size() / 9); });
+
+    if (clean) {
+        TriangleWelder welder(firstTriangles.back());
+        for (auto const& positions : rangePositions) {
+            welder.addTriangles(reinterpret_cast<char const*>(positions.data()), 9 * sizeof(float),
+                                static_cast<unsigned>(positions.size() / 9));
+        }
+        createWeldedMesh(welder, [&](span<unsigned> const indices) {
+            for (auto const& positions : rangePositions) {
+                welder.getIndices(reinterpret_cast<char const*>(positions.data()), 9 * sizeof(float),
+                                  static_cast<unsigned>(positions.size() / 9), indices);
+            }
+        }, mesh);
+        return std::move(mesh);
+    }
+
+    createMesh(mesh, 3 * firstTriangles.back(), firstTriangles.back());
+    auto const positions = mesh->getPositionBuffer();
+    auto const indices = mesh->getIndexBuffer();
+    if (!positions.empty() && !indices.empty()) {
+        common::parallelFor(rangePositions.size(), [&](size_t const begin, size_t const end) {
+            for (auto i = begin; i < end; ++i) {
+                auto const firstTriangle = firstTriangles[i];
+                std::copy(rangePositions[i].begin(), rangePositions[i].end(),
+                          positions.begin() + size_t{firstTriangle} * 9);
+                std::iota(indices.begin() + size_t{firstTriangle} * 3,
+                          indices.begin() + size_t{firstTriangle} * 3 + rangePositions[i].size() / 3,
+                          firstTriangle * 3);
+                // Release memory as soon as it is copied
+                vector<float>{}.swap(rangePositions[i]);
+            }
+        }, 1);
+    } else {
+        unsigned vertexIndex = 0;
+        for (auto const& rangePosition : rangePositions) {
+            for (size_t i = 0; i < rangePosition.size(); i += 9, vertexIndex += 3) {
+                for (size_t j = i; j < i + 9; j += 3) {
+                    mesh->addVertex(rangePosition[j], rangePosition[j + 1], rangePosition[j + 2]);
+                }
+                mesh->addFace({vertexIndex, vertexIndex + 1, vertexIndex + 2});
+            }
+        }
+    }
 
     return std::move(mesh);
 }
@@ -1,17 +1,49 @@
 #pragma once
+#include <functional>
+#include <istream>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 #include "Reader.h"
 
 namespace mv::readers {
 
+class TriangleWelder;
+
 class STLReader : public Reader {
     public:
+        // Reads the file from a memory mapping. Files that can't be mapped are read as streams
         MeshPointer getOutput(Mesh::MeshPointer = nullptr) override;
+        // Reads binary files a block of triangles at a time and ASCII files a piece of text at a time
+        MeshPointer readStream(std::istream&, Mesh::MeshPointer = nullptr) override;
     private:
         MeshPointer getOutput(std::ifstream&, Mesh::MeshPointer&, bool clean = false);
         explicit STLReader(std::string fileName, IMeshFactory const&);
-        MeshPointer readBinary(std::ifstream&, bool clean, Mesh::MeshPointer&);
+        MeshPointer readBinary(std::span<char const> fileData, bool clean, Mesh::MeshPointer&);
+        // Reads the triangle records that follow the header and triangle count
+        MeshPointer readBinary(std::istream&, unsigned numTris, bool clean, Mesh::MeshPointer&);
+        MeshPointer readAscii(std::span<char const> fileData, bool clean, Mesh::MeshPointer&);
+        // Reads the rest of a file that begins with start
+        MeshPointer readAscii(std::istream&, std::string_view start, bool clean, Mesh::MeshPointer&);
+        // Parses welded meshes from the pieces of a text of textSize bytes
+        MeshPointer readWeldedAscii(std::span<std::string_view const> pieces, size_t textSize, Mesh::MeshPointer&);
+        // Parses the facets of each range concurrently into the positions of 9 floats per triangle of the range
+        void parseRanges(std::span<std::string_view const> ranges,
+                         std::span<std::vector<float>> rangePositions) const;
+        // Appends the positions of the facets in the text to ranges of 9 floats per triangle and hands them over
+        void parseAscii(std::string_view text, std::vector<std::vector<float>>& rangePositions);
+        // Creates a mesh from triangles that don't share vertices. Ranges are released as they are copied
+        MeshPointer createSoupMesh(std::vector<std::vector<float>>& rangePositions, bool clean,
+                                   Mesh::MeshPointer&) const;
+        void createMesh(Mesh::MeshPointer&, unsigned numVertices, unsigned numFaces) const;
+        // Reports the progress of a binary file after its first numTrianglesRead triangles
+        void reportTriangles(size_t numTrianglesRead, size_t numTriangles) const;
+        // Creates a mesh from the welded vertices and triangles. writeIndices has to pass the triangles that
+        // were added to the welder to TriangleWelder::getIndices
+        void createWeldedMesh(TriangleWelder&, std::function<void(std::span<unsigned>)> const& writeIndices,
+                              Mesh::MeshPointer&) const;
 
     friend class STLReaderFixture;
     friend class ReaderFactory;
@@ -0,0 +1,240 @@
+#include "TriangleWelder.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace mv::readers {
+
+using namespace common;
+
+namespace {
+    // Shards are selected by the top bits of a key's hash
+    constexpr unsigned shardBits = 8;
+    constexpr unsigned numShards = 1u << shardBits;
+    constexpr unsigned minimumShardCapacity = 16;
+
+    // Marks unused slots
+    constexpr unsigned noVertex = numeric_limits<unsigned>::max();
+
+    // Work per thread below which thread startup costs more than it saves
+    constexpr size_t minimumTrianglesPerThread = 16384;
+}
+
+TriangleWelder::TriangleWelder(size_t const expectedNumTriangles)
+    : m_shards(new Shard[numShards])
+    , m_weldedPositions(nullptr)
+    , m_numTrianglesAdded(0)
+    , m_numTrianglesWritten(0)
+    , m_numTriangles(0)
+    , m_positionsWritten(false) {
+    // A closed triangle mesh has about half as many vertices as triangles. Tables grow when they are three
+    // quarters full, so they start with room for that many vertices at that load
+    auto const expectedNumVertices = expectedNumTriangles / 2 / numShards;
+    auto const capacity = std::bit_ceil(std::max<size_t>(4 * expectedNumVertices / 3 + 1, minimumShardCapacity));
+    for (unsigned i = 0; i < numShards; ++i) {
+        m_shards[i].slots.resize(capacity, noVertex);
+        m_shards[i].keys.reserve(expectedNumVertices);
+        m_shards[i].vertices.reserve(expectedNumVertices);
+    }
+}
+
+TriangleWelder::Key TriangleWelder::getKey(float const* position) {
+    Key key;
+    memcpy(key.data(), position, sizeof(key));
+    // Negative zero is equal to zero
+    for (auto& bits : key) {
+        if (bits == 0x80000000u) bits = 0;
+    }
+    return key;
+}
+
+uint64_t TriangleWelder::hashKey(Key const& key) {
+    auto hash = (key[0] | static_cast<uint64_t>(key[1]) << 32) * 0x9E3779B97F4A7C15ull ^
+                key[2] * 0xC2B2AE3D27D4EB4Full;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    return hash ^ hash >> 32;
+}
+
+bool TriangleWelder::isCollapsed(Key const (&keys)[3]) {
+    return keys[0] == keys[1] || keys[1] == keys[2] || keys[2] == keys[0];
+}
+
+void TriangleWelder::grow(Shard& shard) {
+    vector<unsigned> slots(shard.slots.size() * 2, noVertex);
+    auto const mask = slots.size() - 1;
+    for (unsigned i = 0; i < shard.keys.size(); ++i) {
+        auto slot = hashKey(shard.keys[i]) & mask;
+        while (slots[slot] != noVertex) slot = (slot + 1) & mask;
+        slots[slot] = i;
+    }
+    shard.slots = std::move(slots);
+}
+
+void TriangleWelder::insert(Key const& key, unsigned const vertex) {
+    auto const hash = hashKey(key);
+    auto& shard = m_shards[hash >> (64 - shardBits)];
+    lock_guard lock{shard.mutex};
+    if (4 * (shard.keys.size() + 1) > 3 * shard.slots.size()) {
+        grow(shard);
+    }
+    auto const mask = shard.slots.size() - 1;
+    for (auto slot = hash & mask;; slot = (slot + 1) & mask) {
+        auto const index = shard.slots[slot];
+        if (index == noVertex) {
+            shard.slots[slot] = static_cast<unsigned>(shard.keys.size());
+            shard.keys.push_back(key);
+            shard.vertices.push_back(vertex);
+            return;
+        }
+        if (shard.keys[index] == key) {
+            // Threads add vertices out of order, so the first vertex is the lowest numbered one
+            shard.vertices[index] = std::min(shard.vertices[index], vertex);
+            return;
+        }
+    }
+}
+
+unsigned TriangleWelder::find(Key const& key) const {
+    // Keys of the shards are released by then, so slots are compared with the welded positions
+    auto const hash = hashKey(key);
+    auto const& shard = m_shards[hash >> (64 - shardBits)];
+    auto const mask = shard.slots.size() - 1;
+    for (auto slot = hash & mask;; slot = (slot + 1) & mask) {
+        auto const index = shard.slots[slot];
+        if (index == noVertex) {
+            throw std::runtime_error("Triangles passed to the welder are not the ones that were added");
+        }
+        auto const vertex = shard.vertices[index];
+        if (getKey(m_weldedPositions + 3 * size_t{vertex}) == key) {
+            return vertex;
+        }
+    }
+}
+
+void TriangleWelder::addTriangles(char const* triangles, size_t const stride, unsigned const numTriangles) {
+    if (m_positionsWritten) {
+        throw std::runtime_error("Triangles cannot be added after welded positions are written");
+    }
+    vector<unsigned> numValidTriangles(getNumberOfRanges(numTriangles, minimumTrianglesPerThread));
+    parallelFor(numTriangles, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+        float positions[9];
+        Key keys[3];
+        for (auto i = begin; i < end; ++i) {
+            memcpy(positions, triangles + i * stride, sizeof(positions));
+            auto const firstVertex = 3 * (m_numTrianglesAdded + static_cast<unsigned>(i));
+            for (unsigned j = 0; j < 3; ++j) {
+                keys[j] = getKey(positions + 3 * j);
+                insert(keys[j], firstVertex + j);
+            }
+            numValidTriangles[rangeIndex] += isCollapsed(keys) ? 0 : 1;
+        }
+    }, minimumTrianglesPerThread);
+    for (auto const count : numValidTriangles) {
+        m_numTriangles += count;
+    }
+    m_numTrianglesAdded += numTriangles;
+}
+
+unsigned TriangleWelder::getNumberOfVertices() const {
+    unsigned numVertices = 0;
+    for (unsigned i = 0; i < numShards; ++i) {
+        numVertices += static_cast<unsigned>(m_shards[i].vertices.size());
+    }
+    return numVertices;
+}
+
+void TriangleWelder::getPositions(span<float> const positions) {
+    auto const numVertices = getNumberOfVertices();
+    if (positions.size() < 3 * size_t{numVertices}) {
+        throw std::runtime_error("Position buffer is too small for " + std::to_string(numVertices) + " vertices");
+    }
+    if (m_positionsWritten) {
+        throw std::runtime_error("Welded positions can only be written once");
+    }
+    m_positionsWritten = true;
+
+    // Welded vertices are numbered in the order of the triangle vertices they first appear as. Marking those
+    // triangle vertices in a bitmask and counting the marks before each one gives the numbers
+    auto const minimumShardsPerThread = numVertices < minimumTrianglesPerThread ? numShards : 1;
+    vector<uint64_t> firstVertexMask((3 * size_t{m_numTrianglesAdded} + 63) / 64);
+    parallelFor(numShards, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            for (auto const vertex : m_shards[i].vertices) {
+                atomic_ref<uint64_t>(firstVertexMask[vertex / 64])
+                    .fetch_or(uint64_t{1} << (vertex % 64), memory_order_relaxed);
+            }
+        }
+    }, minimumShardsPerThread);
+    vector<unsigned> marksBefore(firstVertexMask.size());
+    for (size_t i = 1; i < firstVertexMask.size(); ++i) {
+        marksBefore[i] = marksBefore[i - 1] + static_cast<unsigned>(popcount(firstVertexMask[i - 1]));
+    }
+
+    parallelFor(numShards, [&](size_t const begin, size_t const end) {
+        for (auto i = begin; i < end; ++i) {
+            auto& shard = m_shards[i];
+            for (size_t j = 0; j < shard.vertices.size(); ++j) {
+                auto& vertex = shard.vertices[j];
+                auto const word = vertex / 64;
+                auto const lowerBits = (uint64_t{1} << (vertex % 64)) - 1;
+                vertex = marksBefore[word] + static_cast<unsigned>(popcount(firstVertexMask[word] & lowerBits));
+                memcpy(positions.data() + 3 * size_t{vertex}, shard.keys[j].data(), sizeof(Key));
+            }
+            shard.keys = {};
+        }
+    }, minimumShardsPerThread);
+    m_weldedPositions = positions.data();
+}
+
+void TriangleWelder::getIndices(char const* triangles, size_t const stride, unsigned const numTriangles,
+                                span<unsigned> const indices) {
+    if (!m_positionsWritten) {
+        throw std::runtime_error("Welded positions have to be written before indices");
+    }
+
+    // Triangles that don't collapse are counted first to find where each range's indices go
+    auto getKeys = [&](size_t const triangle, Key (&keys)[3]) {
+        float positions[9];
+        memcpy(positions, triangles + triangle * stride, sizeof(positions));
+        for (unsigned j = 0; j < 3; ++j) {
+            keys[j] = getKey(positions + 3 * j);
+        }
+    };
+    vector<unsigned> offsets(getNumberOfRanges(numTriangles, minimumTrianglesPerThread) + 1);
+    parallelFor(numTriangles, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+        Key keys[3];
+        for (auto i = begin; i < end; ++i) {
+            getKeys(i, keys);
+            offsets[rangeIndex + 1] += isCollapsed(keys) ? 0 : 1;
+        }
+    }, minimumTrianglesPerThread);
+    for (size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+    if (indices.size() < 3 * (size_t{m_numTrianglesWritten} + offsets.back())) {
+        throw std::runtime_error("Index buffer is too small for " +
+                                 std::to_string(m_numTrianglesWritten + offsets.back()) + " triangles");
+    }
+
+    parallelFor(numTriangles, [&](size_t const begin, size_t const end, size_t const rangeIndex) {
+        auto* triangleIndices = indices.data() + 3 * (size_t{m_numTrianglesWritten} + offsets[rangeIndex]);
+        Key keys[3];
+        for (auto i = begin; i < end; ++i) {
+            getKeys(i, keys);
+            if (isCollapsed(keys)) continue;
+            for (auto const& key : keys) {
+                *triangleIndices++ = find(key);
+            }
+        }
+    }, minimumTrianglesPerThread);
+    m_numTrianglesWritten += offsets.back();
+}
+
+}
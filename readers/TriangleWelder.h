@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace mv::readers {
+
+    // Welds the vertices of a triangle soup while it is read, so that a mesh with shared vertices can be created
+    // without first creating one with three vertices per triangle. Memory used is proportional to the number of
+    // welded vertices and not to the number of triangles
+    //
+    // Vertices are welded when their coordinates are exactly equal. Each distinct vertex is appended once to the
+    // positions of one of many shards with their own locks, so that threads adding triangles rarely wait for each
+    // other. A shard's hash table holds only the indices of its positions. Welded vertices are numbered in the
+    // order in which they first appear in the soup, which makes the result independent of the number of threads.
+    // Triangles that collapse because two of their vertices are welded are dropped
+    class TriangleWelder {
+    public:
+        // Capacity is reserved for the number of vertices a closed mesh with the specified number of triangles has
+        explicit TriangleWelder(size_t expectedNumTriangles = 0);
+
+        // Adds triangles to the soup. Vertex coordinates of a triangle are 9 consecutive floats, which need not
+        // be aligned, and triangles start stride bytes apart. Triangles are numbered in the order they are added
+        void addTriangles(char const* triangles, size_t stride, unsigned numTriangles);
+
+        // Number of welded vertices
+        [[nodiscard]] unsigned getNumberOfVertices() const;
+
+        // Number of triangles that don't collapse
+        [[nodiscard]] unsigned getNumberOfTriangles() const { return m_numTriangles; }
+
+        // Writes the x,y,z coordinates of the welded vertices. No triangles can be added after this. Indices are
+        // found by comparing with the written positions, so they have to stay unchanged until indices are written
+        void getPositions(std::span<float> positions);
+
+        // Writes the vertex indices of the triangles that don't collapse. The soup has to be passed in again, in
+        // the same pieces and order it was added in, after the positions are written. Indices of each piece
+        // follow the indices of the piece before it
+        void getIndices(char const* triangles, size_t stride, unsigned numTriangles, std::span<unsigned> indices);
+
+    private:
+        using Key = std::array<uint32_t, 3>;
+
+        struct alignas(64) Shard {
+            std::mutex mutex;
+            // Open addressing table with linear probing that holds indices of the shard's vertices. Capacity is a
+            // power of two
+            std::vector<unsigned> slots;
+            // Positions of the shard's vertices in the order they were first added. They are released once the
+            // welded positions are written
+            std::vector<Key> keys;
+            // Index of the first triangle vertex of each of the shard's vertices until positions are written and
+            // the index of the welded vertex afterwards
+            std::vector<unsigned> vertices;
+        };
+
+        static Key getKey(float const* position);
+        static uint64_t hashKey(Key const&);
+        static bool isCollapsed(Key const (&keys)[3]);
+
+        void insert(Key const&, unsigned vertex);
+        [[nodiscard]] unsigned find(Key const&) const;
+        static void grow(Shard&);
+
+        std::unique_ptr<Shard[]> m_shards;
+        float const* m_weldedPositions;
+        unsigned m_numTrianglesAdded;
+        unsigned m_numTrianglesWritten;
+        unsigned m_numTriangles;
+        bool m_positionsWritten;
+    };
+
+}
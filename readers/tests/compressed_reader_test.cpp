@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "ReaderFixture.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#ifdef HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+using namespace std;
+using namespace mv;
+using namespace mv::readers;
+using namespace testing;
+namespace fs = std::filesystem;
+
+namespace {
+
+    string readFile(fs::path const& file) {
+        ifstream ifs(file, ios::binary);
+        return {istreambuf_iterator<char>(ifs), istreambuf_iterator<char>()};
+    }
+
+    void writeFile(fs::path const& file, string_view const contents) {
+        ofstream{file, ios::binary}.write(contents.data(), static_cast<streamsize>(contents.size()));
+    }
+
+#ifdef HAS_ZLIB
+    // Compresses the data as gzip members of up to memberSize bytes of the data each
+    string gzip(string_view data, size_t const memberSize = string_view::npos) {
+        string compressed;
+        do {
+            auto const member = data.substr(0, memberSize);
+            data.remove_prefix(member.size());
+            z_stream stream{};
+            deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+            auto const offset = compressed.size();
+            compressed.resize(offset + deflateBound(&stream, member.size()));
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(member.data()));
+            stream.avail_in = static_cast<uInt>(member.size());
+            stream.next_out = reinterpret_cast<Bytef*>(compressed.data() + offset);
+            stream.avail_out = static_cast<uInt>(compressed.size() - offset);
+            deflate(&stream, Z_FINISH);
+            compressed.resize(offset + stream.total_out);
+            deflateEnd(&stream);
+        } while (!data.empty());
+        return compressed;
+    }
+#endif
+
+#ifdef HAS_ZSTD
+    string zstd(string_view const data) {
+        string compressed(ZSTD_compressBound(data.size()), '\0');
+        compressed.resize(ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), 3));
+        return compressed;
+    }
+#endif
+
+}
+
+class CompressedReaderFixture : public ReaderFixture {
+    protected:
+        // Checks that compressed copies of files are read like the files
+        void testCompressedFiles(vector<fs::path> const& files, string_view const extension,
+                                 string (*compress)(string_view)) const {
+            for (auto const& file : files) {
+                auto const compressedFile = m_directory / (file.filename().string() + string{extension});
+                writeFile(compressedFile, compress(readFile(file)));
+                ASSERT_TRUE(ReaderFactory{}.isFileTypeSupported(compressedFile)) << compressedFile;
+                for (bool const clean : {false, true}) {
+                    auto const geometry = read(file, clean);
+                    ASSERT_FALSE(geometry.indices.empty());
+                    ASSERT_EQ(geometry, read(compressedFile, clean)) << compressedFile << (clean ? " cleaned" : "");
+                }
+            }
+        }
+};
+
+#ifdef HAS_ZLIB
+
+TEST_F(CompressedReaderFixture, Gzip) {
+    testCompressedFiles({m_modelsDir / "cube.stl", m_modelsDir / "cube_ascii.stl", m_modelsDir / "cube.ply",
+                         m_modelsDir / "Armadillo.ply", m_modelsDir / "suzanne_subdivided.stl"},
+                        ".gz", [](string_view const data) { return gzip(data); });
+    testCompressedFiles(writeAsciiFiles(), ".GZ", [](string_view const data) { return gzip(data); });
+}
+
+TEST_F(CompressedReaderFixture, ConcatenatedGzipMembers) {
+    auto const file = m_modelsDir / "Armadillo.ply";
+    auto const compressedFile = m_directory / "Armadillo.ply.gz";
+    writeFile(compressedFile, gzip(readFile(file), 100'000));
+    ASSERT_EQ(read(file), read(compressedFile));
+}
+
+TEST_F(CompressedReaderFixture, InvalidFiles) {
+    auto const contents = readFile(m_modelsDir / "Armadillo.ply");
+    auto const compressed = gzip(contents);
+    auto const compressedFile = m_directory / "Armadillo.ply.gz";
+    writeFile(compressedFile, string_view{compressed}.substr(0, compressed.size() / 2));
+    ASSERT_THROW(read(compressedFile), std::runtime_error);
+    writeFile(compressedFile, contents);
+    ASSERT_THROW(read(compressedFile), std::runtime_error);
+
+    // Stops decompressing files whose readers fail before they are done
+    writeFile(compressedFile, gzip(string_view{contents}.substr(0, contents.size() / 2)));
+    ASSERT_THROW(read(compressedFile), std::runtime_error);
+
+    // Only formats that can be read as streams can be read compressed
+    auto const objFile = m_directory / "cube.obj.gz";
+    writeFile(objFile, gzip(readFile(m_modelsDir / "cube.obj")));
+    ASSERT_FALSE(ReaderFactory{}.isFileTypeSupported(objFile));
+    ASSERT_THROW(ReaderFactory{}.getReader(objFile.string()), std::runtime_error);
+}
+
+#endif
+
+#ifdef HAS_ZSTD
+
+TEST_F(CompressedReaderFixture, Zstd) {
+    testCompressedFiles({m_modelsDir / "cube.stl", m_modelsDir / "cube_ascii.stl", m_modelsDir / "cube.ply",
+                         m_modelsDir / "Armadillo.ply", m_modelsDir / "suzanne_subdivided.stl"},
+                        ".zst", [](string_view const data) { return zstd(data); });
+    testCompressedFiles(writeAsciiFiles(), ".zst", [](string_view const data) { return zstd(data); });
+
+    auto const compressed = zstd(readFile(m_modelsDir / "cube.stl"));
+    auto const compressedFile = m_directory / "cube.stl.zst";
+    writeFile(compressedFile, string_view{compressed}.substr(0, compressed.size() - 1));
+    ASSERT_THROW(read(compressedFile), std::runtime_error);
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+#include "DerivedDataCache.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace mv::readers;
+namespace fs = std::filesystem;
+
+class DerivedDataCacheFixture : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            m_directory = fs::temp_directory_path() / "derivedDataCacheTest";
+            fs::remove_all(m_directory);
+        }
+
+        void TearDown() override {
+            fs::remove_all(m_directory);
+        }
+
+        static void write(fs::path const& path, size_t const size) {
+            ofstream{path, ios::binary} << string(size, 'x');
+        }
+
+        fs::path m_directory;
+};
+
+TEST_F(DerivedDataCacheFixture, Keys) {
+    string const data(10'000'000, 'a');
+    auto const key = DerivedDataCache::getKey(data, "stl");
+    ASSERT_EQ(key.size(), 16);
+    ASSERT_EQ(key, DerivedDataCache::getKey(data, "stl"));
+    ASSERT_NE(key, DerivedDataCache::getKey(data, "stl cleanup"));
+    auto modified = data;
+    modified[9'999'999] = 'b';
+    ASSERT_NE(key, DerivedDataCache::getKey(modified, "stl"));
+    ASSERT_NE(key, DerivedDataCache::getKey({data.data(), data.size() - 1}, "stl"));
+    ASSERT_NE(DerivedDataCache::getKey({}, ""), DerivedDataCache::getKey({}, "stl"));
+}
+
+TEST_F(DerivedDataCacheFixture, StoreAndFind) {
+    DerivedDataCache const cache(m_directory, 1 << 20);
+    ASSERT_FALSE(cache.find("a", "bin"));
+    ASSERT_TRUE(cache.store("a", "bin", [](fs::path const& path) { write(path, 10); }));
+    auto const entry = cache.find("a", "bin");
+    ASSERT_TRUE(entry);
+    ASSERT_EQ(fs::file_size(*entry), 10);
+    ASSERT_FALSE(cache.find("a", "txt"));
+
+    // Entries are replaced as a whole and failed writes leave no trace
+    ASSERT_TRUE(cache.store("a", "bin", [](fs::path const& path) { write(path, 20); }));
+    ASSERT_EQ(fs::file_size(*entry), 20);
+    ASSERT_FALSE(cache.store("a", "bin", [](fs::path const& path) {
+        write(path, 30);
+        throw std::runtime_error("Write failed");
+    }));
+    ASSERT_EQ(fs::file_size(*entry), 20);
+    ASSERT_EQ(distance(fs::directory_iterator(m_directory), fs::directory_iterator()), 1);
+}
+
+TEST_F(DerivedDataCacheFixture, LeastRecentlyUsedEntriesAreEvicted) {
+    DerivedDataCache const cache(m_directory, 3000);
+    for (auto const* key : {"a", "b", "c"}) {
+        ASSERT_TRUE(cache.store(key, "bin", [](fs::path const& path) { write(path, 1000); }));
+    }
+    // Makes the order of use independent of the file system's time resolution
+    auto const now = fs::file_time_type::clock::now();
+    fs::last_write_time(m_directory / "a.bin", now - chrono::minutes(2));
+    fs::last_write_time(m_directory / "b.bin", now - chrono::minutes(3));
+    fs::last_write_time(m_directory / "c.bin", now - chrono::minutes(1));
+    ASSERT_TRUE(cache.find("b", "bin"));
+
+    ASSERT_TRUE(cache.store("d", "bin", [](fs::path const& path) { write(path, 1000); }));
+    ASSERT_FALSE(cache.find("a", "bin"));
+    for (auto const* key : {"b", "c", "d"}) {
+        ASSERT_TRUE(cache.find(key, "bin")) << key;
+    }
+
+    // Entries larger than the cache are kept until the next entry is stored
+    ASSERT_TRUE(cache.store("e", "bin", [](fs::path const& path) { write(path, 5000); }));
+    ASSERT_TRUE(cache.find("e", "bin"));
+    ASSERT_EQ(distance(fs::directory_iterator(m_directory), fs::directory_iterator()), 1);
+}
+
+TEST_F(DerivedDataCacheFixture, StoreInBackground) {
+    DerivedDataCache const cache(m_directory, 1 << 20);
+    for (auto const* key : {"a", "b"}) {
+        cache.storeInBackground(key, "bin", [](fs::path const& path) { write(path, 10); });
+    }
+    // Failed writes leave no trace
+    cache.storeInBackground("c", "bin", [](fs::path const& path) {
+        write(path, 10);
+        throw std::runtime_error("Write failed");
+    });
+    cache.waitForBackgroundStores();
+    ASSERT_TRUE(cache.find("a", "bin"));
+    ASSERT_TRUE(cache.find("b", "bin"));
+    ASSERT_FALSE(cache.find("c", "bin"));
+    ASSERT_EQ(distance(fs::directory_iterator(m_directory), fs::directory_iterator()), 2);
+}
+
+TEST_F(DerivedDataCacheFixture, FileKeys) {
+    fs::create_directories(m_directory);
+    auto const file = m_directory / "input";
+    write(file, 10);
+    auto const key = DerivedDataCache::getFileKey(file, "stl");
+    ASSERT_TRUE(key);
+    ASSERT_EQ(key, DerivedDataCache::getFileKey(file, "stl"));
+    ASSERT_NE(key, DerivedDataCache::getFileKey(file, "stl cleanup"));
+    // Keys of the status differ from keys of the contents
+    ASSERT_NE(key, DerivedDataCache::getKey(string(10, 'x'), "stl"));
+    // Files that are touched or change size get new keys
+    fs::last_write_time(file, fs::last_write_time(file) + chrono::minutes(1));
+    auto const touchedKey = DerivedDataCache::getFileKey(file, "stl");
+    ASSERT_NE(key, touchedKey);
+    auto const lastWriteTime = fs::last_write_time(file);
+    write(file, 11);
+    fs::last_write_time(file, lastWriteTime);
+    ASSERT_NE(touchedKey, DerivedDataCache::getFileKey(file, "stl"));
+    // Only regular files have keys
+    ASSERT_FALSE(DerivedDataCache::getFileKey(m_directory, "stl"));
+    ASSERT_FALSE(DerivedDataCache::getFileKey(m_directory / "missing", "stl"));
+}
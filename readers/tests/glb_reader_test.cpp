@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+#include "GLBReader.h"
+#include "MockMeshFactory.h"
+#include "MockBufferedMesh.h"
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace mv;
+using namespace mv::common;
+using namespace mv::readers;
+using namespace testing;
+
+namespace mv::readers {
+
+    class GLBReaderFixture : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            auto *pData = getenv("modelsDir");
+            if (!pData) throw std::runtime_error("modelsDir environment variable not set");
+            m_modelsDir = pData;
+        }
+
+        template<typename T>
+        static void append(std::string& data, T const value) {
+            char bytes[sizeof(T)];
+            memcpy(bytes, &value, sizeof(T));
+            data.append(bytes, sizeof(T));
+        }
+
+        // Packs a JSON description and a binary buffer into a GLB container
+        static std::string createGLB(std::string json, std::string binary) {
+            while (json.size() % 4) json += ' ';
+            while (binary.size() % 4) binary += '\0';
+            std::string data;
+            append<uint32_t>(data, 0x46546C67);
+            append<uint32_t>(data, 2);
+            append<uint32_t>(data, static_cast<uint32_t>(28 + json.size() + binary.size()));
+            append<uint32_t>(data, static_cast<uint32_t>(json.size()));
+            append<uint32_t>(data, 0x4E4F534A);
+            data += json;
+            append<uint32_t>(data, static_cast<uint32_t>(binary.size()));
+            append<uint32_t>(data, 0x004E4942);
+            return data + binary;
+        }
+
+        // Reads the data into a mesh that exposes its buffers
+        MockBufferedMesh& readData(std::string const& data, Mesh::MeshPointer& mesh) {
+            mesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+            auto& bufferedMesh = dynamic_cast<MockBufferedMesh&>(*mesh);
+            readStream(data, mesh);
+            return bufferedMesh;
+        }
+
+        void readStream(std::string const& data, Mesh::MeshPointer& mesh) {
+            istringstream stream(data);
+            mesh = glbReader.getOutput(stream, mesh);
+        }
+
+        std::unique_ptr<GLBReader> createReader(std::string const& fileName) {
+            return std::unique_ptr<GLBReader>{new GLBReader{fileName, mockMeshFactory}};
+        }
+
+        filesystem::path m_modelsDir;
+        MockMeshFactory mockMeshFactory;
+        GLBReader glbReader {"", mockMeshFactory};
+    };
+
+    TEST_F(GLBReaderFixture, ReadFile) {
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto& mesh = *bufferedMesh;
+        EXPECT_CALL(mesh, initialize(24, 12)).Times(Exactly(1));
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(m_modelsDir / "cube.glb")->getOutput(std::move(meshPointer));
+        ASSERT_EQ((std::vector<float>{mesh.positions.begin(), mesh.positions.begin() + 6}),
+                  (std::vector<float>{1, -1, -1, 1, 1, -1}));
+        ASSERT_EQ((std::vector<unsigned>{mesh.indices.begin(), mesh.indices.begin() + 9}),
+                  (std::vector<unsigned>{0, 1, 2, 0, 2, 3, 4, 5, 6}));
+        // Normals of the file are used
+        ASSERT_EQ(mesh.normals.size(), 24 * 3);
+        ASSERT_EQ((std::vector<float>{mesh.normals.begin(), mesh.normals.begin() + 6}),
+                  (std::vector<float>{1, 0, 0, 1, 0, 0}));
+    }
+
+    TEST_F(GLBReaderFixture, NodeTransforms) {
+        // A triangle without indices whose positions and normals are interleaved. It is instanced by a translated
+        // node, a node that is rotated by 90 degrees around z and the mirrored child of the translated node
+        std::string binary;
+        for (float const value : {0.f, 0.f, 0.f, 0.f, 0.f, 1.f,
+                                  1.f, 0.f, 0.f, 0.f, 0.f, 1.f,
+                                  0.f, 1.f, 0.f, 0.f, 0.f, 1.f}) {
+            append(binary, value);
+        }
+        auto const json = R"({
+            "scene": 0,
+            "scenes": [{"nodes": [0, 1]}],
+            "nodes": [
+                {"mesh": 0, "translation": [10, 0, 0], "children": [2]},
+                {"mesh": 0, "rotation": [0, 0, 0.70710678, 0.70710678]},
+                {"mesh": 0, "matrix": [-1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1]}
+            ],
+            "meshes": [{"primitives": [{"attributes": {"POSITION": 0, "NORMAL": 1}}]}],
+            "accessors": [
+                {"bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3"},
+                {"bufferView": 0, "byteOffset": 12, "componentType": 5126, "count": 3, "type": "VEC3"}
+            ],
+            "bufferViews": [{"buffer": 0, "byteLength": 72, "byteStride": 24}],
+            "buffers": [{"byteLength": 72}]
+        })";
+        Mesh::MeshPointer mesh;
+        auto const& bufferedMesh = readData(createGLB(json, binary), mesh);
+        std::vector<float> const expectedPositions {10, 0, 0, 11, 0, 0, 10, 1, 0,
+                                                    10, 0, 0, 9, 0, 0, 10, 1, 0,
+                                                    0, 0, 0, 0, 1, 0, -1, 0, 0};
+        ASSERT_EQ(bufferedMesh.positions.size(), expectedPositions.size());
+        for (size_t i = 0; i < expectedPositions.size(); ++i) {
+            ASSERT_NEAR(bufferedMesh.positions[i], expectedPositions[i], 1e-6) << "Position " << i / 3;
+        }
+        // The mirrored triangle's winding is reversed to keep it facing the same way
+        ASSERT_EQ(bufferedMesh.indices, (std::vector<unsigned>{0, 1, 2, 3, 5, 4, 6, 7, 8}));
+        for (size_t i = 0; i < bufferedMesh.normals.size(); i += 3) {
+            ASSERT_NEAR(bufferedMesh.normals[i + 2], 1, 1e-6);
+        }
+    }
+
+    TEST_F(GLBReaderFixture, IndexTypesAndMissingNormals) {
+        std::string binary;
+        for (float const value : {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 0.f, 0.f, 1.f, 0.f}) append(binary, value);
+        for (uint8_t const index : {0, 1, 2, 0}) append(binary, index);
+        for (uint32_t const index : {0, 2, 3}) append(binary, index);
+        auto const json = R"({
+            "meshes": [{"primitives": [
+                {"attributes": {"POSITION": 0}, "indices": 1},
+                {"attributes": {"POSITION": 0}, "indices": 2},
+                {"attributes": {"POSITION": 0}, "mode": 1}
+            ]}],
+            "accessors": [
+                {"bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3"},
+                {"bufferView": 1, "componentType": 5121, "count": 3, "type": "SCALAR"},
+                {"bufferView": 2, "componentType": 5125, "count": 3, "type": "SCALAR"}
+            ],
+            "bufferViews": [
+                {"buffer": 0, "byteLength": 48},
+                {"buffer": 0, "byteOffset": 48, "byteLength": 4},
+                {"buffer": 0, "byteOffset": 52, "byteLength": 12}
+            ],
+            "buffers": [{"byteLength": 64}]
+        })";
+        auto const data = createGLB(json, binary);
+        Mesh::MeshPointer mesh;
+        auto const& bufferedMesh = readData(data, mesh);
+        // Files without scenes have each mesh at the origin. Primitives that aren't triangles are skipped
+        ASSERT_EQ(bufferedMesh.positions.size(), 8 * 3);
+        ASSERT_EQ(bufferedMesh.indices, (std::vector<unsigned>{0, 1, 2, 4, 6, 7}));
+        ASSERT_TRUE(bufferedMesh.normals.empty()) << "Normals have to be computed";
+
+        // Meshes without buffers are filled a vertex and a face at a time
+        auto mockMesh = std::make_unique<MockMesh>();
+        EXPECT_CALL(*mockMesh, initialize(8, 2)).Times(Exactly(1));
+        EXPECT_CALL(*mockMesh, addVertex(_, _, _)).Times(Exactly(8));
+        EXPECT_CALL(*mockMesh, addFace(_)).Times(Exactly(2));
+        Mesh::MeshPointer mockMeshPointer {std::move(mockMesh)};
+        readStream(data, mockMeshPointer);
+    }
+
+    TEST_F(GLBReaderFixture, InvalidFile) {
+        std::string binary;
+        for (float const value : {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 0.f}) append(binary, value);
+        for (uint16_t const index : {0, 1, 3}) append(binary, index);
+        auto createFile = [&](std::string const& accessors, std::string const& primitive) {
+            return createGLB(R"({"meshes": [{"primitives": [)" + primitive + R"(]}], "accessors": [)" + accessors +
+                             R"(], "bufferViews": [{"buffer": 0, "byteLength": 36},
+                                                   {"buffer": 0, "byteOffset": 36, "byteLength": 6}]})", binary);
+        };
+        auto const positions = R"({"bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3"})";
+        Mesh::MeshPointer mesh;
+        ASSERT_NO_THROW(readData(createFile(positions, R"({"attributes": {"POSITION": 0}})"), mesh));
+        // Index out of range
+        auto const indices = R"({"bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR"})";
+        auto const indexedPrimitive = R"({"attributes": {"POSITION": 0}, "indices": 1})";
+        ASSERT_THROW(readData(createFile(std::string{positions} + ", " + indices, indexedPrimitive), mesh),
+                     std::runtime_error);
+        // Accessor out of range
+        ASSERT_THROW(readData(createFile(R"({"bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3"})",
+                                         R"({"attributes": {"POSITION": 0}})"), mesh), std::runtime_error);
+        // Unsupported position type
+        ASSERT_THROW(readData(createFile(R"({"bufferView": 0, "componentType": 5126, "count": 9, "type": "SCALAR"})",
+                                         R"({"attributes": {"POSITION": 0}})"), mesh), std::runtime_error);
+        // Not a GLB file
+        ASSERT_THROW(readData("glTF", mesh), std::runtime_error);
+        ASSERT_THROW(readData(createGLB("{", binary), mesh), std::runtime_error);
+    }
+
+}
@@ -0,0 +1,29 @@
+#include "gtest/gtest.h"
+#include "Json.h"
+using namespace std;
+using namespace mv::readers;
+
+TEST(Json, ParseDocument) {
+    auto const json = Json::parse(R"( {"a": [1, -2.5e1, true, null],
+                                       "b": {"c": "d\"\n\u00e9\ud83d\ude00"}, "e": false} )");
+    ASSERT_TRUE(json.isObject());
+    auto const& a = json.find("a")->getArray();
+    ASSERT_EQ(a.size(), 4);
+    ASSERT_EQ(a[0].getNumber(), 1);
+    ASSERT_EQ(a[1].getNumber(), -25);
+    ASSERT_TRUE(a[2].getBool());
+    ASSERT_TRUE(a[3].isNull());
+    ASSERT_EQ(json.find("b")->find("c")->getString(), "d\"\n\xC3\xA9\xF0\x9F\x98\x80");
+    ASSERT_FALSE(json.find("e")->getBool());
+    ASSERT_EQ(json.find("f"), nullptr);
+    ASSERT_EQ(json.getNumber("f", 3), 3);
+    ASSERT_THROW(json.getNumber("e", 3), std::runtime_error);
+    ASSERT_THROW(static_cast<void>(json.getArray()), std::runtime_error);
+}
+
+TEST(Json, InvalidDocuments) {
+    for (auto const* text : {"", "{", "[1,]", "{\"a\" 1}", "\"abc", "tru", "nan", "1 2", "\"\\x\"", "\"\\ud800\""}) {
+        ASSERT_THROW(Json::parse(text), std::runtime_error) << text;
+    }
+    ASSERT_THROW(Json::parse(std::string(1000, '[')), std::runtime_error);
+}
@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "ReaderFixture.h"
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace mv;
+using namespace mv::readers;
+using namespace testing;
+namespace fs = std::filesystem;
+
+namespace {
+
+    // Coordinates of the vertices of each triangle, which are the same for a mesh and its triangle soup
+    vector<float> getTriangles(Geometry const& geometry) {
+        vector<float> triangles;
+        triangles.reserve(3 * geometry.indices.size());
+        for (auto const index : geometry.indices) {
+            triangles.insert(triangles.end(), geometry.positions.begin() + 3 * index,
+                             geometry.positions.begin() + 3 * index + 3);
+        }
+        return triangles;
+    }
+
+}
+
+class MeshChunkFixture : public ReaderFixture {
+    protected:
+        // Reads the file while another thread collects the chunks the reader hands over
+        static Geometry read(fs::path const& file, bool const clean, vector<MeshChunk>& chunks,
+                             bool const asStream = false, size_t const channelCapacity = 4) {
+            auto channel = make_shared<MeshChunkChannel>(channelCapacity);
+            thread collector {[channel, &chunks] {
+                while (auto chunk = channel->pop()) {
+                    chunks.push_back(std::move(*chunk));
+                }
+            }};
+            Geometry geometry;
+            try {
+                geometry = ReaderFixture::read(file, clean, [&channel](Reader& reader) {
+                    reader.setChunkChannel(channel);
+                }, asStream);
+            } catch (...) {
+                channel->close();
+                collector.join();
+                throw;
+            }
+            channel->close();
+            collector.join();
+            return geometry;
+        }
+
+        // Checks that the chunks are the file's triangles in order and that they only refer to vertices that
+        // arrived with or before them
+        static void testChunks(fs::path const& file) {
+            for (bool const asStream : {false, true}) {
+                for (bool const clean : {false, true}) {
+                    vector<MeshChunk> chunks;
+                    auto const geometry = read(file, clean, chunks, asStream);
+                    ASSERT_FALSE(geometry.indices.empty()) << file;
+
+                    Geometry chunkGeometry;
+                    for (auto const& chunk : chunks) {
+                        ASSERT_FALSE(chunk.positions.empty() && chunk.indices.empty());
+                        ASSERT_LE(chunk.positions.size(), 3 * verticesPerMeshChunk);
+                        ASSERT_LE(chunk.indices.size(), 3 * trianglesPerMeshChunk);
+                        chunkGeometry.positions.insert(chunkGeometry.positions.end(), chunk.positions.begin(),
+                                                       chunk.positions.end());
+                        for (auto const index : chunk.indices) {
+                            ASSERT_LT(index, chunkGeometry.positions.size() / 3) << file;
+                        }
+                        chunkGeometry.indices.insert(chunkGeometry.indices.end(), chunk.indices.begin(),
+                                                     chunk.indices.end());
+                    }
+                    ASSERT_EQ(getTriangles(chunkGeometry), getTriangles(geometry))
+                        << file << (clean ? " cleaned" : "") << (asStream ? " streamed" : "");
+                }
+            }
+        }
+
+        // A binary STL with more triangles than fit in a chunk
+        fs::path writeLargeBinarySTL() const {
+            return writeBinarySTL(3 * trianglesPerMeshChunk + 100);
+        }
+};
+
+TEST_F(MeshChunkFixture, STL) {
+    testChunks(m_modelsDir / "cube.stl");
+    testChunks(m_modelsDir / "cube_ascii.stl");
+    testChunks(m_modelsDir / "suzanne_subdivided.stl");
+    testChunks(writeLargeBinarySTL());
+    testChunks(writeAsciiFiles()[1]);
+}
+
+TEST_F(MeshChunkFixture, PLY) {
+    testChunks(m_modelsDir / "cube.ply");
+    testChunks(m_modelsDir / "Armadillo.ply");
+    testChunks(writeAsciiFiles()[0]);
+}
+
+TEST_F(MeshChunkFixture, ClosedChannel) {
+    // Files are read completely when the chunks are no longer collected
+    auto channel = make_shared<MeshChunkChannel>(1);
+    channel->close();
+    auto const geometry = ReaderFixture::read(writeLargeBinarySTL(), false, [&channel](Reader& reader) {
+        reader.setChunkChannel(channel);
+    });
+    ASSERT_EQ(geometry.indices.size(), 3 * (3 * trianglesPerMeshChunk + 100));
+}
+
+TEST_F(MeshChunkFixture, ChannelClosedWhileReading) {
+    // Readers stop handing over chunks once the collector closes the channel and still read the whole file
+    auto channel = make_shared<MeshChunkChannel>(1);
+    size_t numChunks = 0;
+    thread collector {[channel, &numChunks] {
+        if (channel->pop()) ++numChunks;
+        channel->close();
+        while (channel->pop()) ++numChunks;
+    }};
+    auto const geometry = ReaderFixture::read(writeLargeBinarySTL(), false, [&channel](Reader& reader) {
+        reader.setChunkChannel(channel);
+    });
+    collector.join();
+    ASSERT_EQ(geometry.indices.size(), 3 * (3 * trianglesPerMeshChunk + 100));
+    ASSERT_LE(numChunks, 2);
+}
@@ -0,0 +1,144 @@
+#include "gtest/gtest.h"
+#include "OBJReader.h"
+#include "MockMeshFactory.h"
+#include "MockBufferedMesh.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace mv;
+using namespace mv::common;
+using namespace mv::readers;
+using namespace testing;
+
+namespace mv::readers {
+
+    class OBJReaderFixture : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            auto *pData = getenv("modelsDir");
+            if (!pData) throw std::runtime_error("modelsDir environment variable not set");
+            m_modelsDir = pData;
+        }
+
+        // Reads the text into a mesh that exposes its buffers
+        MockBufferedMesh& readData(std::string const& data, Mesh::MeshPointer& mesh) {
+            mesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+            auto& bufferedMesh = dynamic_cast<MockBufferedMesh&>(*mesh);
+            readStream(data, mesh);
+            return bufferedMesh;
+        }
+
+        void readStream(std::string const& data, Mesh::MeshPointer& mesh) {
+            istringstream stream(data);
+            mesh = objReader.getOutput(stream, mesh);
+        }
+
+        std::unique_ptr<OBJReader> createReader(std::string const& fileName) {
+            return std::unique_ptr<OBJReader>{new OBJReader{fileName, mockMeshFactory}};
+        }
+
+        filesystem::path m_modelsDir;
+        MockMeshFactory mockMeshFactory;
+        OBJReader objReader {"", mockMeshFactory};
+    };
+
+    TEST_F(OBJReaderFixture, ReadFile) {
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto& mesh = *bufferedMesh;
+        EXPECT_CALL(mesh, initialize(8, 12)).Times(Exactly(1));
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(m_modelsDir / "cube.obj")->getOutput(std::move(meshPointer));
+        ASSERT_TRUE(std::all_of(mesh.positions.begin(), mesh.positions.end(),
+                                [](float const coordinate) { return coordinate == 1 || coordinate == -1; }));
+        // Quads are split into fans and v/vt/vn tuples refer to 0-based vertices
+        ASSERT_EQ((std::vector<unsigned>{mesh.indices.begin(), mesh.indices.begin() + 6}),
+                  (std::vector<unsigned>{0, 4, 6, 0, 6, 2}));
+    }
+
+    TEST_F(OBJReaderFixture, IndexFormats) {
+        std::string const data =
+                "# Faces in all the index formats\r\n"
+                "v 0 0 0\r\n"
+                "v 1 0 0 1.0\r\n"
+                "v +1 1 0 0.5 0.5 0.5\r\n"
+                "vt 0 0\r\n"
+                "vn 0 0 1\r\n"
+                "f 1 2 3\r\n"
+                "g group\r\n"
+                "f 1/1 2/1 3/1\r\n"
+                "v 0 1e0 0\r\n"
+                "f 1//1 3//1 4//1\r\n"
+                "f -4/-1/-1 -3/-1/-1 -2/-1/-1 -1/-1/-1\r\n"
+                "l 1 2\r\n"
+                "f 4 3\r\n"
+                "v 0 0 1\r\n"
+                "f 1 2 3 4 5";
+        Mesh::MeshPointer mesh;
+        auto const& bufferedMesh = readData(data, mesh);
+        ASSERT_EQ(bufferedMesh.positions, (std::vector<float>{0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 0, 0, 1}));
+        ASSERT_EQ(bufferedMesh.indices, (std::vector<unsigned>{0, 1, 2, 0, 1, 2, 0, 2, 3, 0, 1, 2, 0, 2, 3,
+                                                               0, 1, 2, 0, 2, 3, 0, 3, 4}));
+
+        // Meshes without buffers are filled a vertex and a face at a time
+        auto mockMesh = std::make_unique<MockMesh>();
+        EXPECT_CALL(*mockMesh, initialize(5, 8)).Times(Exactly(1));
+        EXPECT_CALL(*mockMesh, addVertex(_, _, _)).Times(Exactly(5));
+        EXPECT_CALL(*mockMesh, addFace(_)).Times(Exactly(8));
+        Mesh::MeshPointer mockMeshPointer {std::move(mockMesh)};
+        readStream(data, mockMeshPointer);
+    }
+
+    TEST_F(OBJReaderFixture, InvalidFile) {
+        Mesh::MeshPointer mesh;
+        ASSERT_THROW(readData("v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n", mesh), std::runtime_error);
+        ASSERT_THROW(readData("v 0 0 0\nv 1 0 0\nv 1 1 0\nf -1 -2 -4\n", mesh), std::runtime_error);
+        ASSERT_THROW(readData("v 0 0 0\nv 1 0 0\nv 1 1 0\nf 0 1 2\n", mesh), std::runtime_error);
+        ASSERT_THROW(readData("v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 a\n", mesh), std::runtime_error);
+        ASSERT_THROW(readData("v 0 0\n", mesh), std::runtime_error);
+    }
+
+    TEST_F(OBJReaderFixture, ReadLargeFile) {
+        // A grid of quads that is large enough to be parsed on several threads. Every other row of faces uses
+        // relative indices, which refer to the vertices of the row written just before it
+        unsigned const gridSize = 300;
+        std::string data;
+        std::vector<float> expectedPositions;
+        std::vector<unsigned> expectedIndices;
+        for (unsigned row = 0; row <= gridSize; ++row) {
+            for (unsigned column = 0; column <= gridSize; ++column) {
+                data += "v " + std::to_string(column) + ' ' + std::to_string(row) + " 0\n";
+                expectedPositions.insert(expectedPositions.end(), {static_cast<float>(column),
+                                                                   static_cast<float>(row), 0});
+            }
+            if (!row) continue;
+            for (unsigned column = 0; column < gridSize; ++column) {
+                auto const corner = (row - 1) * (gridSize + 1) + column;
+                unsigned const quad[] = {corner, corner + 1, corner + gridSize + 2, corner + gridSize + 1};
+                data += 'f';
+                for (auto const vertex : quad) {
+                    auto const numVertices = static_cast<int>((row + 1) * (gridSize + 1));
+                    data += ' ' + std::to_string(row % 2 ? static_cast<int>(vertex) + 1 :
+                                                           static_cast<int>(vertex) - numVertices) + "/1/1";
+                }
+                data += '\n';
+                expectedIndices.insert(expectedIndices.end(), {quad[0], quad[1], quad[2], quad[0], quad[2], quad[3]});
+            }
+        }
+        auto const largeFile = m_modelsDir / "large.obj";
+        ofstream{largeFile, ios::binary}.write(data.data(), static_cast<streamsize>(data.size()));
+
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto const& mesh = *bufferedMesh;
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(largeFile)->getOutput(std::move(meshPointer));
+        filesystem::remove(largeFile);
+        ASSERT_EQ(mesh.positions, expectedPositions);
+        ASSERT_EQ(mesh.indices, expectedIndices);
+    }
+
+}
@@ -2,12 +2,21 @@
 #include "ReaderFactory.h"
 #include "PLYReader.h"
 #include "MockMeshFactory.h"
+#include "MockBufferedMesh.h"
 #include "gmock/gmock.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <sstream>
 using namespace std;
 using namespace mv;
 using namespace mv::common;
 using namespace mv::readers;
+using namespace testing;
 
 namespace mv::readers {
     class PLYReaderFixture : public ::testing::Test {
@@ -29,14 +38,55 @@ namespace mv::readers {
             plyReader->getOutput();
         }
 
+        // Text that can't be sought, like a pipe, so that streamed files are read without seeking
+        class UnseekableBuffer : public std::stringbuf {
+        public:
+            using std::stringbuf::stringbuf;
+        protected:
+            pos_type seekoff(off_type, ios_base::seekdir, ios_base::openmode) override { return pos_type(-1); }
+            pos_type seekpos(pos_type, ios_base::openmode) override { return pos_type(-1); }
+        };
+
         void readData(std::string const& data) {
-            istringstream stream(data);
-            // Call private method PLYReader::getOutput() and pass the mock mesh
+            UnseekableBuffer buffer(data);
+            std::istream stream(&buffer);
+            // Pass the mock mesh to PLYReader::readStream()
             // NOTE: Without the mock mesh being passed, gmock's EXPECT_ macros won't have an already instantiated
             // object to work with (this is a gmock hard requirement, see the test below for setup)
-            plyReader->getOutput(stream, mockMeshPtr);
+            mockMeshPtr = plyReader->readStream(stream, std::move(mockMeshPtr));
+        }
+
+        // Reads a file into a mesh that exposes its buffers
+        MockBufferedMesh& readData(std::string const& data, Mesh::MeshPointer& mesh) {
+            mesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+            auto& bufferedMesh = dynamic_cast<MockBufferedMesh&>(*mesh);
+            UnseekableBuffer buffer(data);
+            std::istream stream(&buffer);
+            mesh = plyReader->readStream(stream, std::move(mesh));
+            return bufferedMesh;
+        }
+
+        // Appends the bytes of a value in the specified byte order
+        template<typename T>
+        static void append(std::string& data, T const value, bool const bigEndian = false) {
+            char bytes[sizeof(T)];
+            memcpy(bytes, &value, sizeof(T));
+            if (bigEndian != (std::endian::native == std::endian::big)) std::reverse(bytes, bytes + sizeof(T));
+            data.append(bytes, sizeof(T));
+        }
+
+        std::unique_ptr<PLYReader> parseHeader(std::string const& header) {
+            auto reader = createReader("");
+            istringstream stream(header);
+            reader->readHeader(stream);
+            return reader;
+        }
+
+        std::unique_ptr<PLYReader> createReader(std::string const& fileName) {
+            return std::unique_ptr<PLYReader>{new PLYReader{fileName, mockMeshFactory}};
         }
 
+        MockMeshFactory mockMeshFactory;
         Mesh::MeshPointer mockMeshPtr { new MockMesh{} };
         std::unique_ptr<PLYReader> plyReader { new PLYReader{"", MockMeshFactory{}} };
     };
@@ -95,4 +145,367 @@ namespace mv::readers {
         readData(asciiFile);
     }
 
-}
\ No newline at end of file
+
+    TEST_F(PLYReaderFixture, ParseSchema) {
+        testing::internal::CaptureStdout();
+        auto const plyReader = parseHeader(
+                "ply\r\n"
+                "format binary_big_endian 1.0\r\n"
+                "element vertex 8\r\n"
+                "property double x\r\n"
+                "property double y\r\n"
+                "property double z\r\n"
+                "property uint8 red\r\n"
+                "element face 6\r\n"
+                "property list ushort int32 vertex_index\r\n"
+                "element material 1\r\n"
+                "property float shininess\r\n"
+                "end_header\r\n");
+        testing::internal::GetCapturedStdout();
+        ASSERT_TRUE(plyReader->isInputFileBinary());
+        ASSERT_FALSE(plyReader->isInputFileLittleEndian());
+        ASSERT_EQ(plyReader->getNumberOfVertices(), 8);
+        ASSERT_EQ(plyReader->getNumberOfFaces(), 6);
+        auto const& elements = plyReader->getElements();
+        ASSERT_EQ(elements.size(), 3);
+        ASSERT_EQ(elements[0].properties.size(), 4);
+        ASSERT_EQ(elements[0].properties[3].name, "red");
+        ASSERT_EQ(elements[0].properties[3].type, PLYReader::PropertyType::UInt8);
+        ASSERT_EQ(elements[0].getRowSize(), 25);
+        ASSERT_TRUE(elements[1].properties[0].isList);
+        ASSERT_EQ(elements[1].properties[0].countType, PLYReader::PropertyType::UInt16);
+        ASSERT_EQ(elements[1].properties[0].type, PLYReader::PropertyType::Int32);
+        ASSERT_EQ(elements[1].getRowSize(), 0);
+        ASSERT_EQ(elements[2].name, "material");
+    }
+
+    TEST_F(PLYReaderFixture, BinaryWithExtraProperties) {
+        testing::internal::CaptureStdout();
+        // Vertices with normals, colors and quality. Faces with flags and texture coordinates around the
+        // vertex indices. A quad is split into two triangles
+        std::string data =
+                "ply\n"
+                "format binary_little_endian 1.0\n"
+                "element vertex 4\n"
+                "property float x\n"
+                "property float y\n"
+                "property float z\n"
+                "property float nx\n"
+                "property float ny\n"
+                "property float nz\n"
+                "property uchar red\n"
+                "property uchar green\n"
+                "property uchar blue\n"
+                "property float quality\n"
+                "element face 2\n"
+                "property uchar flags\n"
+                "property list uchar int vertex_indices\n"
+                "property list uchar float texcoord\n"
+                "end_header\n";
+        float const coordinates[] = {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0.5f};
+        for (unsigned i = 0; i < 4; ++i) {
+            for (unsigned j = 0; j < 3; ++j) append(data, coordinates[3 * i + j]);
+            for (float const normal : {0.f, 0.f, 1.f}) append(data, normal);
+            for (uint8_t const color : {255, 128, 0}) append(data, color);
+            append(data, 0.75f);
+        }
+        append<uint8_t>(data, 1);
+        append<uint8_t>(data, 4);
+        for (int const index : {0, 1, 2, 3}) append(data, index);
+        append<uint8_t>(data, 2);
+        append(data, 0.5f);
+        append(data, 0.5f);
+        append<uint8_t>(data, 0);
+        append<uint8_t>(data, 3);
+        for (int const index : {3, 2, 1}) append(data, index);
+        append<uint8_t>(data, 0);
+
+        Mesh::MeshPointer mesh;
+        auto const& bufferedMesh = readData(data, mesh);
+        testing::internal::GetCapturedStdout();
+        ASSERT_EQ(bufferedMesh.positions, std::vector<float>(std::begin(coordinates), std::end(coordinates)));
+        ASSERT_EQ(bufferedMesh.indices, (std::vector<unsigned>{0, 1, 2, 0, 2, 3, 3, 2, 1}));
+    }
+
+    TEST_F(PLYReaderFixture, BigEndianBinary) {
+        testing::internal::CaptureStdout();
+        // Elements that aren't vertices or faces are skipped
+        std::string data =
+                "ply\n"
+                "format binary_big_endian 1.0\n"
+                "comment vertices in double precision\n"
+                "element vertex 3\n"
+                "property double x\n"
+                "property double y\n"
+                "property double z\n"
+                "element edge 1\n"
+                "property int vertex1\n"
+                "property int vertex2\n"
+                "element face 1\n"
+                "property list ushort uint vertex_index\n"
+                "end_header\n";
+        for (double const coordinate : {1., 2., 3., 4., 5., 6., -7., -8., -9.}) append(data, coordinate, true);
+        append(data, 0, true);
+        append(data, 1, true);
+        append<uint16_t>(data, 3, true);
+        for (unsigned const index : {2u, 1u, 0u}) append(data, index, true);
+
+        Mesh::MeshPointer mesh;
+        auto const& bufferedMesh = readData(data, mesh);
+        testing::internal::GetCapturedStdout();
+        ASSERT_EQ(bufferedMesh.positions, (std::vector<float>{1, 2, 3, 4, 5, 6, -7, -8, -9}));
+        ASSERT_EQ(bufferedMesh.indices, (std::vector<unsigned>{2, 1, 0}));
+
+        // Meshes without buffers are filled a vertex and a face at a time
+        auto& mockMesh = dynamic_cast<MockMesh&>(*mockMeshPtr);
+        EXPECT_CALL(mockMesh, initialize(3, 1)).Times(Exactly(1));
+        EXPECT_CALL(mockMesh, addVertex(_, _, _)).Times(Exactly(2));
+        EXPECT_CALL(mockMesh, addVertex(-7, -8, -9)).Times(Exactly(1));
+        EXPECT_CALL(mockMesh, addFace(_)).Times(Exactly(1));
+        testing::internal::CaptureStdout();
+        readData(data);
+        testing::internal::GetCapturedStdout();
+    }
+
+    TEST_F(PLYReaderFixture, InvalidBinary) {
+        testing::internal::CaptureStdout();
+        std::string const header =
+                "ply\n"
+                "format binary_little_endian 1.0\n"
+                "element vertex 3\n"
+                "property float x\n"
+                "property float y\n"
+                "property float z\n"
+                "element face 1\n"
+                "property list uchar int vertex_indices\n"
+                "end_header\n";
+        auto data = header;
+        for (unsigned i = 0; i < 9; ++i) append(data, 1.f);
+        append<uint8_t>(data, 3);
+        Mesh::MeshPointer mesh;
+        // Truncated
+        for (int const index : {0, 1}) append(data, index);
+        ASSERT_THROW(readData(data, mesh), std::runtime_error);
+        // Index out of range
+        append(data, 3);
+        ASSERT_THROW(readData(data, mesh), std::runtime_error);
+        testing::internal::GetCapturedStdout();
+    }
+
+    TEST_F(PLYReaderFixture, ReadFile) {
+        auto const* modelsDir = getenv("modelsDir");
+        ASSERT_NE(modelsDir, nullptr) << "modelsDir environment variable not set";
+        testing::internal::CaptureStdout();
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto const& mesh = *bufferedMesh;
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(std::string{modelsDir} + "/Armadillo.ply")->getOutput(std::move(meshPointer));
+        testing::internal::GetCapturedStdout();
+        ASSERT_EQ(mesh.positions.size(), 34596 * 3);
+        ASSERT_EQ(mesh.indices.size(), 69188 * 3);
+        ASSERT_TRUE(std::all_of(mesh.indices.begin(), mesh.indices.end(),
+                                [](unsigned const index) { return index < 34596; }));
+    }
+
+    TEST_F(PLYReaderFixture, ReadLargeBinaryFile) {
+        auto const* modelsDir = getenv("modelsDir");
+        ASSERT_NE(modelsDir, nullptr) << "modelsDir environment variable not set";
+        testing::internal::CaptureStdout();
+
+        // A grid of quads that is large enough to be decoded on several threads. Faces are written as triangles,
+        // as a mix of triangles and quads and with a property after the vertex indices, which decodes the faces
+        // with each of the face decoders
+        unsigned const gridSize = 300;
+        unsigned const numVertices = (gridSize + 1) * (gridSize + 1);
+        unsigned const numQuads = gridSize * gridSize;
+        auto getQuad = [](unsigned const quad) {
+            auto const corner = quad / gridSize * (gridSize + 1) + quad % gridSize;
+            return std::array<int, 4>{static_cast<int>(corner), static_cast<int>(corner + 1),
+                                      static_cast<int>(corner + gridSize + 2), static_cast<int>(corner + gridSize + 1)};
+        };
+        enum class FaceLayout { Triangles, Mixed, ExtraProperty };
+        for (auto const layout : {FaceLayout::Triangles, FaceLayout::Mixed, FaceLayout::ExtraProperty}) {
+            std::vector<unsigned> expectedIndices;
+            std::string faces;
+            unsigned numFaces = 0;
+            auto addFace = [&](std::vector<int> const& face) {
+                append<uint8_t>(faces, static_cast<uint8_t>(face.size()));
+                for (auto const index : face) append(faces, index);
+                if (layout == FaceLayout::ExtraProperty) append<uint8_t>(faces, 7);
+                for (size_t i = 2; i < face.size(); ++i) {
+                    expectedIndices.insert(expectedIndices.end(), {static_cast<unsigned>(face[0]),
+                                           static_cast<unsigned>(face[i - 1]), static_cast<unsigned>(face[i])});
+                }
+                ++numFaces;
+            };
+            for (unsigned i = 0; i < numQuads; ++i) {
+                auto const quad = getQuad(i);
+                if (layout == FaceLayout::Mixed && i % 7 == 0) {
+                    addFace({quad[0], quad[1], quad[2], quad[3]});
+                } else {
+                    addFace({quad[0], quad[1], quad[2]});
+                    addFace({quad[0], quad[2], quad[3]});
+                }
+            }
+
+            auto data = "ply\n"
+                        "format binary_little_endian 1.0\n"
+                        "element vertex " + std::to_string(numVertices) + "\n"
+                        "property float x\n"
+                        "property float y\n"
+                        "property float z\n"
+                        "element face " + std::to_string(numFaces) + "\n"
+                        "property list uchar int vertex_indices\n" +
+                        (layout == FaceLayout::ExtraProperty ? "property uchar flags\n" : "") +
+                        "end_header\n";
+            std::vector<float> expectedPositions;
+            for (unsigned i = 0; i < numVertices; ++i) {
+                for (auto const coordinate : {static_cast<float>(i % (gridSize + 1)),
+                                              static_cast<float>(i / (gridSize + 1)), 0.5f}) {
+                    append(data, coordinate);
+                    expectedPositions.push_back(coordinate);
+                }
+            }
+            data += faces;
+            auto const largeFile = std::string{modelsDir} + "/large.ply";
+            ofstream{largeFile, ios::binary}.write(data.data(), static_cast<streamsize>(data.size()));
+
+            auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+            auto const& mesh = *bufferedMesh;
+            Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+            meshPointer = createReader(largeFile)->getOutput(std::move(meshPointer));
+            ASSERT_EQ(mesh.positions, expectedPositions);
+            ASSERT_EQ(mesh.indices, expectedIndices);
+
+            // Streamed files are decoded the same way
+            Mesh::MeshPointer streamedMeshPointer;
+            auto const& streamedMesh = readData(data, streamedMeshPointer);
+            ASSERT_EQ(streamedMesh.positions, expectedPositions);
+            ASSERT_EQ(streamedMesh.indices, expectedIndices);
+            filesystem::remove(largeFile);
+        }
+        testing::internal::GetCapturedStdout();
+    }
+
+    TEST_F(PLYReaderFixture, ASCIIPolygons) {
+        testing::internal::CaptureStdout();
+        std::string const data =
+                "ply\r\n"
+                "format ascii 1.0\r\n"
+                "element vertex 5\r\n"
+                "property float x\r\n"
+                "property float y\r\n"
+                "property float z\r\n"
+                "property list uchar float texcoords\r\n"
+                "property uchar red\r\n"
+                "element face 3\r\n"
+                "property uchar flags\r\n"
+                "property list uchar int vertex_indices\r\n"
+                "property float quality\r\n"
+                "end_header\r\n"
+                "0 0 0 2 0.5 0.5 255\r\n"
+                "1 0 0 0 128\r\n"
+                "+1 1 0 2 0 0 0\r\n"
+                "0.5 1.5e0 0 0 0\r\n"
+                "-0 1 -1 1 1 1\r\n"
+                "1 5 0 1 2 3 4 0.5\r\n"
+                "0 2 0 1 0\r\n"
+                "0 4 4 3 2 1 1\r\n";
+        Mesh::MeshPointer mesh;
+        auto const& bufferedMesh = readData(data, mesh);
+        ASSERT_EQ(bufferedMesh.positions, (std::vector<float>{0, 0, 0, 1, 0, 0, 1, 1, 0, 0.5, 1.5, 0, 0, 1, -1}));
+        // Pentagons and quads are split into triangle fans and faces with fewer than three vertices are skipped
+        ASSERT_EQ(bufferedMesh.indices, (std::vector<unsigned>{0, 1, 2, 0, 2, 3, 0, 3, 4, 4, 3, 2, 4, 2, 1}));
+
+        // Rows that don't match the header
+        std::string const header =
+                "ply\n"
+                "format ascii 1.0\n"
+                "element vertex 3\n"
+                "property float x\n"
+                "property float y\n"
+                "property float z\n"
+                "element face 1\n"
+                "property list uchar int vertex_indices\n"
+                "end_header\n"
+                "0 0 0\n"
+                "1 0 0\n";
+        ASSERT_THROW(readData(header + "1 1 0\n3 0 1\n", mesh), std::runtime_error);
+        ASSERT_THROW(readData(header + "1 x 0\n3 0 1 2\n", mesh), std::runtime_error);
+        ASSERT_THROW(readData(header + "1 1 0\n3 0 1 3\n", mesh), std::runtime_error);
+        ASSERT_THROW(readData(header + "1 1 0\n", mesh), std::runtime_error);
+        testing::internal::GetCapturedStdout();
+    }
+
+    TEST_F(PLYReaderFixture, ReadASCIIFile) {
+        auto const* modelsDir = getenv("modelsDir");
+        ASSERT_NE(modelsDir, nullptr) << "modelsDir environment variable not set";
+        testing::internal::CaptureStdout();
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto const& mesh = *bufferedMesh;
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(std::string{modelsDir} + "/cube.ply")->getOutput(std::move(meshPointer));
+        testing::internal::GetCapturedStdout();
+        ASSERT_EQ(mesh.positions.size(), 24 * 3);
+        ASSERT_EQ(mesh.indices.size(), 12 * 3);
+        ASSERT_TRUE(std::all_of(mesh.positions.begin(), mesh.positions.end(),
+                                [](float const coordinate) { return coordinate == 1 || coordinate == -1; }));
+        ASSERT_EQ((std::vector<unsigned>{mesh.indices.begin(), mesh.indices.begin() + 6}),
+                  (std::vector<unsigned>{0, 1, 2, 0, 2, 3}));
+    }
+
+    TEST_F(PLYReaderFixture, ReadLargeASCIIFile) {
+        auto const* modelsDir = getenv("modelsDir");
+        ASSERT_NE(modelsDir, nullptr) << "modelsDir environment variable not set";
+        testing::internal::CaptureStdout();
+
+        // A grid of quads and triangles that is large enough to be parsed on several threads
+        unsigned const gridSize = 300;
+        unsigned const numVertices = (gridSize + 1) * (gridSize + 1);
+        std::string vertices, faces;
+        std::vector<float> expectedPositions;
+        std::vector<unsigned> expectedIndices;
+        for (unsigned i = 0; i < numVertices; ++i) {
+            auto const x = static_cast<float>(i % (gridSize + 1)) / 4;
+            auto const y = static_cast<float>(i / (gridSize + 1)) / 4;
+            vertices += std::to_string(x) + ' ' + std::to_string(y) + " 0\n";
+            expectedPositions.insert(expectedPositions.end(), {x, y, 0});
+        }
+        unsigned numFaces = 0;
+        for (unsigned i = 0; i < gridSize * gridSize; ++i) {
+            auto const corner = i / gridSize * (gridSize + 1) + i % gridSize;
+            unsigned const quad[] = {corner, corner + 1, corner + gridSize + 2, corner + gridSize + 1};
+            if (i % 3) {
+                faces += "4 " + std::to_string(quad[0]) + ' ' + std::to_string(quad[1]) + ' ' +
+                         std::to_string(quad[2]) + ' ' + std::to_string(quad[3]) + '\n';
+                ++numFaces;
+            } else {
+                faces += "3 " + std::to_string(quad[0]) + ' ' + std::to_string(quad[1]) + ' ' +
+                         std::to_string(quad[2]) + "\n3 " + std::to_string(quad[0]) + ' ' +
+                         std::to_string(quad[2]) + ' ' + std::to_string(quad[3]) + '\n';
+                numFaces += 2;
+            }
+            expectedIndices.insert(expectedIndices.end(), {quad[0], quad[1], quad[2], quad[0], quad[2], quad[3]});
+        }
+        auto const data = "ply\n"
+                          "format ascii 1.0\n"
+                          "element vertex " + std::to_string(numVertices) + "\n"
+                          "property float x\n"
+                          "property float y\n"
+                          "property float z\n"
+                          "element face " + std::to_string(numFaces) + "\n"
+                          "property list uchar int vertex_indices\n"
+                          "end_header\n" + vertices + faces;
+        auto const largeFile = std::string{modelsDir} + "/large_ascii.ply";
+        ofstream{largeFile, ios::binary}.write(data.data(), static_cast<streamsize>(data.size()));
+
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto const& mesh = *bufferedMesh;
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(largeFile)->getOutput(std::move(meshPointer));
+        filesystem::remove(largeFile);
+        testing::internal::GetCapturedStdout();
+        ASSERT_EQ(mesh.positions, expectedPositions);
+        ASSERT_EQ(mesh.indices, expectedIndices);
+    }
+}
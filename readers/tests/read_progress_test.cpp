@@ -0,0 +1,66 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "ReaderFixture.h"
+#include <filesystem>
+#include <stop_token>
+#include <vector>
+using namespace std;
+using namespace mv;
+using namespace mv::readers;
+using namespace testing;
+namespace fs = std::filesystem;
+
+class ReadProgressFixture : public ReaderFixture {
+    protected:
+        // Progress that is reported while the file is read
+        static vector<ReadProgress> read(fs::path const& file, bool const asStream = false) {
+            vector<ReadProgress> progress;
+            ReaderFixture::read(file, false, [&progress](Reader& reader) {
+                reader.setProgressCallback([&progress](ReadProgress const& p) { progress.push_back(p); });
+            }, asStream);
+            return progress;
+        }
+
+        // Checks that the progress only moves forward and that mapped files are reported to be read completely
+        static void testProgress(fs::path const& file) {
+            for (bool const asStream : {false, true}) {
+                auto const progress = read(file, asStream);
+                ASSERT_FALSE(progress.empty()) << file;
+                for (size_t i = 1; i < progress.size(); ++i) {
+                    ASSERT_GE(progress[i].bytesRead, progress[i - 1].bytesRead) << file;
+                    ASSERT_GE(progress[i].elementsRead, progress[i - 1].elementsRead) << file;
+                }
+                ASSERT_GT(progress.back().elementsRead, 0) << file;
+                if (!asStream) {
+                    ASSERT_EQ(progress.back().totalBytes, fs::file_size(file)) << file;
+                    ASSERT_EQ(progress.back().bytesRead, progress.back().totalBytes) << file;
+                }
+            }
+        }
+
+        // A binary STL that is long enough to be read in several pieces
+        fs::path writeLargeBinarySTL() const {
+            return writeBinarySTL(1 << 18);
+        }
+};
+
+TEST_F(ReadProgressFixture, STL) {
+    auto const file = writeLargeBinarySTL();
+    testProgress(file);
+    ASSERT_EQ(read(file).back().elementsRead, 1 << 18);
+}
+
+TEST_F(ReadProgressFixture, PLY) {
+    testProgress(m_modelsDir / "Armadillo.ply");
+}
+
+TEST_F(ReadProgressFixture, Cancel) {
+    // Reads that are asked to stop give up at the next piece
+    std::stop_source stopSource;
+    stopSource.request_stop();
+    for (auto const& file : {writeLargeBinarySTL(), m_modelsDir / "Armadillo.ply"}) {
+        ASSERT_THROW(ReaderFixture::read(file, false, [&stopSource](Reader& reader) {
+            reader.setStopToken(stopSource.get_token());
+        }), ReadCancelled) << file;
+    }
+}
@@ -63,6 +63,8 @@ TEST_F(ReaderFixture, SupportedFormats) {
         try {
             ReaderFactory{MOCK_MESH_FACTORY}.getReader((m_modelsDir/"cube.stl").string());
             ReaderFactory{MOCK_MESH_FACTORY}.getReader((m_modelsDir/"Armadillo.ply").string());
+            ReaderFactory{MOCK_MESH_FACTORY}.getReader((m_modelsDir/"cube.obj").string());
+            ReaderFactory{MOCK_MESH_FACTORY}.getReader((m_modelsDir/"cube.glb").string());
         } catch (std::runtime_error& ex) {
             throw;
         }
@@ -76,7 +78,7 @@ TEST(ReaderFactory, ReturnsValidLookupResultsWithSupportedExtensions) {
     ASSERT_TRUE(ReaderFactory{MOCK_MESH_FACTORY}.isFileTypeSupported("a.ply")) << "ply should be a supported type";
     ASSERT_TRUE(ReaderFactory{MOCK_MESH_FACTORY}.isFileTypeSupported("a.sTl")) << "stl should be a supported type";
     ASSERT_TRUE(ReaderFactory{MOCK_MESH_FACTORY}.isFileTypeSupported("a.PlY")) << "stl should be a supported type";
-    ASSERT_FALSE(ReaderFactory{MOCK_MESH_FACTORY}.isFileTypeSupported("a.ObJ")) << "obj should be an unsupported type";
+    ASSERT_TRUE(ReaderFactory{MOCK_MESH_FACTORY}.isFileTypeSupported("a.ObJ")) << "obj should be a supported type";
     ASSERT_FALSE(ReaderFactory{MOCK_MESH_FACTORY}.isFileTypeSupported(".")) << "directories should be an unsupported type";
     ASSERT_FALSE(ReaderFactory{MOCK_MESH_FACTORY}.isFileTypeSupported("abc.stl")) << "non-existent files should be "
                                                                                      "classified as unsupported";
@@ -1,8 +1,15 @@
 #include "gtest/gtest.h"
 #include "STLReader.h"
 #include "MockMeshFactory.h"
+#include "MockBufferedMesh.h"
+#include <array>
+#include <cstring>
 #include <memory>
 #include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
 using namespace std;
 using namespace mv;
 using namespace mv::common;
@@ -32,8 +39,32 @@ namespace mv::readers {
             stlReader.getOutput(ifs, mockMesh, /*clean=*/true);
         }
 
+        void readStream(std::string fileName, Mesh::MeshPointer& mesh, bool clean = false) {
+            ifstream ifs(m_modelsDir / fileName, ios::binary);
+            ASSERT_TRUE(ifs) << "Unable to open " << fileName;
+            mesh = stlReader.getOutput(ifs, mesh, clean);
+        }
+
+        std::unique_ptr<STLReader> createReader(filesystem::path const& filePath) {
+            return std::unique_ptr<STLReader>{new STLReader(filePath, mockMeshFactory)};
+        }
+
+        // Positions of the triangle vertices of a binary STL
+        std::vector<float> readPositions(std::string fileName) {
+            ifstream ifs(m_modelsDir / fileName, ios::binary);
+            std::vector<char> data{istreambuf_iterator<char>(ifs), istreambuf_iterator<char>()};
+            unsigned numTris;
+            memcpy(&numTris, data.data() + 80, 4);
+            std::vector<float> positions(numTris * 9);
+            for (unsigned i = 0; i < numTris; ++i) {
+                memcpy(positions.data() + 9 * i, data.data() + 84 + 50 * i + 12, 36);
+            }
+            return positions;
+        }
+
         filesystem::path m_modelsDir;
-        mv::readers::STLReader stlReader{"", MockMeshFactory{}};
+        MockMeshFactory mockMeshFactory;
+        mv::readers::STLReader stlReader{"", mockMeshFactory};
         std::unique_ptr<Mesh> mockMesh { new MockMesh{} };
     };
 
@@ -52,9 +83,277 @@ namespace mv::readers {
     TEST_F(STLReaderFixture, Cleanup) {
         auto& mesh = dynamic_cast<MockMesh&>(*mockMesh.get());
 
-        // Should call Mesh::removeDuplicateVertices when clean flag is on
-        EXPECT_CALL(mesh, removeDuplicateVertices()).Times(Exactly(1));
+        // Should create the mesh with welded vertices when clean flag is on instead of welding it afterwards
+        EXPECT_CALL(mesh, initialize(8, 12)).Times(Exactly(1));
+        EXPECT_CALL(mesh, addVertex(_,_,_)).Times(Exactly(8));
+        EXPECT_CALL(mesh, addFace(_)).Times(Exactly(12));
+        EXPECT_CALL(mesh, removeDuplicateVertices()).Times(Exactly(0));
 
         readDataAndClean("cube.stl");
     }
+
+    TEST_F(STLReaderFixture, ReadMappedFileIntoBuffers) {
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto& mesh = *bufferedMesh;
+        // Meshes with flat buffers are filled directly
+        EXPECT_CALL(mesh, initialize(12*3, 12)).Times(Exactly(1));
+        EXPECT_CALL(mesh, addVertex(_,_,_)).Times(Exactly(0));
+        EXPECT_CALL(mesh, addFace(_)).Times(Exactly(0));
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(m_modelsDir / "cube.stl")->getOutput(std::move(meshPointer));
+
+        ASSERT_EQ(mesh.positions, readPositions("cube.stl"));
+        for (unsigned i = 0; i < 36; ++i) {
+            ASSERT_EQ(mesh.indices[i], i);
+        }
+    }
+
+    TEST_F(STLReaderFixture, ReadStreamIntoBuffers) {
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto& mesh = *bufferedMesh;
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        readStream("cube.stl", meshPointer);
+        ASSERT_EQ(mesh.positions, readPositions("cube.stl"));
+        ASSERT_EQ(mesh.indices[35], 35);
+    }
+
+    TEST_F(STLReaderFixture, TruncatedFile) {
+        // Header claims more triangles than the file has
+        ifstream ifs(m_modelsDir / "cube.stl", ios::binary);
+        std::vector<char> data{istreambuf_iterator<char>(ifs), istreambuf_iterator<char>()};
+        data.resize(84 + 50 * 5);
+        auto const truncatedFile = m_modelsDir / "truncated.stl";
+        ofstream{truncatedFile, ios::binary}.write(data.data(), static_cast<streamsize>(data.size()));
+
+        Mesh::MeshPointer meshPointer {std::make_unique<NiceMock<MockBufferedMesh>>()};
+        ASSERT_THROW(createReader(truncatedFile)->getOutput(std::move(meshPointer)), std::runtime_error);
+        meshPointer = std::make_unique<NiceMock<MockBufferedMesh>>();
+        ASSERT_THROW(readStream("truncated.stl", meshPointer), std::runtime_error);
+        filesystem::remove(truncatedFile);
+    }
+
+    TEST_F(STLReaderFixture, ReadLargeFile) {
+        // Large enough to be decoded on several threads
+        unsigned const numTris = 200000;
+        std::vector<char> data(84 + 50 * size_t{numTris}, 0);
+        memcpy(data.data() + 80, &numTris, 4);
+        for (unsigned i = 0; i < numTris; ++i) {
+            for (unsigned j = 0; j < 9; ++j) {
+                auto const value = static_cast<float>(9 * i + j);
+                memcpy(data.data() + 84 + 50 * size_t{i} + 12 + 4 * j, &value, 4);
+            }
+        }
+        auto const largeFile = m_modelsDir / "large.stl";
+        ofstream{largeFile, ios::binary}.write(data.data(), static_cast<streamsize>(data.size()));
+
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto& mesh = *bufferedMesh;
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(largeFile)->getOutput(std::move(meshPointer));
+        for (unsigned i = 0; i < numTris * 9; ++i) {
+            ASSERT_EQ(mesh.positions[i], static_cast<float>(i));
+        }
+        for (unsigned i = 0; i < numTris * 3; ++i) {
+            ASSERT_EQ(mesh.indices[i], i);
+        }
+
+        // Streamed files are decoded the same way
+        auto streamedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto const& streamedPositions = streamedMesh->positions;
+        Mesh::MeshPointer streamedMeshPointer {std::move(streamedMesh)};
+        readStream("large.stl", streamedMeshPointer);
+        ASSERT_EQ(streamedPositions, mesh.positions);
+        filesystem::remove(largeFile);
+    }
+
+    TEST_F(STLReaderFixture, ReadAscii) {
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto& mesh = *bufferedMesh;
+        EXPECT_CALL(mesh, initialize(12*3, 12)).Times(Exactly(1));
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(m_modelsDir / "cube_ascii.stl")->getOutput(std::move(meshPointer));
+        ASSERT_EQ(mesh.positions, readPositions("cube.stl"));
+        for (unsigned i = 0; i < 36; ++i) {
+            ASSERT_EQ(mesh.indices[i], i);
+        }
+
+        auto streamedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto const& streamedPositions = streamedMesh->positions;
+        Mesh::MeshPointer streamedMeshPointer {std::move(streamedMesh)};
+        readStream("cube_ascii.stl", streamedMeshPointer);
+        ASSERT_EQ(streamedPositions, mesh.positions);
+
+        // Meshes without buffers are built a vertex and face at a time
+        auto& unbufferedMesh = dynamic_cast<MockMesh&>(*mockMesh.get());
+        EXPECT_CALL(unbufferedMesh, addVertex(_, _, _)).Times(Exactly(36));
+        EXPECT_CALL(unbufferedMesh, addFace(_)).Times(Exactly(12));
+        readData("cube_ascii.stl");
+    }
+
+    TEST_F(STLReaderFixture, ReadLargeAsciiFile) {
+        // Large enough to be parsed on several threads. Names can contain keywords and coordinates can be signed
+        // and in scientific notation
+        unsigned const numTris = 30000;
+        std::ostringstream text;
+        text << "solid vertex facet\n";
+        for (unsigned i = 0; i < numTris; ++i) {
+            text << "facet normal 0 0 1\n outer loop\n";
+            for (unsigned j = 0; j < 3; ++j) {
+                auto const value = 9 * i + 3 * j;
+                text << "  vertex +" << value << ' ' << value + 1 << ".0 " << value + 2 << "e0\n";
+            }
+            text << " endloop\r\nendfacet\n";
+        }
+        text << "endsolid vertex facet\n";
+        auto const largeFile = m_modelsDir / "large_ascii.stl";
+        ofstream{largeFile} << text.str();
+
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto& mesh = *bufferedMesh;
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        meshPointer = createReader(largeFile)->getOutput(std::move(meshPointer));
+        filesystem::remove(largeFile);
+        ASSERT_EQ(mesh.positions.size(), numTris * 9);
+        for (unsigned i = 0; i < numTris * 9; ++i) {
+            ASSERT_EQ(mesh.positions[i], static_cast<float>(i));
+        }
+        for (unsigned i = 0; i < numTris * 3; ++i) {
+            ASSERT_EQ(mesh.indices[i], i);
+        }
+    }
+
+    TEST_F(STLReaderFixture, InvalidAsciiFile) {
+        auto const invalidFile = m_modelsDir / "invalid_ascii.stl";
+        auto read = [&](std::string const& text) {
+            ofstream{invalidFile} << text;
+            Mesh::MeshPointer meshPointer {std::make_unique<NiceMock<MockBufferedMesh>>()};
+            createReader(invalidFile)->getOutput(std::move(meshPointer));
+        };
+        // Quads are not supported
+        EXPECT_THROW(read("solid quad\nfacet normal 0 0 1\nouter loop\nvertex 0 0 0\nvertex 1 0 0\nvertex 1 1 0\n"
+                          "vertex 0 1 0\nendloop\nendfacet\nendsolid quad\n"), std::runtime_error);
+        EXPECT_THROW(read("solid bad\nfacet normal 0 0 1\nouter loop\nvertex 0 0 0\nvertex 1 x 0\nvertex 1 1 0\n"
+                          "endloop\nendfacet\nendsolid bad\n"), std::runtime_error);
+        EXPECT_THROW(read("solid truncated\nfacet normal 0 0 1\nouter loop\nvertex 0 0 0\n"), std::runtime_error);
+        filesystem::remove(invalidFile);
+    }
+
+    TEST_F(STLReaderFixture, WeldOnLoad) {
+        auto const expectedPositions = readPositions("cube.stl");
+        auto verify = [&](MockBufferedMesh const& mesh) {
+            ASSERT_EQ(mesh.positions.size(), 8 * 3);
+            ASSERT_EQ(mesh.indices.size(), 12 * 3);
+            for (unsigned i = 0; i < 36; ++i) {
+                for (unsigned j = 0; j < 3; ++j) {
+                    ASSERT_EQ(mesh.positions[3 * mesh.indices[i] + j], expectedPositions[3 * i + j]);
+                }
+            }
+        };
+
+        // Mapped binary and ASCII files and streamed files are all welded the same way
+        std::vector<float> weldedPositions;
+        for (auto const* fileName : {"cube.stl", "cube_ascii.stl"}) {
+            auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+            auto& mesh = *bufferedMesh;
+            EXPECT_CALL(mesh, removeDuplicateVertices()).Times(Exactly(0));
+            Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+            auto reader = createReader(m_modelsDir / fileName);
+            reader->setCleanupOnImport(true);
+            meshPointer = reader->getOutput(std::move(meshPointer));
+            verify(mesh);
+            if (weldedPositions.empty()) weldedPositions = mesh.positions;
+            ASSERT_EQ(mesh.positions, weldedPositions);
+
+            auto streamedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+            auto& streamed = *streamedMesh;
+            Mesh::MeshPointer streamedMeshPointer {std::move(streamedMesh)};
+            readStream(fileName, streamedMeshPointer, /*clean=*/true);
+            verify(streamed);
+            ASSERT_EQ(streamed.positions, weldedPositions);
+        }
+    }
+
+    TEST_F(STLReaderFixture, WeldLargeFileOnLoad) {
+        // A grid of n x n quads, two triangles each, with a collapsed triangle after every row. Large enough to be
+        // welded on several threads
+        unsigned const n = 200;
+        std::vector<float> soup;
+        auto addTriangle = [&soup](std::initializer_list<std::array<float, 3>> vertices) {
+            for (auto const& vertex : vertices) soup.insert(soup.end(), vertex.begin(), vertex.end());
+        };
+        for (unsigned i = 0; i < n; ++i) {
+            auto const y = static_cast<float>(i);
+            for (unsigned j = 0; j < n; ++j) {
+                auto const x = static_cast<float>(j);
+                addTriangle({{x, y, 0}, {x + 1, y, 0}, {x + 1, y + 1, 0}});
+                addTriangle({{x, y, 0}, {x + 1, y + 1, 0}, {x, y + 1, -0.f}});
+            }
+            addTriangle({{0, y, 0}, {0, y, 0}, {1, y, 0}});
+        }
+        unsigned const numTris = static_cast<unsigned>(soup.size() / 9);
+        std::vector<char> data(84 + 50 * size_t{numTris}, 0);
+        memcpy(data.data() + 80, &numTris, 4);
+        for (unsigned i = 0; i < numTris; ++i) {
+            memcpy(data.data() + 84 + 50 * size_t{i} + 12, soup.data() + 9 * i, 36);
+        }
+        auto const largeFile = m_modelsDir / "large_weld.stl";
+        ofstream{largeFile, ios::binary}.write(data.data(), static_cast<streamsize>(data.size()));
+
+        auto bufferedMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto& mesh = *bufferedMesh;
+        Mesh::MeshPointer meshPointer {std::move(bufferedMesh)};
+        auto reader = createReader(largeFile);
+        reader->setCleanupOnImport(true);
+        meshPointer = reader->getOutput(std::move(meshPointer));
+        filesystem::remove(largeFile);
+
+        // Vertices are numbered in the order they first appear in
+        std::vector<float> expectedPositions;
+        std::vector<unsigned> expectedIndices;
+        std::map<std::array<float, 3>, unsigned> vertexIndices;
+        for (unsigned i = 0; i < numTris; ++i) {
+            unsigned triangle[3];
+            for (unsigned j = 0; j < 3; ++j) {
+                std::array<float, 3> vertex;
+                memcpy(vertex.data(), soup.data() + 9 * i + 3 * j, sizeof(vertex));
+                // Zero and negative zero are the same
+                for (auto& coordinate : vertex) coordinate += 0.f;
+                auto const [entry, isNew] = vertexIndices.emplace(vertex, vertexIndices.size());
+                if (isNew) expectedPositions.insert(expectedPositions.end(), vertex.begin(), vertex.end());
+                triangle[j] = entry->second;
+            }
+            if (triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[2] != triangle[0]) {
+                expectedIndices.insert(expectedIndices.end(), triangle, triangle + 3);
+            }
+        }
+        ASSERT_EQ(vertexIndices.size(), (n + 1) * (n + 1));
+        ASSERT_EQ(expectedIndices.size(), 2 * n * n * 3);
+        ASSERT_EQ(mesh.positions, expectedPositions);
+        ASSERT_EQ(mesh.indices, expectedIndices);
+
+        // ASCII files are welded a piece of text at a time, with the same result
+        std::ostringstream text;
+        text << "solid grid\n";
+        for (unsigned i = 0; i < numTris; ++i) {
+            text << "facet normal 0 0 1\n outer loop\n";
+            for (unsigned j = 0; j < 3; ++j) {
+                auto const* vertex = soup.data() + 9 * i + 3 * j;
+                text << "  vertex " << vertex[0] << ' ' << vertex[1] << ' ' << vertex[2] << '\n';
+            }
+            text << " endloop\nendfacet\n";
+        }
+        text << "endsolid grid\n";
+        ASSERT_GT(text.str().size(), size_t{2} << 20) << "Text has to be parsed in several pieces";
+        auto const largeAsciiFile = m_modelsDir / "large_weld_ascii.stl";
+        ofstream{largeAsciiFile} << text.str();
+        auto asciiMesh = std::make_unique<NiceMock<MockBufferedMesh>>();
+        auto& ascii = *asciiMesh;
+        meshPointer = std::move(asciiMesh);
+        auto asciiReader = createReader(largeAsciiFile);
+        asciiReader->setCleanupOnImport(true);
+        meshPointer = asciiReader->getOutput(std::move(meshPointer));
+        filesystem::remove(largeAsciiFile);
+        ASSERT_EQ(ascii.positions, expectedPositions);
+        ASSERT_EQ(ascii.indices, expectedIndices);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#version 410 core
+precision highp float;
+in vec3 vertexCamera;
+out vec4 fragmentColor;
+
+uniform struct Material {
+    vec3 ambientColor;
+    vec3 diffuseColor;
+} material;
+
+// NOTE: Light position is assumed to be in view coordinates
+uniform struct Light {
+    vec3 position;
+    vec3 color;
+} light;
+
+uniform struct Fog {
+    float minimumDistance;
+    float maximumDistance;
+    vec3 color;
+    bool enabled;
+} fog;
+
+void main() {
+    // The triangle's normal is perpendicular to the rates at which the position changes across the screen. Its
+    // orientation doesn't matter, since both sides of the triangle are lit
+    vec3 normal = normalize(cross(dFdx(vertexCamera), dFdy(vertexCamera)));
+    vec3 lightDirection = normalize(light.position - vertexCamera);
+    vec3 diffuseLight = material.diffuseColor * light.color * abs(dot(normal, lightDirection));
+    vec3 color = light.color * material.ambientColor + diffuseLight;
+    if (fog.enabled) {
+        float distanceFromCamera = length(vertexCamera);
+        float fogFactor = (distanceFromCamera - fog.minimumDistance) / (fog.maximumDistance - fog.minimumDistance);
+        color = mix(color, fog.color, fogFactor);
+    }
+    fragmentColor = vec4(color, 1.0);
+}
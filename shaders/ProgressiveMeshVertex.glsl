@@ -0,0 +1,15 @@
+#version 410 core
+
+precision highp float;
+
+in vec3 vertexModel;
+uniform mat4 projectionTransform;
+uniform mat4 modelViewTransform;
+out vec3 vertexCamera;
+
+// Vertices of a mesh that is being read have no normals. Shading is left to the fragment shader, which derives the
+// normal of each triangle
+void main() {
+    vertexCamera = (modelViewTransform * vec4(vertexModel, 1.0)).xyz;
+    gl_Position = projectionTransform * vec4(vertexCamera, 1.0);
+}
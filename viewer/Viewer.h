@@ -1,6 +1,7 @@
 #pragma once
 #include "Drawable.h"
 #include "PointerTypes.h"
+#include <functional>
 
 namespace mv::viewer {
 
@@ -16,6 +17,10 @@ namespace mv::viewer {
             // Remove a drawable from the scene
             virtual void remove(Drawable::DrawablePointer const&) = 0;
 
+            // Runs a task on the thread that renders before the next frame is drawn. Can be called from any thread,
+            // e.g. to hand drawables that were created in the background to the viewer
+            virtual void post(std::function<void()> task) = 0;
+
             // Render scene, viewports and renderables
             virtual void render() = 0;
 
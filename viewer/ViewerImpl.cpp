@@ -22,6 +22,7 @@
 #include "emscripten/html5.h"
 #endif
 
+#include <algorithm>
 #include <filesystem>
 #include <string>
 using namespace std;
@@ -230,6 +231,28 @@ void ViewerImpl::remove(Drawable::DrawablePointer const& drawableToRemove) {
     if (scene) scene->remove(*drawableToRemove);
 }
 
+void ViewerImpl::post(std::function<void()> task) {
+    std::lock_guard lock{postedTasksMutex};
+    postedTasks.push_back(std::move(task));
+}
+
+bool ViewerImpl::runPostedTasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard lock{postedTasksMutex};
+        tasks.swap(postedTasks);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+    return !tasks.empty();
+}
+
+bool ViewerImpl::drawablesRequireRedraw() const {
+    return std::any_of(drawables.begin(), drawables.end(),
+                       [](auto const& drawable) { return drawable->requiresRedraw(); });
+}
+
 #ifdef EMSCRIPTEN
 bool ViewerImpl::isCanvasResized(CanvasDimensions& canvasDimensions) const {
     double deviceWidth, deviceHeight;
@@ -268,7 +291,11 @@ void ViewerImpl::RenderLoop::draw() {
         }
 #endif
 
-        if (viewer->needsRedraw || viewer->ui.requiresRedraw()) {
+        if (viewer->runPostedTasks()) {
+            viewer->needsRedraw = true;
+        }
+
+        if (viewer->needsRedraw || viewer->ui.requiresRedraw() || viewer->drawablesRequireRedraw()) {
 
             if (viewer->isDebugOn()) {
                 std::puts(std::format("{}: Viewer was modified. Redrawing the scene...", __PRETTY_FUNCTION__).c_str());
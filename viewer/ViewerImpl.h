@@ -3,6 +3,9 @@
 #include "EventTypes.h"
 #include "Scene.h"
 #include "UserInterface.h"
+#include <functional>
+#include <mutex>
+#include <vector>
 
 class GLFWwindow;
 
@@ -13,6 +16,7 @@ namespace mv::viewer {
         void add(Drawable::DrawablePointers const& newDrawables) override;
         void add(Drawable::DrawablePointer const&) override;
         void remove(Drawable::DrawablePointer const&) override;
+        void post(std::function<void()> task) override;
         void render() override;
         [[nodiscard]] math3d::Matrix<float, 3, 3> getViewportToWindowTransform() const override;
 
@@ -41,6 +45,11 @@ namespace mv::viewer {
 
         void createWindow();
 
+        // Runs the tasks that were posted since the last frame. Returns false if there were none
+        bool runPostedTasks();
+
+        [[nodiscard]] bool drawablesRequireRedraw() const;
+
 #ifdef EMSCRIPTEN
         bool isCanvasResized(common::CanvasDimensions& canvasDimensions) const;
 #endif
@@ -76,6 +85,8 @@ namespace mv::viewer {
         bool leftMouseDown;
         bool needsRedraw;
         ui::UserInterface& ui;
+        std::mutex postedTasksMutex;
+        std::vector<std::function<void()>> postedTasks;
 
         // Member functions
     private:
@@ -114,6 +114,11 @@ namespace mv::scene {
             arcballController->notifyDisplayResized(displayDimensions);
         }
 
+        // Changes have to be in the bounds before the view is computed from them
+        for (auto& drawable : drawables) {
+            drawable.get().update();
+        }
+
         // Compute the view
         camera->apply();
 
@@ -173,20 +178,23 @@ namespace mv::scene {
     }
 
     mv::common::Point3D Viewport::getCentroid() const {
-        if (drawables.empty()) {
-            //std::cerr << std::format("{}: No drawables were found.", __PRETTY_FUNCTION__);
-            return {};
-        }
         mv::common::Point3D centroid;
+        unsigned numDrawables = 0;
         for (auto& drawable : drawables) {
+            if (!drawable.get().hasBounds()) continue;
             auto drawableCentroid = drawable.get().getCentroid();
             centroid.x += drawableCentroid.x;
             centroid.y += drawableCentroid.y;
             centroid.z += drawableCentroid.z;
+            ++numDrawables;
+        }
+        if (!numDrawables) {
+            //std::cerr << std::format("{}: No drawables were found.", __PRETTY_FUNCTION__);
+            return {};
         }
-        centroid.x /= static_cast<float>(drawables.size());
-        centroid.y /= static_cast<float>(drawables.size());
-        centroid.z /= static_cast<float>(drawables.size());
+        centroid.x /= static_cast<float>(numDrawables);
+        centroid.y /= static_cast<float>(numDrawables);
+        centroid.z /= static_cast<float>(numDrawables);
         return centroid;
     }
 
@@ -196,6 +204,7 @@ namespace mv::scene {
         }
         mv::common::Bounds viewportBounds;
         for (auto& drawable : drawables) {
+            if (!drawable.get().hasBounds()) continue;
             auto drawableBounds = drawable.get().getBounds();
             viewportBounds.x.min = std::min(drawableBounds.x.min, viewportBounds.x.min);
             viewportBounds.y.min = std::min(drawableBounds.y.min, viewportBounds.y.min);
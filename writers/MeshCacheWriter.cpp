@@ -0,0 +1,70 @@
+#include "MeshCacheWriter.h"
+#include "MeshCacheFormat.h"
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+namespace mv::writers {
+
+using namespace common::meshcache;
+
+MeshCacheWriter::Contents MeshCacheWriter::getContents(Mesh const& mesh) {
+    // Arrays share the mesh's buffers, so only the indices are copied
+    size_t numIndexBytes;
+    unsigned* indices;
+    mesh.getConnectivityData(numIndexBytes, indices);
+    return {mesh.getNumberOfVertices(),
+            mesh.getVertexData(),
+            {indices, indices + mesh.getNumberOfFaces() * size_t{3}},
+            mesh.getNormals(common::NormalLocation::Vertex),
+            mesh.getNormals(common::NormalLocation::Face),
+            mesh.getBounds()};
+}
+
+void MeshCacheWriter::write(Contents const& contents) const {
+    auto const numVertices = contents.numVertices;
+    auto const numFaces = static_cast<unsigned>(contents.indices.size() / 3);
+    auto const& bounds = contents.bounds;
+    float const boundsData[] {bounds.x.min, bounds.y.min, bounds.z.min, bounds.x.max, bounds.y.max, bounds.z.max};
+
+    struct SectionData {
+        SectionType type;
+        void const* data;
+        uint64_t size;
+    };
+    vector<SectionData> const sectionData {
+        {SectionType::Positions, contents.positions.getData(), numVertices * 3ull * sizeof(float)},
+        {SectionType::Indices, contents.indices.data(), numFaces * 3ull * sizeof(unsigned)},
+        {SectionType::VertexNormals, contents.vertexNormals.getData(), numVertices * 3ull * sizeof(float)},
+        {SectionType::FaceNormals, contents.faceNormals.getData(), numFaces * 3ull * sizeof(float)},
+        {SectionType::Bounds, boundsData, sizeof(boundsData)},
+    };
+
+    auto align = [](uint64_t const offset) {
+        return (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+    };
+    Header const header {magic, version, byteOrderMark, numVertices, numFaces,
+                         static_cast<uint32_t>(sectionData.size()), 0};
+    vector<Section> sections;
+    auto offset = align(sizeof(Header) + sectionData.size() * sizeof(Section));
+    for (auto const& [type, data, size] : sectionData) {
+        sections.push_back({type, 0, offset, size});
+        offset = align(offset + size);
+    }
+
+    ofstream ofs(m_fileName, ios::binary);
+    if (!ofs) throw std::runtime_error("Unable to open " + m_fileName + " for writing");
+    ofs.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<char const*>(sections.data()),
+              static_cast<streamsize>(sections.size() * sizeof(Section)));
+    vector<char> const padding(sectionAlignment);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        ofs.write(padding.data(), static_cast<streamsize>(sections[i].offset) - static_cast<streamsize>(ofs.tellp()));
+        ofs.write(static_cast<char const*>(sectionData[i].data), static_cast<streamsize>(sectionData[i].size));
+    }
+    ofs.close();
+    if (!ofs) throw std::runtime_error("Unable to write " + m_fileName);
+}
+
+}
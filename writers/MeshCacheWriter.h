@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "Mesh.h"
+
+namespace mv::writers {
+
+// Writes meshes in MeshViewer's native .mvmesh format (see MeshCacheFormat.h), which can be reopened without parsing
+class MeshCacheWriter {
+public:
+    // What is written of a mesh. Positions and normals share the mesh's buffers and the indices are copied, so the
+    // contents can be written while the mesh is used or after it is destroyed
+    struct Contents {
+        unsigned numVertices;
+        Mesh::VertexData positions;
+        std::vector<unsigned> indices;
+        Mesh::NormalData vertexNormals;
+        Mesh::NormalData faceNormals;
+        common::Bounds bounds;
+    };
+
+    explicit MeshCacheWriter(std::string fileName) : m_fileName(std::move(fileName)) { }
+
+    // Normals and bounds the mesh doesn't have yet are computed
+    [[nodiscard]] static Contents getContents(Mesh const& mesh);
+
+    // Writes the mesh along with its normals and bounds
+    void write(Mesh const& mesh) const { write(getContents(mesh)); }
+    void write(Contents const&) const;
+
+private:
+    std::string m_fileName;
+};
+
+}